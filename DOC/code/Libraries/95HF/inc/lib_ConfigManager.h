@@ -51,6 +51,22 @@
 #define	TRACK_NFCTYPE5 		0x20 /* 0010 0000 */
 #define TRACK_ALL 				0xFF /* 1111 1111 */
 
+/* Technologies of the discovery loop (NFC-A for TT1/TT2/TT4A, NFC-B, NFC-F, NFC-V) ------------*/
+#define CONFIGMANAGER_TECHNO_A					0
+#define CONFIGMANAGER_TECHNO_B					1
+#define CONFIGMANAGER_TECHNO_F					2
+#define CONFIGMANAGER_TECHNO_V					3
+#define CONFIGMANAGER_NBTECHNO					4
+
+/* field off time which resets the tags before a discovery loop */
+#ifndef CONFIGMANAGER_FIELDOFF_MS
+	#define CONFIGMANAGER_FIELDOFF_MS			5
+#endif
+/* guard time between the RF field on and the first command (GTA and GTV of the NFC Forum) */
+#ifndef CONFIGMANAGER_GUARDTIME_MS
+	#define CONFIGMANAGER_GUARDTIME_MS		5
+#endif
+
 /* Flags for Initiator/Target tracking  ------------------------------------------------------*/
 #define	P2P_NOTHING				0x00
 #define	INITIATOR_NFCA 		0x01 /* 0000 0001 */
@@ -117,6 +133,8 @@ typedef struct {
 void ConfigManager_HWInit (void);
 void ConfigManager_AutoMode (MANAGER_CONFIG *pManagerConfig);
 uint8_t ConfigManager_TagHunting ( uint8_t tagsToFind );
+uint8_t ConfigManager_Discovery ( uint8_t tagsToFind, bool StopOnFirstTag );
+uint8_t ConfigManager_Poll ( uint8_t tagsToFind );
 uint8_t ConfigManager_TagEmulation (PICCEMULATOR_SELECT_TAG_TYPE TagEmulated, uint16_t delay_ms);
 uint8_t ConfigManager_P2P(uint8_t P2Pmode);
 
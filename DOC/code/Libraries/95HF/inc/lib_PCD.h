@@ -199,6 +199,7 @@
 #define PCD_ISO14443A_APPENDCRC												0x20
 #define PCD_ISO14443A_DONTAPPENDCRC										0x00
 #define PCD_ISO14443A_A8BITSINFIRSTBYTE								0x08
+#define PCD_ISO14443A_SPLITFRAME											0x40
 
 /* Speed parameters commom to  ISO14443B protocols --------------------------------------*/
 #define PCD_ISO14443B_TRANSMISSION_SPEED_106K  				0x00
@@ -213,6 +214,55 @@
 
 #define PCD_ISO14443B_APPEND_CRC							 				0x01
 
+/* Speed parameters of ISO14443A protocol -----------------------------------------------*/
+#define PCD_ISO14443A_TRANSMISSION_SPEED_106K  				0x00
+#define PCD_ISO14443A_TRANSMISSION_SPEED_212K	 				0x40
+#define PCD_ISO14443A_TRANSMISSION_SPEED_424K	 				0x80
+#define PCD_ISO14443A_TRANSMISSION_SPEED_848K	 				0xC0
+
+#define PCD_ISO14443A_RECEPTION_SPEED_106K						0x00
+#define PCD_ISO14443A_RECEPTION_SPEED_212K		 				0x10
+#define PCD_ISO14443A_RECEPTION_SPEED_424K		 				0x20
+#define PCD_ISO14443A_RECEPTION_SPEED_848K		 				0x30
+
+/* Speed parameters of FeliCa protocol --------------------------------------------------*/
+#define PCD_FELICA_TRANSMISSION_SPEED_212K	 					0x40
+#define PCD_FELICA_TRANSMISSION_SPEED_424K	 					0x80
+
+#define PCD_FELICA_RECEPTION_SPEED_212K		 						0x10
+#define PCD_FELICA_RECEPTION_SPEED_424K		 						0x20
+
+#define PCD_FELICA_APPEND_CRC							 						0x01
+
+/* ISO14443 bit rates (DRI/DSI of PPS, ATTRIB and protocol select coding) ---------------*/
+#define PCD_ISO14443_BITRATE_106K											0x00
+#define PCD_ISO14443_BITRATE_212K											0x01
+#define PCD_ISO14443_BITRATE_424K											0x02
+#define PCD_ISO14443_BITRATE_848K											0x03
+/* highest bit rate requested to the cards */
+#ifndef PCD_ISO14443_MAXBITRATE
+#define PCD_ISO14443_MAXBITRATE												PCD_ISO14443_BITRATE_848K
+#endif
+/* bit rate capability (ATS TA(1) or ATQB) : same bit rate in both directions */
+#define PCD_ISO14443_SAMEBITRATEMASK									0x80
+#define PCD_ISO14443_TRANSMISSIONSPEED(BitRate)				((BitRate) << 6)
+#define PCD_ISO14443_RECEPTIONSPEED(BitRate)					((BitRate) << 4)
+
+/* ISO14443 frame sizes (FSCI/FSDI coding of ATS, RATS, ATQB and ATTRIB) ----------------*/
+#define PCD_ISO14443_FRAMESIZE_128										0x07
+#define PCD_ISO14443_FRAMESIZE_256										0x08
+/* frame size announced to the cards : the reply of the PCD device holds 255 bytes, */
+/* so a card with a longer answer has to chain it */
+#ifndef PCD_ISO14443_FSDI
+#define PCD_ISO14443_FSDI															PCD_ISO14443_FRAMESIZE_128
+#endif
+
+/* ISO14443 frame waiting time (FWT = 2^FWI x 4096/fc), protocol select PP and MM bytes */
+/* give a time out of 2^PP x (MM+1) x 4096/fc --------------------------------------------*/
+#define PCD_ISO14443_DEFAULTFWI												0x04
+#define PCD_ISO14443_MAXFWI														0x0E
+#define PCD_ISO14443_MAXWTXM													59
+
 /* Error codes for Higher level */
 #define PCDNFC_OK 										RESULTOK
 #define PCDNFC_ERROR 									ERRORCODE_GENERIC
@@ -221,13 +271,54 @@
 #define PCDNFC_ERROR_LOCKED 					4
 #define PCDNFC_ERROR_NOT_FORMATED			5
 
+/* Statistics of the last NDEF write (PCDNFCTx_WriteNDEF) : units written and units saved because
+   their content did not change. A unit is a byte for Type 1 WRITE-E and Type 4, a block otherwise */
+typedef struct{
+	uint16_t NbWritten;
+	uint16_t NbSaved;
+}PCDNFC_WRITESTAT;
+
+extern PCDNFC_WRITESTAT PCDNFC_WriteStat;
+
+/* Capability cache : the static information of the tags found by the NDEF functions, one entry per UID */
+#ifndef PCDNFC_CCCACHE_NBENTRY
+#define PCDNFC_CCCACHE_NBENTRY												4
+#endif
+#define PCDNFC_MAX_UID_SIZE														10
+/* flags of a cache entry */
+#define PCDNFC_CC_FASTREAD														0x01		// Type 2 : FAST_READ supported
+#define PCDNFC_CC_EXTENDEDCMD													0x02		// Type 5 : extended commands (2 bytes address)
+
+typedef struct{
+	uint8_t 	TagType;				// st95tagtype of the tag
+	uint8_t 	UIDsize;
+	uint8_t 	UID[PCDNFC_MAX_UID_SIZE];
+	uint32_t 	MemorySize;			// size of the data area of the tag (bytes)
+	uint16_t 	NDEFOffset;			// Type 2 : address of the NDEF TLV, Type 5 : size of the CC
+	uint16_t 	MaxRead;				// Type 3 : Nbr, Type 4 : MLe
+	uint16_t 	MaxWrite;				// Type 3 : Nbw, Type 4 : MLc
+	uint16_t 	FileID;					// Type 4 : NDEF file identifier
+	uint8_t 	Access;					// access byte of the CC (Type 4 : read access)
+	uint8_t 	WriteAccess;		// Type 4 : write access
+	uint8_t 	Density;				// Type 5 : ISO15693_LOW_DENSITY or ISO15693_HIGH_DENSITY
+	uint8_t 	Flags;					// PCDNFC_CC_xxx
+}PCDNFC_CCINFO;
+
 					 
 /* Functions ---------------------------------------------------------------- */
 int8_t PCD_IsReaderResultCodeOk 		( uint8_t CmdCode,uc8 *ReaderReply);
 int8_t PCD_IsCRCOk 									( uc8 Protocol , uc8 *pReaderReply );
+void PCD_ISO14443BitRate							( uc8 BitRateCapability, uc8 MaxBitRate, uint8_t *pDR, uint8_t *pDS );
+uint16_t PCD_ISO14443FrameSize					( uc8 FSCI );
+bool PCD_ISO14443FrameWaitingTime				( uc8 FWI, uc8 WTXM, uint8_t *pPP, uint8_t *pMM );
 
 int8_t 	PCD_CheckSendReceive				(uc8 *pCommand, uint8_t *pResponse);
 
+int8_t PCDNFC_GetCachedCC							( uc8 TagType, uc8 *pUID, uc8 UIDsize, PCDNFC_CCINFO *pInfo );
+void PCDNFC_StoreCC										( const PCDNFC_CCINFO *pInfo );
+void PCDNFC_InvalidateCC							( uc8 TagType, uc8 *pUID, uc8 UIDsize );
+void PCDNFC_FlushCCCache							( void );
+
 void PCD_FieldOff								( void );
 void PCD_FieldOn 								( void );
 
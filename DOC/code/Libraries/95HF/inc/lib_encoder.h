@@ -0,0 +1,99 @@
+/**
+  ******************************************************************************
+  * @file    lib_encoder.h
+  * @author  MMY Application Team
+  * @version V4.0.0
+  * @date    02/06/2014
+  * @brief   Bulk NDEF encoding of the tags of a production line
+  ******************************************************************************
+  * @copyright
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LIB_ENCODER_H
+#define __LIB_ENCODER_H
+
+#include "lib_ConfigManager.h"
+
+/* success and error code --------------------------------------------------------------------- */
+#define ENCODER_SUCCESSCODE											RESULTOK
+#define ENCODER_ERRORCODE_DEFAULT								0xD1
+#define ENCODER_ERRORCODE_NOTAG									0xD2		// no new tag within MaxIdlePoll polls
+#define ENCODER_ERRORCODE_TAGTYPE								0xD3		// the kind of tag is not supported
+#define ENCODER_ERRORCODE_WRITE									0xD4		// the NDEF write failed (or the message does not fit)
+#define ENCODER_ERRORCODE_VERIFY								0xD5		// the message read back differs from the message written
+#define ENCODER_ERRORCODE_LOCK									0xD6		// the tag cannot be set read-only
+#define ENCODER_ERRORCODE_PARAMETER							0xD7
+
+/* options of a job --------------------------------------------------------------------------- */
+#define ENCODER_OPTION_VERIFY										0x01		// read back the message and compare its CRC
+#define ENCODER_OPTION_LOCK											0x02		// set the message read-only (Type 2, 3 and 5)
+
+#define ENCODER_MAX_UID_SIZE										10
+
+/* one NDEF message of a queue */
+typedef struct {
+	uc8					*pMessage;
+	uint16_t		Length;
+}ENCODER_IMAGE;
+
+/* variable field of a template : the bytes of the template replaced for each tag */
+typedef struct {
+	uint16_t		Offset;						// position in the template message
+	uint8_t			Length;
+}ENCODER_FIELD;
+
+typedef struct {
+	uint8_t			TagsToFind;				// TRACK_NFCTYPEx of the tags to encode (Type 1 is not supported)
+	uint8_t			Options;					// ENCODER_OPTION_xxx
+	uint16_t		NbTag;						// number of tags to encode
+	const ENCODER_IMAGE	*pImage;	// queue : NbTag messages, one per tag (0x00 => template)
+	uc8					*pTemplate;				// template : message shared by all the tags
+	uint16_t		TemplateLength;
+	const ENCODER_FIELD	*pField;	// NbField fields of the template
+	uint8_t			NbField;
+	uc8					*pFieldValue;			// NbTag records : the values of the fields of one tag, concatenated
+	uint16_t		MaxIdlePoll;			// polls without a new tag before the job stops (0 => no limit)
+}ENCODER_JOB;
+
+/* result of one tag, the times are in ms (0 if ENCODER_GetTick_ms is not set) */
+typedef struct {
+	uint8_t			UID[ENCODER_MAX_UID_SIZE];
+	uint8_t			UIDsize;
+	uint8_t			TagType;					// TRACK_NFCTYPEx
+	uint8_t			Status;						// ENCODER_SUCCESSCODE or ENCODER_ERRORCODE_xxx
+	uint16_t		CRC;							// CRC of the message written
+	uint16_t		NbWritten;				// units written (PCDNFC_WriteStat)
+	uint32_t		DetectTime;				// from the end of the previous tag
+	uint32_t		WriteTime;
+	uint32_t		VerifyTime;
+	uint32_t		LockTime;
+	uint32_t		TotalTime;
+}ENCODER_RESULT;
+
+typedef struct {
+	uint16_t		NbTagOk;
+	uint16_t		NbTagError;
+	uint32_t		Duration;					// ms (0 if ENCODER_GetTick_ms is not set)
+	uint32_t		TagsPerMinute;		// 0 if the duration is unknown
+}ENCODER_STAT;
+
+extern uint32_t (*ENCODER_GetTick_ms)(void);
+
+/* ---------------------------------------------------------------------------------
+ * --- Local Functions
+ * --------------------------------------------------------------------------------- */
+int8_t ENCODER_Run											( const ENCODER_JOB *pJob, ENCODER_RESULT *pResult, ENCODER_STAT *pStat);
+uint16_t ENCODER_ComputeCRC							( uc8 *pData, uc16 Length);
+
+#endif /* __LIB_ENCODER_H */
+
+/******************* (C) COPYRIGHT 2014 STMicroelectronics *****END OF FILE****/
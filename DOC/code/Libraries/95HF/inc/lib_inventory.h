@@ -0,0 +1,73 @@
+/**
+  ******************************************************************************
+  * @file    lib_inventory.h 
+  * @author  MMY Application Team
+  * @version V4.0.0
+  * @date    02/06/2014
+  * @brief   Inventory result table shared by the PCD protocols
+  ******************************************************************************
+  * @copyright
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LIB_INVENTORY_H
+#define __LIB_INVENTORY_H
+
+#include "lib_pcd.h"
+
+/* success and error code --------------------------------------------------------------------- */
+#define INVENTORY_SUCCESSCODE										RESULTOK
+#define INVENTORY_ERRORCODE_DEFAULT							0xE1
+#define INVENTORY_ERRORCODE_FULL								0xE2
+#define INVENTORY_ERRORCODE_PARAMETER						0xE3
+
+/* technologies ------------------------------------------------------------------------------- */
+#define INVENTORY_TECHNO_ISO14443A							0x01
+#define INVENTORY_TECHNO_ISO14443B							0x02
+#define INVENTORY_TECHNO_FELICA									0x03
+#define INVENTORY_TECHNO_ISO15693								0x04
+
+#define INVENTORY_MAX_UID_SIZE									10
+#define INVENTORY_RSSI_UNKNOWN									0x00
+#define INVENTORY_MAX_HITCOUNT									0xFFFF
+#define INVENTORY_NOINDEX												0xFFFF
+
+typedef struct {
+	uint8_t 	UID[INVENTORY_MAX_UID_SIZE];
+	uint8_t 	UIDsize;
+	uint8_t 	Technology;			// INVENTORY_TECHNO_xxx
+	uint8_t 	Info;						// DSFID (ISO15693) or SAK (ISO14443A)
+	uint8_t 	RSSI;						// INVENTORY_RSSI_UNKNOWN if not available
+	uint16_t 	HitCount;				// number of inventory rounds the tag was seen
+	uint32_t 	FirstSeen;			// timestamp given by the application
+	uint32_t 	LastSeen;
+	uint16_t 	Next;						// next record with the same hash (internal)
+}INVENTORY_RECORD;
+
+typedef struct {
+	INVENTORY_RECORD	*pRecord;		// Capacity records, allocated by the application
+	uint16_t					*pHashHead;	// NbHashEntry indexes, allocated by the application
+	uint16_t					Capacity;
+	uint16_t					NbHashEntry;
+	uint16_t					NbRecord;
+}INVENTORY_TABLE;
+
+/* ---------------------------------------------------------------------------------
+ * --- Local Functions  
+ * --------------------------------------------------------------------------------- */
+int8_t INVENTORY_Init										( INVENTORY_TABLE *pTable, INVENTORY_RECORD *pRecord, uint16_t *pHashHead, uc16 Capacity, uc16 NbHashEntry);
+void INVENTORY_Clear										( INVENTORY_TABLE *pTable);
+int8_t INVENTORY_Add										( INVENTORY_TABLE *pTable, uc8 Technology, uc8 *pUID, uc8 UIDsize, uc8 Info, uc8 RSSI, uc32 Timestamp);
+INVENTORY_RECORD *INVENTORY_Find				( INVENTORY_TABLE *pTable, uc8 Technology, uc8 *pUID, uc8 UIDsize);
+
+#endif /* __LIB_INVENTORY_H */
+
+/******************* (C) COPYRIGHT 2014 STMicroelectronics *****END OF FILE****/
@@ -23,11 +23,13 @@
 
 #include "lib_pcd.h"
 #include "lib_iso14443A.h"
+#include "lib_inventory.h"
 
 /*  status and error code ---------------------------------------------------------------------- */
 #define ISO14443A_SUCCESSCODE									RESULTOK
 #define ISO14443A_ERRORCODE_DEFAULT						0x61
 #define ISO14443A_ERRORCODE_CRC								0x62
+#define ISO14443A_ERRORCODE_TAGOVERFLOW				0x63
 
 
 /* Anticollison levels (commands)  ------------------------------------------------------------- */
@@ -86,6 +88,53 @@
 #define	ATQ_FLAG_UID_DOUBLE_SIZE		1
 #define ATQ_FLAG_UID_TRIPLE_SIZE		2
 
+/* ATS format and default time out of the PCD device (protocol select PP and MM bytes) ------- */
+#define ISO14443A_ATS_TAPRESENTMASK								0x10
+#define ISO14443A_ATS_TBPRESENTMASK								0x20
+#define ISO14443A_ATS_TCPRESENTMASK								0x40
+#define ISO14443A_ATS_FWISHIFT										4
+#define ISO14443A_DEFAULT_PP											0x01
+#define ISO14443A_DEFAULT_MM											0xA0
+
+/* Multi tag anticollision  ------------------------------------------------------------------ */
+#define ISO14443A_CASCADETAG											0x88
+#define ISO14443A_NBBYTE_BCC											1
+#define ISO14443A_NBBIT_UIDCLN										(ISO14443A_UID_SINGLE_SIZE*8)
+#define ISO14443A_NBBYTE_TAGRECORD								(1+ISO14443A_MAX_UID_SIZE)
+/* number of collisions remembered during the tree walk (the other ones are found again from the root) */
+#ifndef ISO14443A_ACBRANCH_NBENTRY
+#define ISO14443A_ACBRANCH_NBENTRY								16
+#endif
+/* number of failed rounds before the tree walk is stopped */
+#define ISO14443A_TREEWALK_NBRETRY								3
+/* number of tags returned by ISO14443A_MultiTagHunting and ISO14443A_MultiTagPart2 */
+#define ISO14443A_MULTITAGHUNTING_NBTAG						5
+
+/* Fast reactivation  ------------------------------------------------------------------------ */
+#ifndef ISO14443A_REACTIVATION_NBENTRY
+#define ISO14443A_REACTIVATION_NBENTRY						4
+#endif
+#define ISO14443A_MAX_ATS_SIZE										20
+
+typedef struct{
+	uint8_t 	ATQA[ISO14443A_ATQA_SIZE];
+	uint8_t 	UIDsize;
+	uint8_t 	UID[ISO14443A_MAX_UID_SIZE];
+	uint8_t 	SAK;
+	/* ATS (TL first), ATSsize = 0 when the card does not support RATS */
+	uint8_t 	ATSsize;
+	uint8_t 	ATS[ISO14443A_MAX_ATS_SIZE];
+	uint16_t 	FSC;
+}ISO14443A_REACTIVATIONENTRY;
+
+typedef struct{
+	/* ATQA received with the request of the round (can be merged with the ATQA of other cards) */
+	uint8_t 	ATQA[ISO14443A_ATQA_SIZE];
+	uint8_t 	UIDsize;
+	uint8_t 	UID[ISO14443A_MAX_UID_SIZE];
+	uint8_t 	SAK;
+}ISO14443A_TAGRECORD;
+
 
 /* ---------------------------------------------------------------------------------
  * --- Local Functions  
@@ -98,6 +147,15 @@ int8_t TOPAZ_ID( uint8_t *pDataRead);
 
 void ISO14443A_MultiTagHunting ( uint8_t* pNbTag, uint8_t *pUIDout );
 void ISO14443A_MultiTagPart2 ( uint8_t *pNbTag, uint8_t *pUIDout );
+int8_t ISO14443A_MultiTagInventory ( INVENTORY_TABLE *pTable, uc32 Timestamp, uint8_t *pNbTag );
+int8_t ISO14443A_MultiTagAnticollision ( ISO14443A_TAGRECORD *pRecord, uc8 MaxNbTag, uint8_t *pNbTag );
+int8_t ISO14443A_Reactivate ( void );
+void ISO14443A_SetMaxBitRate ( uc8 BitRate );
+int8_t ISO14443A_ExtendFrameWaitingTime ( uc8 WTXM );
+uint8_t ISO14443A_GetHistoricalBytes ( uc8 **ppHistoricalBytes );
+void ISO14443A_InvalidateReactivation ( uc8 *pUID, uc8 UIDsize );
+void ISO14443A_FlushReactivationCache ( void );
+int8_t ISO14443A_Halt ( void );
 
 #endif /* __ISO14443A_H */
 
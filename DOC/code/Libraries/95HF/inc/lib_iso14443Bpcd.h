@@ -28,6 +28,8 @@
 #define ISO14443B_SUCCESSCODE											RESULTOK
 #define ISO14443B_ERRORCODE_DEFAULT								0x71
 #define ISO14443B_ERRORCODE_CRC										0x72
+#define ISO14443B_ERRORCODE_COLLISION							0x73
+#define ISO14443B_ERRORCODE_TAGOVERFLOW						0x74
 
 
 /* REQB/WUPB command
@@ -56,8 +58,43 @@
 #define ISO14443B_SLOT_MARKER_1								 0
 #define ISO14443B_SLOT_MARKER_2								 0x01
 #define ISO14443B_SLOT_MARKER_4								 0x02
-#define ISO14443B_SLOT_MARKER_8								 3<<1
+#define ISO14443B_SLOT_MARKER_8								 0x03
 #define ISO14443B_SLOT_MARKER_16							 0x04
+/* number of slots of a SLOT MARKER code */
+#define ISO14443B_NBSLOT(SlotCode)						 (1 << (SlotCode))
+
+/* Slot-MARKER command (1 byte) : APn = (slot number - 1) in the 4 msb, '5' in the 4 lsb 
+ * (the slot 1 is the answer to the REQB/WUPB)
+ */
+#define ISO14443B_SLOTMARKER(Slot)						 ((((Slot) - 1) << 4) | ISO14443B_ANTICOLLISION_PREFIX_BYTE)
+
+/* HLTB command
+ * ------------------------------------
+ * 1st byte	| 2th to 5th bytes | (2 bytes)
+ * ------------------------------------
+ *   '50'   | Identifier(PUPI) |   CRC
+ * ------------------------------------
+ */
+#define ISO14443B_HLTB												 0x50
+#define ISO14443B_HLTB_ANSWER									 0x00
+
+/* ATQB : '50' + PUPI + Application data + Protocol info (3 bytes) */
+#define ISO14443B_ATQB_FIRSTBYTE							 0x50
+#define ISO14443B_NBBYTE_ATQB									 12
+#define ISO14443B_NBBYTE_CRC									 2
+
+/* guard time between the RF field on and the first REQB (GTB of the NFC Forum) */
+#ifndef ISO14443B_GUARDTIME_MS
+	#define ISO14443B_GUARDTIME_MS							 5
+#endif
+
+/* maximum number of rounds of the slot anticollision */
+#ifndef ISO14443B_ANTICOLLISION_NBROUND
+	#define ISO14443B_ANTICOLLISION_NBROUND			 8
+#endif
+
+/* R(NAK) block number 0 : the card answers R(ACK) (presence check) */
+#define COMMAND_NACKBLOCK_B										 0xB2
 
 /* ATTRIB command
  * ---------------------------------------------------------------------------------------------------------------
@@ -155,6 +192,12 @@
 #define ISO14443B_MAX_PROTOCOL_SIZE			         0x04
 #define ISO14443B_MAX_LOG_MSG                    60
 
+/* ATQB protocol info : FSCI and FWI, default time out of the PCD device (protocol select PP and MM bytes) */
+#define ISO14443B_PROTOCOLINFO_FSCISHIFT				4
+#define ISO14443B_PROTOCOLINFO_FWISHIFT					4
+#define ISO14443B_DEFAULT_PP										0x03
+#define ISO14443B_DEFAULT_MM										0xFF
+
 /* analog configuration values 	-------------------------------------*/
 #define	ISO14443B_ANALOGCONFIG 									0x0151
 
@@ -165,15 +208,29 @@ typedef struct{
 					ProtocolInfo[ISO14443B_MAX_PROTOCOL_SIZE];
 	bool 		IsDetected;
 	char		LogMsg[ISO14443B_MAX_LOG_MSG];
+	/* bit rates negotiated with the ATTRIB command (PCD_ISO14443_BITRATE_xxx) */
+	uint8_t DRI,
+					DSI;
 }ISO14443B_CARD;
 
+typedef struct{
+	uint8_t PUPI[ISO14443B_MAX_PUPI_SIZE],
+					ApplicationField[ISO14443B_MAX_APPLI_SIZE],
+					ProtocolInfo[ISO14443B_MAX_PROTOCOL_SIZE];
+}ISO14443B_TAGRECORD;
+
 
 int8_t ISO14443B_Init								( void );
 int8_t ISO14443B_ReqB								( uint8_t *pDataRead );
 int8_t ISO14443B_AttriB							( uint8_t *pDataRead );
 int8_t ISO14443B_IsPresent					( void );
+int8_t ISO14443B_IsPresentGuardTime	( uc8 FieldOnTime );
 int8_t ISO14443B_IsCardIntheField		( void );
 int8_t ISO14443B_Anticollision			( void );
+void ISO14443B_SetMaxBitRate				( uc8 BitRate );
+int8_t ISO14443B_ExtendFrameWaitingTime	( uc8 WTXM );
+int8_t ISO14443B_MultiTagAnticollision	( ISO14443B_TAGRECORD *pRecord, uc8 MaxNbTag, uint8_t *pNbTag );
+int8_t ISO14443B_Halt									( void );
 
 
 
@@ -19,6 +19,7 @@
 #define __LIB_ISO15693_H
 
 #include "lib_pcd.h"
+#include "lib_inventory.h"
 
 #define RFU 									0
 #define ISO15693_PROTOCOL              			0x01
@@ -100,6 +101,12 @@
 #define ISO15693_CMDCODE_LOCKDSFID						0x2A
 #define ISO15693_CMDCODE_GETSYSINFO						0x2B
 #define ISO15693_CMDCODE_GETSECURITYINFO			0x2C
+#define ISO15693_CMDCODE_EXTWRITESINGLEBLOCK	0x31		// 2 bytes block address (ISO15693-3:2013)
+#define ISO15693_CMDCODE_EXTREADMULBLOCKS			0x33		// 2 bytes block address (ISO15693-3:2013)
+#define ISO15693_CMDCODE_EXTWRITEMULBLOCKS		0x34		// 2 bytes block address (ISO15693-3:2013)
+/* ST custom command code -------------------------------------------------------------------- */
+#define ISO15693_CMDCODE_ST_INVENTORYREAD			0xA0
+#define ISO15693_ICMFGCODE_ST									0x02
 
 
 
@@ -185,6 +192,10 @@
 #define ISO15693_NBBYTE_INVENTORYSCANCHAIN			11  // =(2+8+8+64) /8 +1 
 #define ISO15693_NBBITS_MASKPARAMETER   				64
 
+/* anticollision : stack of the masks of the slots with a collision (mask length + mask value) */
+#define ISO15693_MASKSTACK_NBENTRY							0x80
+#define ISO15693_MASKSTACK_ENTRYSIZE						(1+ISO15693_NBBYTE_UID)
+
 /* success and error code --------------------------------------------------------------------- */
 #define ISO15693_SUCCESSCODE										RESULTOK
 #define ISO15693_ERRORCODE_DEFAULT							0xF1
@@ -201,6 +212,7 @@
 #define ISO15693_MAXLENGTH_READSINGLEBLOCK 			13		// 8 + 8 + 8 + 64 + 16 = 104bits => 13 bytes
 #define ISO15693_MAXLENGTH_LOCKSINGLEBLOCK 			13		// 8 + 8 + 8 + 64 + 16 = 104bits => 13 bytes
 #define ISO15693_MAXLENGTH_READMULBLOCK 				14		// 8 + 8 + 8 + 64 + 8 + 16 = 112 bits => 14 bytes
+#define ISO15693_MAXLENGTH_EXTREADMULBLOCK 			16		// 8 + 8 + 16 + 64 + 16 + 16 = 128 bits => 16 bytes
 #define ISO15693_MAXLENGTH_SELECT	 							12		// 8 + 8 	 + 64 + 16 = 96 bits => 12 bytes
 #define ISO15693_MAXLENGTH_RESETTOREADY					12		// 8 + 8 	 + 64 + 16 = 96 bits => 12 bytes
 #define ISO15693_MAXLENGTH_WRTITEAFI						13		// 8 + 8 + 8 + 64 + 16 = 104bits => 13 bytes
@@ -209,6 +221,7 @@
 #define ISO15693_MAXLENGTH_LOCKDSFID						12		// 8 + 8 	 + 64 + 16 = 96 bits => 12 bytes
 #define ISO15693_MAXLENGTH_GETMULSECURITY				14		// 8 + 8 + 8 + 64 + 8 + 16 = 112 bits => 14 bytes
 #define ISO15693_MAXLENGTH_GETSYSTEMINFO				12		// 8 + 8 	 + 64 + 16 = 96 => 12 bytes
+#define ISO15693_MAXLENGTH_STINVENTORYREAD			17		// 8 + 8 + 8 + 8 + 8 + 64 + 8 + 8 + 16 = 136 bits => 17 bytes
 // reply length
 #define ISO15693_MAXLENGTH_REPLYINVENTORY				12	 	// 8 + 8 + 64 + 16  = 96 => 12 bytes
 #define ISO15693_MAXLENGTH_REPLYSTAYQUIET				4		// No reply
@@ -247,6 +260,80 @@ int8_t 		DataRate		,	// 0 => 26k 	1 => 52 k 	2 => 6k	3=>RFU
 					AppendCRC		;	// 1=> append	0=> don't append			
 }ISO15693ConfigStruct;
 
+/* system information cache ------------------------------------------------------------------- */
+#ifndef ISO15693_SYSINFOCACHE_NBENTRY
+#define ISO15693_SYSINFOCACHE_NBENTRY						4
+#endif
+/* supported commands deduced from the IC reference */
+#define ISO15693_SUPPORT_READMULTIPLE							0x01
+#define ISO15693_SUPPORT_PROTOCOLEXTENSION				0x02
+#define ISO15693_SUPPORT_WRITEMULTIPLE						0x04
+#define ISO15693_SUPPORT_EXTENDEDCMD							0x08		// extended commands (2 bytes block address without protocol extension)
+
+typedef struct {
+	uint8_t 	UID[ISO15693_NBBYTE_UID];
+	uint8_t 	InfoFlags;
+	uint8_t 	DSFID;
+	uint8_t 	AFI;
+	uint16_t 	NbBlock;				// number of blocks of the tag
+	uint8_t 	BlockSize;			// number of bytes per block
+	uint8_t 	ICRef;
+	uint8_t 	Density;				// ISO15693_LOW_DENSITY or ISO15693_HIGH_DENSITY
+	uint8_t 	SupportedCmd;		// ISO15693_SUPPORT_xxx mask
+}ISO15693_SYSTEMINFO;
+
+/* bulk read ---------------------------------------------------------------------------------- */
+#ifndef ISO15693_BULKREAD_NBBLOCKPERREAD
+#define ISO15693_BULKREAD_NBBLOCKPERREAD				32		// max number of blocks per Read Multiple command
+#endif
+#define ISO15693_BULKREAD_MAXDATALENGTH					(RFTRANS_95HF_MAX_BUFFER_SIZE-ISO15693_NBBYTE_REPLYFLAG-ISO15693_NBBYTE_CRC16-CONTROL_15693_NBBYTE)
+#define ISO15693_NBBYTE_INVENTORYRECORD					(ISO15693_NBBYTE_DSFID+ISO15693_NBBYTE_UID)	// DSFID + UID (ISO15693_RunAntiCollision)
+
+/* inventory read ----------------------------------------------------------------------------- */
+#define ISO15693_INVENTORYREAD_MAXNBBLOCK				32
+#define ISO15693_INVENTORYREAD_STONLY						0x01	// only ST tags in the field => no check for other tags
+#define ISO15693_INVENTORYREADOFFSET_STATUS			ISO15693_NBBYTE_INVENTORYRECORD
+#define ISO15693_INVENTORYREADOFFSET_DATA				(ISO15693_NBBYTE_INVENTORYRECORD+1)
+// DSFID + UID + status + data
+#define ISO15693_NBBYTE_INVENTORYREADRECORD(NbBlock)	(ISO15693_INVENTORYREADOFFSET_DATA+(NbBlock)*ISO15693_NBBYTE_BLOCKLENGTH)
+
+typedef struct {
+	uint8_t 	UID[ISO15693_NBBYTE_UID];
+	uint8_t 	Status;					// ISO15693_SUCCESSCODE or ISO15693_ERRORCODE_xxx
+	uint8_t 	TagErrorCode;		// error code returned by the tag (0x00 => none)
+	uint16_t 	NbBlockRead;
+}ISO15693_BULKREADRESULT;
+
+typedef struct {
+	uint16_t 	NbTagOk;
+	uint16_t 	NbTagError;
+	uint32_t 	NbBlockRead;
+	uint32_t 	Duration;				// ms (0 if ISO15693_GetTick_ms is not set)
+	uint32_t 	BlocksPerSecond;
+}ISO15693_BULKREADSTAT;
+
+/* write buffer ------------------------------------------------------------------------------- */
+#ifndef ISO15693_WRITEBUFFER_NBBLOCK
+#define ISO15693_WRITEBUFFER_NBBLOCK						64		// number of blocks covered by a write buffer
+#endif
+#ifndef ISO15693_WRITEBUFFER_NBBLOCKPERWRITE
+#define ISO15693_WRITEBUFFER_NBBLOCKPERWRITE		4			// max number of blocks per Write Multiple command
+#endif
+#define ISO15693_WRITEBUFFER_BLOCKVALID					0x01	// block content is the tag content
+#define ISO15693_WRITEBUFFER_BLOCKDIRTY					0x02	// block has to be written in the tag
+
+typedef struct {
+	uint8_t 	UID[ISO15693_NBBYTE_UID];
+	uint8_t 	Density;
+	uint8_t 	SupportedCmd;		// ISO15693_SUPPORT_xxx mask (ISO15693_SUPPORT_WRITEMULTIPLE and ISO15693_SUPPORT_EXTENDEDCMD may be set by the application)
+	uint16_t 	FirstBlock;			// first block covered by the buffer
+	uint16_t 	NbBlock;				// number of blocks covered by the buffer
+	uint8_t 	BlockState[ISO15693_WRITEBUFFER_NBBLOCK];
+	uint8_t 	Data[ISO15693_WRITEBUFFER_NBBLOCK*ISO15693_NBBYTE_BLOCKLENGTH];
+	uint16_t 	NbBlockWritten;	// statistics : blocks written in the tag
+	uint16_t 	NbBlockSkipped;	// statistics : block writes saved (unchanged content)
+}ISO15693_WRITEBUFFER;
+
 // CRC 16 constants
 #define ISO15693_PRELOADCRC16 						0xFFFF 
 #define ISO15693_POLYCRC16 								0x8408 
@@ -267,11 +354,29 @@ int8_t ISO15693_Init										( void );
 /* ISO15693 commands --- */
 int8_t ISO15693_RunInventory16slots 		( uc8 Flags , uc8 AFI,uint8_t *NbTag,uint8_t *pUIDout);
 int8_t ISO15693_RunAntiCollision 				( uc8 Flags , uc8 AFI,uint8_t *NbTag,uint8_t *pUIDout);
+int8_t ISO15693_AddToInventory					( INVENTORY_TABLE *pTable, uc8 *pInventory, uc8 NbTag, uc32 Timestamp);
+int8_t ISO15693_RunInventoryRead				( uc8 Flags , uc8 AFI, uc8 Mode, uc8 FirstBlock, uc8 NbBlock, uint8_t *NbTag, uint8_t *pOut);
 
 // Get functions
 int8_t ISO15693_GetUID 									(uint8_t *UIDout);
 int8_t ISO15693_GetTagIdentification  	(uint16_t *Length_Memory_TAG, uint8_t *Tag_Density, uint8_t *IC_Ref_TAG);
 int8_t ISO15693_GetSystemInfo 					( uc8 Flags, uc8 *UIDin ,uint8_t *pResponse);
+int8_t ISO15693_GetCachedSystemInfo			( uc8 *UIDin, ISO15693_SYSTEMINFO *pSysInfo);
+void ISO15693_InvalidateSystemInfo			( uc8 *UIDin);
+void ISO15693_FlushSystemInfoCache			( void );
+int8_t ISO15693_GetCurrentUID						( uint8_t *UIDout);
+int8_t ISO15693_StayQuietCurrentTag			( void);
+
+// Bulk functions
+extern uint32_t (*ISO15693_GetTick_ms)(void);
+int8_t ISO15693_BulkRead								( uc8 *pInventory, uc8 NbTag, uc16 FirstBlock, uc16 NbBlock, ISO15693_SYSTEMINFO *pLayout, uint8_t *pData, ISO15693_BULKREADRESULT *pResult, ISO15693_BULKREADSTAT *pStat);
+int8_t ISO15693_ReadBlocks							( uc8 *UIDin, uc16 FirstBlock, uc16 NbBlock, ISO15693_SYSTEMINFO *pLayout, uint8_t *pData);
+
+// Write buffer functions
+int8_t ISO15693_WriteBufferOpen					( ISO15693_WRITEBUFFER *pBuffer, uc8 *UIDin, uc16 FirstBlock);
+int8_t ISO15693_WriteBufferWrite				( ISO15693_WRITEBUFFER *pBuffer, uc8 *Data_To_Write, uc16 NbBytes_To_Write, uc16 FirstBytes_To_Write);
+int8_t ISO15693_WriteBufferCommit				( ISO15693_WRITEBUFFER *pBuffer);
+int8_t ISO15693_WriteBufferClose				( ISO15693_WRITEBUFFER *pBuffer);
 
 // Tag functions
 uint8_t ISO15693_ReadBytesTagData				(uint8_t Tag_Density, uint8_t IC_Ref_Tag, uint8_t *Data_To_Read, uint16_t NbBytes_To_Read, uint16_t FirstBytes_To_Read);
@@ -31,24 +31,116 @@
 /* command code -------------------------------------------------------------- */
 #define ISO18092_COMMAND_REQC														0x00
 //#define ISO18092_COMMAND_ATR														0x00
+#define FELICA_RESPONSE_POLLING													0x01
+#define FELICA_COMMAND_REQUESTRESPONSE									0x04
+#define FELICA_RESPONSE_REQUESTRESPONSE									0x05
+#define FELICA_COMMAND_CHECK														0x06
+#define FELICA_RESPONSE_CHECK														0x07
+#define FELICA_COMMAND_UPDATE														0x08
+#define FELICA_RESPONSE_UPDATE													0x09
 
 /* code status	-------------------------------------------------------------------------- */
 #define ISO18092_SUCCESSCODE														RESULTOK
 #define ISO18092_ERRORCODE_DEFAULT											0xC1
+#define ISO18092_ERRORCODE_COLLISION										0xC2
+
+/* Polling command
+ * ----------------------------------------------------------------
+ * 1st byte	| 2nd, 3rd bytes | 4th byte     | 5th byte
+ * ----------------------------------------------------------------
+ *   '00'   | System code    | Request code | Time slot number
+ * ----------------------------------------------------------------
+ */
+#define FELICA_SYSTEMCODE_WILDCARD											0xFFFF
+#define FELICA_SYSTEMCODE_NDEF													0x12FC
+
+#define FELICA_REQUESTCODE_NONE													0x00
+#define FELICA_REQUESTCODE_SYSTEMCODE										0x01
+#define FELICA_REQUESTCODE_COMMUNICATIONPERFORMANCE			0x02
+
+/* the card answers in a slot chosen between 0 and the time slot number */
+#define FELICA_TIMESLOT_1																0x00
+#define FELICA_TIMESLOT_2																0x01
+#define FELICA_TIMESLOT_4																0x03
+#define FELICA_TIMESLOT_8																0x07
+#define FELICA_TIMESLOT_16															0x0F
+
+/* Polling response : '01' + IDm + PMm + Request data (request code different from 0) */
+#define FELICA_NBBYTE_IDM																UID_SIZE_FELICA
+#define FELICA_NBBYTE_PMM																8
+#define FELICA_NBBYTE_REQUESTDATA												2
+#define FELICA_NBBYTE_POLLINGRESPONSE										(1+FELICA_NBBYTE_IDM+FELICA_NBBYTE_PMM)
+
+/* communication performance (request data of the polling) */
+#define FELICA_COMMUNICATIONPERFORMANCE_424K						0x02
+
+/* bit rates of the PCD device */
+#define FELICA_BITRATE_212K															0x01
+#define FELICA_BITRATE_424K															0x02
+
+/* Check and Update commands
+ * ---------------------------------------------------------------------------------------------------
+ * Command code | IDm | Number of services ('01') | Service code (lsb first) | Number of blocks | Block list | (Block data)
+ * ---------------------------------------------------------------------------------------------------
+ * answer : Response code | IDm | Status flag 1 | Status flag 2 | (Number of blocks | Block data)
+ */
+#define FELICA_NBBYTE_BLOCK															16
+#define FELICA_NBBYTE_BLOCKCOMMANDHEADER								(1+FELICA_NBBYTE_IDM+1+2+1)
+#define FELICA_NBBYTE_CRC																2
+/* block list element : 2 bytes up to the block 255, 3 bytes above */
+#define FELICA_BLOCKLIST_2BYTES													0x80
+#define FELICA_BLOCKLIST_3BYTES													0x00
+#define FELICA_NBBYTE_MAXBLOCKLISTELEMENT								3
+/* offsets in the answer */
+#define FELICA_OFFSET_STATUSFLAG1												(1+FELICA_NBBYTE_IDM)
+#define FELICA_OFFSET_STATUSFLAG2												(FELICA_OFFSET_STATUSFLAG1+1)
+#define FELICA_OFFSET_NBBLOCK														(FELICA_OFFSET_STATUSFLAG2+1)
+#define FELICA_OFFSET_BLOCKDATA													(FELICA_OFFSET_NBBLOCK+1)
+/* blocks by exchange : the PCD device handles frames of 255 bytes */
+#define FELICA_MAX_NBBLOCK_CHECK												((RFTRANS_95HF_MAX_BUFFER_SIZE-FELICA_OFFSET_BLOCKDATA-FELICA_NBBYTE_CRC-CONTROL_FELICA_NBBYTE)/FELICA_NBBYTE_BLOCK)
+#define FELICA_MAX_NBBLOCK_UPDATE												((RFTRANS_95HF_MAX_BUFFER_SIZE-FELICA_NBBYTE_BLOCKCOMMANDHEADER)/(FELICA_NBBYTE_MAXBLOCKLISTELEMENT+FELICA_NBBYTE_BLOCK))
+
+/* guard time between the RF field on and the first polling (JIS X 6319-4, GTF of the NFC Forum) */
+#ifndef FELICA_GUARDTIME_MS
+	#define FELICA_GUARDTIME_MS														20
+#endif
+/* the PCD device only receives the first answer of a polling : the polling is sent again
+   (with a new slot chosen by each card) until this number of pollings brings no new card */
+#ifndef FELICA_POLLING_NBREPEAT
+	#define FELICA_POLLING_NBREPEAT												4
+#endif
+#ifndef FELICA_POLLING_MAXNBPOLLING
+	#define FELICA_POLLING_MAXNBPOLLING										16
+#endif
 
 typedef struct{
 	uint8_t ATQC[ATQC_SIZE];
 	uint8_t UID	[UID_SIZE_FELICA];
 	bool 		IsDetected;
 //	char		LogMsg[120];
+	/* bit rate of the PCD device (FELICA_BITRATE_xxx) */
+	uint8_t BitRate;
 }FELICA_CARD;
 
 //extern FELICA_CARD 	FELICA_Card;
 
+typedef struct{
+	uint8_t IDm[FELICA_NBBYTE_IDM];
+	uint8_t PMm[FELICA_NBBYTE_PMM];
+	/* system code or communication performance (0 when the request code is FELICA_REQUESTCODE_NONE) */
+	uint8_t RequestData[FELICA_NBBYTE_REQUESTDATA];
+}FELICA_TAGRECORD;
+
 /* ---------------------------------------------------------------------------------
  * --- Local Functions  
  * --------------------------------------------------------------------------------- */
 void 	 FELICA_Initialization( void );
+void 	 FELICA_InitializationGuardTime( uc8 FieldOnTime );
+int8_t FELICA_Polling			( uc16 SystemCode, uc8 RequestCode, uc8 TimeSlot, FELICA_TAGRECORD *pRecord, uc8 MaxNbTag, uint8_t *pNbTag );
+int8_t FELICA_Check				( uc8 *pIDm, uc16 ServiceCode, uc16 FirstBlock, uc16 NbBlock, uc8 MaxNbBlock, uint8_t *pDataRead );
+int8_t FELICA_Update				( uc8 *pIDm, uc16 ServiceCode, uc16 FirstBlock, uc16 NbBlock, uc8 MaxNbBlock, uc8 *pDataToWrite );
+int8_t FELICA_SelectMaxBitRate	( void );
+void 	 FELICA_SetMaxBitRate	( uc8 BitRate );
 int8_t FELICA_IsPresent		( void );
 int8_t FELICA_CardTest			( void );
 int8_t FELICA_Anticollision( void );
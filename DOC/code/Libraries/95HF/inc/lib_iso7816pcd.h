@@ -35,10 +35,63 @@
 #define ISO7816_IBLOCK02												0x02
 #define ISO7816_IBLOCK03												0x03
 
+/*  ISO-DEP (ISO14443-4) block layer ----------------------------------------------------------- */
+#define ISO7816_PCB_TYPEMASK										0xC0
+#define ISO7816_PCB_TYPE_I											0x00
+#define ISO7816_PCB_TYPE_R											0x80
+#define ISO7816_PCB_TYPE_S											0xC0
+#define ISO7816_PCB_BLOCKNUMBERMASK							0x01
+#define ISO7816_PCB_CHAININGMASK								0x10
+#define ISO7816_PCB_IBLOCK											0x02
+#define ISO7816_PCB_RACK												0xA2
+#define ISO7816_PCB_RNAK												0xB2
+#define ISO7816_PCB_SWTX												0xF2
+#define ISO7816_PCB_SDESELECT										0xC2
+#define ISO7816_WTXM_MASK												0x3F
+
+#define ISO7816_NBBYTE_PCB											1
+#define ISO7816_NBBYTE_CRC											2
+#define ISO7816_NBBYTE_HEADER										4
+#define ISO7816_NBBYTE_SW												2
+/* number of R-blocks sent to recover a frame before the exchange fails */
+#ifndef ISO7816_NBRETRY
+#define ISO7816_NBRETRY													2
+#endif
+/* number of S(WTX) accepted for one block */
+#ifndef ISO7816_MAX_NBWTX
+#define ISO7816_MAX_NBWTX												100
+#endif
+
+/* short APDU : header, LC, 255 data bytes, LE */
+#define ISO7816_MAX_COMMAND_SIZE								(ISO7816_NBBYTE_HEADER + 1 + 255 + 1)
+/* extended APDU : 0x00 followed by LC or LE on two bytes */
+#define ISO7816_NBBYTE_EXTENDEDLENGTH						3
+#define ISO7816_MAX_EXTENDEDLE									(0xFFFF - ISO7816_NBBYTE_SW)
+/* response : status and length of the PCD device, PCB, 256 data bytes, SW1 SW2 */
+#define ISO7816_RESPONSEOFFSET_DATA							(PCD_DATA_OFFSET + ISO7816_NBBYTE_PCB)
+#define ISO7816_MAX_RESPONSE_SIZE								(ISO7816_RESPONSEOFFSET_DATA + 256 + ISO7816_NBBYTE_SW)
+
+/* historical bytes : compact-TLV objects (followed by 3 status bytes for the category 0x00) */
+#define ISO7816_CATEGORY_COMPACTTLV							0x80
+#define ISO7816_CATEGORY_COMPACTTLVSTATUS				0x00
+#define ISO7816_NBBYTE_STATUSINDICATOR					3
+#define ISO7816_TAG_CARDCAPABILITIES						0x07
+#define ISO7816_NBBYTE_CARDCAPABILITIES					3
+/* third software function table : extended LC and LE fields */
+#define ISO7816_EXTENDEDLENGTH_MASK							0x40
+
+/* status words (SW1 SW2) */
+#define ISO7816_SW_NONE													0x0000		// no response (transmission error)
+#define ISO7816_SW_SUCCESS											0x9000
+#define ISO7816_SW_NOCURRENTEF									0x6986		// command not allowed, no current EF
+#define ISO7816_SW_FILENOTFOUND									0x6A82		// file or application not found
+
 #define ISO7816_SELECT_FILE     								0xA4
 #define ISO7816_UPDATE_BINARY   								0xD6
 #define ISO7816_READ_BINARY     								0xB0
 
+#define ISO7816_EXTENDEDLENGTH									0x00
+
 #define ISO7816_CLASS_0X00											0x00
 #define ISO7816_CLASS_STM												0xA2
 
@@ -86,6 +139,13 @@ typedef struct
 int8_t 	ISO7816_SelectFile 	( uc8 P1byte , uc8 P2byte , uc8 LCbyte , uint8_t *PData );
 int8_t 	ISO7816_ReadBinary		( uc8 P1byte , uc8 P2byte , uc8 LEbyte , uint8_t *pDataRead );
 int8_t 	ISO7816_UpdateBinary	( uc8 P1byte , uc8 P2byte , uc8 LCbyte , uint8_t *pData);
+int8_t 	ISO7816_Transceive		( uc8 *pCommand , uc16 CommandLength , uint8_t *pResponse , uint16_t *pResponseLength , uc16 MaxResponseLength );
+void 		ISO7816_ResetBlockNumber	( void );
+int8_t 	ISO7816_ReadBinaryExtended		( uc8 P1byte , uc8 P2byte , uc16 LE , uint8_t *pDataRead , uint16_t *pNbByteRead );
+int8_t 	ISO7816_UpdateBinaryExtended	( uc8 P1byte , uc8 P2byte , uc16 LC , uc8 *pData );
+bool 		ISO7816_IsExtendedLengthSupported	( void );
+uint16_t ISO7816_GetStatusWord					( void );
+int8_t 	ISO7816_Deselect								( void );
 
 
 #endif /* __SMARTCARD_H */
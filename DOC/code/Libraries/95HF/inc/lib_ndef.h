@@ -0,0 +1,173 @@
+/**
+  ******************************************************************************
+  * @file    lib_ndef.h
+  * @author  MMY Application Team
+  * @version V4.0.0
+  * @date    02/06/2014
+  * @brief   NDEF message parser (records are returned as views on the tag buffer)
+  ******************************************************************************
+  * @copyright
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LIB_NDEF_H
+#define __LIB_NDEF_H
+
+#include "lib_pcd.h"
+
+/* success and error code --------------------------------------------------------------------- */
+#define NDEF_SUCCESSCODE												RESULTOK
+#define NDEF_ERRORCODE_DEFAULT									0x55
+#define NDEF_ERRORCODE_FORMAT										0x56		// the message is not a valid NDEF message
+#define NDEF_ERRORCODE_END											0x57		// no more record
+#define NDEF_ERRORCODE_NEEDDATA									0x58		// the stream needs more bytes
+#define NDEF_ERRORCODE_OVERFLOW									0x59		// the type and ID of a record are too long for the stream
+#define NDEF_ERRORCODE_TYPE											0x5A		// the record is not of the requested type
+
+/* record header (1st byte)
+ * --------------------------------------------------------------------
+ *  MB (1 bit) | ME (1 bit) | CF (1 bit) | SR (1 bit) | IL (1 bit) | TNF (3 bits)
+ * --------------------------------------------------------------------
+ */
+#define NDEF_HEADER_MB													0x80
+#define NDEF_HEADER_ME													0x40
+#define NDEF_HEADER_CF													0x20
+#define NDEF_HEADER_SR													0x10
+#define NDEF_HEADER_IL													0x08
+#define NDEF_HEADER_TNF_MASK										0x07
+
+/* Type Name Format */
+#define NDEF_TNF_EMPTY													0x00
+#define NDEF_TNF_WELLKNOWN											0x01
+#define NDEF_TNF_MEDIA													0x02
+#define NDEF_TNF_URI														0x03
+#define NDEF_TNF_EXTERNAL												0x04
+#define NDEF_TNF_UNKNOWN												0x05
+#define NDEF_TNF_UNCHANGED											0x06
+
+/* well-known types */
+#define NDEF_RTD_URI														"U"
+#define NDEF_RTD_TEXT														"T"
+#define NDEF_RTD_SMARTPOSTER										"Sp"
+
+/* Text record status byte */
+#define NDEF_TEXT_UTF16													0x80
+#define NDEF_TEXT_LANGUAGE_MASK									0x3F
+
+/* TLV of the Type 1, 2 and 5 tags */
+#define NDEF_TLV_NULL														0x00
+#define NDEF_TLV_MESSAGE												0x03
+#define NDEF_TLV_TERMINATOR											0xFE
+
+/* largest type + ID of a record parsed by a stream (they are copied in the stream) */
+#ifndef NDEF_STREAM_MAX_TYPEID
+	#define NDEF_STREAM_MAX_TYPEID								64
+#endif
+
+/* record view : the pointers address the parsed buffer, nothing is copied */
+typedef struct {
+	uint8_t			Header;						// MB ME CF SR IL TNF
+	uint8_t			TNF;							// TNF of the record (of the first chunk for a chunked record)
+	uint8_t			TypeLength;
+	uc8					*pType;
+	uint8_t			IDLength;
+	uc8					*pID;
+	uint32_t		PayloadLength;		// payload of this record (of this chunk for a chunked record)
+	uc8					*pPayload;
+}NDEF_RECORD;
+
+typedef struct {
+	uc8					*pMessage;
+	uint32_t		Length;
+	uint32_t		Offset;
+	bool				InChunk;					// a chunked record is being parsed
+	uint8_t			ChunkTNF;					// type of the first chunk
+	uint8_t			ChunkTypeLength;
+	uc8					*pChunkType;
+}NDEF_ITERATOR;
+
+/* stream parser events */
+#define NDEF_EVENT_RECORD												0x01		// header of a record (Record is valid, pType/pID point in the stream)
+#define NDEF_EVENT_PAYLOAD											0x02		// part of the payload of the current record
+#define NDEF_EVENT_END													0x03		// last record of the message done
+
+typedef struct {
+	uint8_t			Event;						// NDEF_EVENT_xxx
+	NDEF_RECORD	Record;						// header of the current record
+	uc8					*pData;						// NDEF_EVENT_PAYLOAD : part of the payload (in the fed buffer)
+	uint16_t		DataLength;
+	bool				LastData;					// NDEF_EVENT_PAYLOAD : end of the payload of the record
+}NDEF_STREAMEVENT;
+
+typedef struct {
+	uc8					*pData;						// bytes fed and not yet parsed
+	uint16_t		DataLength;
+	uint8_t			State;						// internal
+	uint8_t			Header;
+	uint8_t			NbByte;						// bytes of the current field already received
+	uint8_t			PayloadLengthField[4];
+	uint8_t			TypeLength;
+	uint8_t			IDLength;
+	uint32_t		PayloadLength;
+	uint32_t		PayloadLeft;
+	uint8_t			TypeID[NDEF_STREAM_MAX_TYPEID];	// type and ID (kept for the following chunks of a chunked record)
+	bool				InChunk;
+	uint8_t			ChunkTNF;
+	uint8_t			ChunkTypeLength;
+}NDEF_STREAM;
+
+/* well-known types views */
+typedef struct {
+	const char	*pPrefix;					// from the URI identifier code (ROM table, "" if none)
+	uint8_t			PrefixLength;
+	uc8					*pURI;						// rest of the URI (payload)
+	uint32_t		URILength;
+}NDEF_URI;
+
+typedef struct {
+	bool				UTF16;
+	uc8					*pLanguage;
+	uint8_t			LanguageLength;
+	uc8					*pText;
+	uint32_t		TextLength;
+}NDEF_TEXT;
+
+/* parser benchmark */
+typedef struct {
+	uint32_t 	NbRecord;					// records parsed by all the loops
+	uint32_t 	NbByte;						// bytes parsed by all the loops
+	uint32_t 	Duration;					// ms (0 if NDEF_GetTick_ms is not set)
+	uint32_t 	BytesPerSecond;		// 0 if the duration is unknown
+}NDEF_BENCHSTAT;
+
+extern uint32_t (*NDEF_GetTick_ms)(void);
+
+/* ---------------------------------------------------------------------------------
+ * --- Local Functions
+ * --------------------------------------------------------------------------------- */
+int8_t NDEF_FindMessageTLV							( uc8 *pTLV, uc32 Length, uc8 **ppMessage, uint32_t *pMessageLength);
+void NDEF_IteratorInit									( NDEF_ITERATOR *pIterator, uc8 *pMessage, uc32 Length);
+int8_t NDEF_NextRecord									( NDEF_ITERATOR *pIterator, NDEF_RECORD *pRecord);
+
+void NDEF_StreamInit										( NDEF_STREAM *pStream);
+void NDEF_StreamFeed										( NDEF_STREAM *pStream, uc8 *pData, uc16 Length);
+int8_t NDEF_StreamNext									( NDEF_STREAM *pStream, NDEF_STREAMEVENT *pEvent);
+
+bool NDEF_IsWellKnown										( const NDEF_RECORD *pRecord, const char *pType);
+int8_t NDEF_GetURI											( const NDEF_RECORD *pRecord, NDEF_URI *pURI);
+int8_t NDEF_GetText											( const NDEF_RECORD *pRecord, NDEF_TEXT *pText);
+int8_t NDEF_GetSmartPoster							( const NDEF_RECORD *pRecord, NDEF_URI *pURI, NDEF_TEXT *pTitle);
+
+int8_t NDEF_Benchmark										( uc8 *pMessage, uc32 Length, uc16 NbLoop, NDEF_BENCHSTAT *pStat);
+
+#endif /* __LIB_NDEF_H */
+
+/******************* (C) COPYRIGHT 2014 STMicroelectronics *****END OF FILE****/
@@ -31,7 +31,9 @@
 
 /* Command List */
 #define PCDNFCT1_READALL						0x00
+#define PCDNFCT1_RSEG								0x10
 #define PCDNFCT1_WRITE_E						0x53
+#define PCDNFCT1_WRITE_E8						0x54
 
 /* Mask */
 #define PCDNFCT1_NDEF_CAPABLE_MSK 	0xF0
@@ -41,12 +43,51 @@
 #define PCDNFCT1_TLV_LOCK 					0x01
 #define PCDNFCT1_TLV_MEM	 					0x02
 #define PCDNFCT1_TLV_NDEF	 					0x03
+#define PCDNFCT1_TLV_PROPRIETARY		0xFD
+#define PCDNFCT1_TLV_TERMINATOR			0xFE
+#define PCDNFCT1_TLV_LONGLENGTH			0xFF
+/* Lock/Memory control TLV value : position (page address, byte offset), size, page size (2^n bytes) */
+#define PCDNFCT1_TLV_CONTROL_LENGTH	3
+#define PCDNFCT1_PAGEADDRESS(V0)		((V0) >> 4)
+#define PCDNFCT1_BYTEOFFSET(V0)			((V0) & 0x0F)
+#define PCDNFCT1_BYTESPERPAGE(V2)		(1 << ((V2) & 0x0F))
+#define PCDNFCT1_CONTROLSIZE(V1)		(((V1) == 0) ? 256 : (V1))
 
 #define PCDNFCT1_NDEF_MNB						0xE1
 #define PCDNFCT1_NDEF_DISABLE				0x00
 
 #define PCDNFCT1_TOPAZ_MODE					0xA8
 
+/* Header ROM : HR0 = 0x11 for the static memory (Topaz 96), 0x12 for the dynamic memory (Topaz 512) */
+#define PCDNFCT1_HR0_STATIC					0x11
+
+/* Memory map */
+#define PCDNFCT1_NBBYTE_BLOCK				8
+#define PCDNFCT1_NBBYTE_SEGMENT			128
+#define PCDNFCT1_NBBYTE_STATICMEMORY	120
+#define PCDNFCT1_NMN_ADDRESS				8
+#define PCDNFCT1_TMS_ADDRESS				10
+#define PCDNFCT1_DATA_ADDRESS				12
+/* blocks 0x0D to 0x0F : reserved and lock bytes of the static area */
+#define PCDNFCT1_RESERVED_ADDRESS		0x68
+/* WRITE-E only addresses the bytes of the first segment */
+#define PCDNFCT1_MAX_WRITEE_ADDRESS	0x7F
+#define PCDNFCT1_MEMORYSIZE(TMS)		(((TMS) + 1) * PCDNFCT1_NBBYTE_BLOCK)
+
+/* memory read at once (Topaz 512 by default) */
+#ifndef PCDNFCT1_MAX_MEMORYSIZE
+	#define PCDNFCT1_MAX_MEMORYSIZE		512
+#endif
+/* lock and reserved areas given by the Lock/Memory control TLVs */
+#ifndef PCDNFCT1_MAX_NBAREA
+	#define PCDNFCT1_MAX_NBAREA				4
+#endif
+
+typedef struct{
+	uint16_t Address;
+	uint16_t Size;
+}PCDNFCT1_AREA;
+
 /* Functions */
 uint8_t PCDNFCT1_ReadNDEF( void );
 uint8_t PCDNFCT1_WriteNDEF( void );
@@ -21,6 +21,7 @@
 #define _LIB_NFCTYPE2PCD_H
 
 #include "lib_pcd.h"
+#include "lib_iso14443Apcd.h"
 
 /* Error codes */
 #define PCDNFCT2_OK 											PCDNFC_OK
@@ -34,11 +35,43 @@
 #define PCDNFCT2_READ								0x30
 #define PCDNFCT2_WRITE							0xA2
 #define PCDNFCT2_SECTOR_SEL					0xC2
+#define PCDNFCT2_COMPATIBILITY_WRITE	0xA0
+/* NXP NTAG2xx and Ultralight EV1 commands */
+#define PCDNFCT2_GET_VERSION				0x60
+#define PCDNFCT2_FAST_READ					0x3A
+#define PCDNFCT2_READ_SIG						0x3C
 
 /* Size */
 #define PCDNFCT2_READ_SIZE					16
 #define PCDNFCT2_READ_SIZE_BUFFER		18
 #define PCDNFCT2_SECTOR_SIZE				1024
+#define PCDNFCT2_BLOCK_SIZE					4
+#define PCDNFCT2_DATA_ADDRESS				16
+#define PCDNFCT2_NBBYTE_CRC					2
+#define PCDNFCT2_VERSION_SIZE				8
+#define PCDNFCT2_SIGNATURE_SIZE			32
+/* pages of a FAST_READ answer received by the PCD device (with the CRC and the control bytes) */
+#define PCDNFCT2_FASTREAD_MAX_NBPAGE	((RFTRANS_95HF_MAX_BUFFER_SIZE-PCDNFCT2_NBBYTE_CRC-ISO14443A_NBBYTE)/PCDNFCT2_BLOCK_SIZE)
+#define PCDNFCT2_FASTREAD_MAX_SIZE		(PCDNFCT2_FASTREAD_MAX_NBPAGE*PCDNFCT2_BLOCK_SIZE)
+
+/* GET_VERSION answer : header, vendor ID, product type, ... */
+#define PCDNFCT2_VERSION_VENDOR			1
+#define PCDNFCT2_VERSION_TYPE				2
+#define PCDNFCT2_VENDOR_NXP					0x04
+#define PCDNFCT2_TYPE_ULTRALIGHT		0x03
+#define PCDNFCT2_TYPE_NTAG					0x04
+
+/* ACK/NAK : 4-bit answer of the tag */
+#define PCDNFCT2_RESULTSCODE_4BITS	0x90
+#define PCDNFCT2_ACK								0x0A
+#define PCDNFCT2_ACKNAK_MSK					0x0F
+
+/* the ACK of a WRITE is waited within the time out of the PCD device (ISO14443A_DEFAULT_PP/MM,
+   about 100 ms) which covers the programming time of the tags (4.1 ms for the NXP tags).
+   This delay is only waited before the COMPATIBILITY_WRITE sent when a WRITE is not acknowledged */
+#ifndef PCDNFCT2_WRITE_DELAY_MS
+	#define PCDNFCT2_WRITE_DELAY_MS		5
+#endif
 
 /* Mask */
 #define PCDNFCT2_READ_MSK						0xF0
@@ -49,11 +82,35 @@
 #define PCDNFCT2_TLV_LOCK 					0x01
 #define PCDNFCT2_TLV_MEM	 					0x02
 #define PCDNFCT2_TLV_NDEF	 					0x03
+#define PCDNFCT2_TLV_PROPRIETARY		0xFD
+#define PCDNFCT2_TLV_TERMINATOR			0xFE
+#define PCDNFCT2_TLV_LONGLENGTH			0xFF
+#define PCDNFCT2_TLV_CONTROL_LENGTH	3
+
+/* Lock and Memory control TLV : position of the area and number of lock bits or reserved bytes */
+#define PCDNFCT2_PAGEADDRESS(V0)		((V0) >> 4)
+#define PCDNFCT2_BYTEOFFSET(V0)			((V0) & 0x0F)
+#define PCDNFCT2_BYTESPERPAGE(V2)		(1 << ((V2) & 0x0F))
+#define PCDNFCT2_CONTROLSIZE(V1)		((V1) == 0 ? 256 : (V1))
+
+/* number of lock and reserved areas of the data area handled */
+#ifndef PCDNFCT2_MAX_NBAREA
+	#define PCDNFCT2_MAX_NBAREA				4
+#endif
 
 #define PCDNFCT2_NDEF_MNB						0xE1
 
+typedef struct{
+	uint16_t Address;
+	uint16_t Size;
+}PCDNFCT2_AREA;
+
 /* Functions */
 uint8_t PCDNFCT2_ReadNDEF( void );
 uint8_t PCDNFCT2_WriteNDEF( void );
+uint8_t PCDNFCT2_LockNDEF( void );
+uint8_t PCDNFCT2_GetVersion( uint8_t *pVersion );
+uint8_t PCDNFCT2_ReadSignature( uint8_t *pSignature );
+void PCDNFCT2_SetWriteDelay( uc8 Delay_ms );
 
 #endif
@@ -39,10 +39,19 @@
 #define PCDNFCT3_CODE_WRITE_LSB			0x09
 #define PCDNFCT3_FIRST_BLOC_MSB			0x80
 #define PCDNFCT3_FIRST_BLOC_LSB			0x00
+#define PCDNFCT3_SERVICECODE_READ		((PCDNFCT3_CODE_READ_MSB<<8)|PCDNFCT3_CODE_READ_LSB)
+#define PCDNFCT3_SERVICECODE_WRITE	((PCDNFCT3_CODE_WRITE_MSB<<8)|PCDNFCT3_CODE_WRITE_LSB)
+
+/* Blocks : AttribInfo then NDEF message */
+#define PCDNFCT3_ATTR_BLOC					0
+#define PCDNFCT3_FIRST_NDEF_BLOC		1
+#define PCDNFCT3_NBBLOC(NbByte)			(((NbByte)+FELICA_NBBYTE_BLOCK-1)/FELICA_NBBYTE_BLOCK)
 
 /* Flag */
 #define PCDNFCT3_WRITE_ON						0x0F
 #define PCDNFCT3_WRITE_OFF					0x00
+#define PCDNFCT3_RWFLAG_READONLY		0x00
+#define PCDNFCT3_RWFLAG_READWRITE		0x01
 
 /* Size */
 #define PCDNFCT3_ATTR_SIZE					16
@@ -50,5 +59,6 @@
 /* Functions */
 uint8_t PCDNFCT3_ReadNDEF( void );
 uint8_t PCDNFCT3_WriteNDEF( void );
+uint8_t PCDNFCT3_LockNDEF( void );
 
 #endif
@@ -33,11 +33,37 @@
 #define PCDNFCT4_CC_ID							{0xE1,0x03}
 
 /* Size */
-#define PCDNFCT4_BUFFER_READ				256
+#define PCDNFCT4_BUFFER_READ				ISO7816_MAX_RESPONSE_SIZE
+/* largest read and write binary of a short APDU (the frames are chained by the ISO-DEP layer) */
+#define PCDNFCT4_MAX_MLE						0xFF
+#define PCDNFCT4_MAX_MLC						0xFF
+
+/* number of identical bytes which ends a run of bytes to update in a differential write */
+#ifndef PCDNFCT4_DIFF_GAP
+	#define PCDNFCT4_DIFF_GAP					8
+#endif
 
 #define PCDNFCT4_ACCESS_ALLOWED			0x00
 
+/* no file selected in a session */
+#define PCDNFCT4_NOFILE							0x0000
+
+/* session : the NDEF application and a file stay selected between the commands */
+typedef struct{
+	bool 						IsOpen;
+	uint16_t 				SelectedFile;		// file selected on the tag (PCDNFCT4_NOFILE when unknown)
+	uint16_t 				MLe;						// largest read binary of the session
+	uint16_t 				MLc;						// largest update binary of the session
+	bool 						ExtendedLength;	// extended LC field used by the update binary commands
+	PCDNFC_CCINFO 	CC;							// CC file of the tag
+}PCDNFCT4_SESSION;
+
 uint8_t PCDNFCT4_ReadNDEF(void);
 uint8_t PCDNFCT4_WriteNDEF( void );
 
+uint8_t PCDNFCT4_OpenSession( void );
+void PCDNFCT4_CloseSession( void );
+uint8_t PCDNFCT4_SessionReadBinary( uc16 FileID, uc16 Offset, uc16 NbByteToRead, uint8_t *pBufferRead );
+uint8_t PCDNFCT4_SessionUpdateBinary( uc16 FileID, uc16 Offset, uc16 NbByteToWrite, uint8_t *pBufferWrite );
+
 #endif
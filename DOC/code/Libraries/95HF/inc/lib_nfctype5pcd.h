@@ -31,8 +31,35 @@
 #define PCDNFCT5_ERROR_LOCKED 						PCDNFC_ERROR_LOCKED
 #define PCDNFCT5_ERROR_NOT_FORMATED				PCDNFC_ERROR_NOT_FORMATED
 
+/* Memory layout */
+#define PCDNFCT5_NBBLOCK_SECTOR						32
+#define PCDNFCT5_NBBYTE_SECTOR						(PCDNFCT5_NBBLOCK_SECTOR*ISO15693_NBBYTE_BLOCKLENGTH)
+
+/* Capability container (the NDEF TLV follows the CC) */
+#define PCDNFCT5_CC_MAGIC									0xE1		// 1 byte block address
+#define PCDNFCT5_CC_MAGIC_EXTENDED				0xE2		// 2 bytes block address (extended commands)
+#define PCDNFCT5_NBBYTE_CC								4
+#define PCDNFCT5_NBBYTE_EXTENDEDCC				8				// CC2 = 0 : the memory size is in CC6-CC7
+#define PCDNFCT5_CC_READACCESS_MASK				0x0C
+#define PCDNFCT5_CC_WRITEACCESS_MASK			0x03
+#define PCDNFCT5_CC_WRITEACCESS_NEVER			0x03
+#define PCDNFCT5_CC_ACCESS_MASK						0x0F
+#define PCDNFCT5_CC_MBREAD								0x01		// CC3 : Read Multiple supported
+#define PCDNFCT5_CC_LARGEMEMORY						0x04		// CC3 (4 bytes CC) : memory above 2 KB, size given by Get System Info
+#define PCDNFCT5_CC_MAX_MEMORYSIZE				2040		// largest memory size of a 4 bytes CC
+/* size of the CC of a buffer starting with a CC */
+#define PCDNFCT5_CCSIZE(pCC)							(((pCC)[2] == 0x00)? PCDNFCT5_NBBYTE_EXTENDEDCC : PCDNFCT5_NBBYTE_CC)
+
+typedef struct {
+	uint8_t 	NbByteCC;				// PCDNFCT5_NBBYTE_CC or PCDNFCT5_NBBYTE_EXTENDEDCC
+	uint8_t 	Access;					// CC1 : version and access conditions
+	uint8_t 	Flags;					// PCDNFC_CC_EXTENDEDCMD
+	uint32_t 	MemorySize;			// size of the data area (bytes)
+}PCDNFCT5_CC;
+
 /* Functions */
 uint8_t PCDNFCT5_ReadNDEF( void );
 uint8_t PCDNFCT5_WriteNDEF( void );
+uint8_t PCDNFCT5_LockNDEF( void );
 
 #endif
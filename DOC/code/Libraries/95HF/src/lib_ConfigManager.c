@@ -43,6 +43,9 @@ static void ConfigManager_Init( void);
 static int8_t ConfigManager_IDN(uint8_t *pResponse);
 static void ConfigManager_Start(void );
 static int8_t ConfigManager_PORsequence( void );
+static void ConfigManager_GuardTime( uint8_t *pFieldOnTime, uc8 GuardTime );
+static uint8_t ConfigManager_PollTechno( uc8 Techno, uc8 tagsToFind, uint8_t *pFieldOnTime );
+static uint8_t ConfigManager_PollLoop( uc8 tagsToFind, bool StopOnFirstTag, uint8_t FieldOnTime );
 
 /** @addtogroup lib_ConfigManager_Private_Functions
  * 	@{
@@ -59,6 +62,10 @@ bool		uAppliTimeOut;
 uint8_t TagUID[16];
 
 bool 	StopProcess = false;
+
+/* polling order of the discovery loop, the last technology detected is moved first */
+static uint8_t ConfigManager_TechnoOrder[CONFIGMANAGER_NBTECHNO] = {CONFIGMANAGER_TECHNO_A, CONFIGMANAGER_TECHNO_F, 
+																																		CONFIGMANAGER_TECHNO_B, CONFIGMANAGER_TECHNO_V};
 PICCEMULATOR_SELECT_TAG_TYPE commandReceived = PICCEMULATOR_TAG_TYPE_UNKNOWN;
 
 
@@ -153,6 +160,135 @@ static int8_t ConfigManager_PORsequence( void )
 	return MANAGER_ERRORCODE_PORERROR;
 }
 
+/**
+ *	@brief  This function waits for the end of a guard time counted from the RF field on
+ *  @param  pFieldOnTime : time (ms) already spent since the RF field was switched on, updated
+ *  @param  GuardTime : guard time (ms) of the technology
+ *  @retval none
+ */
+static void ConfigManager_GuardTime( uint8_t *pFieldOnTime, uc8 GuardTime )
+{
+	if (*pFieldOnTime < GuardTime)
+	{
+		delay_ms(GuardTime - *pFieldOnTime);
+		*pFieldOnTime = GuardTime;
+	}
+}
+
+/**
+ *	@brief  This function polls one technology. The RF field is kept on, so the guard time is only 
+ *  @brief  waited for the part not yet spent since the field was switched on.
+ *  @param  Techno : technology to poll (CONFIGMANAGER_TECHNO_xxx)
+ *  @param  tagsToFind : Flags to select the different kinds of tag to track
+ *  @param  pFieldOnTime : time (ms) already spent since the RF field was switched on, updated
+ *  @retval TRACK_NOTHING : No tag of this technology
+ *  @retval TRACK_NFCTYPEx : the kind of tag found
+ */
+static uint8_t ConfigManager_PollTechno( uc8 Techno, uc8 tagsToFind, uint8_t *pFieldOnTime )
+{
+	int8_t status;
+
+	switch (Techno)
+	{
+		/*******NFC type 1, 2 and 4A ********/
+		case CONFIGMANAGER_TECHNO_A:
+			if ((tagsToFind&(TRACK_NFCTYPE1|TRACK_NFCTYPE2|TRACK_NFCTYPE4A)) == 0)
+				break;
+			ISO14443A_Init( );
+			ConfigManager_GuardTime(pFieldOnTime, CONFIGMANAGER_GUARDTIME_MS);
+			if(ISO14443A_IsPresent() != RESULTOK)
+				break;
+			if (tagsToFind&TRACK_NFCTYPE1)
+			{
+				if(TOPAZ_ID(TagUID) == RESULTOK)
+					return TRACK_NFCTYPE1;
+				/* the NFC-A tag went back to idle state with the RID command */
+				if(ISO14443A_IsPresent() != RESULTOK)
+					break;
+			}
+			if ((tagsToFind&(TRACK_NFCTYPE2|TRACK_NFCTYPE4A)) && ISO14443A_Anticollision() == RESULTOK)
+			{	
+				if (ISO14443A_Card.SAK == 0x00 && tagsToFind&TRACK_NFCTYPE2) /* TT2 */
+					return TRACK_NFCTYPE2;
+				else if (ISO14443A_Card.SAK != 0x00 && tagsToFind&TRACK_NFCTYPE4A)/* TT4A */
+					return TRACK_NFCTYPE4A;
+			}
+			break;
+		
+		/*******NFC type 3 ********/
+		case CONFIGMANAGER_TECHNO_F:
+			if ((tagsToFind&TRACK_NFCTYPE3) == 0)
+				break;
+			FELICA_InitializationGuardTime(*pFieldOnTime);
+			*pFieldOnTime = MAX(*pFieldOnTime, FELICA_GUARDTIME_MS);
+			if(FELICA_IsPresent() == RESULTOK )
+				return TRACK_NFCTYPE3;
+			break;
+		
+		/*******NFC type 4B ********/
+		case CONFIGMANAGER_TECHNO_B:
+			if ((tagsToFind&TRACK_NFCTYPE4B) == 0)
+				break;
+			status = ISO14443B_IsPresentGuardTime(*pFieldOnTime);
+			*pFieldOnTime = MAX(*pFieldOnTime, ISO14443B_GUARDTIME_MS);
+			if(status == RESULTOK )
+			{
+				delay_us (50);
+				if(ISO14443B_Anticollision() == RESULTOK)
+					return TRACK_NFCTYPE4B;
+			}
+			break;
+		
+		/*******ISO15693 ********/
+		case CONFIGMANAGER_TECHNO_V:
+			if ((tagsToFind&TRACK_NFCTYPE5) == 0)
+				break;
+			ISO15693_Init( );
+			ConfigManager_GuardTime(pFieldOnTime, CONFIGMANAGER_GUARDTIME_MS);
+			if(ISO15693_GetUID (TagUID) == RESULTOK)	
+				return TRACK_NFCTYPE5;
+			break;
+		
+		default:
+			break;
+	}
+	
+	return TRACK_NOTHING;
+}
+
+/**
+ *	@brief  This function polls the technologies selected in the discovery order
+ *  @param  tagsToFind : Flags to select the different kinds of tag to track
+ *  @param  StopOnFirstTag : true to stop on the first tag found
+ *  @param  FieldOnTime : time (ms) already spent since the RF field was switched on
+ *  @retval TRACK_NOTHING : No tag in the RF field
+ *  @retval TRACK_NFCTYPEx : flags of the kinds of tag present in the RF field
+ */
+static uint8_t ConfigManager_PollLoop( uc8 tagsToFind, bool StopOnFirstTag, uint8_t FieldOnTime )
+{
+	uint8_t tagsFound = TRACK_NOTHING,
+					tagFound,
+					Techno,
+					i;
+	
+	for (i=0; i<CONFIGMANAGER_NBTECHNO && !StopProcess; i++)
+	{
+		Techno = ConfigManager_TechnoOrder[i];
+		tagFound = ConfigManager_PollTechno(Techno, tagsToFind, &FieldOnTime);
+		if (tagFound == TRACK_NOTHING)
+			continue;
+		
+		tagsFound |= tagFound;
+		/* this technology is polled first next time */
+		memmove(&ConfigManager_TechnoOrder[1], &ConfigManager_TechnoOrder[0], i);
+		ConfigManager_TechnoOrder[0] = Techno;
+		if (StopOnFirstTag == true)
+			break;
+	}
+	
+	return tagsFound;
+}
+
 
 /**
   * @}
@@ -269,83 +405,53 @@ void ConfigManager_AutoMode (MANAGER_CONFIG *pManagerConfig)
 */
 uint8_t ConfigManager_TagHunting ( uint8_t tagsToFind )
 {
+	return ConfigManager_Discovery(tagsToFind, true);
+}
+
+/**  
+* @brief  	this function polls the technologies selected in one RF field on cycle. The field is reset 
+* @brief  	once, then kept on when switching from a technology to the next one : the guard time 
+* @brief  	counted from the field on is only waited once (and completed for NFC-F).
+* @brief  	The last technology detected is polled first by the next discovery loops.
+* @param  	tagsToFind : Flags to select the different kinds of tag to track, same as return value
+* @param  	StopOnFirstTag : true to stop on the first tag found, the tag stays activated.
+* @param  	                 false to poll every technology (the last tag found stays activated)
+* @retval 	TRACK_NOTHING : No tag in the RF field
+* @retval 	TRACK_NFCTYPEx : flags of the kinds of tag present in the RF field
+*/
+uint8_t ConfigManager_Discovery ( uint8_t tagsToFind, bool StopOnFirstTag )
+{
+	uint8_t tagsFound;
+	
 	ConfigManager_Start();
 	
-	/*******NFC type 1 ********/
-	if (tagsToFind&TRACK_NFCTYPE1)
-	{
-		PCD_FieldOff();
-		delay_ms(5);
-		PCD_FieldOn();
-		ISO14443A_Init( );
-		delay_ms(5);
-		if(ISO14443A_IsPresent() == RESULTOK)
-		{		
-			if(TOPAZ_ID(TagUID) == RESULTOK)
-				return TRACK_NFCTYPE1;	
-		}
-	}
-	/*******NFC type 2 and 4A ********/
-	if ((tagsToFind&TRACK_NFCTYPE2) || (tagsToFind&TRACK_NFCTYPE4A))
-	{
-		PCD_FieldOff();
-		delay_ms(5);
-		PCD_FieldOn();
-		ISO14443A_Init( );
-		delay_ms(5);
-		if(ISO14443A_IsPresent() == RESULTOK)
-		{			
-			if(ISO14443A_Anticollision() == RESULTOK)
-			{	
-				if (ISO14443A_Card.SAK == 0x00 && tagsToFind&TRACK_NFCTYPE2) /* TT2 */
-					return TRACK_NFCTYPE2;
-				else if (ISO14443A_Card.SAK != 0x00 && tagsToFind&TRACK_NFCTYPE4A)/* TT4A */
-					return TRACK_NFCTYPE4A;
-			}
-		}
-	}
-	/*******NFC type 3 ********/
-	if (tagsToFind&TRACK_NFCTYPE3)
-	{
-		PCD_FieldOff();
-		delay_ms(5);
-		PCD_FieldOn();
-		delay_ms(5);
-		FELICA_Initialization();
-		if(FELICA_IsPresent() == RESULTOK )
-			return TRACK_NFCTYPE3;
-	}
-	/*******NFC type 4B ********/
-	if (tagsToFind&TRACK_NFCTYPE4B)
-	{
-		PCD_FieldOff();
-		delay_ms(5);
-		PCD_FieldOn();
-		delay_ms(5);
-		if(ISO14443B_IsPresent() == RESULTOK )
-		{
-			delay_us (50);
-			if(ISO14443B_Anticollision() == RESULTOK)
-			{
-				return TRACK_NFCTYPE4B;
-			}
-		}
-	}
-	/*******ISO15693 ********/
-	if (tagsToFind&TRACK_NFCTYPE5)
-	{
+	/* reset of the tags, the first protocol select switches the field on */
+	PCD_FieldOff();
+	delay_ms(CONFIGMANAGER_FIELDOFF_MS);
+	
+	tagsFound = ConfigManager_PollLoop(tagsToFind, StopOnFirstTag, 0);
+	
+	if (tagsFound == TRACK_NOTHING)
 		PCD_FieldOff();
-		delay_ms(5);
-		PCD_FieldOn();
-		delay_ms(5);
-		if(ISO15693_GetUID (TagUID) == RESULTOK)	
-			return TRACK_NFCTYPE5;
-	}
 	
-	PCD_FieldOff();
+	return tagsFound;
+}
+
+/**  
+* @brief  	this function looks for the next tag without resetting the RF field : the field stays on 
+* @brief  	and no guard time is waited. The tags already activated are not reset, a tag 
+* @brief  	entering the field is powered by the field while it comes in.
+* @brief  	It chains the tags of a production line after a first ConfigManager_Discovery.
+* @param  	tagsToFind : Flags to select the different kinds of tag to track, same as return value
+* @retval 	TRACK_NOTHING : No tag in the RF field
+* @retval 	TRACK_NFCTYPEx : the kind of tag found, the tag stays activated
+*/
+uint8_t ConfigManager_Poll ( uint8_t tagsToFind )
+{
+	ConfigManager_Start();
 	
-	/* No tag found */
-	return TRACK_NOTHING;
+	/* the field is on for longer than the guard times */
+	return ConfigManager_PollLoop(tagsToFind, true, 0xFF);
 }
 
 
@@ -30,6 +30,16 @@ extern ST95Mode st95mode;
 extern ST95TagType st95tagtype;
 
 static uint8_t IsAnAvailableProtocol 		(uint8_t Protocol);
+static int8_t PCDNFC_FindCC							(uc8 TagType, uc8 *pUID, uc8 UIDsize);
+static void PCDNFC_TouchCC							(uc8 Index);
+
+/* Statistics of the last NDEF write */
+PCDNFC_WRITESTAT PCDNFC_WriteStat;
+
+/* Capability cache (least recently used entry replaced) */
+static PCDNFC_CCINFO		CCCache [PCDNFC_CCCACHE_NBENTRY];
+static uint16_t					CCCacheAge [PCDNFC_CCCACHE_NBENTRY];	// 0 => free entry
+static uint16_t					CCCacheTick = 0;
 
 
 /** @addtogroup _95HF_Libraries
@@ -95,6 +105,52 @@ static uint8_t IsAnAvailableProtocol (uint8_t Protocol)
 		default: return PCD_ERRORCODE_PARAMETER;
 	}	
 }
+
+/**
+ *	@brief  Look for a tag in the capability cache
+ *  @param  TagType : st95tagtype of the tag
+ *  @param  *pUID : UID of the tag
+ *  @param  UIDsize : number of bytes of the UID
+ *  @return index of the entry in the cache, -1 if the tag is not in the cache
+ */
+static int8_t PCDNFC_FindCC (uc8 TagType, uc8 *pUID, uc8 UIDsize)
+{
+	uint8_t i;
+
+	if (UIDsize > PCDNFC_MAX_UID_SIZE)
+		return -1;
+
+	for (i=0; i<PCDNFC_CCCACHE_NBENTRY; i++)
+	{
+		if (CCCacheAge[i] != 0 && CCCache[i].TagType == TagType && CCCache[i].UIDsize == UIDsize &&
+				memcmp(CCCache[i].UID, pUID, UIDsize) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+/**
+ *	@brief  Mark an entry of the capability cache as the most recently used
+ *  @param  Index : index of the entry
+ *  @retval None
+ */
+static void PCDNFC_TouchCC (uc8 Index)
+{
+	uint8_t i;
+
+	if (++CCCacheTick == 0)
+	{
+		/* wrap around : keep the used entries, forget their order */
+		for (i=0; i<PCDNFC_CCCACHE_NBENTRY; i++)
+		{
+			if (CCCacheAge[i] != 0)
+				CCCacheAge[i] = 1;
+		}
+		CCCacheTick = 2;
+	}
+	CCCacheAge[Index] = CCCacheTick;
+}
  
 /**
   * @}
@@ -594,6 +650,157 @@ int8_t PCD_IsReaderResultCodeOk (uint8_t CmdCode,uc8 *ReaderReply)
 	}
 }
 
+/**  
+* @brief  	this function returns the highest bit rates supported by both the card and the PCD device.
+* @param  	BitRateCapability	:  	bit rate capability of the card (ATS TA(1) or ATQB bit rate byte)
+* @param  	MaxBitRate	:  	highest bit rate allowed (PCD_ISO14443_BITRATE_xxx)
+* @param  	pDR	:  	bit rate from the PCD device to the card (PCD_ISO14443_BITRATE_xxx)
+* @param  	pDS	:  	bit rate from the card to the PCD device (PCD_ISO14443_BITRATE_xxx)
+* @retval  	None
+*/
+void PCD_ISO14443BitRate (uc8 BitRateCapability, uc8 MaxBitRate, uint8_t *pDR, uint8_t *pDS)
+{
+	uint8_t BitRate;
+
+	*pDR = PCD_ISO14443_BITRATE_106K;
+	*pDS = PCD_ISO14443_BITRATE_106K;
+
+	/* b1 to b3 : PCD to card 212, 424 and 848 kbps, b5 to b7 : card to PCD 212, 424 and 848 kbps */
+	for (BitRate = PCD_ISO14443_BITRATE_212K; BitRate <= MIN(MaxBitRate,PCD_ISO14443_BITRATE_848K); BitRate++)
+	{
+		if ((BitRateCapability & PCD_ISO14443_SAMEBITRATEMASK) != 0x00)
+		{
+			if ((BitRateCapability & (0x01 << (BitRate-1))) != 0x00 && (BitRateCapability & (0x10 << (BitRate-1))) != 0x00)
+			{
+				*pDR = BitRate;
+				*pDS = BitRate;
+			}
+		}
+		else
+		{
+			if ((BitRateCapability & (0x01 << (BitRate-1))) != 0x00)
+				*pDR = BitRate;
+			if ((BitRateCapability & (0x10 << (BitRate-1))) != 0x00)
+				*pDS = BitRate;
+		}
+	}
+}
+
+/**  
+* @brief  	this function converts a FSCI (or FSDI) into a frame size.
+* @param  	FSCI	:  	frame size coding of the ATS, RATS, ATQB or ATTRIB
+* @retval  	frame size in bytes (PCB and CRC included)
+*/
+uint16_t PCD_ISO14443FrameSize (uc8 FSCI)
+{
+	uc16 FrameSize[] = {16, 24, 32, 40, 48, 64, 96, 128, 256};
+
+	/* the RFU values are understood as 256 bytes */
+	return FrameSize[MIN(FSCI, PCD_ISO14443_FRAMESIZE_256)];
+}
+
+/**  
+* @brief  	this function computes the PP and MM bytes of the protocol select command for a frame waiting time.
+* @brief  	The default time out is kept when it is longer than the frame waiting time of the card.
+* @param  	FWI	:  	frame waiting time integer of the card (ATS TB(1) or ATQB)
+* @param  	WTXM	:  	waiting time extension multiplier asked by a S(WTX) block (1 when there is none)
+* @param  	pPP	:  	PP byte, default value as input
+* @param  	pMM	:  	MM byte, default value as input
+* @retval  	true : the PP and MM bytes are changed
+* @retval  	false : the default time out is long enough
+*/
+bool PCD_ISO14443FrameWaitingTime (uc8 FWI, uc8 WTXM, uint8_t *pPP, uint8_t *pMM)
+{
+	uint8_t Fwi = FWI,
+					Wtxm = MIN(MAX(WTXM,1),PCD_ISO14443_MAXWTXM);
+
+	/* FWI = 15 is RFU and understood as the default value */
+	if (Fwi > PCD_ISO14443_MAXFWI)
+		Fwi = PCD_ISO14443_DEFAULTFWI;
+
+	/* both are in 4096/fc unit */
+	if (((uint32_t)Wtxm << Fwi) <= (((uint32_t)*pMM + 1) << *pPP))
+		return false;
+
+	*pPP = Fwi;
+	*pMM = Wtxm - 1;
+	return true;
+}
+
+/**  
+* @brief  	this function returns the capability information of a tag found by a previous NDEF function.
+* @brief  	The NDEF functions check that the information is still valid with their first exchange.
+* @param  	TagType	:  	st95tagtype of the tag
+* @param  	pUID	:  	UID of the tag
+* @param  	UIDsize	:  	number of bytes of the UID
+* @param  	pInfo	:  	capability information
+* @retval  	PCDNFC_OK : the tag is in the cache
+* @retval  	PCDNFC_ERROR : the tag is not in the cache
+*/
+int8_t PCDNFC_GetCachedCC (uc8 TagType, uc8 *pUID, uc8 UIDsize, PCDNFC_CCINFO *pInfo)
+{
+	int8_t	Index = PCDNFC_FindCC (TagType, pUID, UIDsize);
+
+	if (Index < 0)
+		return PCDNFC_ERROR;
+
+	PCDNFC_TouchCC (Index);
+	memcpy(pInfo, &CCCache[Index], sizeof(PCDNFC_CCINFO));
+	return PCDNFC_OK;
+}
+
+/**  
+* @brief  	this function stores the capability information of a tag (the least recently used entry is replaced)
+* @param  	pInfo	:  	capability information (TagType, UID and UIDsize identify the tag)
+* @retval  	None
+*/
+void PCDNFC_StoreCC (const PCDNFC_CCINFO *pInfo)
+{
+	uint8_t i;
+	int8_t	Index = PCDNFC_FindCC (pInfo->TagType, pInfo->UID, pInfo->UIDsize);
+
+	if (pInfo->UIDsize > PCDNFC_MAX_UID_SIZE)
+		return;
+
+	if (Index < 0)
+	{
+		Index = 0;
+		for (i=1; i<PCDNFC_CCCACHE_NBENTRY; i++)
+		{
+			if (CCCacheAge[i] < CCCacheAge[Index])
+				Index = i;
+		}
+	}
+
+	memcpy(&CCCache[Index], pInfo, sizeof(PCDNFC_CCINFO));
+	PCDNFC_TouchCC (Index);
+}
+
+/**  
+* @brief  	this function removes a tag from the capability cache (after an error or a format change)
+* @param  	TagType	:  	st95tagtype of the tag
+* @param  	pUID	:  	UID of the tag
+* @param  	UIDsize	:  	number of bytes of the UID
+* @retval  	None
+*/
+void PCDNFC_InvalidateCC (uc8 TagType, uc8 *pUID, uc8 UIDsize)
+{
+	int8_t	Index = PCDNFC_FindCC (TagType, pUID, UIDsize);
+
+	if (Index >= 0)
+		CCCacheAge[Index] = 0;
+}
+
+/**  
+* @brief  	this function empties the capability cache
+* @retval  	None
+*/
+void PCDNFC_FlushCCCache (void)
+{
+	memset(CCCacheAge, 0x00, sizeof(CCCacheAge));
+	CCCacheTick = 0;
+}
+
 #ifdef USE_CR95HF_DEVICE
 /**
  *	@brief  this function send a BaudRate command to the PCD device
@@ -0,0 +1,623 @@
+/**
+  ******************************************************************************
+  * @file    lib_encoder.c
+  * @author  MMY Application Team
+  * @version V4.0.0
+  * @date    02/06/2014
+  * @brief   Bulk NDEF encoding of the tags of a production line
+  ******************************************************************************
+  * @copyright
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
+  */
+#include "lib_encoder.h"
+#include "lib_nfctype2pcd.h"
+#include "lib_nfctype3pcd.h"
+#include "lib_nfctype4pcd.h"
+#include "lib_nfctype5pcd.h"
+#include "lib_ndef.h"
+
+extern ISO14443A_CARD 	ISO14443A_Card;
+extern ISO14443B_CARD 	ISO14443B_Card;
+extern FELICA_CARD 			FELICA_Card;
+extern ST95TagType 			st95tagtype;
+extern bool 						StopProcess;
+
+extern uint8_t TT2Tag[];
+extern uint8_t *TT3AttribInfo, *TT3NDEFfile;
+extern uint8_t CardNDEFfileT4A[];
+extern uint8_t CardNDEFfileT4B[];
+extern uint8_t TT5Tag[];
+
+/* NDEF TLV of the Type 2 and Type 5 buffers (behind the 16 bytes header of the Type 2 tags,
+   behind a 4 bytes CC for the Type 5 tags, moved behind the CC of the tag by the write) */
+#define ENCODER_TT2_TLV													16
+#define ENCODER_TT5_TLV													PCDNFCT5_NBBYTE_CC
+
+#define ENCODER_PRELOADCRC16										0xFFFF
+#define ENCODER_POLYCRC16												0x8408
+
+uint32_t (*ENCODER_GetTick_ms)(void) = 0x00;
+
+static uint32_t ENCODER_Tick 						( void);
+static uint8_t ENCODER_SelectTag 				( uc8 TagType, ENCODER_RESULT *pResult);
+static uint16_t ENCODER_PlaceTLV 				( uint8_t *pTLV, uc8 *pMessage, uc16 Length);
+static int8_t ENCODER_PlaceMessage 			( uc8 TagType, uc8 *pMessage, uc16 Length, uint8_t **ppMessage);
+static int8_t ENCODER_GetMessage 				( uc8 TagType, uc8 **ppMessage, uint16_t *pLength);
+static uint8_t ENCODER_WriteNDEF 				( uc8 TagType);
+static void ENCODER_ClearMessage 				( uc8 TagType);
+static uint8_t ENCODER_ReadNDEF 				( uc8 TagType);
+static uint8_t ENCODER_LockNDEF 				( uc8 TagType);
+static void ENCODER_EncodeTag 					( const ENCODER_JOB *pJob, uc16 NthTag, ENCODER_RESULT *pResult);
+static void ENCODER_ReleaseTag 					( uc8 TagType);
+
+/** @addtogroup _95HF_Libraries
+ * 	@{
+ *	@brief  <b>This is the library used by the whole 95HF family (RX95HF, CR95HF, ST95HF) <br />
+ *				  You will find ISO libraries ( 14443A, 14443B, 15693, ...) for PICC and PCD <br />
+ *				  The libraries selected in the project will depend of the application targetted <br />
+ *				  and the product chosen (RX95HF emulate PICC, CR95HF emulate PCD, ST95HF can do both)</b>
+ */
+
+/** @addtogroup PCD
+ * 	@{
+ *	@brief  This part of the library enables PCD capabilities of CR95HF & ST95HF.
+ */
+
+
+/** @addtogroup Encoder_pcd
+ * 	@{
+ *	@brief  This file writes a NDEF message in each tag presented to the reader (queue of messages
+ *					or template with variable fields), verifies it and sets it read-only if requested.
+ *					The RF field stays on between the tags, so a tag is polled without field reset
+ *					and guard time as soon as the previous one is done.
+*/
+
+
+/** @addtogroup lib_encoder_Private_Functions
+ *  @{
+ */
+
+/**
+ * @brief  Return the time in ms (0 if ENCODER_GetTick_ms is not set)
+ * @retval time in ms
+ */
+static uint32_t ENCODER_Tick ( void)
+{
+	if (ENCODER_GetTick_ms != 0x00)
+		return ENCODER_GetTick_ms();
+	return 0;
+}
+
+/**
+ * @brief  Get the UID of the tag found by the discovery and select the NDEF functions of its type
+ * @param  TagType : TRACK_NFCTYPEx
+ * @param  *pResult : UID and UIDsize are filled
+ * @retval ENCODER_SUCCESSCODE : the tag is supported
+ * @retval ENCODER_ERRORCODE_TAGTYPE : the kind of tag is not supported
+ */
+static uint8_t ENCODER_SelectTag ( uc8 TagType, ENCODER_RESULT *pResult)
+{
+	switch (TagType)
+	{
+		case TRACK_NFCTYPE2:
+		case TRACK_NFCTYPE4A:
+			pResult->UIDsize = MIN(ISO14443A_Card.UIDsize, ENCODER_MAX_UID_SIZE);
+			memcpy(pResult->UID, ISO14443A_Card.UID, pResult->UIDsize);
+			st95tagtype = (TagType == TRACK_NFCTYPE2)? TT2 : TT4A;
+			break;
+		case TRACK_NFCTYPE3:
+			pResult->UIDsize = FELICA_NBBYTE_IDM;
+			memcpy(pResult->UID, FELICA_Card.UID, FELICA_NBBYTE_IDM);
+			st95tagtype = TT3;
+			break;
+		case TRACK_NFCTYPE4B:
+			pResult->UIDsize = ISO14443B_MAX_PUPI_SIZE;
+			memcpy(pResult->UID, ISO14443B_Card.PUPI, ISO14443B_MAX_PUPI_SIZE);
+			st95tagtype = TT4B;
+			break;
+		case TRACK_NFCTYPE5:
+			if (ISO15693_GetCurrentUID(pResult->UID) != ISO15693_SUCCESSCODE)
+				return ENCODER_ERRORCODE_DEFAULT;
+			pResult->UIDsize = ISO15693_NBBYTE_UID;
+			st95tagtype = TT5;
+			break;
+		default:
+			return ENCODER_ERRORCODE_TAGTYPE;
+	}
+
+	return ENCODER_SUCCESSCODE;
+}
+
+/**
+ * @brief  Build a NDEF TLV followed by the terminator TLV (Type 2 and Type 5 tags)
+ * @param  *pTLV : destination
+ * @param  *pMessage : NDEF message
+ * @param  Length : number of bytes of the message
+ * @retval offset of the message in the TLV
+ */
+static uint16_t ENCODER_PlaceTLV ( uint8_t *pTLV, uc8 *pMessage, uc16 Length)
+{
+	uint16_t offset;
+
+	pTLV[0] = NDEF_TLV_MESSAGE;
+	if (Length < 0xFF)
+	{
+		pTLV[1] = Length;
+		offset = 2;
+	}
+	else
+	{
+		pTLV[1] = 0xFF;
+		pTLV[2] = GETMSB(Length);
+		pTLV[3] = GETLSB(Length);
+		offset = 4;
+	}
+	memcpy(&pTLV[offset], pMessage, Length);
+	pTLV[offset+Length] = NDEF_TLV_TERMINATOR;
+
+	return offset;
+}
+
+/**
+ * @brief  Copy a NDEF message in the buffer written by the NDEF function of the tag
+ * @param  TagType : TRACK_NFCTYPEx
+ * @param  *pMessage : NDEF message
+ * @param  Length : number of bytes of the message
+ * @param  **ppMessage : position of the message in the buffer (for the variable fields)
+ * @retval ENCODER_SUCCESSCODE : the message is ready to be written
+ * @retval ENCODER_ERRORCODE_WRITE : the message does not fit in the buffer
+ */
+static int8_t ENCODER_PlaceMessage ( uc8 TagType, uc8 *pMessage, uc16 Length, uint8_t **ppMessage)
+{
+	uint8_t *pCardNDEFfile;
+
+	switch (TagType)
+	{
+		case TRACK_NFCTYPE2:
+			if (ENCODER_TT2_TLV + 4 + Length + 1 > NFCT2_MAX_TAGMEMORY)
+				return ENCODER_ERRORCODE_WRITE;
+			*ppMessage = &TT2Tag[ENCODER_TT2_TLV + ENCODER_PlaceTLV(&TT2Tag[ENCODER_TT2_TLV], pMessage, Length)];
+			break;
+		case TRACK_NFCTYPE3:
+			if (Length > NFCT3_MAX_TAGMEMORY)
+				return ENCODER_ERRORCODE_WRITE;
+			TT3AttribInfo[11] = 0x00;
+			TT3AttribInfo[12] = GETMSB(Length);
+			TT3AttribInfo[13] = GETLSB(Length);
+			memcpy(TT3NDEFfile, pMessage, Length);
+			*ppMessage = TT3NDEFfile;
+			break;
+		case TRACK_NFCTYPE4A:
+		case TRACK_NFCTYPE4B:
+			if (2 + Length > NFCT4_MAX_NDEFMEMORY)
+				return ENCODER_ERRORCODE_WRITE;
+			pCardNDEFfile = (TagType == TRACK_NFCTYPE4A)? CardNDEFfileT4A : CardNDEFfileT4B;
+			pCardNDEFfile[0] = GETMSB(Length);
+			pCardNDEFfile[1] = GETLSB(Length);
+			memcpy(&pCardNDEFfile[2], pMessage, Length);
+			*ppMessage = &pCardNDEFfile[2];
+			break;
+		case TRACK_NFCTYPE5:
+			// No CC in front of the TLV : the CC of the tag is kept
+			if (PCDNFCT5_NBBYTE_EXTENDEDCC + 4 + Length + 1 > NFCT5_MAX_TAGMEMORY)
+				return ENCODER_ERRORCODE_WRITE;
+			memset(TT5Tag, 0x00, ENCODER_TT5_TLV);
+			*ppMessage = &TT5Tag[ENCODER_TT5_TLV + ENCODER_PlaceTLV(&TT5Tag[ENCODER_TT5_TLV], pMessage, Length)];
+			break;
+		default:
+			return ENCODER_ERRORCODE_TAGTYPE;
+	}
+
+	return ENCODER_SUCCESSCODE;
+}
+
+/**
+ * @brief  Find the NDEF message in the buffer filled by the NDEF read function of the tag
+ * @param  TagType : TRACK_NFCTYPEx
+ * @param  **ppMessage : NDEF message
+ * @param  *pLength : number of bytes of the message
+ * @retval ENCODER_SUCCESSCODE : the message is found
+ * @retval ENCODER_ERRORCODE_VERIFY : the buffer does not contain a NDEF TLV
+ */
+static int8_t ENCODER_GetMessage ( uc8 TagType, uc8 **ppMessage, uint16_t *pLength)
+{
+	uc8 *pTLV;
+	uc8 *pCardNDEFfile;
+	uint32_t length, size;
+
+	switch (TagType)
+	{
+		case TRACK_NFCTYPE2:
+		case TRACK_NFCTYPE5:
+			if (TagType == TRACK_NFCTYPE2)
+			{
+				pTLV = &TT2Tag[ENCODER_TT2_TLV];
+				size = NFCT2_MAX_TAGMEMORY - ENCODER_TT2_TLV;
+			}
+			else
+			{
+				pTLV = &TT5Tag[PCDNFCT5_CCSIZE(TT5Tag)];
+				size = NFCT5_MAX_TAGMEMORY - PCDNFCT5_CCSIZE(TT5Tag);
+			}
+			if (NDEF_FindMessageTLV(pTLV, size, ppMessage, &length) != NDEF_SUCCESSCODE)
+				return ENCODER_ERRORCODE_VERIFY;
+			*pLength = length;
+			break;
+		case TRACK_NFCTYPE3:
+			*pLength = (TT3AttribInfo[12]<<8)|TT3AttribInfo[13];
+			*ppMessage = TT3NDEFfile;
+			break;
+		case TRACK_NFCTYPE4A:
+		case TRACK_NFCTYPE4B:
+			pCardNDEFfile = (TagType == TRACK_NFCTYPE4A)? CardNDEFfileT4A : CardNDEFfileT4B;
+			*pLength = (pCardNDEFfile[0]<<8)|pCardNDEFfile[1];
+			*ppMessage = &pCardNDEFfile[2];
+			break;
+		default:
+			return ENCODER_ERRORCODE_TAGTYPE;
+	}
+
+	return ENCODER_SUCCESSCODE;
+}
+
+/**
+ * @brief  Write the NDEF message prepared by ENCODER_PlaceMessage
+ * @param  TagType : TRACK_NFCTYPEx
+ * @retval PCDNFC_OK or PCDNFC_ERROR_xxx
+ */
+static uint8_t ENCODER_WriteNDEF ( uc8 TagType)
+{
+	switch (TagType)
+	{
+		case TRACK_NFCTYPE2:
+			return PCDNFCT2_WriteNDEF();
+		case TRACK_NFCTYPE3:
+			return PCDNFCT3_WriteNDEF();
+		case TRACK_NFCTYPE4A:
+		case TRACK_NFCTYPE4B:
+			return PCDNFCT4_WriteNDEF();
+		case TRACK_NFCTYPE5:
+			return PCDNFCT5_WriteNDEF();
+		default:
+			return PCDNFC_ERROR;
+	}
+}
+
+/**
+ * @brief  Clear the message area of the tag buffer, the verify cannot find the message just written
+ * @param  TagType : TRACK_NFCTYPEx
+ * @retval None
+ */
+static void ENCODER_ClearMessage ( uc8 TagType)
+{
+	switch (TagType)
+	{
+		case TRACK_NFCTYPE2:
+			memset(&TT2Tag[ENCODER_TT2_TLV], 0x00, NFCT2_MAX_TAGMEMORY - ENCODER_TT2_TLV);
+			break;
+		case TRACK_NFCTYPE3:
+			TT3AttribInfo[12] = 0x00;
+			TT3AttribInfo[13] = 0x00;
+			memset(TT3NDEFfile, 0x00, NFCT3_MAX_TAGMEMORY);
+			break;
+		case TRACK_NFCTYPE4A:
+			memset(CardNDEFfileT4A, 0x00, NFCT4_MAX_NDEFMEMORY);
+			break;
+		case TRACK_NFCTYPE4B:
+			memset(CardNDEFfileT4B, 0x00, NFCT4_MAX_NDEFMEMORY);
+			break;
+		case TRACK_NFCTYPE5:
+			memset(TT5Tag, 0x00, NFCT5_MAX_TAGMEMORY);
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief  Read the NDEF message back (the read stops at the end of the message)
+ * @param  TagType : TRACK_NFCTYPEx
+ * @retval PCDNFC_OK or PCDNFC_ERROR_xxx
+ */
+static uint8_t ENCODER_ReadNDEF ( uc8 TagType)
+{
+	switch (TagType)
+	{
+		case TRACK_NFCTYPE2:
+			return PCDNFCT2_ReadNDEF();
+		case TRACK_NFCTYPE3:
+			return PCDNFCT3_ReadNDEF();
+		case TRACK_NFCTYPE4A:
+		case TRACK_NFCTYPE4B:
+			return PCDNFCT4_ReadNDEF();
+		case TRACK_NFCTYPE5:
+			return PCDNFCT5_ReadNDEF();
+		default:
+			return PCDNFC_ERROR;
+	}
+}
+
+/**
+ * @brief  Set the NDEF message read-only
+ * @param  TagType : TRACK_NFCTYPEx
+ * @retval PCDNFC_OK or PCDNFC_ERROR_xxx (PCDNFC_ERROR for the Type 4 tags, their lock is proprietary)
+ */
+static uint8_t ENCODER_LockNDEF ( uc8 TagType)
+{
+	switch (TagType)
+	{
+		case TRACK_NFCTYPE2:
+			return PCDNFCT2_LockNDEF();
+		case TRACK_NFCTYPE3:
+			return PCDNFCT3_LockNDEF();
+		case TRACK_NFCTYPE5:
+			return PCDNFCT5_LockNDEF();
+		default:
+			return PCDNFC_ERROR;
+	}
+}
+
+/**
+ * @brief  Write, verify and lock the tag found by the discovery
+ * @param  *pJob : encoding job
+ * @param  NthTag : index of the tag in the job (message of the queue or record of the field values)
+ * @param  *pResult : result of the tag (UID, TagType and DetectTime are already set)
+ */
+static void ENCODER_EncodeTag ( const ENCODER_JOB *pJob, uc16 NthTag, ENCODER_RESULT *pResult)
+{
+	uc8 *pMessage;
+	uc8 *pValue;
+	uint8_t *pPlaced;
+	uint16_t length, lengthRead, crc;
+	uint32_t time;
+	uint8_t i;
+
+	// Message of the tag
+	if (pJob->pImage != 0x00)
+	{
+		pMessage = pJob->pImage[NthTag].pMessage;
+		length = pJob->pImage[NthTag].Length;
+	}
+	else
+	{
+		pMessage = pJob->pTemplate;
+		length = pJob->TemplateLength;
+	}
+	pResult->Status = ENCODER_PlaceMessage(pResult->TagType, pMessage, length, &pPlaced);
+	if (pResult->Status != ENCODER_SUCCESSCODE)
+		return;
+	// Variable fields of the template
+	if (pJob->pImage == 0x00 && pJob->NbField != 0)
+	{
+		pValue = pJob->pFieldValue;
+		for (i=0; i<pJob->NbField; i++)
+			pValue += pJob->pField[i].Length;
+		pValue = pJob->pFieldValue + (uint32_t)NthTag*(pValue - pJob->pFieldValue);
+		for (i=0; i<pJob->NbField; i++)
+		{
+			memcpy(&pPlaced[pJob->pField[i].Offset], pValue, pJob->pField[i].Length);
+			pValue += pJob->pField[i].Length;
+		}
+	}
+	crc = ENCODER_ComputeCRC(pPlaced, length);
+	pResult->CRC = crc;
+
+	// Write
+	time = ENCODER_Tick();
+	if (ENCODER_WriteNDEF(pResult->TagType) != PCDNFC_OK)
+	{
+		pResult->Status = ENCODER_ERRORCODE_WRITE;
+		return;
+	}
+	pResult->NbWritten = PCDNFC_WriteStat.NbWritten;
+	pResult->WriteTime = ENCODER_Tick() - time;
+
+	// Verify : only the NDEF TLV is read back, in the same activation
+	if ((pJob->Options & ENCODER_OPTION_VERIFY) != 0)
+	{
+		time = ENCODER_Tick();
+		ENCODER_ClearMessage(pResult->TagType);
+		if (ENCODER_ReadNDEF(pResult->TagType) != PCDNFC_OK ||
+				ENCODER_GetMessage(pResult->TagType, &pMessage, &lengthRead) != ENCODER_SUCCESSCODE ||
+				lengthRead != length || ENCODER_ComputeCRC(pMessage, lengthRead) != crc)
+		{
+			pResult->Status = ENCODER_ERRORCODE_VERIFY;
+			return;
+		}
+		pResult->VerifyTime = ENCODER_Tick() - time;
+	}
+
+	// Lock
+	if ((pJob->Options & ENCODER_OPTION_LOCK) != 0)
+	{
+		time = ENCODER_Tick();
+		if (ENCODER_LockNDEF(pResult->TagType) != PCDNFC_OK)
+		{
+			pResult->Status = ENCODER_ERRORCODE_LOCK;
+			return;
+		}
+		pResult->LockTime = ENCODER_Tick() - time;
+	}
+}
+
+/**
+ * @brief  Take the tag out of the next polls of the job : HLTA (NFC-A), S(DESELECT) then halt (Type 4),
+ * @brief	 stay quiet (Type 5). The Type 3 tags have no halt command, they are skipped by their UID.
+ * @param  TagType : TRACK_NFCTYPEx
+ * @retval None
+ */
+static void ENCODER_ReleaseTag ( uc8 TagType)
+{
+	switch (TagType)
+	{
+		case TRACK_NFCTYPE2:
+			ISO14443A_Halt();
+			break;
+		case TRACK_NFCTYPE4A:
+		case TRACK_NFCTYPE4B:
+			PCDNFCT4_CloseSession();
+			// A deselected card is in the halt state, the HLTx is only sent when the S(DESELECT) is lost
+			if (ISO7816_Deselect() != ISO7816_SUCCESSCODE)
+			{
+				if (TagType == TRACK_NFCTYPE4A)
+					ISO14443A_Halt();
+				else
+					ISO14443B_Halt();
+			}
+			break;
+		case TRACK_NFCTYPE5:
+			ISO15693_StayQuietCurrentTag();
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+  * @}
+  */
+
+/** @addtogroup lib_encoder_Public_Functions
+ *  @{
+ */
+
+/**
+ * @brief  Compute the CRC of a buffer (CRC-16/ISO-HDLC, the CRC of the ISO15693 frames)
+ * @param  *pData : data
+ * @param  Length : number of bytes
+ * @retval CRC
+ */
+uint16_t ENCODER_ComputeCRC ( uc8 *pData, uc16 Length)
+{
+	uint16_t	Crc = ENCODER_PRELOADCRC16;
+	uint16_t	i;
+	uint8_t		j;
+
+	for (i=0; i<Length; i++)
+	{
+		Crc ^= pData[i];
+		for (j=0; j<8; j++)
+			Crc = ((Crc & 0x0001) != 0)? (Crc >> 1) ^ ENCODER_POLYCRC16 : (Crc >> 1);
+	}
+
+	return (uint16_t)~Crc;
+}
+
+/**
+ * @brief  Encode the tags of a job : each new tag found is written with the next message, read back
+ * @brief	 (ENCODER_OPTION_VERIFY) and set read-only (ENCODER_OPTION_LOCK). A tag which fails gets its
+ * @brief	 error in its result and the next tag gets the next message. The RF field stays on between
+ * @brief	 the tags (ConfigManager_Poll), the tag just encoded is skipped until another tag is found.
+ * @param  *pJob : encoding job
+ * @param  *pResult : NbTag results (allocated by the application, 0x00 => no result)
+ * @param  *pStat : statistics of the job (tags per minute)
+ * @retval ENCODER_SUCCESSCODE : the NbTag tags have been encoded (see their status)
+ * @retval ENCODER_ERRORCODE_NOTAG : no new tag within MaxIdlePoll polls
+ * @retval ENCODER_ERRORCODE_DEFAULT : the job has been stopped (ConfigManager_Stop)
+ * @retval ENCODER_ERRORCODE_PARAMETER : the job is not valid
+ */
+int8_t ENCODER_Run ( const ENCODER_JOB *pJob, ENCODER_RESULT *pResult, ENCODER_STAT *pStat)
+{
+	ENCODER_RESULT	result, *pTagResult;
+	uint8_t					lastUID[ENCODER_MAX_UID_SIZE], lastUIDsize = 0;
+	uint8_t					tagType = TRACK_NOTHING;
+	uint16_t				NthTag = 0, NbIdlePoll = 0;
+	uint32_t				startTime, tagTime;
+	bool						fieldOn = false;
+	int8_t					status = ENCODER_SUCCESSCODE;
+	uint8_t					i;
+
+	if (pJob == 0x00 || pStat == 0x00 || (pJob->TagsToFind & ~TRACK_NFCTYPE1) == 0)
+		return ENCODER_ERRORCODE_PARAMETER;
+	if (pJob->pImage == 0x00 && (pJob->pTemplate == 0x00 || (pJob->NbField != 0 && (pJob->pField == 0x00 || pJob->pFieldValue == 0x00))))
+		return ENCODER_ERRORCODE_PARAMETER;
+	for (i=0; pJob->pImage == 0x00 && i<pJob->NbField; i++)
+	{
+		if (pJob->pField[i].Offset + pJob->pField[i].Length > pJob->TemplateLength)
+			return ENCODER_ERRORCODE_PARAMETER;
+	}
+
+	memset(pStat, 0x00, sizeof(ENCODER_STAT));
+	startTime = ENCODER_Tick();
+	tagTime = startTime;
+
+	while (NthTag < pJob->NbTag)
+	{
+		// The first discovery resets the tags, the next ones keep the field on
+		if (fieldOn == false)
+			tagType = ConfigManager_Discovery(pJob->TagsToFind & ~TRACK_NFCTYPE1, true);
+		else
+			tagType = ConfigManager_Poll(pJob->TagsToFind & ~TRACK_NFCTYPE1);
+		if (StopProcess)
+		{
+			status = ENCODER_ERRORCODE_DEFAULT;
+			break;
+		}
+		if (tagType != TRACK_NOTHING)
+			fieldOn = true;
+
+		pTagResult = (pResult != 0x00)? &pResult[NthTag] : &result;
+		memset(pTagResult, 0x00, sizeof(ENCODER_RESULT));
+		pTagResult->TagType = tagType;
+		// Same tag as the previous one : still in the field
+		if (tagType == TRACK_NOTHING || ENCODER_SelectTag(tagType, pTagResult) != ENCODER_SUCCESSCODE ||
+				(pTagResult->UIDsize == lastUIDsize && memcmp(pTagResult->UID, lastUID, lastUIDsize) == 0))
+		{
+			if (pJob->MaxIdlePoll != 0 && ++NbIdlePoll >= pJob->MaxIdlePoll)
+			{
+				status = ENCODER_ERRORCODE_NOTAG;
+				break;
+			}
+			continue;
+		}
+		NbIdlePoll = 0;
+		pTagResult->DetectTime = ENCODER_Tick() - tagTime;
+
+		ENCODER_EncodeTag(pJob, NthTag, pTagResult);
+		ENCODER_ReleaseTag(pTagResult->TagType);
+
+		lastUIDsize = pTagResult->UIDsize;
+		memcpy(lastUID, pTagResult->UID, lastUIDsize);
+		pTagResult->TotalTime = ENCODER_Tick() - tagTime;
+		tagTime += pTagResult->TotalTime;
+		if (pTagResult->Status == ENCODER_SUCCESSCODE)
+			pStat->NbTagOk++;
+		else
+			pStat->NbTagError++;
+		NthTag++;
+	}
+
+	PCD_FieldOff();
+
+	pStat->Duration = ENCODER_Tick() - startTime;
+	if (pStat->Duration != 0)
+		pStat->TagsPerMinute = ((uint32_t)(pStat->NbTagOk + pStat->NbTagError)*60000)/pStat->Duration;
+
+	return status;
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/******************* (C) COPYRIGHT 2014 STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,215 @@
+/**
+  ******************************************************************************
+  * @file    lib_inventory.c
+  * @author  MMY Application Team
+  * @version V4.0.0
+  * @date    02/06/2014
+  * @brief   Inventory result table shared by the PCD protocols
+  ******************************************************************************
+  * @copyright
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
+  */
+#include "lib_inventory.h"
+
+static uint16_t INVENTORY_Hash ( uc8 Technology, uc8 *pUID, uc8 UIDsize, uc16 NbHashEntry);
+
+/** @addtogroup _95HF_Libraries
+ * 	@{
+ *	@brief  <b>This is the library used by the whole 95HF family (RX95HF, CR95HF, ST95HF) <br />
+ *				  You will find ISO libraries ( 14443A, 14443B, 15693, ...) for PICC and PCD <br />
+ *				  The libraries selected in the project will depend of the application targetted <br />
+ *				  and the product chosen (RX95HF emulate PICC, CR95HF emulate PCD, ST95HF can do both)</b>
+ */
+
+/** @addtogroup PCD
+ * 	@{
+ *	@brief  This part of the library enables PCD capabilities of CR95HF & ST95HF.
+ */
+
+
+/** @addtogroup Inventory_pcd
+ * 	@{
+ *	@brief  This file stores the tags found by the anticollision of the different protocols
+ *					in one table (fixed size records, one record per UID).
+*/
+
+
+/** @addtogroup lib_inventory_Private_Functions
+ *  @{
+ */
+
+/**
+ * @brief  Compute the hash of a UID (FNV-1a)
+ * @param  Technology : INVENTORY_TECHNO_xxx
+ * @param  *pUID : UID of the tag
+ * @param  UIDsize : number of bytes of the UID
+ * @param  NbHashEntry : size of the hash table
+ * @retval index in the hash table
+ */
+static uint16_t INVENTORY_Hash ( uc8 Technology, uc8 *pUID, uc8 UIDsize, uc16 NbHashEntry)
+{
+	uint32_t	Hash = 0x811C9DC5;
+	uint8_t		i;
+
+	Hash = (Hash ^ Technology) * 0x01000193;
+	for (i=0; i<UIDsize; i++)
+		Hash = (Hash ^ pUID[i]) * 0x01000193;
+
+	return (uint16_t)(Hash % NbHashEntry);
+}
+
+/**
+  * @}
+  */ 
+
+/** @addtogroup lib_inventory_Public_Functions
+ *  @{
+ */
+
+/**
+ * @brief  Initialize an inventory table
+ * @param  *pTable : inventory table
+ * @param  *pRecord : storage for Capacity records (allocated by the application)
+ * @param  *pHashHead : storage for NbHashEntry indexes (allocated by the application, about Capacity entries)
+ * @param  Capacity : maximum number of tags in the table
+ * @param  NbHashEntry : size of the hash table
+ * @retval INVENTORY_SUCCESSCODE / INVENTORY_ERRORCODE_PARAMETER
+ */
+int8_t INVENTORY_Init ( INVENTORY_TABLE *pTable, INVENTORY_RECORD *pRecord, uint16_t *pHashHead, uc16 Capacity, uc16 NbHashEntry)
+{
+	if (Capacity == 0 || Capacity >= INVENTORY_NOINDEX || NbHashEntry == 0)
+		return INVENTORY_ERRORCODE_PARAMETER;
+
+	pTable->pRecord = pRecord;
+	pTable->pHashHead = pHashHead;
+	pTable->Capacity = Capacity;
+	pTable->NbHashEntry = NbHashEntry;
+
+	INVENTORY_Clear (pTable);
+
+	return INVENTORY_SUCCESSCODE;
+}
+
+/**
+ * @brief  Remove all the records of an inventory table
+ * @param  *pTable : inventory table
+ * @retval None
+ */
+void INVENTORY_Clear ( INVENTORY_TABLE *pTable)
+{
+	uint16_t i;
+
+	for (i=0; i<pTable->NbHashEntry; i++)
+		pTable->pHashHead[i] = INVENTORY_NOINDEX;
+
+	pTable->NbRecord = 0;
+}
+
+/**
+ * @brief  Look for a tag in an inventory table
+ * @param  *pTable : inventory table
+ * @param  Technology : INVENTORY_TECHNO_xxx
+ * @param  *pUID : UID of the tag
+ * @param  UIDsize : number of bytes of the UID
+ * @retval pointer on the record of the tag, 0x00 if the tag is not in the table
+ */
+INVENTORY_RECORD *INVENTORY_Find ( INVENTORY_TABLE *pTable, uc8 Technology, uc8 *pUID, uc8 UIDsize)
+{
+	INVENTORY_RECORD	*pRecord;
+	uint16_t					Index;
+
+	Index = pTable->pHashHead[INVENTORY_Hash (Technology, pUID, UIDsize, pTable->NbHashEntry)];
+
+	while (Index != INVENTORY_NOINDEX)
+	{
+		pRecord = &pTable->pRecord[Index];
+		if (pRecord->Technology == Technology && pRecord->UIDsize == UIDsize && memcmp(pRecord->UID, pUID, UIDsize) == 0)
+			return pRecord;
+		Index = pRecord->Next;
+	}
+
+	return 0x00;
+}
+
+/**
+ * @brief  Add a tag in an inventory table. If the tag is already in the table its record is updated
+ * @param  *pTable : inventory table
+ * @param  Technology : INVENTORY_TECHNO_xxx
+ * @param  *pUID : UID of the tag
+ * @param  UIDsize : number of bytes of the UID
+ * @param  Info : DSFID (ISO15693) or SAK (ISO14443A)
+ * @param  RSSI : signal level (INVENTORY_RSSI_UNKNOWN if not available)
+ * @param  Timestamp : time of the inventory (unit chosen by the application)
+ * @retval INVENTORY_SUCCESSCODE : the tag has been added or updated
+ * @retval INVENTORY_ERRORCODE_FULL : the table is full
+ * @retval INVENTORY_ERRORCODE_PARAMETER : the UID is too long
+ */
+int8_t INVENTORY_Add ( INVENTORY_TABLE *pTable, uc8 Technology, uc8 *pUID, uc8 UIDsize, uc8 Info, uc8 RSSI, uc32 Timestamp)
+{
+	INVENTORY_RECORD	*pRecord;
+	uint16_t					Hash;
+
+	if (UIDsize == 0 || UIDsize > INVENTORY_MAX_UID_SIZE)
+		return INVENTORY_ERRORCODE_PARAMETER;
+
+	/* already seen => update the record */
+	pRecord = INVENTORY_Find (pTable, Technology, pUID, UIDsize);
+	if (pRecord != 0x00)
+	{
+		pRecord->Info = Info;
+		if (RSSI != INVENTORY_RSSI_UNKNOWN)
+			pRecord->RSSI = RSSI;
+		pRecord->LastSeen = Timestamp;
+		if (pRecord->HitCount < INVENTORY_MAX_HITCOUNT)
+			pRecord->HitCount++;
+		return INVENTORY_SUCCESSCODE;
+	}
+
+	if (pTable->NbRecord >= pTable->Capacity)
+		return INVENTORY_ERRORCODE_FULL;
+
+	Hash = INVENTORY_Hash (Technology, pUID, UIDsize, pTable->NbHashEntry);
+
+	pRecord = &pTable->pRecord[pTable->NbRecord];
+	memset(pRecord, 0x00, sizeof(INVENTORY_RECORD));
+	memcpy(pRecord->UID, pUID, UIDsize);
+	pRecord->UIDsize = UIDsize;
+	pRecord->Technology = Technology;
+	pRecord->Info = Info;
+	pRecord->RSSI = RSSI;
+	pRecord->HitCount = 1;
+	pRecord->FirstSeen = Timestamp;
+	pRecord->LastSeen = Timestamp;
+	pRecord->Next = pTable->pHashHead[Hash];
+
+	pTable->pHashHead[Hash] = pTable->NbRecord;
+	pTable->NbRecord++;
+
+	return INVENTORY_SUCCESSCODE;
+}
+
+/**
+  * @}
+  */ 
+
+/**
+  * @}
+  */ 
+
+/**
+  * @}
+  */ 
+
+/**
+  * @}
+  */ 
+
+/******************* (C) COPYRIGHT 2014 STMicroelectronics *****END OF FILE****/
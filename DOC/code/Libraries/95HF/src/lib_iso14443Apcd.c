@@ -26,13 +26,35 @@
 
 static uc8 TOPAZ[] = {SEND_RECEIVE, 0x08, 0x78, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xA8};
 
-static u8 MultiID[200] = {0};
-static u8 MultiIDPart2[64] = {0};
+/* path of the tree walk : UID CLn of the levels already selected and bits known in the current one */
+typedef struct{
+	uint8_t		CLn[CASCADE_LVL_3][ISO14443A_UID_SINGLE_SIZE];
+	uint8_t		Level;
+	uint8_t		NbKnownBit;
+}ISO14443A_ACPATH;
+
+static u8 MultiIDPart2[ISO14443A_MULTITAGHUNTING_NBTAG*ISO14443A_NBBYTE_TAGRECORD] = {0};
 static u8 RemainingID = 0;
 
+static ISO14443A_ACPATH	ACBranch[ISO14443A_ACBRANCH_NBENTRY];
+static uint8_t					NbACBranch = 0;
+
+static ISO14443A_REACTIVATIONENTRY	ReactivationCache [ISO14443A_REACTIVATION_NBENTRY];
+static uint16_t											ReactivationAge [ISO14443A_REACTIVATION_NBENTRY];	// 0 => free entry
+static uint16_t											ReactivationTick = 0;
+/* ATS returned by the last RATS command */
+static uint8_t											LastATS [ISO14443A_MAX_ATS_SIZE];
+static uint8_t											LastATSsize = 0;
+
 
 uint16_t FSC = 32;
 
+/* highest bit rate requested with the PPS (lowered when a bit rate fails) */
+static uint8_t ISO14443A_MaxBitRate = PCD_ISO14443_MAXBITRATE;
+/* frame waiting time of the card (ATS TB(1)) and extension asked by the last S(WTX) */
+static uint8_t ISO14443A_FWI = PCD_ISO14443_DEFAULTFWI;
+static uint8_t ISO14443A_WTXM = 1;
+
 
 ISO14443A_CARD 	ISO14443A_Card;
 extern uint8_t													u95HFBuffer [RFTRANS_95HF_MAX_BUFFER_SIZE+3];
@@ -45,17 +67,24 @@ extern ST95TagType st95tagtype;
 
 
 static void ISO14443A_InitStructure( void );
-static uint16_t FSCIToFSC(uint8_t FSCI);
 static int8_t ISO14443A_REQA( uint8_t *pDataRead );
+static int8_t ISO14443A_WUPA( uint8_t *pDataRead );
 static int8_t ISO14443A_HLTA( uint8_t *pDataRead );
 static int8_t ISO14443A_RATS( uint8_t *pDataRead );
 static int8_t ISO14443A_PPS( uint8_t *pDataRead );
+static int8_t ISO14443A_ConfigureBitRate( uc8 DR, uc8 DS );
 static int8_t ISO14443A_AC( uint8_t *pDataRead, u8 CascadeLevel );
+static int8_t ISO14443A_ACLoop( uc8 CascadeLevel, uint8_t *pCLn, uint8_t NbKnownBit, ISO14443A_ACPATH *pPath, uint8_t *pDataRead );
+static int8_t ISO14443A_Select( uc8 CascadeLevel, uc8 *pCLn, uint8_t *pSAK, uint8_t *pDataRead );
+static void ISO14443A_PushBranch( ISO14443A_ACPATH *pPath, uc8 Level, uc8 *pCLn, uc8 CollisionBit );
+static int8_t ISO14443A_DirectSelect( ISO14443A_REACTIVATIONENTRY *pEntry, uint8_t *pDataRead );
+static int8_t ISO14443A_FindReactivation( uc8 *pUID, uc8 UIDsize );
+static void ISO14443A_TouchReactivation( uc8 Index );
+static void ISO14443A_StoreReactivation( void );
 static int8_t ISO14443A_ACLevel1 ( uint8_t *pDataRead );
 static int8_t ISO14443A_ACLevel2 ( uint8_t *pDataRead );
 static int8_t ISO14443A_ACLevel3 ( uint8_t *pDataRead );
 static void ISO14443A_CompleteStructure ( uint8_t *pATQA );
-static int8_t ISO14443A_MultiAnticollision( void );
 
 
 /** @addtogroup _95HF_Libraries
@@ -101,38 +130,45 @@ static void ISO14443A_InitStructure( void )
 }
 
 /**
- * @brief  this functions convert FSCI to FSC
- * @param  FSCI	: FSCI value
- * @return FSC
+ * @brief  this functions sends the REQA command to the PCD device
+ * @param  *pDataRead	: Pointer to the PCD response
+ * @return ISO14443A_SUCCESSCODE the function is succesful
+ * @return ISO14443A_ERRORCODE_DEFAULT : an error occured
  */
-static uint16_t FSCIToFSC(uint8_t FSCI)
+static int8_t ISO14443A_REQA( uint8_t *pDataRead )
 {
-	if (FSCI == 0) return 16;
-	else if (FSCI == 1) return 24;
-	else if (FSCI == 2) return 32;
-	else if (FSCI == 3) return 40;
-	else if (FSCI == 4) return 48;
-	else if (FSCI == 5) return 64;
-	else if (FSCI == 6) return 96;
-	else if (FSCI == 7) return 128;
-	else return 256;
+	uc8 		ReqA[]					= { 0x26, 0x07};
+	int8_t	status;
+
+
+	/* sends the command to the PCD device*/
+	errchk(PCD_SendRecv(0x02,ReqA,pDataRead));
+
+	/* retrieves the ATQA response */
+	memcpy(ISO14443A_Card.ATQA, &pDataRead[PCD_DATA_OFFSET], ISO14443A_ATQA_SIZE);
+	/* completes the strucure according to the ATQA response */
+	ISO14443A_CompleteStructure ( ISO14443A_Card.ATQA );
+		
+	return ISO14443A_SUCCESSCODE;
+Error:
+	return ISO14443A_ERRORCODE_DEFAULT; 
 }
 
 
 /**
- * @brief  this functions sends the REQA command to the PCD device
+ * @brief  this functions sends the WUPA command to the PCD device (the halted cards answer too)
  * @param  *pDataRead	: Pointer to the PCD response
  * @return ISO14443A_SUCCESSCODE the function is succesful
  * @return ISO14443A_ERRORCODE_DEFAULT : an error occured
  */
-static int8_t ISO14443A_REQA( uint8_t *pDataRead )
+static int8_t ISO14443A_WUPA( uint8_t *pDataRead )
 {
-	uc8 		ReqA[]					= { 0x26, 0x07};
+	uc8 		WupA[]					= { COMMAND_WUPA, 0x07};
 	int8_t	status;
 
 
 	/* sends the command to the PCD device*/
-	errchk(PCD_SendRecv(0x02,ReqA,pDataRead));
+	errchk(PCD_SendRecv(0x02,WupA,pDataRead));
 
 	/* retrieves the ATQA response */
 	memcpy(ISO14443A_Card.ATQA, &pDataRead[PCD_DATA_OFFSET], ISO14443A_ATQA_SIZE);
@@ -154,163 +190,175 @@ Error:
  */
 static int8_t ISO14443A_AC( uint8_t *pDataRead, u8 CascadeLevel )
 {
-	u8 AnticolParameter [7] = {0x00, ISO14443A_NVM_20, 0x08,0x00,0x00,0x00,0x00};
-	u8 NbResponseByte = 0;
-	u8 NbResponseByteOrigin = 0;
-	u8 Collision = 0;
-	u8 ByteCollisionIndex = 0;
-	u8 BitCollisionIndex = 0;
-
-	u8 RemainingBit = 0;
-	u8 NewByteCollisionIndex = 0;
-	u8 NewBitCollisionIndex = 0;
-	u8 UID[4] = {0x00,0x00,0x00,0x00};
-	int8_t status;
+	uint8_t CLn[ISO14443A_UID_SINGLE_SIZE];
 
-	/* prepare command regarding cascade level on-going */
-	AnticolParameter[0] = CascadeLevel;
+	/* at each collision the branch with the bit set to 1 is chosen */
+	return ISO14443A_ACLoop( CascadeLevel, CLn, 0, 0x00, pDataRead );
+}
 
-	/* sends the command to the PCD device*/
-	errchk(PCD_SendRecv(0x03,AnticolParameter,pDataRead));
-	
-	NbResponseByte = pDataRead[1]; 
-	NbResponseByteOrigin = NbResponseByte;
-	Collision = (pDataRead[NbResponseByte-1] & 0x80);
+/**
+ * @brief  this function runs the bit oriented anticollision of one cascade level.
+ * @brief  The anticollision frame is sent with the known bits of the UID CLn, a collision adds
+ * @brief  one known bit (set to 1) and the frame is sent again until the whole UID CLn is received.
+ * @brief  When pPath is not NULL the branch with the collision bit set to 0 is stacked for the tree walk.
+ * @param  CascadeLevel	: select code of the cascade level (SEL_CASCADE_LVL_x)
+ * @param  *pCLn	: known bits of the UID CLn (input) / UID CLn of the card (output)
+ * @param  NbKnownBit	: number of known bits of the UID CLn
+ * @param  *pPath	: path of the tree walk (levels already selected), NULL when no branch is stacked
+ * @param  *pDataRead	: Pointer to the PCD response (0x80, length, UID CLn, BCC when succesful)
+ * @return ISO14443A_SUCCESSCODE the function is succesful
+ * @return ISO14443A_ERRORCODE_DEFAULT : an error occured
+ */
+static int8_t ISO14443A_ACLoop( uc8 CascadeLevel, uint8_t *pCLn, uint8_t NbKnownBit, ISO14443A_ACPATH *pPath, uint8_t *pDataRead )
+{
+	uint8_t AnticolParameter [ISO14443A_UID_SINGLE_SIZE+3],
+					Frame [ISO14443A_UID_SINGLE_SIZE+ISO14443A_NBBYTE_BCC],
+					Length,
+					FirstByte,
+					KnownMask,
+					NbResponseByte,
+					*pControl,
+					CollisionBit,
+					i;
+	int8_t status;
 
-	ByteCollisionIndex = pDataRead[NbResponseByte];
-	BitCollisionIndex = pDataRead[NbResponseByte+1];
-	
-	/* case that should not happend, as occurs because we have miss another collision */
-	if( BitCollisionIndex == 8)
+	memcpy(Frame, pCLn, (NbKnownBit+7)/8);
+
+	while (NbKnownBit < ISO14443A_NBBIT_UIDCLN)
 	{
-		return ISO14443A_ERRORCODE_DEFAULT;
-	}
-			
-	/* check for collision (Tag of different UID length at the same time not managed so far) */
-	while( Collision == 0x80)
-	{		
-		/* clear collision detection */
-		Collision = 0x00;
-		
-		/* send the command to the PCD device*/
-		AnticolParameter[1] = ISO14443A_NVM_20 + ((ByteCollisionIndex) <<4) + (BitCollisionIndex+1);
-		if( ByteCollisionIndex == 0)
-		{	
-			AnticolParameter[2] = pDataRead[2] & ((u8)(~(0xFF<<(BitCollisionIndex+1)))); /* ISO said it's better to put collision bit to value 1 */
-			AnticolParameter[3] = (BitCollisionIndex+1) | 0x40; /* add split frame bit */
-			UID [0] = AnticolParameter[2];
-		}
-		else if( ByteCollisionIndex == 1)
+		FirstByte = NbKnownBit/8;
+		KnownMask = (uint8_t)(~(0xFF << (NbKnownBit%8)));
+
+		/* SEL | NVB | known bits of the UID CLn | control byte */
+		Length = 0;
+		AnticolParameter[Length++] = CascadeLevel;
+		AnticolParameter[Length++] = ISO14443A_NVM_20 + (FirstByte << 4) + (NbKnownBit%8);
+		memcpy(&AnticolParameter[Length], Frame, (NbKnownBit+7)/8);
+		Length += (NbKnownBit+7)/8;
+		if ((NbKnownBit%8) != 0)
 		{
-			AnticolParameter[2] = pDataRead[2];
-			AnticolParameter[3] = pDataRead[3] & ((u8)(~(0xFF<<(BitCollisionIndex+1)))); /* ISO said it's better to put collision bit to value 1 */			
-			AnticolParameter[4] = (BitCollisionIndex+1) | 0x40; /* add split frame bit */
-			UID [0] = AnticolParameter[2];
-			UID [1] = AnticolParameter[3];
-		}
-		else if( ByteCollisionIndex == 2)
-		{
-			AnticolParameter[2] = pDataRead[2];
-			AnticolParameter[3] = pDataRead[3];
-			AnticolParameter[4] = pDataRead[4] & ((u8)(~(0xFF<<(BitCollisionIndex+1)))); /* ISO said it's better to put collision bit to value 1 */			
-			AnticolParameter[5] = (BitCollisionIndex+1) | 0x40; /* add split frame bit */;
-			UID [0] = AnticolParameter[2];
-			UID [1] = AnticolParameter[3];
-			UID [2] = AnticolParameter[4];
-		}
-		else if( ByteCollisionIndex == 3)
-		{
-			AnticolParameter[2] = pDataRead[2];
-			AnticolParameter[3] = pDataRead[3];
-			AnticolParameter[4] = pDataRead[4];
-			AnticolParameter[5] = pDataRead[5] & ((u8)(~(0xFF<<(BitCollisionIndex+1)))); /* ISO said it's better to put collision bit to value 1 */			
-			AnticolParameter[6] = (BitCollisionIndex+1) | 0x40; /* add split frame bit */;
-			UID [0] = AnticolParameter[2];
-			UID [1] = AnticolParameter[3];
-			UID [2] = AnticolParameter[4];
-			UID [3] = AnticolParameter[5];
+			AnticolParameter[Length-1] &= KnownMask;
+			/* split frame : the card reply starts with the missing bits of the last byte */
+			AnticolParameter[Length++] = (NbKnownBit%8) | PCD_ISO14443A_SPLITFRAME;
 		}
 		else
+			AnticolParameter[Length++] = PCD_ISO14443A_A8BITSINFIRSTBYTE;
+
+		errchk(PCD_SendRecv(Length,AnticolParameter,pDataRead));
+
+		if (pDataRead[PCD_LENGTH_OFFSET] <= ISO14443A_NBBYTE)
 			return ISO14443A_ERRORCODE_DEFAULT;
-				
-		/* send part of the UID */
-		PCD_SendRecv((0x03+ByteCollisionIndex+1),AnticolParameter,pDataRead);
-		
-		if(pDataRead[0] != 0x80)
-				return ISO14443A_ERRORCODE_DEFAULT;
-		
-		/* check if there is another collision to take into account*/
-		NbResponseByte = pDataRead[1]; 
-		Collision = (pDataRead[NbResponseByte-1]) & 0x80;
-		
-		if ( Collision == 0x80)
+		NbResponseByte = pDataRead[PCD_LENGTH_OFFSET] - ISO14443A_NBBYTE;
+		if (FirstByte + NbResponseByte > ISO14443A_UID_SINGLE_SIZE+ISO14443A_NBBYTE_BCC)
+			return ISO14443A_ERRORCODE_DEFAULT;
+		pControl = &pDataRead[PCD_DATA_OFFSET+NbResponseByte];
+
+		/* merge the reply with the known bits */
+		for (i=0; i<NbResponseByte; i++)
+			Frame[FirstByte+i] = pDataRead[PCD_DATA_OFFSET+i];
+		Frame[FirstByte] = (Frame[FirstByte] & ~KnownMask) | (AnticolParameter[Length-2] & KnownMask);
+
+		if ((pControl[0] & ISO14443A_COLISIONMASK) == 0x00)
 		{
-			NewByteCollisionIndex = pDataRead[NbResponseByte];
-			NewBitCollisionIndex = pDataRead[NbResponseByte+1];
-		}
-					
-		/* we can check that non-alignement is the one expected */
-		RemainingBit = 8 - (0x0F & (pDataRead[2+(NbResponseByte-2)-1]));
-		if( RemainingBit == BitCollisionIndex+1)
-		{		
-			/* recreate the good UID */
-			if( ByteCollisionIndex == 0)
-			{
-				UID [0] = ((~(0xFF << (BitCollisionIndex+1))) & AnticolParameter[2]) | pDataRead[2] ;
-				UID [1] = pDataRead[3];
-				UID [2] = pDataRead[4];
-				UID [3] = pDataRead[5];
-			}
-			else if( ByteCollisionIndex == 1)
-			{
-				UID [1] = ((~(0xFF << (BitCollisionIndex+1))) & AnticolParameter[3]) | pDataRead[2] ;
-				UID [2] = pDataRead[3];
-				UID [3] = pDataRead[4];
-			}
-			else if( ByteCollisionIndex == 2)
-			{
-				UID [2] = ((~(0xFF << (BitCollisionIndex+1))) & AnticolParameter[4]) | pDataRead[2] ;
-				UID [3] = pDataRead[3];
-			}
-			else if( ByteCollisionIndex == 3)
-			{
-				UID [3] = ((~(0xFF << (BitCollisionIndex+1))) & AnticolParameter[5]) | pDataRead[2] ;
-			}
-			else
+			if (FirstByte + NbResponseByte != ISO14443A_UID_SINGLE_SIZE+ISO14443A_NBBYTE_BCC)
 				return ISO14443A_ERRORCODE_DEFAULT;
-		}				
-		else
-			return ISO14443A_ERRORCODE_DEFAULT;		
-		
-			/* prepare the buffer expected by the caller */
-			pDataRead[0] = 0x80;
-			pDataRead[1] = NbResponseByteOrigin;
-			pDataRead[2] = UID [0];
-			pDataRead[3] = UID [1];
-			pDataRead[4] = UID [2];
-			pDataRead[5] = UID [3];	
-			pDataRead[6] = UID[0]^UID[1]^UID[2]^UID[3];	
-		
-		/* if collision was detected restart anticol */
-		if ( Collision == 0x80)
-		{
-			if( ByteCollisionIndex != NewByteCollisionIndex )
-			{
-				ByteCollisionIndex += NewByteCollisionIndex;
-				BitCollisionIndex = NewBitCollisionIndex;	
-			}
-			else
-			{
-				ByteCollisionIndex += NewByteCollisionIndex;
-				BitCollisionIndex += (NewBitCollisionIndex+1);				
-			}
+			break;
 		}
+
+		/* the collision bit of the first byte is counted from the first bit received */
+		CollisionBit = (FirstByte + pControl[1])*8 + pControl[2];
+		if (pControl[1] == 0)
+			CollisionBit += NbKnownBit%8;
+		/* a collision in the BCC or on a known bit should not happend */
+		if (CollisionBit < NbKnownBit || CollisionBit >= ISO14443A_NBBIT_UIDCLN)
+			return ISO14443A_ERRORCODE_DEFAULT;
+
+		if (pPath != 0x00)
+			ISO14443A_PushBranch(pPath, (CascadeLevel-SEL_CASCADE_LVL_1)/2, Frame, CollisionBit);
+
+		Frame[CollisionBit/8] |= 0x01 << (CollisionBit%8);
+		NbKnownBit = CollisionBit + 1;
 	}
-	
+
+	if (NbKnownBit >= ISO14443A_NBBIT_UIDCLN)
+	{
+		/* all the bits are known (collision on the last one) : the BCC is computed */
+		Frame[ISO14443A_UID_SINGLE_SIZE] = 0x00;
+		for (i=0; i<ISO14443A_UID_SINGLE_SIZE; i++)
+			Frame[ISO14443A_UID_SINGLE_SIZE] ^= Frame[i];
+	}
+
+	/* checks the BCC */
+	if ((Frame[0]^Frame[1]^Frame[2]^Frame[3]) != Frame[ISO14443A_UID_SINGLE_SIZE])
+		return ISO14443A_ERRORCODE_DEFAULT;
+
+	memcpy(pCLn, Frame, ISO14443A_UID_SINGLE_SIZE);
+
+	/* prepare the buffer expected by the caller */
+	pDataRead[READERREPLY_STATUSOFFSET] = SENDRECV_RESULTSCODE_OK;
+	pDataRead[PCD_LENGTH_OFFSET] = ISO14443A_UID_SINGLE_SIZE + ISO14443A_NBBYTE_BCC + ISO14443A_NBBYTE;
+	memcpy(&pDataRead[PCD_DATA_OFFSET], Frame, ISO14443A_UID_SINGLE_SIZE+ISO14443A_NBBYTE_BCC);
+
 	return ISO14443A_SUCCESSCODE;
 Error:
-	return ISO14443A_ERRORCODE_DEFAULT; 
-	
+	return ISO14443A_ERRORCODE_DEFAULT;
+}
+
+/**
+ * @brief  this function selects the card whose UID CLn is given
+ * @param  CascadeLevel	: select code of the cascade level (SEL_CASCADE_LVL_x)
+ * @param  *pCLn	: UID CLn of the card
+ * @param  *pSAK	: SAK returned by the card
+ * @param  *pDataRead	: Pointer to the PCD response
+ * @return ISO14443A_SUCCESSCODE the function is succesful
+ * @return ISO14443A_ERRORCODE_DEFAULT : an error occured
+ */
+static int8_t ISO14443A_Select( uc8 CascadeLevel, uc8 *pCLn, uint8_t *pSAK, uint8_t *pDataRead )
+{
+	uint8_t SelectParameter [ISO14443A_UID_SINGLE_SIZE+4],
+					Length = 0;
+	int8_t status;
+
+	SelectParameter[Length++] = CascadeLevel;
+	SelectParameter[Length++] = ISO14443A_NVM_70;
+	memcpy(&SelectParameter[Length], pCLn, ISO14443A_UID_SINGLE_SIZE);
+	Length += ISO14443A_UID_SINGLE_SIZE;
+	SelectParameter[Length++] = pCLn[0]^pCLn[1]^pCLn[2]^pCLn[3];
+	/* Add the control byte : Append the CRC + 8 bits in first byte (standard frame)*/
+	SelectParameter[Length++] = PCD_ISO14443A_APPENDCRC | PCD_ISO14443A_A8BITSINFIRSTBYTE;
+
+	errchk(PCD_SendRecv(Length,SelectParameter,pDataRead));
+	errchk(PCD_IsCRCOk (PCD_PROTOCOL_ISO14443A,pDataRead) );
+
+	*pSAK = pDataRead[PCD_DATA_OFFSET];
+
+	return ISO14443A_SUCCESSCODE;
+Error:
+	return ISO14443A_ERRORCODE_DEFAULT;
+}
+
+/**
+ * @brief  this function stacks the branch of the tree walk with the collision bit set to 0.
+ * @brief  When the stack is full the branch is dropped, its cards are found again from the root.
+ * @param  *pPath	: path of the tree walk
+ * @param  Level	: cascade level of the collision (0 to 2)
+ * @param  *pCLn	: UID CLn received (bits before the collision bit are valid)
+ * @param  CollisionBit	: position of the collision bit in the UID CLn
+ * @return void
+ */
+static void ISO14443A_PushBranch( ISO14443A_ACPATH *pPath, uc8 Level, uc8 *pCLn, uc8 CollisionBit )
+{
+	ISO14443A_ACPATH *pBranch;
+
+	if (NbACBranch >= ISO14443A_ACBRANCH_NBENTRY)
+		return;
+
+	pBranch = &ACBranch[NbACBranch++];
+	memcpy(pBranch->CLn, pPath->CLn, Level*ISO14443A_UID_SINGLE_SIZE);
+	memcpy(pBranch->CLn[Level], pCLn, CollisionBit/8 + 1);
+	pBranch->CLn[Level][CollisionBit/8] &= (uint8_t)(~(0xFF << (CollisionBit%8)));
+	pBranch->Level = Level;
+	pBranch->NbKnownBit = CollisionBit + 1;
 }
 
 /**
@@ -451,7 +499,7 @@ static int8_t ISO14443A_ACLevel3 ( uint8_t *pDataRead )
 	errchk(ISO14443A_AC(pDataRead, SEL_CASCADE_LVL_3));
 
 	/* Copies the UID into the data structure */
-	memcpy(&ISO14443A_Card.UID[ISO14443A_UID_PART], &pDataRead[PCD_DATA_OFFSET], ISO14443A_UID_SINGLE_SIZE);
+	memcpy(&ISO14443A_Card.UID[2*ISO14443A_UID_PART], &pDataRead[PCD_DATA_OFFSET], ISO14443A_UID_SINGLE_SIZE);
 	/* copies the BCC byte of the card response*/
 	BccByte = pDataRead[PCD_DATA_OFFSET + ISO14443A_UID_SINGLE_SIZE ];
 	
@@ -460,11 +508,8 @@ static int8_t ISO14443A_ACLevel3 ( uint8_t *pDataRead )
 	pDataToSend[Length ++] = ISO14443A_NVM_70;
 	
 	/* Copies the UID into the data structure */
-	if(ISO14443A_Card.UIDsize == ISO14443A_UID_TRIPLE_SIZE)
-	{
-		memcpy(&(pDataToSend[Length]),&(ISO14443A_Card.UID[ISO14443A_UID_PART]) , ISO14443A_UID_SINGLE_SIZE);
-		Length += ISO14443A_UID_SINGLE_SIZE ;
-	}
+	memcpy(&(pDataToSend[Length]),&(ISO14443A_Card.UID[2*ISO14443A_UID_PART]) , ISO14443A_UID_SINGLE_SIZE);
+	Length += ISO14443A_UID_SINGLE_SIZE ;
 
 	pDataToSend[Length ++] = BccByte;
 	/* Add the control byte : Append the CRC + 8 bits in first byte (standard frame)*/
@@ -508,8 +553,11 @@ static int8_t ISO14443A_HLTA( uint8_t *pDataRead )
 static int8_t ISO14443A_RATS( uint8_t *pDataRead )
 {
 	int8_t status;	
-	uint8_t FSCI;
-	uc8 	 pdata[]= { 0xE0, 0x80, 0x28};
+	uint8_t FSCI,
+					NthByte = 2,
+					PP = ISO14443A_DEFAULT_PP,
+					MM = ISO14443A_DEFAULT_MM;
+	uc8 	 pdata[]= { COMMAND_RATS, PCD_ISO14443_FSDI << 4, 0x28};
 
 	/* send the command to the PCD device*/
 	errchk(PCD_SendRecv(0x03,pdata,pDataRead));
@@ -519,7 +567,24 @@ static int8_t ISO14443A_RATS( uint8_t *pDataRead )
 	errchk(PCD_IsCRCOk (PCD_PROTOCOL_ISO14443A,pDataRead) );
 
 	FSCI = pDataRead[3]&0x0F;
-	FSC = FSCIToFSC(FSCI);
+	FSC = PCD_ISO14443FrameSize(FSCI);
+
+	/* keeps the ATS for the reactivation cache */
+	LastATSsize = MIN(pDataRead[PCD_DATA_OFFSET], ISO14443A_MAX_ATS_SIZE);
+	memcpy(LastATS, &pDataRead[PCD_DATA_OFFSET], LastATSsize);
+
+	/* TB(1) follows TA(1) when present */
+	ISO14443A_FWI = PCD_ISO14443_DEFAULTFWI;
+	ISO14443A_WTXM = 1;
+	if ((LastATS[1] & ISO14443A_ATS_TAPRESENTMASK) != 0x00)
+		NthByte++;
+	if (LastATSsize > NthByte && (LastATS[1] & ISO14443A_ATS_TBPRESENTMASK) != 0x00)
+		ISO14443A_FWI = LastATS[NthByte] >> ISO14443A_ATS_FWISHIFT;
+	/* the time out of the PCD device is too short for this card */
+	if (PCD_ISO14443FrameWaitingTime(ISO14443A_FWI, ISO14443A_WTXM, &PP, &MM) == true)
+	{
+		errchk(ISO14443A_ConfigureBitRate(PCD_ISO14443_BITRATE_106K, PCD_ISO14443_BITRATE_106K));
+	}
 
 	return ISO14443A_SUCCESSCODE;
 Error:
@@ -528,27 +593,111 @@ Error:
 
 
 /**
- * @brief Handles the WAKE_UP command
- * @param *pDataRead	: Pointer to the response
- * @return ISO14443A_SUCCESSCODE the function is succesful
- * @return ISO14443A_ERRORCODE_DEFAULT : an error occured
+ * @brief  this function negotiates the bit rates with the PPS command (highest bit rates of ATS TA(1)).
+ * @brief  The PCD device is configured with the new bit rates and the card presence is checked, when it
+ * @brief  fails the PCD device goes back to 106 kbps and the next PPS will ask a lower bit rate.
+ * @param  *pDataRead	: Pointer to the response
+ * @return ISO14443A_SUCCESSCODE the function is succesful (bit rates in ISO14443A_Card.DRI and DSI)
+ * @return ISO14443A_ERRORCODE_DEFAULT : the card is lost at the new bit rate
  */
 static int8_t ISO14443A_PPS( uint8_t *pDataRead )
 {
-	uc8 	 pdata[]= { 0xD0, 0x11, 0x00, 0x28};
+	uint8_t pdata[]= { COMMAND_PPS, 0x11, 0x00, 0x28},
+					PresenceCheck[]= { COMMAND_NACKBLOCK, 0x28},
+					DR,
+					DS;
 	int8_t status;
 
-	/* sends the command to the PCD device*/
-	errchk(PCD_SendRecv(0x04,pdata,pDataRead));
+	ISO14443A_Card.DRI = PCD_ISO14443_BITRATE_106K;
+	ISO14443A_Card.DSI = PCD_ISO14443_BITRATE_106K;
+
+	/* TA(1) is present when b5 of T0 is set */
+	if (LastATSsize < 3 || (LastATS[1] & 0x10) == 0x00)
+		return ISO14443A_SUCCESSCODE;
+
+	PCD_ISO14443BitRate(LastATS[2], ISO14443A_MaxBitRate, &DR, &DS);
+	/* 106 kbps in both directions : the PPS is useless */
+	if (DR == PCD_ISO14443_BITRATE_106K && DS == PCD_ISO14443_BITRATE_106K)
+		return ISO14443A_SUCCESSCODE;
+
+	/* PPS1 : DSI (b4-b3) | DRI (b2-b1) */
+	pdata[2] = (DS << 2) | DR;
+
+	/* sends the command to the PCD device, the card stays at 106 kbps when it does not answer */
+	if (PCD_SendRecv(0x04,pdata,pDataRead) != PCD_SUCCESSCODE ||
+			PCD_IsCRCOk (PCD_PROTOCOL_ISO14443A,pDataRead) != PCD_SUCCESSCODE ||
+			pDataRead[PCD_DATA_OFFSET] != COMMAND_PPS)
+		return ISO14443A_SUCCESSCODE;
+
+	/* the card uses the new bit rates */
+	errchk(ISO14443A_ConfigureBitRate(DR, DS));
+	ISO14443A_Card.DRI = DR;
+	ISO14443A_Card.DSI = DS;
 
-	/* checks the CRC */
+	/* the card answers R(ACK) to a R(NAK) */
+	errchk(PCD_SendRecv(0x02,PresenceCheck,pDataRead));
 	errchk(PCD_IsCRCOk (PCD_PROTOCOL_ISO14443A,pDataRead) );
-	
+
 	return ISO14443A_SUCCESSCODE;
 Error:
+	/* fallback : a lower bit rate will be asked at the next activation */
+	if (ISO14443A_MaxBitRate > PCD_ISO14443_BITRATE_106K)
+		ISO14443A_MaxBitRate = MAX(DR, DS) - 1;
+	ISO14443A_ConfigureBitRate(PCD_ISO14443_BITRATE_106K, PCD_ISO14443_BITRATE_106K);
+	ISO14443A_Card.DRI = PCD_ISO14443_BITRATE_106K;
+	ISO14443A_Card.DSI = PCD_ISO14443_BITRATE_106K;
 	return ISO14443A_ERRORCODE_DEFAULT; 
 }
 
+/**
+ * @brief  this function configures the PCD device for the IS014443A protocol at the given bit rates
+ * @param  DR	: bit rate from the PCD device to the card (PCD_ISO14443_BITRATE_xxx)
+ * @param  DS	: bit rate from the card to the PCD device (PCD_ISO14443_BITRATE_xxx)
+ * @return ISO14443A_SUCCESSCODE the function is succesful
+ * @return ISO14443A_ERRORCODE_DEFAULT : an error occured
+ */
+static int8_t ISO14443A_ConfigureBitRate( uc8 DR, uc8 DS )
+{
+	u8  ProtocolSelectParameters []  = {0x00, ISO14443A_DEFAULT_PP, ISO14443A_DEFAULT_MM},
+			WriteRegisterParameters []  = {0x5A, 0x04},
+			DemoGainParameters []  = {0x01, 0xDF};
+	uint8_t  *pDataRead = u95HFBuffer;
+	int8_t  status;
+
+	ProtocolSelectParameters[0] = PCD_ISO14443_TRANSMISSIONSPEED(DR) | PCD_ISO14443_RECEPTIONSPEED(DS);
+	/* time out of the PCD device : frame waiting time of the card (extended by S(WTX)) */
+	PCD_ISO14443FrameWaitingTime(ISO14443A_FWI, ISO14443A_WTXM, &ProtocolSelectParameters[1], &ProtocolSelectParameters[2]);
+
+	/* sends a protocol Select command to the pcd to configure it */
+	errchk(PCD_ProtocolSelect(0x04,PCD_PROTOCOL_ISO14443A,ProtocolSelectParameters,pDataRead)); 
+
+	errchk(PCD_WriteRegister    ( 0x04,0x3A,0x00,WriteRegisterParameters,pDataRead));
+
+	/* in order to adjust the demoduation gain of the PCD*/
+	errchk(PCD_WriteRegister (0x04,0x68,0x01,DemoGainParameters,u95HFBuffer));
+
+#if 0
+  errchk(PCD_WriteRegister  ( 0x03,0x68,0x00,&StartIndex,pDataRead)); 
+
+	for(i=0; i<=1; i++)
+	{
+		errchk(PCD_WriteRegister  ( 0x03,0x69,0x00,&DemoGainParameters[i],pDataRead)); 
+	} 
+
+ 
+	errchk(PCD_WriteRegister  ( 0x03,0x68,0x00,&StartIndex,pDataRead)); 
+	for(i=0; i<=5; i++)
+	{
+		errchk(PCD_ReadRegister ( 0x03,0x69,0x01,0x00,pDataRead));
+		DemoGainParameters[i] = pDataRead[2];
+	}
+#endif
+
+	return ISO14443A_SUCCESSCODE;
+Error:
+	return ISO14443A_ERRORCODE_DEFAULT;
+}
+
 
 /**
  * @brief  this function completes the ISO144443 type A structure according to the ATQA response
@@ -578,42 +727,130 @@ static void ISO14443A_CompleteStructure ( uint8_t *pATQA )
 
 
 /**
- * @brief  Checks if a card is in the field
- * @param  None
- * @return ISO14443A_SUCCESSCODE (Anticollision done) / ISO14443A_ERRORCODE_DEFAULT (Communication issue)
+ * @brief  this function selects a known card with its whole UID (one SELECT by cascade level, no anticollision)
+ * @param  *pEntry	: reactivation entry of the card
+ * @param  *pDataRead	: Pointer to the PCD response
+ * @return ISO14443A_SUCCESSCODE the card answered with the expected SAK
+ * @return ISO14443A_ERRORCODE_DEFAULT : an error occured
  */
-static int8_t ISO14443A_MultiAnticollision( void )
+static int8_t ISO14443A_DirectSelect( ISO14443A_REACTIVATIONENTRY *pEntry, uint8_t *pDataRead )
 {
-	uint8_t *pDataRead = u95HFBufferAntiCol;
+	uint8_t CLn[ISO14443A_UID_SINGLE_SIZE],
+					NbLevel,
+					Level,
+					Offset = 0,
+					SAK = 0;
 	int8_t 	status;
 
-	
-	/* Checks if an error occured and execute the Anti-collision level 1*/
-	errchk(ISO14443A_ACLevel1(pDataRead) );
+	if (pEntry->UIDsize == ISO14443A_UID_SINGLE_SIZE)
+		NbLevel = CASCADE_LVL_1;
+	else if (pEntry->UIDsize == ISO14443A_UID_DOUBLE_SIZE)
+		NbLevel = CASCADE_LVL_2;
+	else
+		NbLevel = CASCADE_LVL_3;
 
-	/* UID Complete ? */
-	if(ISO14443A_Card.SAK & SAK_FLAG_UID_NOT_COMPLETE)
+	for (Level=0; Level<NbLevel; Level++)
 	{
-		/* Checks if an error occured and execute the Anti-collision level 2*/
-		errchk(ISO14443A_ACLevel2(pDataRead) );
-	}
-	/* UID Complete ? */
-	if(ISO14443A_Card.SAK & SAK_FLAG_UID_NOT_COMPLETE)
-	{
-		/* Checks if an error occured and execute the Anti-collision level 3*/
-		errchk(ISO14443A_ACLevel3(pDataRead) );
+		if (Level < NbLevel-1)
+		{
+			CLn[0] = ISO14443A_CASCADETAG;
+			memcpy(&CLn[1], &pEntry->UID[Offset], ISO14443A_UID_PART);
+			Offset += ISO14443A_UID_PART;
+		}
+		else
+			memcpy(CLn, &pEntry->UID[Offset], ISO14443A_UID_SINGLE_SIZE);
+
+		errchk(ISO14443A_Select(SEL_CASCADE_LVL_1+2*Level, CLn, &SAK, pDataRead));
+		if (Level < NbLevel-1 && (SAK & SAK_FLAG_UID_NOT_COMPLETE) == 0x00)
+			return ISO14443A_ERRORCODE_DEFAULT;
 	}
 
-	/* Quiet the founded tag */
-	/* Send a HALT command */
-	errchk(ISO14443A_HLTA(pDataRead) );
-	
+	if (SAK != pEntry->SAK)
+		return ISO14443A_ERRORCODE_DEFAULT;
+
 	return ISO14443A_SUCCESSCODE;
 Error:
-	return ISO14443A_ERRORCODE_DEFAULT; 
+	return ISO14443A_ERRORCODE_DEFAULT;
+}
+
+/**
+ * @brief  this function looks for a card in the reactivation cache
+ * @param  *pUID	: UID of the card
+ * @param  UIDsize	: UID size
+ * @return index of the entry / -1 when the card is not in the cache
+ */
+static int8_t ISO14443A_FindReactivation( uc8 *pUID, uc8 UIDsize )
+{
+	uint8_t i;
+
+	for (i=0; i<ISO14443A_REACTIVATION_NBENTRY; i++)
+	{
+		if (ReactivationAge[i] != 0 && ReactivationCache[i].UIDsize == UIDsize &&
+				memcmp(ReactivationCache[i].UID, pUID, UIDsize) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+/**
+ * @brief  this function marks an entry of the reactivation cache as the most recently used
+ * @param  Index	: index of the entry
+ * @return void
+ */
+static void ISO14443A_TouchReactivation( uc8 Index )
+{
+	uint8_t i;
+
+	if (++ReactivationTick == 0)
+	{
+		/* counter overflow: keep the entries but restart their age */
+		for (i=0; i<ISO14443A_REACTIVATION_NBENTRY; i++)
+		{
+			if (ReactivationAge[i] != 0)
+				ReactivationAge[i] = 1;
+		}
+		ReactivationTick = 2;
+	}
+
+	ReactivationAge[Index] = ReactivationTick;
+}
+
+/**
+ * @brief  this function stores the card just activated in the reactivation cache
+ * @brief  (the least recently used entry is replaced when the cache is full)
+ * @return void
+ */
+static void ISO14443A_StoreReactivation( void )
+{
+	ISO14443A_REACTIVATIONENTRY *pEntry;
+	int8_t	Index;
+	uint8_t i;
 
+	Index = ISO14443A_FindReactivation(ISO14443A_Card.UID, ISO14443A_Card.UIDsize);
+	if (Index < 0)
+	{
+		Index = 0;
+		for (i=1; i<ISO14443A_REACTIVATION_NBENTRY; i++)
+		{
+			if (ReactivationAge[i] < ReactivationAge[Index])
+				Index = i;
+		}
+	}
+
+	pEntry = &ReactivationCache[Index];
+	memcpy(pEntry->ATQA, ISO14443A_Card.ATQA, ISO14443A_ATQA_SIZE);
+	pEntry->UIDsize = ISO14443A_Card.UIDsize;
+	memcpy(pEntry->UID, ISO14443A_Card.UID, ISO14443A_MAX_UID_SIZE);
+	pEntry->SAK = ISO14443A_Card.SAK;
+	pEntry->ATSsize = LastATSsize;
+	memcpy(pEntry->ATS, LastATS, LastATSsize);
+	pEntry->FSC = FSC;
+
+	ISO14443A_TouchReactivation(Index);
 }
 
+
 /**
   * @}
   */ 
@@ -632,38 +869,16 @@ Error:
  */
 int8_t ISO14443A_Init ( void )
 {
-	u8  ProtocolSelectParameters []  = {0x00, 0x01, 0xA0},
-			WriteRegisterParameters []  = {0x5A, 0x04},
-			DemoGainParameters []  = {0x01, 0xDF};
-	uint8_t  *pDataRead = u95HFBuffer;
 	int8_t  status;
 
 	ISO14443A_InitStructure( );
+	ISO14443A_FWI = PCD_ISO14443_DEFAULTFWI;
+	ISO14443A_WTXM = 1;
 
-	/* sends a protocol Select command to the pcd to configure it */
-	errchk(PCD_ProtocolSelect(0x04,PCD_PROTOCOL_ISO14443A,ProtocolSelectParameters,pDataRead)); 
-
-	errchk(PCD_WriteRegister    ( 0x04,0x3A,0x00,WriteRegisterParameters,pDataRead));
-
-	/* in order to adjust the demoduation gain of the PCD*/
-	errchk(PCD_WriteRegister (0x04,0x68,0x01,DemoGainParameters,u95HFBuffer));
-
-#if 0
-  errchk(PCD_WriteRegister  ( 0x03,0x68,0x00,&StartIndex,pDataRead)); 
-
-	for(i=0; i<=1; i++)
-	{
-		errchk(PCD_WriteRegister  ( 0x03,0x69,0x00,&DemoGainParameters[i],pDataRead)); 
-	} 
-
- 
-	errchk(PCD_WriteRegister  ( 0x03,0x68,0x00,&StartIndex,pDataRead)); 
-	for(i=0; i<=5; i++)
-	{
-		errchk(PCD_ReadRegister ( 0x03,0x69,0x01,0x00,pDataRead));
-		DemoGainParameters[i] = pDataRead[2];
-	}
-#endif
+	/* the activation is done at 106 kbps */
+	errchk(ISO14443A_ConfigureBitRate(PCD_ISO14443_BITRATE_106K, PCD_ISO14443_BITRATE_106K));
+	ISO14443A_Card.DRI = PCD_ISO14443_BITRATE_106K;
+	ISO14443A_Card.DSI = PCD_ISO14443_BITRATE_106K;
  
  return ISO14443A_SUCCESSCODE;
 Error:
@@ -741,6 +956,7 @@ int8_t ISO14443A_Anticollision( void )
 	uint8_t *pDataRead = u95HFBuffer;
 	int8_t 	status;
 
+	LastATSsize = 0;
 	
 	/* Checks if an error occured and execute the Anti-collision level 1*/
 	errchk(ISO14443A_ACLevel1(pDataRead) );
@@ -773,6 +989,9 @@ int8_t ISO14443A_Anticollision( void )
 		st95tagtype = TT2;
 	else 
 		st95tagtype = TT4A;
+
+	/* the next activation of this card can be done with ISO14443A_Reactivate */
+	ISO14443A_StoreReactivation();
 	
 	return ISO14443A_SUCCESSCODE;
 Error:
@@ -782,66 +1001,392 @@ Error:
 
 /**
  * @brief  Checks if cards are in the field
+ * @brief  (kept for compatibility, ISO14443A_MultiTagAnticollision returns all the cards in one call)
  * @param  *pNbTag: Number of tag detected
  * @param  *pUIDout: UIDs of detected tags (11 bytes by tag, first byte indicate UID size) 
  * @return ISO14443A_SUCCESSCODE (Anticollision done) / ISO14443A_ERRORCODE_DEFAULT (Communication issue)
  */
 void ISO14443A_MultiTagHunting ( uint8_t *pNbTag, uint8_t *pUIDout )
 {
-
-	bool exit = false;
-	u8 loop = 0;
+	ISO14443A_TAGRECORD Record[2*ISO14443A_MULTITAGHUNTING_NBTAG];
 	u8 		i = 0;
 
 	RemainingID = 0;
+
+	ISO14443A_MultiTagAnticollision(Record, 2*ISO14443A_MULTITAGHUNTING_NBTAG, pNbTag);
+
+	for (i=0; i<*pNbTag; i++)
+	{
+		if (i < ISO14443A_MULTITAGHUNTING_NBTAG)
+		{
+			pUIDout[i*ISO14443A_NBBYTE_TAGRECORD] = Record[i].UIDsize;
+			memcpy(&pUIDout[i*ISO14443A_NBBYTE_TAGRECORD+1], Record[i].UID, ISO14443A_MAX_UID_SIZE);
+		}
+		else
+		{
+			MultiIDPart2[RemainingID*ISO14443A_NBBYTE_TAGRECORD] = Record[i].UIDsize;
+			memcpy(&MultiIDPart2[RemainingID*ISO14443A_NBBYTE_TAGRECORD+1], Record[i].UID, ISO14443A_MAX_UID_SIZE);
+			RemainingID++;
+		}
+	}
+}
+
+
+void ISO14443A_MultiTagPart2 ( uint8_t *pNbTag, uint8_t *pUIDout )
+{
+	memcpy(pUIDout, &MultiIDPart2[0], RemainingID*ISO14443A_NBBYTE_TAGRECORD);
+	*pNbTag = RemainingID;
+}
+
+/**
+ * @brief  Checks if cards are in the field and stores them in an inventory table
+ * @brief  (the tags already in the table are updated)
+ * @param  *pTable: inventory table
+ * @param  Timestamp: time of the inventory (unit chosen by the application)
+ * @param  *pNbTag: Number of tag detected during this call
+ * @return ISO14443A_SUCCESSCODE / ISO14443A_ERRORCODE_DEFAULT (inventory table full or communication issue)
+ */
+int8_t ISO14443A_MultiTagInventory ( INVENTORY_TABLE *pTable, uc32 Timestamp, uint8_t *pNbTag )
+{
+	ISO14443A_TAGRECORD Record[ISO14443A_MULTITAGHUNTING_NBTAG];
+	uint8_t NbTag = 0,
+					i;
+	int8_t 	ACStatus,
+					status = ISO14443A_SUCCESSCODE;
+
 	*pNbTag = 0;
-	
+
+	/* the cards found are halted, the next call goes on with the remaining ones */
+	do{
+		ACStatus = ISO14443A_MultiTagAnticollision(Record, ISO14443A_MULTITAGHUNTING_NBTAG, &NbTag);
+
+		for (i=0; i<NbTag; i++)
+		{
+			if (INVENTORY_Add (pTable, INVENTORY_TECHNO_ISO14443A, Record[i].UID, Record[i].UIDsize,
+													Record[i].SAK, INVENTORY_RSSI_UNKNOWN, Timestamp) != INVENTORY_SUCCESSCODE)
+				status = ISO14443A_ERRORCODE_DEFAULT;
+		}
+		*pNbTag += NbTag;
+	}while (ACStatus == ISO14443A_ERRORCODE_TAGOVERFLOW && *pNbTag <= 0xFF - ISO14443A_MULTITAGHUNTING_NBTAG);
+
+	if (ACStatus != ISO14443A_SUCCESSCODE)
+		status = ISO14443A_ERRORCODE_DEFAULT;
+
+	return status;
+}
+
+/**
+ * @brief  Runs a tree walk anticollision on the three cascade levels and returns the cards in the field.
+ * @brief  Each card found is selected then halted (HLTA). The collisions met are stacked so that
+ * @brief  the next round starts (REQA + SELECT of the known levels) directly on the next branch of the tree.
+ * @brief  The walk ends when no card answers to a request sent from the root.
+ * @param  *pRecord: card records (ATQA, UID size, UID, SAK)
+ * @param  MaxNbTag: number of records of pRecord
+ * @param  *pNbTag: Number of tag detected
+ * @return ISO14443A_SUCCESSCODE : all the cards are in pRecord
+ * @return ISO14443A_ERRORCODE_TAGOVERFLOW : pRecord is full, the remaining cards are not halted and can be
+ * @return 			read with another call
+ * @return ISO14443A_ERRORCODE_DEFAULT : Communication issue
+ */
+int8_t ISO14443A_MultiTagAnticollision ( ISO14443A_TAGRECORD *pRecord, uc8 MaxNbTag, uint8_t *pNbTag )
+{
+	ISO14443A_ACPATH	Path;
+	uint8_t *pDataRead = u95HFBufferAntiCol,
+					SAK = 0,
+					Level,
+					NbError = 0,
+					i;
+	ISO14443A_TAGRECORD	Card;
+	bool		FromRoot;
+	int8_t 	status;
+
+	*pNbTag = 0;
+	NbACBranch = 0;
+
 	delay_ms(5);
-		
-	ISO14443A_InitStructure(); /* only initialize structure */
 
-	while( exit == false && loop<= 5 )
+	while (NbError < ISO14443A_TREEWALK_NBRETRY)
 	{
+		/* next branch of the tree or whole tree */
+		FromRoot = (NbACBranch == 0);
+		if (FromRoot == true)
+			memset(&Path, 0x00, sizeof(ISO14443A_ACPATH));
+		else
+			memcpy(&Path, &ACBranch[--NbACBranch], sizeof(ISO14443A_ACPATH));
+
+		/* the cards left in ready state by the previous round are back in idle state after the first request */
 		ISO14443A_InitStructure();
-		if(ISO14443A_IsPresent() == RESULTOK)
+		status = ISO14443A_IsPresent();
+		if (status != ISO14443A_SUCCESSCODE)
 		{
-			delay_us (50);
-			if(ISO14443A_MultiAnticollision() == RESULTOK)
-			{	
-				MultiID[0+((*pNbTag)*11)] = ISO14443A_Card.UIDsize;
-				for(i=0; i<10; i++)			
-				{
-					MultiID[(1+i)+((*pNbTag)*11)] = ISO14443A_Card.UID[i];
-				}
-				*pNbTag +=1;
-			}
+			/* no more card */
+			if (FromRoot == true)
+				return ISO14443A_SUCCESSCODE;
+			/* the cards of this branch have left the field */
+			continue;
 		}
-		else
+		delay_us (50);
+
+		/* the levels before the collision are known => direct select */
+		for (Level=0; Level<Path.Level && status == ISO14443A_SUCCESSCODE; Level++)
+			status = ISO14443A_Select(SEL_CASCADE_LVL_1+2*Level, Path.CLn[Level], &SAK, pDataRead);
+
+		/* anticollision of the current level and of the next ones */
+		while (status == ISO14443A_SUCCESSCODE)
+		{
+			Path.Level = Level;
+			status = ISO14443A_ACLoop(SEL_CASCADE_LVL_1+2*Level, Path.CLn[Level], Path.NbKnownBit, &Path, pDataRead);
+			if (status == ISO14443A_SUCCESSCODE)
+				status = ISO14443A_Select(SEL_CASCADE_LVL_1+2*Level, Path.CLn[Level], &SAK, pDataRead);
+			Path.NbKnownBit = 0;
+			Level++;
+			if ((SAK & SAK_FLAG_UID_NOT_COMPLETE) == 0x00)
+				break;
+			if (Level == CASCADE_LVL_3)
+				status = ISO14443A_ERRORCODE_DEFAULT;
+		}
+
+		if (status != ISO14443A_SUCCESSCODE)
 		{
-			/* no more tag */
-			exit = true;
+			NbError++;
+			continue;
 		}
-		loop++;
+
+		/* UID = UID CLn without the cascade tags */
+		memcpy(Card.ATQA, ISO14443A_Card.ATQA, ISO14443A_ATQA_SIZE);
+		Card.UIDsize = 0;
+		for (i=0; i<Level-1; i++)
+		{
+			memcpy(&Card.UID[Card.UIDsize], &Path.CLn[i][1], ISO14443A_UID_PART);
+			Card.UIDsize += ISO14443A_UID_PART;
+		}
+		memcpy(&Card.UID[Card.UIDsize], Path.CLn[Level-1], ISO14443A_UID_SINGLE_SIZE);
+		Card.UIDsize += ISO14443A_UID_SINGLE_SIZE;
+		memset(&Card.UID[Card.UIDsize], 0x00, ISO14443A_MAX_UID_SIZE-Card.UIDsize);
+		Card.SAK = SAK;
+
+		/* a card whose HLTA was missed answers again : it is not reported twice */
+		for (i=0; i<*pNbTag; i++)
+		{
+			if (pRecord[i].UIDsize == Card.UIDsize && memcmp(pRecord[i].UID, Card.UID, Card.UIDsize) == 0)
+				break;
+		}
+		if (i < *pNbTag)
+		{
+			/* counted as an error so that a card which never halts cannot loop the walk */
+			NbError++;
+			ISO14443A_HLTA(pDataRead);
+			continue;
+		}
+
+		/* the card is selected, is there room for it */
+		if (*pNbTag >= MaxNbTag)
+			return ISO14443A_ERRORCODE_TAGOVERFLOW;
+
+		memcpy(&pRecord[*pNbTag], &Card, sizeof(ISO14443A_TAGRECORD));
+		(*pNbTag)++;
+		/* the retries are given to each card */
+		NbError = 0;
+
+		/* Quiet the founded tag */
+		ISO14443A_HLTA(pDataRead);
 	}
-	
-	if( *pNbTag <= 5)
+
+	return ISO14443A_ERRORCODE_DEFAULT;
+}
+
+/**
+ * @brief  Activates a card with the reactivation cache (cards already activated by ISO14443A_Anticollision).
+ * @brief  The cards are woken up with WUPA and the known cards are selected with their whole UID,
+ * @brief  the most recent first. When a card confirms its identity (same SAK) the anticollision is skipped,
+ * @brief  the RATS is still sent (needed to enter the ISO14443-4 protocol) and the cached FSC is used when the
+ * @brief  ATS did not change. Otherwise the complete ISO14443A_Anticollision is run.
+ * @param  None
+ * @return ISO14443A_SUCCESSCODE (card activated) / ISO14443A_ERRORCODE_DEFAULT (no card or communication issue)
+ */
+int8_t ISO14443A_Reactivate ( void )
+{
+	ISO14443A_REACTIVATIONENTRY *pEntry;
+	uint8_t *pDataRead = u95HFBuffer,
+					NbTry,
+					i;
+	uint32_t	AgeBound = 0x10000;
+	int8_t	Index,
+					status;
+
+	ISO14443A_InitStructure();
+
+	/* WakeUp attempt */
+	if (ISO14443A_WUPA(pDataRead) != ISO14443A_SUCCESSCODE)
 	{
-		memcpy(pUIDout, &MultiID[0], (*pNbTag)*11 );
+		/* try again in case tag was in ready or active state */
+		errchk(ISO14443A_WUPA(pDataRead));
 	}
-	else
+	ISO14443A_Card.IsDetected = true;
+
+	for (NbTry=0; NbTry<ISO14443A_REACTIVATION_NBENTRY; NbTry++)
 	{
-		memcpy(pUIDout, &MultiID[0], 5*11 );
-		RemainingID = (*pNbTag-5);
-		memcpy(&MultiIDPart2[0], &MultiID[5*11] , RemainingID*11 );	
+		/* most recent entry not tried yet */
+		Index = -1;
+		for (i=0; i<ISO14443A_REACTIVATION_NBENTRY; i++)
+		{
+			if (ReactivationAge[i] != 0 && ReactivationAge[i] < AgeBound &&
+					(Index < 0 || ReactivationAge[i] > ReactivationAge[Index]))
+				Index = i;
+		}
+		if (Index < 0)
+			break;
+		AgeBound = ReactivationAge[Index];
+		pEntry = &ReactivationCache[Index];
+
+		/* the ATQA gives the UID size, no need to try the other ones */
+		if (memcmp(pEntry->ATQA, ISO14443A_Card.ATQA, ISO14443A_ATQA_SIZE) != 0)
+			continue;
+
+		if (ISO14443A_DirectSelect(pEntry, pDataRead) != ISO14443A_SUCCESSCODE)
+		{
+			/* the cards are back in idle state */
+			errchk(ISO14443A_WUPA(pDataRead));
+			continue;
+		}
+
+		/* the card confirmed its identity */
+		memcpy(ISO14443A_Card.UID, pEntry->UID, ISO14443A_MAX_UID_SIZE);
+		ISO14443A_Card.UIDsize = pEntry->UIDsize;
+		ISO14443A_Card.SAK = pEntry->SAK;
+
+		if(ISO14443A_Card.SAK & SAK_FLAG_ATS_SUPPORTED)
+		{
+			ISO14443A_Card.ATSSupported = true;
+			if (ISO14443A_RATS(pDataRead) != ISO14443A_SUCCESSCODE)
+			{
+				ReactivationAge[Index] = 0;
+				return ISO14443A_ERRORCODE_DEFAULT;
+			}
+
+			if (LastATSsize == pEntry->ATSsize && memcmp(LastATS, pEntry->ATS, LastATSsize) == 0)
+				FSC = pEntry->FSC;
+			else
+			{
+				/* the card changed its parameters */
+				ISO14443A_StoreReactivation();
+			}
+			/* the card is back at 106 kbps after the RATS */
+			errchk(ISO14443A_PPS(pDataRead) );
+		}
+
+		st95mode = PCD;
+		/* Check the Tag type found */
+		if (ISO14443A_Card.SAK == 0x00) /* TT2 */
+			st95tagtype = TT2;
+		else 
+			st95tagtype = TT4A;
+
+		ISO14443A_TouchReactivation(Index);
+		return ISO14443A_SUCCESSCODE;
 	}
-		
+
+	/* unknown card (the cards are in ready state) */
+	return ISO14443A_Anticollision();
+Error:
+	return ISO14443A_ERRORCODE_DEFAULT;
 }
 
+/**
+ * @brief  Sets the highest bit rate asked with the PPS (the fallback after a failure lowers it)
+ * @param  BitRate: PCD_ISO14443_BITRATE_106K to PCD_ISO14443_BITRATE_848K
+ * @return None
+ */
+void ISO14443A_SetMaxBitRate ( uc8 BitRate )
+{
+	ISO14443A_MaxBitRate = MIN(BitRate, PCD_ISO14443_MAXBITRATE);
+}
 
-void ISO14443A_MultiTagPart2 ( uint8_t *pNbTag, uint8_t *pUIDout )
+/**
+ * @brief  Multiplies the time out of the PCD device by the WTXM of a S(WTX) block
+ * @param  WTXM: waiting time extension multiplier (1 goes back to the frame waiting time of the card)
+ * @return ISO14443A_SUCCESSCODE the function is succesful
+ * @return ISO14443A_ERRORCODE_DEFAULT : an error occured
+ */
+int8_t ISO14443A_ExtendFrameWaitingTime ( uc8 WTXM )
 {
-	memcpy(pUIDout, &MultiIDPart2[0], RemainingID*11);
-	*pNbTag = RemainingID;
+	uint8_t PP = ISO14443A_DEFAULT_PP,
+					MM = ISO14443A_DEFAULT_MM;
+	bool		WasExtended;
+
+	WasExtended = PCD_ISO14443FrameWaitingTime(ISO14443A_FWI, ISO14443A_WTXM, &PP, &MM);
+	ISO14443A_WTXM = WTXM;
+	PP = ISO14443A_DEFAULT_PP;
+	MM = ISO14443A_DEFAULT_MM;
+
+	/* the PCD device is configured again only when its time out changes */
+	if (WasExtended == false && PCD_ISO14443FrameWaitingTime(ISO14443A_FWI, ISO14443A_WTXM, &PP, &MM) == false)
+		return ISO14443A_SUCCESSCODE;
+
+	return ISO14443A_ConfigureBitRate(ISO14443A_Card.DRI, ISO14443A_Card.DSI);
+}
+
+/**
+ * @brief  Returns the historical bytes of the ATS received from the activated card
+ * @param  **ppHistoricalBytes: pointer on the first historical byte
+ * @return number of historical bytes (0 when the card did not return an ATS)
+ */
+uint8_t ISO14443A_GetHistoricalBytes ( uc8 **ppHistoricalBytes )
+{
+	uint8_t	NthByte = 2;
+
+	if (LastATSsize < NthByte)
+		return 0;
+
+	/* TL and T0, then TA(1), TB(1) and TC(1) when present */
+	if ((LastATS[1] & ISO14443A_ATS_TAPRESENTMASK) != 0x00)
+		NthByte++;
+	if ((LastATS[1] & ISO14443A_ATS_TBPRESENTMASK) != 0x00)
+		NthByte++;
+	if ((LastATS[1] & ISO14443A_ATS_TCPRESENTMASK) != 0x00)
+		NthByte++;
+
+	if (NthByte >= LastATSsize)
+		return 0;
+
+	*ppHistoricalBytes = &LastATS[NthByte];
+	return LastATSsize - NthByte;
+}
+
+/**
+ * @brief  Removes a card from the reactivation cache
+ * @param  *pUID: UID of the card
+ * @param  UIDsize: UID size
+ * @return None
+ */
+void ISO14443A_InvalidateReactivation ( uc8 *pUID, uc8 UIDsize )
+{
+	int8_t	Index;
+
+	Index = ISO14443A_FindReactivation(pUID, UIDsize);
+	if (Index >= 0)
+		ReactivationAge[Index] = 0;
+}
+
+/**
+ * @brief  Empties the reactivation cache
+ * @param  None
+ * @return None
+ */
+void ISO14443A_FlushReactivationCache ( void )
+{
+	memset(ReactivationAge, 0x00, sizeof(ReactivationAge));
+	ReactivationTick = 0;
+}
+
+/**
+ * @brief  Halts the selected card (HLTA), it only answers a WUPA afterwards
+ * @param  None
+ * @return ISO14443A_SUCCESSCODE : the command is sent
+ */
+int8_t ISO14443A_Halt ( void )
+{
+	return ISO14443A_HLTA(u95HFBuffer);
 }
 
 /**
@@ -27,12 +27,26 @@ extern ST95TagType st95tagtype;
 
 /* private variables 	-----------------------------------------------------------------*/
 ISO14443B_CARD 	ISO14443B_Card;
+/* highest bit rate requested with the ATTRIB (lowered when a bit rate fails) */
+static uint8_t	ISO14443B_MaxBitRate = PCD_ISO14443_MAXBITRATE;
+/* frame waiting time of the card (ATQB) and extension asked by the last S(WTX) */
+static uint8_t	ISO14443B_FWI = PCD_ISO14443_DEFAULTFWI;
+static uint8_t	ISO14443B_WTXM = 1;
+/* number of slots of the first round of the next anticollision (SLOT MARKER code) */
+static uint8_t	ISO14443B_FirstSlotCode = ISO14443B_SLOT_MARKER_1;
 
 static void ISO14443B_InitStructure							( void );
 static void ISO14443B_CompleteStruture 					( uint8_t *pDataRead );
 static int8_t ISO14443B_WriteARConfigB 					( void );
 static int8_t ISO14443B_WriteAndCheckARConfigB 	( void );
 static int8_t ISO14443BReadARConfigB 						( uint8_t *pDataRead );
+static int8_t ISO14443B_ConfigureBitRate				( uc8 DR, uc8 DS );
+static int8_t ISO14443B_CheckATQB								( int8_t SendStatus, uc8 *pDataRead );
+static int8_t ISO14443B_HltB										( uc8 *pPUPI, uint8_t *pDataRead );
+static uint8_t ISO14443B_SlotCode								( uc8 NbCard );
+static int8_t ISO14443B_SlotRound								( uc8 ReqParam, uc8 SlotCode, ISO14443B_TAGRECORD *pRecord, uc8 MaxNbTag, uint8_t *pNbTag,
+																									bool Halt, uint8_t *pNbCollision, uint8_t *pDataRead );
+static int8_t ISO14443B_SlotAnticollision				( uc8 ReqParam, ISO14443B_TAGRECORD *pRecord, uc8 MaxNbTag, uint8_t *pNbTag, bool Halt );
 
 /** @addtogroup _95HF_Libraries
  * 	@{
@@ -155,26 +169,19 @@ Error:
 }
 
 /**
-  * @}
-  */ 
-
-
-/** @addtogroup lib_iso14443Bpcd_Public_Functions
- *  @{
- */
-
-/**
- * @brief  Initializes the the PCD device for the IS014443B protocol
+ * @brief  this function configures the PCD device for the IS014443B protocol at the given bit rates
+ * @param  DR	: bit rate from the PCD device to the card (PCD_ISO14443_BITRATE_xxx)
+ * @param  DS	: bit rate from the card to the PCD device (PCD_ISO14443_BITRATE_xxx)
  * @retval ISO14443B_SUCCESSCODE  : the PCD device is well configured.
  * @retval ISO14443B_ERRORCODE_DEFAULT : Communication issue.
  */
-int8_t ISO14443B_Init( void )
+static int8_t ISO14443B_ConfigureBitRate ( uc8 DR, uc8 DS )
 {
 	uint8_t		*pDataRead = u95HFBuffer;
 	int8_t		status;
 	
 #ifdef USE_QJDDEVICE
-uc8 ProtocolSelectParameters[] 	= { 
+uint8_t ProtocolSelectParameters[] 	= { 
 																		/* Parameters */		
 																		PCD_ISO14443B_TRANSMISSION_SPEED_106K     |
 																		PCD_ISO14443B_RECEPTION_SPEED_106K        |
@@ -185,20 +192,24 @@ uc8 ProtocolSelectParameters[] 	= {
 														};
 uc8	Length = 0x04;
 #else
-uc8 ProtocolSelectParameters[] 	= { 
+uint8_t ProtocolSelectParameters[] 	= { 
 																		/* Parameters */		
 																		PCD_ISO14443B_TRANSMISSION_SPEED_106K     |
 																		PCD_ISO14443B_RECEPTION_SPEED_106K        |
 																		PCD_ISO14443B_APPEND_CRC,	
 																		/* PP MM bytes */
-																		0x03,
-																		0xFF
+																		ISO14443B_DEFAULT_PP,
+																		ISO14443B_DEFAULT_MM
 																		
 														};
 uc8	Length = 0x04;
 #endif
 
-	ISO14443B_InitStructure( );
+	ProtocolSelectParameters[0] |= PCD_ISO14443_TRANSMISSIONSPEED(DR) | PCD_ISO14443_RECEPTIONSPEED(DS);
+#ifndef USE_QJDDEVICE
+	/* time out of the PCD device : frame waiting time of the card (extended by S(WTX)) */
+	PCD_ISO14443FrameWaitingTime(ISO14443B_FWI, ISO14443B_WTXM, &ProtocolSelectParameters[1], &ProtocolSelectParameters[2]);
+#endif
 
 	/* sends a protocol Select command to the pcd to configure it */
 	errchk(PCD_ProtocolSelect(Length,PCD_PROTOCOL_ISO14443B,ProtocolSelectParameters,pDataRead));
@@ -210,11 +221,225 @@ Error:
 	return ISO14443B_ERRORCODE_DEFAULT;
 }
 
+/**
+ * @brief  this function checks the answer received in a slot (REQB, WUPB or Slot-MARKER)
+ * @param  SendStatus	: status returned by PCD_SendRecv
+ * @param  *pDataRead	: Pointer to the PCD response
+ * @retval ISO14443B_SUCCESSCODE  : one card answered with a valid ATQB.
+ * @retval ISO14443B_ERRORCODE_DEFAULT  : no card answered in the slot.
+ * @retval ISO14443B_ERRORCODE_COLLISION  : several cards answered in the slot.
+ */
+static int8_t ISO14443B_CheckATQB ( int8_t SendStatus, uc8 *pDataRead )
+{
+	uint8_t NbByte = pDataRead[PCD_LENGTH_OFFSET];
+
+	/* empty slot */
+	if (SendStatus != PCD_SUCCESSCODE && pDataRead[PCD_COMMAND_OFFSET] == SENDRECV_ERRORCODE_FRAMEWAIT)
+		return ISO14443B_ERRORCODE_DEFAULT;
+
+	/* framing or CRC error, collision flag or truncated ATQB */
+	if (SendStatus != PCD_SUCCESSCODE ||
+			NbByte < ISO14443B_NBBYTE_ATQB + ISO14443B_NBBYTE_CRC + CONTROL_14443B_NBBYTE ||
+			pDataRead[PCD_DATA_OFFSET] != ISO14443B_ATQB_FIRSTBYTE ||
+			(pDataRead[PCD_DATA_OFFSET + NbByte - CONTROL_14443B_NBBYTE] & (CONTROL_14443B_CRCMASK | CONTROL_14443B_COLISIONMASK)) != 0)
+		return ISO14443B_ERRORCODE_COLLISION;
+
+	return ISO14443B_SUCCESSCODE;
+}
+
+/**
+ * @brief  this function emits a HLTB command to the card of the PUPI
+ * @param  *pPUPI	: PUPI of the card
+ * @param  *pDataRead	: Pointer to the PCD response
+ * @retval ISO14443B_SUCCESSCODE  : the card is halted.
+ * @retval ISO14443B_ERRORCODE_DEFAULT  : an error occured
+ */
+static int8_t ISO14443B_HltB ( uc8 *pPUPI, uint8_t *pDataRead )
+{
+	uint8_t HltB[1 + ISO14443B_MAX_PUPI_SIZE] = { ISO14443B_HLTB };
+	int8_t	status;
+
+	memcpy(&HltB[1], pPUPI, ISO14443B_MAX_PUPI_SIZE);
+	errchk(PCD_SendRecv(sizeof(HltB), HltB, pDataRead));
+	errchk(PCD_IsCRCOk(PCD_PROTOCOL_ISO14443B, pDataRead));
+
+	if (pDataRead[PCD_DATA_OFFSET] != ISO14443B_HLTB_ANSWER)
+		return ISO14443B_ERRORCODE_DEFAULT;
+
+	return ISO14443B_SUCCESSCODE;
+Error:
+	return ISO14443B_ERRORCODE_DEFAULT;
+}
+
+/**
+ * @brief  this function returns the smallest SLOT MARKER code giving a slot to each card
+ * @param  NbCard	: number of cards expected
+ * @retval ISO14443B_SLOT_MARKER_1 to ISO14443B_SLOT_MARKER_16
+ */
+static uint8_t ISO14443B_SlotCode ( uc8 NbCard )
+{
+	uint8_t SlotCode = ISO14443B_SLOT_MARKER_1;
+
+	while (ISO14443B_NBSLOT(SlotCode) < NbCard && SlotCode < ISO14443B_SLOT_MARKER_16)
+		SlotCode++;
+
+	return SlotCode;
+}
+
+/**
+ * @brief  this function runs one round of the slot anticollision : REQB/WUPB (slot 1) then a Slot-MARKER by slot
+ * @param  ReqParam	: ISO14443B_REQB_ATTEMPT or ISO14443B_WUPB_ATTEMPT
+ * @param  SlotCode	: ISO14443B_SLOT_MARKER_xxx
+ * @param  *pRecord	: card records (the *pNbTag first ones are already filled)
+ * @param  MaxNbTag	: number of records of pRecord
+ * @param  *pNbTag	: Number of tag detected
+ * @param  Halt	: true to halt each card found, false to stop on the first card (its ATQB stays in pDataRead)
+ * @param  *pNbCollision	: number of slots with a collision
+ * @param  *pDataRead	: Pointer to the PCD response
+ * @retval ISO14443B_SUCCESSCODE  : the round is done.
+ * @retval ISO14443B_ERRORCODE_TAGOVERFLOW  : pRecord is full.
+ */
+static int8_t ISO14443B_SlotRound ( uc8 ReqParam, uc8 SlotCode, ISO14443B_TAGRECORD *pRecord, uc8 MaxNbTag, uint8_t *pNbTag,
+																		bool Halt, uint8_t *pNbCollision, uint8_t *pDataRead )
+{
+	uc8			ReqB[]					= { 			/* APf */
+															ISO14443B_ANTICOLLISION_PREFIX_BYTE   , 
+															/* AFI */
+															ISO14443B_AFI_ALL_FAMILIES            , 
+															/* Parameters */
+															ISO14443B_EXTENDED_ATQB_NOT_SUPPORTED |  
+															ReqParam                              |
+															SlotCode 
+														};
+	uint8_t SlotMarker,
+					Slot,
+					i;
+	int8_t	status;
+
+	*pNbCollision = 0;
+
+	for (Slot = 1; Slot <= ISO14443B_NBSLOT(SlotCode); Slot++)
+	{
+		if (Slot == 1)
+			status = PCD_SendRecv(sizeof(ReqB), ReqB, pDataRead);
+		else
+		{
+			SlotMarker = ISO14443B_SLOTMARKER(Slot);
+			status = PCD_SendRecv(0x01, &SlotMarker, pDataRead);
+		}
+
+		status = ISO14443B_CheckATQB(status, pDataRead);
+		if (status == ISO14443B_ERRORCODE_COLLISION)
+			(*pNbCollision)++;
+		if (status != ISO14443B_SUCCESSCODE)
+			continue;
+
+		/* a card whose HLTB was lost answers again */
+		for (i=0; i<*pNbTag && memcmp(pRecord[i].PUPI, &pDataRead[PCD_DATA_OFFSET + 1], ISO14443B_MAX_PUPI_SIZE) != 0; i++);
+		if (i == *pNbTag)
+		{
+			if (*pNbTag >= MaxNbTag)
+				return ISO14443B_ERRORCODE_TAGOVERFLOW;
+			/* same fields as ISO14443B_CompleteStruture */
+			memcpy(pRecord[i].PUPI,							&pDataRead[PCD_DATA_OFFSET + 1], ISO14443B_MAX_PUPI_SIZE);
+			memcpy(pRecord[i].ApplicationField,	&pDataRead[PCD_DATA_OFFSET + 1 + 0x04], ISO14443B_MAX_APPLI_SIZE);
+			memcpy(pRecord[i].ProtocolInfo,			&pDataRead[PCD_DATA_OFFSET + 1 + 0x04 + 0x04], ISO14443B_MAX_PROTOCOL_SIZE);
+			(*pNbTag)++;
+		}
+
+		if (Halt == false)
+			return ISO14443B_SUCCESSCODE;
+
+		/* the card does not answer to the next REQB (a lost HLTB is sent again when it answers) */
+		ISO14443B_HltB(pRecord[i].PUPI, pDataRead);
+	}
+
+	return ISO14443B_SUCCESSCODE;
+}
+
+/**
+ * @brief  this function runs rounds of slot anticollision until no slot has a collision.
+ * @brief  The number of slots of a round is chosen from the collisions of the previous one
+ * @brief  (two cards at least by collision, two slots by card), the first round uses the number of cards
+ * @brief  found by the previous call.
+ * @param  ReqParam	: request of the first round, ISO14443B_REQB_ATTEMPT or ISO14443B_WUPB_ATTEMPT
+ * @param  *pRecord	: card records
+ * @param  MaxNbTag	: number of records of pRecord
+ * @param  *pNbTag	: Number of tag detected
+ * @param  Halt	: true to halt each card found, false to stop on the first card (its ATQB stays in u95HFBuffer)
+ * @retval ISO14443B_SUCCESSCODE  : the anticollision is done.
+ * @retval ISO14443B_ERRORCODE_TAGOVERFLOW  : pRecord is full.
+ * @retval ISO14443B_ERRORCODE_COLLISION  : collisions are left after ISO14443B_ANTICOLLISION_NBROUND rounds.
+ */
+static int8_t ISO14443B_SlotAnticollision ( uc8 ReqParam, ISO14443B_TAGRECORD *pRecord, uc8 MaxNbTag, uint8_t *pNbTag, bool Halt )
+{
+	uint8_t *pDataRead = u95HFBuffer,
+					Param = ReqParam,
+					SlotCode = ISO14443B_FirstSlotCode,
+					NbCollision,
+					NbRound;
+	int8_t	status = ISO14443B_SUCCESSCODE;
+
+	*pNbTag = 0;
+
+	for (NbRound = 0; NbRound < ISO14443B_ANTICOLLISION_NBROUND; NbRound++)
+	{
+		status = ISO14443B_SlotRound(Param, SlotCode, pRecord, MaxNbTag, pNbTag, Halt, &NbCollision, pDataRead);
+		if (status != ISO14443B_SUCCESSCODE || NbCollision == 0 || (Halt == false && *pNbTag != 0))
+			break;
+
+		SlotCode = ISO14443B_SlotCode(4 * NbCollision);
+		/* the halted cards stay out of the next rounds */
+		Param = ISO14443B_REQB_ATTEMPT;
+	}
+
+	if (NbRound == ISO14443B_ANTICOLLISION_NBROUND)
+		status = ISO14443B_ERRORCODE_COLLISION;
+
+	if (Halt == true)
+		ISO14443B_FirstSlotCode = ISO14443B_SlotCode(*pNbTag);
+
+	return status;
+}
+
+/**
+  * @}
+  */ 
+
+
+/** @addtogroup lib_iso14443Bpcd_Public_Functions
+ *  @{
+ */
+
+/**
+ * @brief  Initializes the the PCD device for the IS014443B protocol
+ * @retval ISO14443B_SUCCESSCODE  : the PCD device is well configured.
+ * @retval ISO14443B_ERRORCODE_DEFAULT : Communication issue.
+ */
+int8_t ISO14443B_Init( void )
+{
+	int8_t		status;
+
+	ISO14443B_InitStructure( );
+	ISO14443B_FWI = PCD_ISO14443_DEFAULTFWI;
+	ISO14443B_WTXM = 1;
+
+	/* the activation is done at 106 kbps */
+	errchk(ISO14443B_ConfigureBitRate(PCD_ISO14443_BITRATE_106K, PCD_ISO14443_BITRATE_106K));
+	ISO14443B_Card.DRI = PCD_ISO14443_BITRATE_106K;
+	ISO14443B_Card.DSI = PCD_ISO14443_BITRATE_106K;
+
+	return ISO14443B_SUCCESSCODE;
+Error:
+	return ISO14443B_ERRORCODE_DEFAULT;
+}
+
 /**
  * @brief  this function emits a REQB command to a PICC device
  * @param  *pDataRead	: Pointer to the response
  * @retval ISO14443B_SUCCESSCODE  : the function is successful.
  * @retval ISO14443B_ERRORCODE_DEFAULT  : an error occured
+ * @retval ISO14443B_ERRORCODE_COLLISION  : several cards answered
  */
 int8_t ISO14443B_ReqB ( uint8_t *pDataRead )
 {
@@ -230,16 +455,15 @@ int8_t ISO14443B_ReqB ( uint8_t *pDataRead )
 														};
 
 	/* sends the command to the PCD device*/
-	errchk(PCD_SendRecv(0x03,ReqB,pDataRead));
+	status = ISO14443B_CheckATQB(PCD_SendRecv(0x03,ReqB,pDataRead), pDataRead);
+	if (status != ISO14443B_SUCCESSCODE)
+		return status;
 	/* Filling of the data structure */
 	ISO14443B_Card.IsDetected = true;
 	/* complete the ISO 14443 type B strucure */
 	ISO14443B_CompleteStruture (pDataRead);
 		
 	return ISO14443B_SUCCESSCODE;
-Error:
-	return ISO14443B_ERRORCODE_DEFAULT; 
-
 }
 
 
@@ -269,7 +493,7 @@ int8_t ISO14443B_AttriB( uint8_t *pDataRead )
 																				EOF_REQUIRED                |
 																				SOF_REQUIRED                ,
 																				/* Parameter 2 */                          
-																				MAX_FRAME_SIZE_256_BYTES    |		 
+																				PCD_ISO14443_FSDI           |		 
 																				PCD_TO_PICC_106K            |
 																				PICC_TO_PCD_106K            ,
 																				/* Parameter 3 */              
@@ -279,12 +503,53 @@ int8_t ISO14443B_AttriB( uint8_t *pDataRead )
 																				CID_0	                     
 														};
 														
+	uint8_t DR,
+					DS,
+					PP = ISO14443B_DEFAULT_PP,
+					MM = ISO14443B_DEFAULT_MM;
+	uc8			PresenceCheck = COMMAND_NACKBLOCK_B;
+
+	/* frame waiting time of the card */
+	ISO14443B_FWI = ISO14443B_Card.ProtocolInfo[2] >> ISO14443B_PROTOCOLINFO_FWISHIFT;
+	ISO14443B_WTXM = 1;
+
+	/* highest bit rates of the ATQB bit rate capability */
+	PCD_ISO14443BitRate(ISO14443B_Card.ProtocolInfo[0], ISO14443B_MaxBitRate, &DR, &DS);
+	AttriB[6] |= (DS << 6) | (DR << 4);
+
 	/* copies the PUPI field */													
 	memcpy(&AttriB[1], ISO14443B_Card.PUPI, ISO14443B_MAX_PUPI_SIZE);
 	/* sends the command to the PCD device*/
 	errchk(PCD_SendRecv(0x09,AttriB,pDataRead));
 	/* checks the CRC */
 	errchk(PCD_IsCRCOk (PCD_PROTOCOL_ISO14443B,pDataRead) );
+
+	ISO14443B_Card.DRI = PCD_ISO14443_BITRATE_106K;
+	ISO14443B_Card.DSI = PCD_ISO14443_BITRATE_106K;
+
+	/* the time out of the PCD device is too short for this card */
+	if (DR == PCD_ISO14443_BITRATE_106K && DS == PCD_ISO14443_BITRATE_106K &&
+			PCD_ISO14443FrameWaitingTime(ISO14443B_FWI, ISO14443B_WTXM, &PP, &MM) == true)
+	{
+		errchk(ISO14443B_ConfigureBitRate(DR, DS));
+	}
+
+	/* the card answered at 106 kbps and uses the new bit rates from now on : 
+		 it answers R(ACK) to a R(NAK) with a valid CRC at these bit rates */
+	if (DR != PCD_ISO14443_BITRATE_106K || DS != PCD_ISO14443_BITRATE_106K)
+	{
+		if (ISO14443B_ConfigureBitRate(DR, DS) != ISO14443B_SUCCESSCODE || 
+				PCD_SendRecv(0x01,&PresenceCheck,pDataRead) != PCD_SUCCESSCODE ||
+				PCD_IsCRCOk (PCD_PROTOCOL_ISO14443B,pDataRead) != PCD_SUCCESSCODE)
+		{
+			/* fallback : a lower bit rate will be asked at the next activation */
+			ISO14443B_MaxBitRate = MAX(DR, DS) - 1;
+			ISO14443B_ConfigureBitRate(PCD_ISO14443_BITRATE_106K, PCD_ISO14443_BITRATE_106K);
+			return ISO14443B_ERRORCODE_DEFAULT;
+		}
+		ISO14443B_Card.DRI = DR;
+		ISO14443B_Card.DSI = DS;
+	}
 		
 	return ISO14443B_SUCCESSCODE;
 Error:
@@ -299,15 +564,43 @@ Error:
  */
 int8_t ISO14443B_IsPresent( void )
 {
+	return ISO14443B_IsPresentGuardTime(0);
+}
+
+/**
+ * @brief  this function checks if a card is in the field, the guard time only waits for the time 
+ * @brief  not yet spent with the RF field on
+ * @param  FieldOnTime : time (ms) already spent since the RF field was switched on
+ * @retval ISO14443B_SUCCESSCODE  : the function is successful.
+ * @retval ISO14443B_ERRORCODE_DEFAULT  : an error occured
+ */
+int8_t ISO14443B_IsPresentGuardTime( uc8 FieldOnTime )
+{
+	ISO14443B_TAGRECORD Record;
 	int8_t	status;
-	uint8_t *pDataRead = u95HFBuffer;
+	uint8_t *pDataRead = u95HFBuffer,
+					NbTag;
 	
 	/* Init the ISO14443 TypeB communication */
 	errchk(ISO14443B_Init( ));
 
-	delay_ms(5);
+	if (FieldOnTime < ISO14443B_GUARDTIME_MS)
+		delay_ms(ISO14443B_GUARDTIME_MS - FieldOnTime);
 	/* WakeUp attempt */
-	errchk(ISO14443B_ReqB(pDataRead));
+	status = ISO14443B_ReqB(pDataRead);
+	/* several cards answered : the slots separate them and the first card found is kept */
+	if (status == ISO14443B_ERRORCODE_COLLISION)
+	{
+		errchk(ISO14443B_SlotAnticollision(ISO14443B_REQB_ATTEMPT, &Record, 1, &NbTag, false));
+		if (NbTag == 0)
+			goto Error;
+		ISO14443B_Card.IsDetected = true;
+		ISO14443B_CompleteStruture(pDataRead);
+	}
+	else
+	{
+		errchk(status);
+	}
 	
 	return ISO14443B_SUCCESSCODE;
 Error:
@@ -356,6 +649,80 @@ Error:
 }
 
 
+/**
+ * @brief  Sets the highest bit rate asked with the ATTRIB (the fallback after a failure lowers it)
+ * @param  BitRate: PCD_ISO14443_BITRATE_106K to PCD_ISO14443_BITRATE_848K
+ * @retval None
+ */
+void ISO14443B_SetMaxBitRate ( uc8 BitRate )
+{
+	ISO14443B_MaxBitRate = MIN(BitRate, PCD_ISO14443_MAXBITRATE);
+}
+
+/**
+ * @brief  Multiplies the time out of the PCD device by the WTXM of a S(WTX) block
+ * @param  WTXM: waiting time extension multiplier (1 goes back to the frame waiting time of the card)
+ * @retval ISO14443B_SUCCESSCODE  : the PCD device is well configured.
+ * @retval ISO14443B_ERRORCODE_DEFAULT : Communication issue.
+ */
+int8_t ISO14443B_ExtendFrameWaitingTime ( uc8 WTXM )
+{
+	uint8_t PP = ISO14443B_DEFAULT_PP,
+					MM = ISO14443B_DEFAULT_MM;
+	bool		WasExtended;
+
+	WasExtended = PCD_ISO14443FrameWaitingTime(ISO14443B_FWI, ISO14443B_WTXM, &PP, &MM);
+	ISO14443B_WTXM = WTXM;
+	PP = ISO14443B_DEFAULT_PP;
+	MM = ISO14443B_DEFAULT_MM;
+
+	/* the PCD device is configured again only when its time out changes */
+	if (WasExtended == false && PCD_ISO14443FrameWaitingTime(ISO14443B_FWI, ISO14443B_WTXM, &PP, &MM) == false)
+		return ISO14443B_SUCCESSCODE;
+
+	return ISO14443B_ConfigureBitRate(ISO14443B_Card.DRI, ISO14443B_Card.DSI);
+}
+
+/**
+ * @brief  Runs a slot anticollision (WUPB/REQB then Slot-MARKER commands) and returns the cards in the field.
+ * @brief  Each card found is halted (HLTB). The number of slots follows the collisions of the previous round.
+ * @param  *pRecord: card records (PUPI, application data, protocol info of the ATQB)
+ * @param  MaxNbTag: number of records of pRecord
+ * @param  *pNbTag: Number of tag detected
+ * @retval ISO14443B_SUCCESSCODE : all the cards are in pRecord
+ * @retval ISO14443B_ERRORCODE_TAGOVERFLOW : pRecord is full, the remaining cards are not halted and can be
+ * @retval 			read with another call
+ * @retval ISO14443B_ERRORCODE_COLLISION : some cards are not separated
+ * @retval ISO14443B_ERRORCODE_DEFAULT : Communication issue
+ */
+int8_t ISO14443B_MultiTagAnticollision ( ISO14443B_TAGRECORD *pRecord, uc8 MaxNbTag, uint8_t *pNbTag )
+{
+	int8_t	status;
+
+	*pNbTag = 0;
+
+	/* Init the ISO14443 TypeB communication */
+	errchk(ISO14443B_Init( ));
+
+	delay_ms(5);
+	/* the WUPB of the first round wakes up the cards halted by a previous call */
+	return ISO14443B_SlotAnticollision(ISO14443B_WUPB_ATTEMPT, pRecord, MaxNbTag, pNbTag, true);
+Error:
+	return ISO14443B_ERRORCODE_DEFAULT;
+}
+
+/**
+ * @brief  Halts the card found by the last REQB (HLTB), it only answers a WUPB afterwards
+ * @param  None
+ * @retval ISO14443B_SUCCESSCODE : the card is halted
+ * @retval ISO14443B_ERRORCODE_DEFAULT : an error occured
+ */
+int8_t ISO14443B_Halt ( void )
+{
+	return ISO14443B_HltB(ISO14443B_Card.PUPI, u95HFBuffer);
+}
+
+
 /**
   * @}
   */ 
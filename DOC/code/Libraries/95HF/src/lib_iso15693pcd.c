@@ -34,18 +34,27 @@ static int8_t ISO15693_GetProtocolExtensionFlag (uc8 FlagsByte);
 static int8_t ISO15693_Inventory ( uc8 Flags , uc8 AFI, uc8 MaskLength, uc8 *MaskValue, uint8_t *pResponse);
 static int8_t ISO15693_InventoryOneSlot	( uc8 Flags , uc8 AFI, uc8 MaskLength, uc8 *MaskValue, uint8_t *pResponse  );
 static int16_t ISO15693_Inventory16Slots ( uc8 Flags , uc8 AFI, uc8 MaskLength, uc8 *MaskValue, uint8_t *NbTag, uint8_t *pResponse  );
+static int8_t ISO15693_STInventoryRead ( uc8 Flags , uc8 AFI, uc8 MaskLength, uc8 *MaskValue, uc8 FirstBlock, uc8 NbBlock, uint8_t *pResponse );
+static int8_t ISO15693_STInventoryReadRecord ( uc8 *pResponse, uc8 MaskLength, uc8 *MaskValue, uc8 NbBlock, uint8_t *pRecord );
+static uint16_t ISO15693_STInventoryRead16Slots ( uc8 Flags , uc8 AFI, uc8 MaskLength, uc8 *MaskValue, uc8 FirstBlock, uc8 NbBlock, uint8_t *NbTag, uint8_t *pOut );
+static void ISO15693_STInventoryReadAntiCollision ( uc8 Flags , uc8 AFI, uc8 FirstBlock, uc8 NbBlock, uint8_t *NbTag, uint8_t *pOut );
 /* Command functions --- */
 static int8_t ISO15693_CreateRequestFlag (uc8 SubCarrierFlag,uc8 DataRateFlag,uc8 InventoryFlag,uc8 ProtExtFlag,uc8 SelectOrAFIFlag,uc8 AddrOrNbSlotFlag,uc8 OptionFlag,uc8 RFUFlag);
 static int8_t ISO15693_StayQuiet(uc8 Flags,uc8 *UIDin);
 static int8_t ISO15693_ReadSingleBlock ( uc8 Flags, uc8 *UID, uc16 BlockNumber,uint8_t *pResponse );
 static int8_t ISO15693_WriteSingleBlock ( uc8 Flags, uc8 *UIDin, uc16 BlockNumber,uc8 *DataToWrite,uint8_t *pResponse );
 static int8_t ISO15693_ReadMultipleBlock (uc8 Flags, uc8 *UIDin, uint16_t BlockNumber, uc8 NbBlock, uint8_t *pResponse );
+static int8_t ISO15693_ExtendedReadMultipleBlock (uc8 Flags, uc8 *UIDin, uc16 BlockNumber, uc16 NbBlock, uint8_t *pResponse );
+static int8_t ISO15693_WriteMultipleBlock (uc8 Flags, uc8 *UIDin, uc16 BlockNumber, uc8 NbBlock, uc8 *DataToWrite, uint8_t *pResponse );
+static int8_t ISO15693_ExtendedWriteSingleBlock (uc8 Flags, uc8 *UIDin, uc16 BlockNumber, uc8 *DataToWrite, uint8_t *pResponse );
+static int8_t ISO15693_ExtendedWriteMultipleBlock (uc8 Flags, uc8 *UIDin, uc16 BlockNumber, uc16 NbBlock, uc8 *DataToWrite, uint8_t *pResponse );
 static int8_t ISO15693_SendEOF ( uint8_t *pResponse );
 /* Is functions --- */
 static int8_t ISO15693_IsInventoryFlag (uc8 FlagsByte);
 static int8_t ISO15693_IsAddressOrNbSlotsFlag (uc8 FlagsByte);
 static int8_t ISO15693_IsATagInTheField (uc8 *pTagReply);
 static int8_t ISO15693_IsCollisionDetected (uc8 *pTagReply);
+static int8_t ISO15693_CheckTagReply (uc8 *pResponse);
 /* CRC16 commands --- */
 static int16_t ISO15693_CRC16 (uc8 *DataIn,uc8 Length);
 static int8_t ISO15693_IsCorrectCRC16Residue (uc8 *DataIn,uc8 Length);
@@ -54,6 +63,28 @@ static uint8_t ISO15693_ReadMultipleTagData(uint8_t Tag_Density, uint8_t *Data_T
 static uint8_t ISO15693_ReadSingleTagData(uint8_t Tag_Density, uint8_t *Data_To_Read, uint16_t NbBlock_To_Read, uint16_t FirstBlock_To_Read);
 static uint8_t ISO15693_TagSave(uint8_t Tag_Density, uint16_t NbByte_To_Write, uint16_t FirstByte_To_Write, uint8_t *Data_To_Save, uint8_t *Length_Low_Limit, uint8_t *Length_High_Limit);
 static uint8_t ISO15693_WriteTagData(uint8_t Tag_Density, uint8_t *Data_To_Write, uint16_t NbBlock_To_Write, uint16_t FirstBlock_To_Write);
+/* System information cache --- */
+static int8_t ISO15693_ParseSystemInfo (uc8 *pResponse, uc8 RequestFlags, ISO15693_SYSTEMINFO *pSysInfo);
+static int8_t ISO15693_FindSystemInfo (uc8 *UIDin);
+static void ISO15693_StoreSystemInfo (ISO15693_SYSTEMINFO *pSysInfo);
+static void ISO15693_TouchSystemInfo (uc8 Index);
+/* Bulk functions --- */
+static uint8_t ISO15693_BulkReadTag (uc8 *UIDin, uc16 FirstBlock, uc16 NbBlock, ISO15693_SYSTEMINFO *pLayout, uint8_t *pData, ISO15693_BULKREADRESULT *pResult);
+/* Write buffer functions --- */
+static int8_t ISO15693_WriteBufferReadBlock (ISO15693_WRITEBUFFER *pBuffer, uc16 NthBlock);
+static uint8_t ISO15693_WriteBufferRequestFlags (ISO15693_WRITEBUFFER *pBuffer);
+static bool ISO15693_WriteBufferIsExtended (ISO15693_WRITEBUFFER *pBuffer);
+
+/* per-UID system information cache, the least recently used entry is replaced first */
+static ISO15693_SYSTEMINFO	SysInfoCache [ISO15693_SYSINFOCACHE_NBENTRY];
+static uint16_t							SysInfoCacheAge [ISO15693_SYSINFOCACHE_NBENTRY];	// 0 => free entry
+static uint16_t							SysInfoCacheTick = 0;
+/* UID of the tag answering the non addressed commands (updated by ISO15693_GetUID) */
+static uint8_t							CurrentUID [ISO15693_NBBYTE_UID];
+static bool									CurrentUIDValid = false;
+
+/** @ brief millisecond time base used for the bulk statistics (to be set by the application) */
+uint32_t (*ISO15693_GetTick_ms)(void) = 0x00;
 
 
 /** @addtogroup _95HF_Libraries
@@ -333,7 +364,7 @@ int8_t 		NthSlot = 0,
 			status,
 			NewFlags;
 int16_t		ReturnValue=0;
-uint8_t		pOneTagResponse [ISO15693_NBBYTE_UID+3+2];
+uint8_t		pOneTagResponse [RFTRANS_95HF_MAX_BUFFER_SIZE+3];	// the 95HF writes the whole reply (flags, DSFID, UID, CRC, control byte)
 	
 	// force NbSlot Flag to 0;
 	NewFlags = Flags & ~ISO15693_MASK_ADDRORNBSLOTSFLAG;
@@ -377,6 +408,211 @@ uint8_t		pOneTagResponse [ISO15693_NBBYTE_UID+3+2];
 
 }
 
+/**  
+* @brief  	this function sends an ST Inventory Read command. Only the ST tags which match the mask answer,
+* @brief	with their DSFID, UID and the requested blocks.
+* @param  	Flags		:  	Request flags (inventory flag shall be set, Nb_slots flag => 1 or 16 slots)
+* @param  	AFI			:  	AFI parameter (optional)
+* @param	MaskLength 	: 	Number of bits of mask value
+* @param	MaskValue	:  	mask value which is compare to Contacless tag UID 
+* @param  	FirstBlock	:  	first block to read
+* @param  	NbBlock		:  	number of blocks to read
+* @param	pResponse	: 	pointer on PCD  response
+* @retval 	ISO15693_SUCCESSCODE	: 	PCD  returns a succesful code
+* @retval 	ISO15693_ERRORCODE_PARAMETERLENGTH	: 	MaskLength value is erroneous
+* @retval 	ISO15693_ERRORCODE_DEFAULT	: 	 PCD  returns an error code
+*/
+static int8_t ISO15693_STInventoryRead ( uc8 Flags , uc8 AFI, uc8 MaskLength, uc8 *MaskValue, uc8 FirstBlock, uc8 NbBlock, uint8_t *pResponse )
+{
+uint8_t 	NthByte = 0,
+					DataToSend [ISO15693_MAXLENGTH_STINVENTORYREAD],
+					NbMaskBytes = (MaskLength+7)/8;
+int8_t		status;
+
+	// initialize the result code to 0xFF and length to 0  in case of error 
+	*pResponse = SENDRECV_ERRORCODE_SOFT;
+	*(pResponse+1) = 0x00;
+
+	if (MaskLength>ISO15693_NBBITS_MASKPARAMETER)
+		return ISO15693_ERRORCODE_PARAMETERLENGTH;
+
+	errchk(ISO15693_IsInventoryFlag (Flags));
+
+	DataToSend[NthByte++] = Flags;
+	DataToSend[NthByte++] = ISO15693_CMDCODE_ST_INVENTORYREAD;
+	DataToSend[NthByte++] = ISO15693_ICMFGCODE_ST;
+
+	if (ISO15693_GetSelectOrAFIFlag (Flags) == true)
+		DataToSend[NthByte++] = AFI;
+
+	DataToSend[NthByte++] = MaskLength;
+	if (NbMaskBytes != 0)
+	{
+		memcpy(&DataToSend[NthByte], MaskValue, NbMaskBytes);
+		NthByte += NbMaskBytes;
+		// clear the bits of the last byte which are not in the mask
+		if ((MaskLength % 8) != 0)
+			DataToSend[NthByte-1] &= (0x01 << (MaskLength % 8)) - 1;
+	}
+	DataToSend[NthByte++] = FirstBlock;
+	DataToSend[NthByte++] = NbBlock - 1;
+
+	errchk(PCD_SendRecv(NthByte,DataToSend,pResponse));
+
+	if (PCD_IsReaderResultCodeOk (SEND_RECEIVE,pResponse) != ISO15693_SUCCESSCODE)
+		return ISO15693_ERRORCODE_DEFAULT;
+
+	return ISO15693_SUCCESSCODE;
+Error:
+	return ISO15693_ERRORCODE_DEFAULT;
+}
+
+/**  
+* @brief  	this function checks the reply of one slot of an ST Inventory Read and writes the tag record.
+* @brief	When the tag only returns the UID bytes which are not covered by the mask, the first UID bytes
+* @brief	are taken from the mask value.
+* @param	pResponse	: 	pointer on PCD  response
+* @param	MaskLength 	: 	Number of bits of the mask sent
+* @param	MaskValue	:  	mask value sent
+* @param  	NbBlock		:  	number of blocks requested
+* @param	pRecord		: 	tag record (DSFID, UID, status, data)
+* @retval 	ISO15693_SUCCESSCODE	: 	one tag answered with a valid reply, the record is written
+* @retval 	ISO15693_ERRORCODE_CRCRESIDUE	: 	collision or invalid reply (several tags in the slot)
+* @retval 	ISO15693_ERRORCODE_DEFAULT	: 	no reply or the tag returned an error
+*/
+static int8_t ISO15693_STInventoryReadRecord ( uc8 *pResponse, uc8 MaskLength, uc8 *MaskValue, uc8 NbBlock, uint8_t *pRecord )
+{
+uint8_t 	NbDataByte = NbBlock*ISO15693_NBBYTE_BLOCKLENGTH,
+					NbUIDByte,
+					Index = PCD_DATA_OFFSET + ISO15693_NBBYTE_REPLYFLAG;
+uint8_t		status;
+
+	if (ISO15693_IsATagInTheField (pResponse) != ISO15693_SUCCESSCODE)
+		return ISO15693_ERRORCODE_DEFAULT;
+
+	status = ISO15693_CheckTagReply (pResponse);
+	/* the tag returned an error : it is left to the standard anticollision */
+	if (status == ISO15693_ERRORCODE_DEFAULT && pResponse[READERREPLY_STATUSOFFSET] == SENDRECV_RESULTSCODE_OK)
+		return ISO15693_ERRORCODE_DEFAULT;
+	if (status != ISO15693_SUCCESSCODE || ISO15693_IsCollisionDetected (pResponse) == ISO15693_SUCCESSCODE)
+		return ISO15693_ERRORCODE_CRCRESIDUE;
+
+	/* flags + DSFID + UID + data + CRC16 + control byte */
+	NbUIDByte = pResponse[PCD_LENGTH_OFFSET] - (ISO15693_NBBYTE_REPLYFLAG + ISO15693_NBBYTE_DSFID + NbDataByte
+																							+ ISO15693_NBBYTE_CRC16 + CONTROL_15693_NBBYTE);
+	if (NbUIDByte != ISO15693_NBBYTE_UID && NbUIDByte != ISO15693_NBBYTE_UID - MaskLength/8)
+		return ISO15693_ERRORCODE_DEFAULT;
+
+	pRecord[0] = pResponse[Index++];
+	if (NbUIDByte < ISO15693_NBBYTE_UID)
+		memcpy(&pRecord[ISO15693_NBBYTE_DSFID], MaskValue, ISO15693_NBBYTE_UID - NbUIDByte);
+	memcpy(&pRecord[ISO15693_NBBYTE_DSFID + ISO15693_NBBYTE_UID - NbUIDByte], &pResponse[Index], NbUIDByte);
+	Index += NbUIDByte;
+	pRecord[ISO15693_INVENTORYREADOFFSET_STATUS] = ISO15693_SUCCESSCODE;
+	memcpy(&pRecord[ISO15693_INVENTORYREADOFFSET_DATA], &pResponse[Index], NbDataByte);
+
+	return ISO15693_SUCCESSCODE;
+}
+
+/**  
+* @brief  	this function sends an ST Inventory Read command in 16 slots mode. The records of the ST tags
+* @brief	which answered alone in their slot are added to pOut and these tags are put in quiet state.
+* @param  	Flags		:  	Request flags (inventory flag shall be set)
+* @param  	AFI			:  	AFI parameter (optional)
+* @param	MaskLength 	: 	Number of bits of mask value
+* @param	MaskValue	:  	mask value which is compare to Contacless tag UID 
+* @param  	FirstBlock	:  	first block to read
+* @param  	NbBlock		:  	number of blocks to read
+* @param	NbTag		: 	number of records in pOut (updated)
+* @param	pOut		: 	tag records of ISO15693_NBBYTE_INVENTORYREADRECORD(NbBlock) bytes
+* @retval 	slots where a collision occured (bit n => slot n)
+*/
+static uint16_t ISO15693_STInventoryRead16Slots ( uc8 Flags , uc8 AFI, uc8 MaskLength, uc8 *MaskValue, uc8 FirstBlock, uc8 NbBlock, uint8_t *NbTag, uint8_t *pOut )
+{
+uint16_t	RecordLength = ISO15693_NBBYTE_INVENTORYREADRECORD(NbBlock),
+					SlotCollision = 0x0000;
+uint8_t		StayQuietFlags = (Flags & ~ISO15693_MASK_INVENTORYFLAG) | ISO15693_MASK_ADDRORNBSLOTSFLAG,
+					FirstTag = *NbTag,
+					NthSlot,
+					NthTag;
+uint8_t		status;
+
+	// force NbSlot Flag to 0
+	ISO15693_STInventoryRead (Flags & ~ISO15693_MASK_ADDRORNBSLOTSFLAG, AFI, MaskLength, MaskValue, FirstBlock, NbBlock, u95HFBuffer);
+
+	for (NthSlot=0; NthSlot<16; NthSlot++)
+	{
+		if (NthSlot != 0)
+		{
+			delayHighPriority_ms(5);
+			ISO15693_SendEOF (u95HFBuffer);
+		}
+
+		status = ISO15693_STInventoryReadRecord (u95HFBuffer, MaskLength, MaskValue, NbBlock, &pOut[(*NbTag)*RecordLength]);
+		if (status == ISO15693_SUCCESSCODE)
+			(*NbTag)++;
+		else if (status == ISO15693_ERRORCODE_CRCRESIDUE)
+			SlotCollision |= (0x0001 << NthSlot);
+	}
+
+	// the tags found do not answer to the next inventory commands
+	for (NthTag=FirstTag; NthTag<*NbTag; NthTag++)
+		ISO15693_StayQuiet (StayQuietFlags, &pOut[NthTag*RecordLength+ISO15693_NBBYTE_DSFID]);
+
+	return SlotCollision;
+}
+
+/**  
+* @brief  	this function runs the ST Inventory Read with the 16 slots anticollision (preorder traversal of the
+* @brief	UIDs as ISO15693_RunAntiCollision) : each ST tag returns its UID and its blocks in one RF frame.
+* @param  	Flags		:  	Request flags (inventory flag shall be set)
+* @param  	AFI			:  	AFI parameter (optional)
+* @param  	FirstBlock	:  	first block to read
+* @param  	NbBlock		:  	number of blocks to read
+* @param	NbTag		: 	number of records in pOut (updated)
+* @param	pOut		: 	tag records of ISO15693_NBBYTE_INVENTORYREADRECORD(NbBlock) bytes
+* @retval 	None
+*/
+static void ISO15693_STInventoryReadAntiCollision ( uc8 Flags , uc8 AFI, uc8 FirstBlock, uc8 NbBlock, uint8_t *NbTag, uint8_t *pOut )
+{
+	uint8_t		MaskValue[ISO15693_NBBYTE_UID],
+			MaskLength,
+			MaskStack [ISO15693_MASKSTACK_NBENTRY*ISO15693_MASKSTACK_ENTRYSIZE],	// the first byte of an entry is mask length (bit size).
+																								// the others bytes are mask value
+			NthStackValue=1,
+			i,
+			Nbloop = 0;
+	uint16_t	SlotCollision;
+
+	memset(MaskStack,0x00,ISO15693_MASKSTACK_ENTRYSIZE);
+
+	do{
+		// unstack mask length and mask value
+		NthStackValue -- ;
+		MaskLength = MaskStack[NthStackValue*ISO15693_MASKSTACK_ENTRYSIZE];
+		memcpy(MaskValue,(MaskStack+NthStackValue*ISO15693_MASKSTACK_ENTRYSIZE+1),ISO15693_NBBYTE_UID);
+
+		SlotCollision = ISO15693_STInventoryRead16Slots (Flags, AFI, MaskLength, MaskValue, FirstBlock, NbBlock, NbTag, pOut);
+
+		// stack the masks of the slots where a collision occured
+		for (i=0;i<16 && MaskLength+4 <= ISO15693_NBBITS_MASKPARAMETER && NthStackValue < ISO15693_MASKSTACK_NBENTRY;i++)
+		{
+			if ((SlotCollision & (0x01 <<i)) != 0)
+			{
+				// the new mask is the mask of the inventory followed by the slot where the collision occured
+				MaskStack[NthStackValue*ISO15693_MASKSTACK_ENTRYSIZE]= MaskLength + 4;
+				memcpy((MaskStack+(NthStackValue*ISO15693_MASKSTACK_ENTRYSIZE)+1),MaskValue,ISO15693_NBBYTE_UID);
+				MaskStack[NthStackValue*ISO15693_MASKSTACK_ENTRYSIZE+1+MaskLength/8] |= (i << (MaskLength%8));
+				NthStackValue++;
+			}
+		}
+
+		Nbloop ++;
+
+	// NbTag is on one byte : the next inventory 16 slots could add 16 tags
+	} while (NthStackValue >0 && Nbloop < 0x20 && *NbTag <= 0xFF-16);
+}
+
 
 /**  
 * @brief  	this function send an stay_quiet command to contacless tag.
@@ -463,6 +699,7 @@ uint8_t DataToSend[ISO15693_MAXLENGTH_READSINGLEBLOCK],
 * @param		pResponse	: 	pointer on PCD  response
 * @retval 	ISO15693_SUCCESSCODE	: 	PCD  returns a succesful code
 * @retval 	ISO15693_ERRORCODE_DEFAULT	: 	 PCD  returns an error code
+* @retval 	ISO15693_ERRORCODE_PARAMETERLENGTH	: 	 block above 255 without the protocol extension flag (nothing sent)
 */
 static int8_t ISO15693_WriteSingleBlock(uc8 Flags, uc8 *UIDin, uc16 BlockNumber,uc8 *DataToWrite,uint8_t *pResponse )
 {
@@ -470,6 +707,9 @@ uint8_t DataToSend[MAX_BUFFER_SIZE],
 		NthByte=0,
 		BlockLength = ISO15693_NBBYTE_BLOCKLENGTH;
 
+	/* a 1 byte block number would write the block BlockNumber modulo 256 */
+	if (BlockNumber > 0xFF && ISO15693_GetProtocolExtensionFlag (Flags) == false)
+		return ISO15693_ERRORCODE_PARAMETERLENGTH;
 	
 	DataToSend[NthByte++] = Flags;
 	DataToSend[NthByte++] = ISO15693_CMDCODE_WRITESINGLEBLOCK;
@@ -507,10 +747,11 @@ uint8_t DataToSend[MAX_BUFFER_SIZE],
 }
 
 /**  
-* @brief  this function send an ReadSingleBlock command to contactless tag.
+* @brief  this function send an ReadMultipleBlock command to contactless tag.
 * @param  	Flags		:  	Request flags
 * @param	UIDin		:  	pointer on contacless tag UID (optional) (depend on address flag of Request flags)
-* @param	BlockNumber	:  	index of block to read
+* @param	BlockNumber	:  	index of the first block to read
+* @param	NbBlock		:  	number of blocks to read minus one
 * @param	pResponse	: 	pointer on PCD  response
 * @retval 	ISO15693_SUCCESSCODE	: 	PCD  returns a succesful code
 * @retval 	ISO15693_ERRORCODE_DEFAULT	: 	 PCD  returns an error code
@@ -528,7 +769,6 @@ uint8_t DataToSend[ISO15693_MAXLENGTH_READSINGLEBLOCK],
 	{	memcpy(&(DataToSend[NthByte]),UIDin,ISO15693_NBBYTE_UID);
 		NthByte +=ISO15693_NBBYTE_UID;	
 	}
-	BlockNumber=BlockNumber<<5; // *32
 	if (ISO15693_GetProtocolExtensionFlag (Flags) 	== false)
 		DataToSend[NthByte++] = BlockNumber;
 	else 
@@ -550,6 +790,179 @@ uint8_t DataToSend[ISO15693_MAXLENGTH_READSINGLEBLOCK],
 
 }
 
+/**  
+* @brief  this function send an ExtendedReadMultipleBlock command to contactless tag (tags of more than 256 blocks
+* @brief	addressed without the protocol extension flag, ST25DV for instance).
+* @param  	Flags		:  	Request flags (the protocol extension flag must be cleared)
+* @param	UIDin		:  	pointer on contacless tag UID (optional) (depend on address flag of Request flags)
+* @param	BlockNumber	:  	index of the first block to read
+* @param	NbBlock		:  	number of blocks to read minus one
+* @param	pResponse	: 	pointer on PCD  response
+* @retval 	ISO15693_SUCCESSCODE	: 	PCD  returns a succesful code
+* @retval 	ISO15693_ERRORCODE_DEFAULT	: 	 PCD  returns an error code
+*/
+static int8_t ISO15693_ExtendedReadMultipleBlock (uc8 Flags, uc8 *UIDin, uc16 BlockNumber, uc16 NbBlock, uint8_t *pResponse )
+{
+uint8_t DataToSend[ISO15693_MAXLENGTH_EXTREADMULBLOCK],
+		NthByte=0;
+
+	DataToSend[NthByte++] = Flags;
+	DataToSend[NthByte++] = ISO15693_CMDCODE_EXTREADMULBLOCKS;
+
+	if (ISO15693_GetAddressOrNbSlotsFlag (Flags) 	== true)
+	{	memcpy(&(DataToSend[NthByte]),UIDin,ISO15693_NBBYTE_UID);
+		NthByte +=ISO15693_NBBYTE_UID;	
+	}
+	DataToSend[NthByte++] = GETLSB(BlockNumber);
+	DataToSend[NthByte++] = GETMSB(BlockNumber);
+	DataToSend[NthByte++] = GETLSB(NbBlock);
+	DataToSend[NthByte++] = GETMSB(NbBlock);
+
+	PCD_SendRecv(NthByte,DataToSend,pResponse);
+
+	if (PCD_IsReaderResultCodeOk (SEND_RECEIVE,pResponse) == PCD_ERRORCODE_DEFAULT)
+		return ISO15693_ERRORCODE_DEFAULT;
+
+	return ISO15693_SUCCESSCODE;
+}
+
+/**  
+* @brief  	this function send an WriteMultipleBlock command to contactless tag.
+* @param  	Flags		:  	Request flags
+* @param		UIDin		:  	pointer on contacless tag UID (optional) (depend on address flag of Request flags)
+* @param		BlockNumber	:  	index of the first block to write
+* @param		NbBlock		:  	number of blocks to write minus one
+* @param		DataToWrite :	Data to write into contacless tag memory
+* @param		pResponse	: 	pointer on PCD  response
+* @retval 	ISO15693_SUCCESSCODE	: 	PCD  returns a succesful code
+* @retval 	ISO15693_ERRORCODE_DEFAULT	: 	 PCD  returns an error code
+* @retval 	ISO15693_ERRORCODE_PARAMETERLENGTH	: 	 block above 255 without the protocol extension flag or 
+* @retval 		too many blocks (nothing sent)
+*/
+static int8_t ISO15693_WriteMultipleBlock (uc8 Flags, uc8 *UIDin, uc16 BlockNumber, uc8 NbBlock, uc8 *DataToWrite, uint8_t *pResponse )
+{
+uint8_t DataToSend[MAX_BUFFER_SIZE],
+		NthByte=0;
+uint16_t NbByteToWrite = (NbBlock+1)*ISO15693_NBBYTE_BLOCKLENGTH;
+
+	/* a 1 byte block number would write the blocks modulo 256 */
+	if (BlockNumber+NbBlock > 0xFF && ISO15693_GetProtocolExtensionFlag (Flags) == false)
+		return ISO15693_ERRORCODE_PARAMETERLENGTH;
+
+	DataToSend[NthByte++] = Flags;
+	DataToSend[NthByte++] = ISO15693_CMDCODE_WRITEMULBLOCKS;
+
+	if (ISO15693_GetAddressOrNbSlotsFlag (Flags) 	== true)
+	{	memcpy(&(DataToSend[NthByte]),UIDin,ISO15693_NBBYTE_UID);
+		NthByte +=ISO15693_NBBYTE_UID;	
+	}
+
+	if (ISO15693_GetProtocolExtensionFlag (Flags) 	== false)
+		DataToSend[NthByte++] = BlockNumber;
+	else 
+	{
+		DataToSend[NthByte++] = BlockNumber & 0x00FF;
+		DataToSend[NthByte++] = (BlockNumber & 0xFF00 ) >> 8;
+	}
+
+	DataToSend[NthByte++] = NbBlock;
+
+	if (NthByte + NbByteToWrite > MAX_BUFFER_SIZE)
+		return ISO15693_ERRORCODE_PARAMETERLENGTH;
+
+	memcpy(&(DataToSend[NthByte]),DataToWrite,NbByteToWrite);
+	NthByte +=NbByteToWrite;
+
+	PCD_SendRecv(NthByte,DataToSend,pResponse);
+
+	if (PCD_IsReaderResultCodeOk (SEND_RECEIVE,pResponse) != PCD_SUCCESSCODE)
+		return ISO15693_ERRORCODE_DEFAULT;
+
+	return ISO15693_SUCCESSCODE;
+}
+
+/**  
+* @brief  	this function send an ExtendedWriteSingleBlock command to contactless tag (tags of more than 256 blocks
+* @brief		addressed without the protocol extension flag, ST25DV for instance).
+* @param  	Flags		:  	Request flags (the protocol extension flag must be cleared)
+* @param		UIDin		:  	pointer on contacless tag UID (optional) (depend on address flag of Request flags)
+* @param		BlockNumber	:  	index of block to write
+* @param		DataToWrite :	Data to write into contacless tag memory
+* @param		pResponse	: 	pointer on PCD  response
+* @retval 	ISO15693_SUCCESSCODE	: 	PCD  returns a succesful code
+* @retval 	ISO15693_ERRORCODE_DEFAULT	: 	 PCD  returns an error code
+*/
+static int8_t ISO15693_ExtendedWriteSingleBlock (uc8 Flags, uc8 *UIDin, uc16 BlockNumber, uc8 *DataToWrite, uint8_t *pResponse )
+{
+uint8_t DataToSend[MAX_BUFFER_SIZE],
+		NthByte=0;
+
+	DataToSend[NthByte++] = Flags;
+	DataToSend[NthByte++] = ISO15693_CMDCODE_EXTWRITESINGLEBLOCK;
+
+	if (ISO15693_GetAddressOrNbSlotsFlag (Flags) 	== true)
+	{	memcpy(&(DataToSend[NthByte]),UIDin,ISO15693_NBBYTE_UID);
+		NthByte +=ISO15693_NBBYTE_UID;	
+	}
+	DataToSend[NthByte++] = GETLSB(BlockNumber);
+	DataToSend[NthByte++] = GETMSB(BlockNumber);
+
+	memcpy(&(DataToSend[NthByte]),DataToWrite,ISO15693_NBBYTE_BLOCKLENGTH);
+	NthByte +=ISO15693_NBBYTE_BLOCKLENGTH;
+
+	PCD_SendRecv(NthByte,DataToSend,pResponse);
+
+	if (PCD_IsReaderResultCodeOk (SEND_RECEIVE,pResponse) != PCD_SUCCESSCODE)
+		return ISO15693_ERRORCODE_DEFAULT;
+
+	return ISO15693_SUCCESSCODE;
+}
+
+/**  
+* @brief  	this function send an ExtendedWriteMultipleBlock command to contactless tag (tags of more than 256 blocks
+* @brief		addressed without the protocol extension flag, ST25DV for instance).
+* @param  	Flags		:  	Request flags (the protocol extension flag must be cleared)
+* @param		UIDin		:  	pointer on contacless tag UID (optional) (depend on address flag of Request flags)
+* @param		BlockNumber	:  	index of the first block to write
+* @param		NbBlock		:  	number of blocks to write minus one
+* @param		DataToWrite :	Data to write into contacless tag memory
+* @param		pResponse	: 	pointer on PCD  response
+* @retval 	ISO15693_SUCCESSCODE	: 	PCD  returns a succesful code
+* @retval 	ISO15693_ERRORCODE_DEFAULT	: 	 PCD  returns an error code
+* @retval 	ISO15693_ERRORCODE_PARAMETERLENGTH	: 	 too many blocks (nothing sent)
+*/
+static int8_t ISO15693_ExtendedWriteMultipleBlock (uc8 Flags, uc8 *UIDin, uc16 BlockNumber, uc16 NbBlock, uc8 *DataToWrite, uint8_t *pResponse )
+{
+uint8_t DataToSend[MAX_BUFFER_SIZE],
+		NthByte=0;
+uint16_t NbByteToWrite = (NbBlock+1)*ISO15693_NBBYTE_BLOCKLENGTH;
+
+	DataToSend[NthByte++] = Flags;
+	DataToSend[NthByte++] = ISO15693_CMDCODE_EXTWRITEMULBLOCKS;
+
+	if (ISO15693_GetAddressOrNbSlotsFlag (Flags) 	== true)
+	{	memcpy(&(DataToSend[NthByte]),UIDin,ISO15693_NBBYTE_UID);
+		NthByte +=ISO15693_NBBYTE_UID;	
+	}
+	DataToSend[NthByte++] = GETLSB(BlockNumber);
+	DataToSend[NthByte++] = GETMSB(BlockNumber);
+	DataToSend[NthByte++] = GETLSB(NbBlock);
+	DataToSend[NthByte++] = GETMSB(NbBlock);
+
+	if (NthByte + NbByteToWrite > MAX_BUFFER_SIZE)
+		return ISO15693_ERRORCODE_PARAMETERLENGTH;
+
+	memcpy(&(DataToSend[NthByte]),DataToWrite,NbByteToWrite);
+	NthByte +=NbByteToWrite;
+
+	PCD_SendRecv(NthByte,DataToSend,pResponse);
+
+	if (PCD_IsReaderResultCodeOk (SEND_RECEIVE,pResponse) != PCD_SUCCESSCODE)
+		return ISO15693_ERRORCODE_DEFAULT;
+
+	return ISO15693_SUCCESSCODE;
+}
+
 /**  
 * @brief  	this function send an EOF pulse to contactless tag.
 * @param	pResponse	: 	pointer on PCD  response
@@ -651,6 +1064,30 @@ static int8_t ISO15693_IsCollisionDetected (uc8 *pResponse)
 
 }
 
+/**  
+* @brief  	this function checks the PCD status, the CRC and the error flag of a tag reply
+* @param  	pResponse	: 	pointer on PCD  response
+* @retval 	ISO15693_SUCCESSCODE	: 	the tag reply is valid
+* @retval 	ISO15693_ERRORCODE_CRCRESIDUE	: 	CRC error
+* @retval 	ISO15693_ERRORCODE_DEFAULT	: 	 no reply or the tag returned an error
+*/
+static int8_t ISO15693_CheckTagReply (uc8 *pResponse)
+{
+uint8_t Tag_error_check;
+
+	if (PCD_IsReaderResultCodeOk (SEND_RECEIVE,pResponse) != PCD_SUCCESSCODE)
+		return ISO15693_ERRORCODE_DEFAULT;
+
+	Tag_error_check = pResponse[ISO15693_OFFSET_LENGTH]+1;
+	if ((pResponse[Tag_error_check] & ISO15693_CRC_MASK) != 0x00)
+		return ISO15693_ERRORCODE_CRCRESIDUE;
+
+	if ((pResponse[PCD_DATA_OFFSET+ISO15693_OFFSET_FLAGS] & ISO15693_MASK_ERRORFLAG) != 0x00)
+		return ISO15693_ERRORCODE_DEFAULT;
+
+	return ISO15693_SUCCESSCODE;
+}
+
 /**  
 * @brief  	this function computes the CRC16 as defined by CRC ISO/IEC 13239
 * @param  	DataIn		:	input data 
@@ -810,7 +1247,7 @@ static uint8_t ISO15693_ReadMultipleTagData(uint8_t Tag_Density, uint8_t *Data_T
 	{			
 			//NumSectorToRead += NthDataToRead;
 
-			if ( ISO15693_ReadMultipleBlock (Requestflags, 0x00,NthDataToRead+SectorStart,0x1F,RepBuffer ) !=ISO15693_SUCCESSCODE)
+			if ( ISO15693_ReadMultipleBlock (Requestflags, 0x00,(NthDataToRead+SectorStart)<<5,0x1F,RepBuffer ) !=ISO15693_SUCCESSCODE)
 						return ISO15693_ERRORCODE_DEFAULT;	
 			/*Data Temp*/
 			memcpy(&Data_To_Read[NthDataToRead*128],&RepBuffer[3],128);
@@ -937,44 +1374,341 @@ static uint8_t ISO15693_WriteTagData(uint8_t Tag_Density, uint8_t *Data_To_Write
 }	
 
 /**
-  * @}
-  */ 
-
-
-/** @addtogroup lib_iso15693pcd_Public_Functions
- *  @{
- */ 
-
-
-/**  
-* @brief  this function selects 15693 protocol accoording to input parameters
-* @retval ISO15693_SUCCESSCODE : the function is successful
-* @retval ISO15693_ERRORCODE_DEFAULT : an error occured
+* @brief  Extract the system information from a Get_System_Info reply
+* @param  *pResponse : PCD response to the Get_System_Info command
+* @param  RequestFlags : request flags used for the command (protocol extension => 2 bytes block number)
+* @param  *pSysInfo : parsed system information
+* @retval ISO15693_ERRORCODE_DEFAULT / ISO15693_SUCCESSCODE.
 */
-int8_t ISO15693_Init	( void )
+static int8_t ISO15693_ParseSystemInfo (uc8 *pResponse, uc8 RequestFlags, ISO15693_SYSTEMINFO *pSysInfo)
 {
-	uint8_t 	ParametersByte=0,
-					pResponse[PROTOCOLSELECT_LENGTH];
-	int8_t		status;
-	u8 DemoGainParameters []  = {0x01, 0xD1}; 
-
-	ParametersByte =  	((ISO15693_APPENDCRC << ISO15693_OFFSET_APPENDCRC ) 	&  ISO15693_MASK_APPENDCRC) |
-											((ISO15693_SINGLE_SUBCARRIER << ISO15693_OFFSET_SUBCARRIER)	& ISO15693_MASK_SUBCARRIER)	|
-											((ISO15693_MODULATION_100 << ISO15693_OFFSET_MODULATION) & ISO15693_MASK_MODULATION) |
-											((ISO15693_WAIT_FOR_SOF <<  ISO15693_OFFSET_WAITORSOF ) & ISO15693_MASK_WAITORSOF) 	|
-											((ISO15693_TRANSMISSION_26 <<   ISO15693_OFFSET_DATARATE  )	& ISO15693_MASK_DATARATE);
-	
-	errchk(PCD_ProtocolSelect(ISO15693_SELECTLENGTH,ISO15693_PROTOCOL,&(ParametersByte),pResponse));
+	uint8_t	Index = PCD_DATA_OFFSET + ISO15693_NBBYTE_REPLYFLAG,
+				InfoFlags;
 
-	/* in order to adjust the demoduation gain of the PCD*/
-  errchk(PCD_WriteRegister    ( 0x04,0x68,0x01,DemoGainParameters,pResponse)); 
+	if (PCD_IsReaderResultCodeOk (SEND_RECEIVE,pResponse) != PCD_SUCCESSCODE)
+		return ISO15693_ERRORCODE_DEFAULT;
 
-	if (PCD_IsReaderResultCodeOk (PROTOCOL_SELECT,pResponse) == ISO15693_ERRORCODE_DEFAULT)
+	/* the tag returned an error (i.e. protocol extension not supported) */
+	if ((pResponse[PCD_DATA_OFFSET+ISO15693_OFFSET_FLAGS] & ISO15693_MASK_ERRORFLAG) != 0x00)
 		return ISO15693_ERRORCODE_DEFAULT;
 
+	memset(pSysInfo, 0x00, sizeof(ISO15693_SYSTEMINFO));
 
-	return ISO15693_SUCCESSCODE;
-Error:
+	InfoFlags = pResponse[Index++];
+	pSysInfo->InfoFlags = InfoFlags;
+	memcpy(pSysInfo->UID, &pResponse[Index], ISO15693_NBBYTE_UID);
+	Index += ISO15693_NBBYTE_UID;
+
+	if ((InfoFlags & ISO15693_MASK_DSFIDFLAG) != 0x00)
+		pSysInfo->DSFID = pResponse[Index++];
+	if ((InfoFlags & ISO15693_MASK_AFIFLAG) != 0x00)
+		pSysInfo->AFI = pResponse[Index++];
+	if ((InfoFlags & ISO15693_MASK_MEMSIZEFLAG) != 0x00)
+	{
+		if (ISO15693_GetProtocolExtensionFlag (RequestFlags) == true)
+		{
+			pSysInfo->NbBlock = (((pResponse[Index+1] << 8) & 0xFF00) | pResponse[Index]) + 1;
+			Index += 2;
+		}
+		else
+			pSysInfo->NbBlock = pResponse[Index++] + 1;
+		pSysInfo->BlockSize = (pResponse[Index++] & ISO15693_MASK_GETSYSINFOREPLY_MEMSIZE) + 1;
+	}
+	if ((InfoFlags & ISO15693_MASK_ICREFFLAG) != 0x00)
+		pSysInfo->ICRef = pResponse[Index++];
+
+	/* density and supported commands from the IC reference */
+	switch (pSysInfo->ICRef)
+	{
+		case ISO15693_M24LR64R :
+		case ISO15693_M24LR64ER :
+		case ISO15693_M24LR16ER :
+		case ISO15693_LRiS64K :
+			pSysInfo->Density = ISO15693_HIGH_DENSITY;
+			break;
+
+		case ISO15693_M24LR04ER :
+			pSysInfo->Density = ISO15693_LOW_DENSITY;
+			break;
+
+		default :
+			/*Flag IC_REF LSB For LRiXX*/
+			switch (pSysInfo->ICRef & 0xFC)
+			{
+				case ISO15693_LRiS2K :
+				case ISO15693_LRi2K :
+				case ISO15693_LRi1K :
+					pSysInfo->Density = ISO15693_LOW_DENSITY;
+					break;
+
+				default :
+					pSysInfo->Density = (ISO15693_GetProtocolExtensionFlag (RequestFlags) == true) ? ISO15693_HIGH_DENSITY : ISO15693_LOW_DENSITY;
+			}
+	}
+
+	if (pSysInfo->Density == ISO15693_HIGH_DENSITY)
+		pSysInfo->SupportedCmd |= ISO15693_SUPPORT_PROTOCOLEXTENSION;
+	/*LRiS2K don't support read multiple*/
+	if ((pSysInfo->ICRef & 0xFC) != ISO15693_LRiS2K)
+		pSysInfo->SupportedCmd |= ISO15693_SUPPORT_READMULTIPLE;
+
+	return ISO15693_SUCCESSCODE;
+}
+
+/**
+* @brief  Look for a tag in the system information cache
+* @param  *UIDin : UID of the tag (0x00 => tag found by the last ISO15693_GetUID)
+* @retval index of the entry in the cache, -1 if the tag is not in the cache
+*/
+static int8_t ISO15693_FindSystemInfo (uc8 *UIDin)
+{
+	uint8_t i;
+
+	if (UIDin == 0x00)
+	{
+		if (CurrentUIDValid == false)
+			return -1;
+		UIDin = CurrentUID;
+	}
+
+	for (i=0; i<ISO15693_SYSINFOCACHE_NBENTRY; i++)
+	{
+		if (SysInfoCacheAge[i] != 0 && memcmp(SysInfoCache[i].UID, UIDin, ISO15693_NBBYTE_UID) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+/**
+* @brief  Mark an entry of the system information cache as the most recently used
+* @param  Index : index of the entry in the cache
+* @retval None
+*/
+static void ISO15693_TouchSystemInfo (uc8 Index)
+{
+	uint8_t i;
+
+	if (++SysInfoCacheTick == 0)
+	{
+		/* counter overflow: keep the entries but restart their age */
+		for (i=0; i<ISO15693_SYSINFOCACHE_NBENTRY; i++)
+		{
+			if (SysInfoCacheAge[i] != 0)
+				SysInfoCacheAge[i] = 1;
+		}
+		SysInfoCacheTick = 2;
+	}
+
+	SysInfoCacheAge[Index] = SysInfoCacheTick;
+}
+
+/**
+* @brief  Store system information in the cache (replace the least recently used entry if full)
+* @param  *pSysInfo : system information to store
+* @retval None
+*/
+static void ISO15693_StoreSystemInfo (ISO15693_SYSTEMINFO *pSysInfo)
+{
+	int8_t	Index;
+	uint8_t i;
+
+	Index = ISO15693_FindSystemInfo (pSysInfo->UID);
+
+	if (Index < 0)
+	{
+		Index = 0;
+		for (i=1; i<ISO15693_SYSINFOCACHE_NBENTRY; i++)
+		{
+			if (SysInfoCacheAge[i] < SysInfoCacheAge[Index])
+				Index = i;
+		}
+	}
+
+	memcpy(&SysInfoCache[Index], pSysInfo, sizeof(ISO15693_SYSTEMINFO));
+	ISO15693_TouchSystemInfo (Index);
+}
+
+/**
+* @brief  Read a block range of one tag with Read Multiple commands of the maximum size (used by ISO15693_BulkRead)
+* @param  *UIDin : UID of the tag (0x00 => non addressed mode)
+* @param  FirstBlock : First block to read
+* @param  NbBlock : Number of blocks to read
+* @param  *pLayout : memory layout of the tag (0x00 => taken from the system information cache)
+* @param  *pData : return the data read in the tag
+* @param  *pResult : result of the tag (error code and number of blocks read)
+* @retval ISO15693_SUCCESSCODE / ISO15693_ERRORCODE_xxx.
+*/
+static uint8_t ISO15693_BulkReadTag (uc8 *UIDin, uc16 FirstBlock, uc16 NbBlock, ISO15693_SYSTEMINFO *pLayout, uint8_t *pData, ISO15693_BULKREADRESULT *pResult)
+{
+	ISO15693_SYSTEMINFO SysInfo;
+	uint8_t 	RequestFlags = ISO15693_MASK_DATARATEFLAG | ISO15693_MASK_ADDRORNBSLOTSFLAG,
+				BlockSize = ISO15693_NBBYTE_BLOCKLENGTH,
+				NbBlockPerRead = 1,
+				NbBlockThisRead;
+	uint16_t 	NthBlock,
+				NbBlockToRead = NbBlock;
+	int8_t 		status;
+
+	if (UIDin == 0x00)
+		RequestFlags &= ~ISO15693_MASK_ADDRORNBSLOTSFLAG;
+
+	/* the memory layout is only requested once per tag */
+	if (pLayout == 0x00)
+	{
+		if (ISO15693_GetCachedSystemInfo (UIDin, &SysInfo) != ISO15693_SUCCESSCODE)
+			return ISO15693_ERRORCODE_NOTAGFOUND;
+		pLayout = &SysInfo;
+	}
+
+	if (pLayout->BlockSize != 0)
+		BlockSize = pLayout->BlockSize;
+	/* the data buffer has ISO15693_NBBYTE_BLOCKLENGTH bytes per block */
+	if (BlockSize > ISO15693_NBBYTE_BLOCKLENGTH)
+		return ISO15693_ERRORCODE_PARAMETERLENGTH;
+
+	/* do not read beyond the tag memory */
+	if (pLayout->NbBlock != 0)
+	{
+		if (FirstBlock >= pLayout->NbBlock)
+			return ISO15693_ERRORCODE_PARAMETERLENGTH;
+		NbBlockToRead = MIN(NbBlock, pLayout->NbBlock - FirstBlock);
+	}
+
+	if (pLayout->Density == ISO15693_HIGH_DENSITY)
+		RequestFlags |= ISO15693_MASK_PROTEXTFLAG;
+	/* the blocks above 255 need the protocol extension or the extended commands */
+	else if ((pLayout->SupportedCmd & ISO15693_SUPPORT_EXTENDEDCMD) == 0x00 && FirstBlock+NbBlockToRead > 0x100)
+		return ISO15693_ERRORCODE_PARAMETERLENGTH;
+	if ((pLayout->SupportedCmd & ISO15693_SUPPORT_READMULTIPLE) != 0x00)
+		NbBlockPerRead = MIN(ISO15693_BULKREAD_NBBLOCKPERREAD, ISO15693_BULKREAD_MAXDATALENGTH/BlockSize);
+
+	for (NthBlock=0; NthBlock<NbBlockToRead; NthBlock+=NbBlockThisRead)
+	{
+		NbBlockThisRead = MIN(NbBlockPerRead, NbBlockToRead-NthBlock);
+
+		if ((pLayout->SupportedCmd & ISO15693_SUPPORT_EXTENDEDCMD) != 0x00 && pLayout->Density != ISO15693_HIGH_DENSITY)
+			ISO15693_ExtendedReadMultipleBlock (RequestFlags, UIDin, FirstBlock+NthBlock, NbBlockThisRead-1, u95HFBuffer);
+		else if (NbBlockThisRead > 1)
+			ISO15693_ReadMultipleBlock (RequestFlags, UIDin, FirstBlock+NthBlock, NbBlockThisRead-1, u95HFBuffer);
+		else
+			ISO15693_ReadSingleBlock (RequestFlags, UIDin, FirstBlock+NthBlock, u95HFBuffer);
+
+		status = ISO15693_CheckTagReply (u95HFBuffer);
+		if (status != ISO15693_SUCCESSCODE)
+		{
+			if (u95HFBuffer[READERREPLY_STATUSOFFSET] == SENDRECV_RESULTSCODE_OK)
+				pResult->TagErrorCode = u95HFBuffer[PCD_DATA_OFFSET+ISO15693_OFFSET_ERRORCODE];
+			return status;
+		}
+
+		memcpy(&pData[NthBlock*ISO15693_NBBYTE_BLOCKLENGTH], &u95HFBuffer[PCD_DATA_OFFSET+ISO15693_NBBYTE_REPLYFLAG], NbBlockThisRead*BlockSize);
+		pResult->NbBlockRead += NbBlockThisRead;
+	}
+
+	status = ISO15693_SUCCESSCODE;
+	if (NbBlockToRead < NbBlock)
+		status = ISO15693_ERRORCODE_PARAMETERLENGTH;
+
+	return status;
+}
+
+/**
+* @brief  Return the request flags used to address the tag of a write buffer
+* @param  *pBuffer : write buffer
+* @retval request flags
+*/
+static uint8_t ISO15693_WriteBufferRequestFlags (ISO15693_WRITEBUFFER *pBuffer)
+{
+	uint8_t RequestFlags = ISO15693_MASK_DATARATEFLAG | ISO15693_MASK_ADDRORNBSLOTSFLAG;
+
+	if (pBuffer->Density == ISO15693_HIGH_DENSITY)
+		RequestFlags |= ISO15693_MASK_PROTEXTFLAG;
+
+	return RequestFlags;
+}
+
+/**
+* @brief  Tell if the blocks of a write buffer are addressed with the extended commands (2 bytes block
+* @brief  number without the protocol extension flag)
+* @param  *pBuffer : write buffer
+* @retval true / false
+*/
+static bool ISO15693_WriteBufferIsExtended (ISO15693_WRITEBUFFER *pBuffer)
+{
+	return ((pBuffer->SupportedCmd & ISO15693_SUPPORT_EXTENDEDCMD) != 0x00 && pBuffer->Density != ISO15693_HIGH_DENSITY);
+}
+
+/**
+* @brief  Load one block of the tag in a write buffer (only if its content is not already known)
+* @param  *pBuffer : write buffer
+* @param  NthBlock : index of the block in the buffer
+* @retval ISO15693_SUCCESSCODE / ISO15693_ERRORCODE_xxx.
+*/
+static int8_t ISO15693_WriteBufferReadBlock (ISO15693_WRITEBUFFER *pBuffer, uc16 NthBlock)
+{
+	uint8_t RequestFlags = ISO15693_WriteBufferRequestFlags (pBuffer);
+	uint16_t Block = pBuffer->FirstBlock+NthBlock;
+	int8_t status;
+
+	if ((pBuffer->BlockState[NthBlock] & (ISO15693_WRITEBUFFER_BLOCKVALID | ISO15693_WRITEBUFFER_BLOCKDIRTY)) != 0x00)
+		return ISO15693_SUCCESSCODE;
+
+	if (ISO15693_WriteBufferIsExtended (pBuffer) == true)
+		ISO15693_ExtendedReadMultipleBlock (RequestFlags, pBuffer->UID, Block, 0, u95HFBuffer);
+	else if (Block > 0xFF && ISO15693_GetProtocolExtensionFlag (RequestFlags) == false)
+		return ISO15693_ERRORCODE_PARAMETERLENGTH;
+	else
+		ISO15693_ReadSingleBlock (RequestFlags, pBuffer->UID, Block, u95HFBuffer);
+	errchk(ISO15693_CheckTagReply (u95HFBuffer));
+
+	memcpy(&pBuffer->Data[NthBlock*ISO15693_NBBYTE_BLOCKLENGTH], &u95HFBuffer[PCD_DATA_OFFSET+ISO15693_NBBYTE_REPLYFLAG], ISO15693_NBBYTE_BLOCKLENGTH);
+	pBuffer->BlockState[NthBlock] |= ISO15693_WRITEBUFFER_BLOCKVALID;
+
+	return ISO15693_SUCCESSCODE;
+Error:
+	return status;
+}
+
+/**
+  * @}
+  */ 
+
+
+/** @addtogroup lib_iso15693pcd_Public_Functions
+ *  @{
+ */ 
+
+
+/**  
+* @brief  this function selects 15693 protocol accoording to input parameters
+* @retval ISO15693_SUCCESSCODE : the function is successful
+* @retval ISO15693_ERRORCODE_DEFAULT : an error occured
+*/
+int8_t ISO15693_Init	( void )
+{
+	uint8_t 	ParametersByte=0,
+					pResponse[PROTOCOLSELECT_LENGTH];
+	int8_t		status;
+	u8 DemoGainParameters []  = {0x01, 0xD1}; 
+
+	ParametersByte =  	((ISO15693_APPENDCRC << ISO15693_OFFSET_APPENDCRC ) 	&  ISO15693_MASK_APPENDCRC) |
+											((ISO15693_SINGLE_SUBCARRIER << ISO15693_OFFSET_SUBCARRIER)	& ISO15693_MASK_SUBCARRIER)	|
+											((ISO15693_MODULATION_100 << ISO15693_OFFSET_MODULATION) & ISO15693_MASK_MODULATION) |
+											((ISO15693_WAIT_FOR_SOF <<  ISO15693_OFFSET_WAITORSOF ) & ISO15693_MASK_WAITORSOF) 	|
+											((ISO15693_TRANSMISSION_26 <<   ISO15693_OFFSET_DATARATE  )	& ISO15693_MASK_DATARATE);
+	
+	errchk(PCD_ProtocolSelect(ISO15693_SELECTLENGTH,ISO15693_PROTOCOL,&(ParametersByte),pResponse));
+
+	/* in order to adjust the demoduation gain of the PCD*/
+  errchk(PCD_WriteRegister    ( 0x04,0x68,0x01,DemoGainParameters,pResponse)); 
+
+	if (PCD_IsReaderResultCodeOk (PROTOCOL_SELECT,pResponse) == ISO15693_ERRORCODE_DEFAULT)
+		return ISO15693_ERRORCODE_DEFAULT;
+
+
+	return ISO15693_SUCCESSCODE;
+Error:
 	return ISO15693_ERRORCODE_DEFAULT;
 }
 
@@ -1016,7 +1750,12 @@ uint8_t Tag_error_check;
 	
 
 	if (status == ISO15693_SUCCESSCODE)
+	{
 		memcpy(UIDout,&(TagReply[ISO15693_OFFSET_UID]),ISO15693_NBBYTE_UID);
+		/* non addressed commands are now answered by this tag */
+		memcpy(CurrentUID,&(TagReply[ISO15693_OFFSET_UID]),ISO15693_NBBYTE_UID);
+		CurrentUIDValid = true;
+	}
 
 	st95mode = PCD;
 	st95tagtype = TT5;
@@ -1058,6 +1797,389 @@ Error:
 	return ISO15693_ERRORCODE_DEFAULT;
 }
 
+/**  
+* @brief  this function returns the system information of a tag. A Get_System_Info command is only
+* @brief	sent when the tag is not in the cache (with protocol extension flag first, without otherwise)
+* @param	UIDin		:  	Tag UID (0x00 => non addressed mode, the tag found by the last ISO15693_GetUID)
+* @param	pSysInfo	:  	system information of the tag
+* @retval ISO15693_SUCCESSCODE : the function is successful
+* @retval ISO15693_ERRORCODE_NOTAGFOUND : the tag did not answer
+* @retval ISO15693_ERRORCODE_DEFAULT : an error occured
+*/
+int8_t ISO15693_GetCachedSystemInfo ( uc8 *UIDin, ISO15693_SYSTEMINFO *pSysInfo)
+{
+uint8_t RepBuffer[32],
+		RequestFlags = 0x0A;
+int8_t	Index;
+
+	Index = ISO15693_FindSystemInfo (UIDin);
+	if (Index >= 0)
+	{
+		ISO15693_TouchSystemInfo (Index);
+		memcpy(pSysInfo, &SysInfoCache[Index], sizeof(ISO15693_SYSTEMINFO));
+		return ISO15693_SUCCESSCODE;
+	}
+
+	if (UIDin != 0x00)
+		RequestFlags |= ISO15693_MASK_ADDRORNBSLOTSFLAG;
+
+	/*Send Get_System_Info with Protocol Extention Flag Set*/
+	if (ISO15693_GetSystemInfo (RequestFlags, UIDin, RepBuffer) != ISO15693_SUCCESSCODE ||
+			ISO15693_ParseSystemInfo (RepBuffer, RequestFlags, pSysInfo) != ISO15693_SUCCESSCODE)
+	{
+		RequestFlags &= ~ISO15693_MASK_PROTEXTFLAG;
+		if (ISO15693_GetSystemInfo (RequestFlags, UIDin, RepBuffer) != ISO15693_SUCCESSCODE)
+			return ISO15693_ERRORCODE_NOTAGFOUND;
+		if (ISO15693_ParseSystemInfo (RepBuffer, RequestFlags, pSysInfo) != ISO15693_SUCCESSCODE)
+			return ISO15693_ERRORCODE_DEFAULT;
+	}
+
+	ISO15693_StoreSystemInfo (pSysInfo);
+
+	/* the tag which answers the non addressed commands is now known */
+	if (UIDin == 0x00)
+	{
+		memcpy(CurrentUID, pSysInfo->UID, ISO15693_NBBYTE_UID);
+		CurrentUIDValid = true;
+	}
+
+	return ISO15693_SUCCESSCODE;
+}
+
+/**  
+* @brief  this function removes a tag from the system information cache
+* @param	UIDin		:  	Tag UID (0x00 => the tag found by the last ISO15693_GetUID)
+* @retval None
+*/
+void ISO15693_InvalidateSystemInfo ( uc8 *UIDin)
+{
+int8_t	Index;
+
+	Index = ISO15693_FindSystemInfo (UIDin);
+	if (Index >= 0)
+		SysInfoCacheAge[Index] = 0;
+
+	if (UIDin == 0x00)
+		CurrentUIDValid = false;
+}
+
+/**  
+* @brief  this function empties the system information cache
+* @retval None
+*/
+void ISO15693_FlushSystemInfoCache ( void )
+{
+	memset(SysInfoCacheAge, 0x00, sizeof(SysInfoCacheAge));
+	SysInfoCacheTick = 0;
+	CurrentUIDValid = false;
+}
+
+/**  
+* @brief  this function returns the UID of the tag which answers the non addressed commands
+* @brief	(tag found by the last ISO15693_GetUID)
+* @param	UIDout	:  	Tag UID
+* @retval ISO15693_SUCCESSCODE : the UID is known
+* @retval ISO15693_ERRORCODE_DEFAULT : no tag found or the tag has been invalidated
+*/
+int8_t ISO15693_GetCurrentUID ( uint8_t *UIDout)
+{
+	if (CurrentUIDValid == false)
+		return ISO15693_ERRORCODE_DEFAULT;
+
+	memcpy(UIDout, CurrentUID, ISO15693_NBBYTE_UID);
+	return ISO15693_SUCCESSCODE;
+}
+
+/**  
+* @brief  this function sends a stay_quiet command to the tag found by the last ISO15693_GetUID, the tag
+* @brief	does not answer the next inventories until the field is reset.
+* @retval ISO15693_SUCCESSCODE : the command is sent
+* @retval ISO15693_ERRORCODE_DEFAULT : no current tag
+*/
+int8_t ISO15693_StayQuietCurrentTag ( void )
+{
+	int8_t	status;
+
+	if (CurrentUIDValid == false)
+		return ISO15693_ERRORCODE_DEFAULT;
+
+	errchk(ISO15693_StayQuiet(ISO15693_MASK_DATARATEFLAG | ISO15693_MASK_ADDRORNBSLOTSFLAG, CurrentUID));
+	CurrentUIDValid = false;
+
+	return ISO15693_SUCCESSCODE;
+Error:
+	return ISO15693_ERRORCODE_DEFAULT;
+}
+
+/**  
+* @brief  this function reads the same block range from several tags. The tags are addressed by their UID,
+* @brief	so they can stay in quiet state after ISO15693_RunAntiCollision. The protocol select command
+* @brief	has to be send first. A tag in error does not stop the read of the other tags.
+* @param  pInventory	:  	tag records (DSFID + UID) as returned by ISO15693_RunAntiCollision
+* @param	NbTag				:  	number of tag records
+* @param	FirstBlock	:  	first block to read
+* @param	NbBlock			:  	number of blocks to read on each tag
+* @param	pLayout			:  	memory layout shared by all the tags (0x00 => read from each tag through the system information cache)
+* @param	pData				:  	data read, NbBlock*ISO15693_NBBYTE_BLOCKLENGTH bytes per tag in the pInventory order
+* @param	pResult			:  	per tag result (NbTag entries)
+* @param	pStat				:  	aggregated statistics (optional)
+* @retval ISO15693_SUCCESSCODE : all the tags have been read
+* @retval ISO15693_ERRORCODE_DEFAULT : at least one tag is in error (see pResult)
+*/
+int8_t ISO15693_BulkRead ( uc8 *pInventory, uc8 NbTag, uc16 FirstBlock, uc16 NbBlock, ISO15693_SYSTEMINFO *pLayout, uint8_t *pData, ISO15693_BULKREADRESULT *pResult, ISO15693_BULKREADSTAT *pStat)
+{
+uint8_t NthTag;
+uint16_t NbTagError = 0;
+uint32_t NbBlockRead = 0,
+				 StartTime = 0,
+				 Duration = 0;
+
+	if (ISO15693_GetTick_ms != 0x00)
+		StartTime = ISO15693_GetTick_ms();
+
+	for (NthTag=0; NthTag<NbTag; NthTag++)
+	{
+		memcpy(pResult[NthTag].UID, &pInventory[NthTag*ISO15693_NBBYTE_INVENTORYRECORD+ISO15693_NBBYTE_DSFID], ISO15693_NBBYTE_UID);
+		pResult[NthTag].TagErrorCode = 0x00;
+		pResult[NthTag].NbBlockRead = 0;
+
+		pResult[NthTag].Status = ISO15693_BulkReadTag (	pResult[NthTag].UID,
+																										FirstBlock,
+																										NbBlock,
+																										pLayout,
+																										&pData[NthTag*NbBlock*ISO15693_NBBYTE_BLOCKLENGTH],
+																										&pResult[NthTag]);
+
+		if (pResult[NthTag].Status != ISO15693_SUCCESSCODE)
+			NbTagError++;
+		NbBlockRead += pResult[NthTag].NbBlockRead;
+	}
+
+	if (ISO15693_GetTick_ms != 0x00)
+		Duration = ISO15693_GetTick_ms() - StartTime;
+
+	if (pStat != 0x00)
+	{
+		pStat->NbTagOk = NbTag - NbTagError;
+		pStat->NbTagError = NbTagError;
+		pStat->NbBlockRead = NbBlockRead;
+		pStat->Duration = Duration;
+		pStat->BlocksPerSecond = (Duration != 0) ? (NbBlockRead*1000)/Duration : 0;
+	}
+
+	if (NbTagError != 0)
+		return ISO15693_ERRORCODE_DEFAULT;
+
+	return ISO15693_SUCCESSCODE;
+}
+
+/**  
+* @brief  this function reads a block range of one tag. Read Multiple is used with the largest number
+* @brief	of blocks allowed by the 95HF buffer when the layout supports it, otherwise Read Single.
+* @param  UIDin				:  	Tag UID (0x00 => non addressed mode, the tag in the field answers)
+* @param	FirstBlock	:  	first block to read
+* @param	NbBlock			:  	number of blocks to read
+* @param	pLayout			:  	memory layout of the tag (0x00 => read through the system information cache)
+* @param	pData				:  	data read, ISO15693_NBBYTE_BLOCKLENGTH bytes per block
+* @retval ISO15693_SUCCESSCODE : the blocks have been read
+* @retval ISO15693_ERRORCODE_PARAMETERLENGTH : the range is beyond the tag memory
+* @retval ISO15693_ERRORCODE_xxx : the tag did not answer or returned an error
+*/
+int8_t ISO15693_ReadBlocks ( uc8 *UIDin, uc16 FirstBlock, uc16 NbBlock, ISO15693_SYSTEMINFO *pLayout, uint8_t *pData)
+{
+ISO15693_BULKREADRESULT Result;
+
+	memset(&Result, 0x00, sizeof(Result));
+	return ISO15693_BulkReadTag (UIDin, FirstBlock, NbBlock, pLayout, pData, &Result);
+}
+
+/**  
+* @brief  this function prepares a write buffer for a tag. The writes done with ISO15693_WriteBufferWrite
+* @brief	are only sent to the tag by ISO15693_WriteBufferCommit or ISO15693_WriteBufferClose.
+* @param  pBuffer			:  	write buffer (allocated by the application, one per tag)
+* @param	UIDin				:  	Tag UID (0x00 => the tag found by the last ISO15693_GetUID)
+* @param	FirstBlock	:  	first block covered by the buffer (ISO15693_WRITEBUFFER_NBBLOCK blocks)
+* @retval ISO15693_SUCCESSCODE : the function is successful
+* @retval ISO15693_ERRORCODE_NOTAGFOUND : the tag did not answer
+* @retval ISO15693_ERRORCODE_PARAMETERLENGTH : the block size of the tag is not supported
+*/
+int8_t ISO15693_WriteBufferOpen ( ISO15693_WRITEBUFFER *pBuffer, uc8 *UIDin, uc16 FirstBlock)
+{
+ISO15693_SYSTEMINFO SysInfo;
+
+	if (ISO15693_GetCachedSystemInfo (UIDin, &SysInfo) != ISO15693_SUCCESSCODE)
+		return ISO15693_ERRORCODE_NOTAGFOUND;
+
+	if (SysInfo.BlockSize != 0 && SysInfo.BlockSize != ISO15693_NBBYTE_BLOCKLENGTH)
+		return ISO15693_ERRORCODE_PARAMETERLENGTH;
+
+	memset(pBuffer, 0x00, sizeof(ISO15693_WRITEBUFFER));
+	memcpy(pBuffer->UID, SysInfo.UID, ISO15693_NBBYTE_UID);
+	pBuffer->Density = SysInfo.Density;
+	pBuffer->SupportedCmd = SysInfo.SupportedCmd;
+	pBuffer->FirstBlock = FirstBlock;
+	pBuffer->NbBlock = ISO15693_WRITEBUFFER_NBBLOCK;
+
+	/* do not go beyond the tag memory */
+	if (SysInfo.NbBlock != 0)
+	{
+		if (FirstBlock >= SysInfo.NbBlock)
+			return ISO15693_ERRORCODE_PARAMETERLENGTH;
+		pBuffer->NbBlock = MIN(ISO15693_WRITEBUFFER_NBBLOCK, SysInfo.NbBlock - FirstBlock);
+	}
+
+	return ISO15693_SUCCESSCODE;
+}
+
+/**  
+* @brief  this function writes bytes in a write buffer. Only the boundary blocks which content is unknown
+* @brief	are read from the tag, and a block is marked to be written only if its content changes.
+* @param  pBuffer							:  	write buffer
+* @param	Data_To_Write				:  	data to write
+* @param	NbBytes_To_Write		:  	number of bytes to write
+* @param	FirstBytes_To_Write	:  	address of the first byte to write in the tag memory
+* @retval ISO15693_SUCCESSCODE : the function is successful
+* @retval ISO15693_ERRORCODE_PARAMETERLENGTH : the bytes are not covered by the buffer
+* @retval ISO15693_ERRORCODE_DEFAULT : a boundary block cannot be read
+*/
+int8_t ISO15693_WriteBufferWrite ( ISO15693_WRITEBUFFER *pBuffer, uc8 *Data_To_Write, uc16 NbBytes_To_Write, uc16 FirstBytes_To_Write)
+{
+uint16_t	FirstByte,
+					LastByte,
+					NthBlock,
+					LastBlock,
+					BlockStart,
+					ByteStart,
+					ByteEnd;
+int8_t		status;
+
+	if (NbBytes_To_Write == 0)
+		return ISO15693_SUCCESSCODE;
+
+	/* bytes offset in the buffer */
+	if (FirstBytes_To_Write < pBuffer->FirstBlock*ISO15693_NBBYTE_BLOCKLENGTH)
+		return ISO15693_ERRORCODE_PARAMETERLENGTH;
+	FirstByte = FirstBytes_To_Write - pBuffer->FirstBlock*ISO15693_NBBYTE_BLOCKLENGTH;
+	LastByte = FirstByte + NbBytes_To_Write - 1;
+	if (LastByte >= pBuffer->NbBlock*ISO15693_NBBYTE_BLOCKLENGTH)
+		return ISO15693_ERRORCODE_PARAMETERLENGTH;
+
+	LastBlock = LastByte / ISO15693_NBBYTE_BLOCKLENGTH;
+
+	for (NthBlock = FirstByte / ISO15693_NBBYTE_BLOCKLENGTH; NthBlock <= LastBlock; NthBlock++)
+	{
+		BlockStart = NthBlock*ISO15693_NBBYTE_BLOCKLENGTH;
+		ByteStart = MAX(FirstByte, BlockStart);
+		ByteEnd = MIN(LastByte, BlockStart + ISO15693_NBBYTE_BLOCKLENGTH - 1);
+
+		/* a partial block write needs the current content of the block */
+		if (ByteStart != BlockStart || ByteEnd != BlockStart + ISO15693_NBBYTE_BLOCKLENGTH - 1)
+		{
+			errchk(ISO15693_WriteBufferReadBlock (pBuffer, NthBlock));
+		}
+
+		/* unchanged content => nothing to write */
+		if ((pBuffer->BlockState[NthBlock] & (ISO15693_WRITEBUFFER_BLOCKVALID | ISO15693_WRITEBUFFER_BLOCKDIRTY)) != 0x00 &&
+				memcmp(&pBuffer->Data[ByteStart], &Data_To_Write[ByteStart-FirstByte], ByteEnd-ByteStart+1) == 0)
+		{
+			if ((pBuffer->BlockState[NthBlock] & ISO15693_WRITEBUFFER_BLOCKDIRTY) == 0x00)
+				pBuffer->NbBlockSkipped++;
+			continue;
+		}
+
+		memcpy(&pBuffer->Data[ByteStart], &Data_To_Write[ByteStart-FirstByte], ByteEnd-ByteStart+1);
+		pBuffer->BlockState[NthBlock] |= ISO15693_WRITEBUFFER_BLOCKDIRTY;
+	}
+
+	return ISO15693_SUCCESSCODE;
+Error:
+	return status;
+}
+
+/**  
+* @brief  this function writes the modified blocks of a write buffer in the tag. Consecutive blocks are
+* @brief	written with Write Multiple when the tag supports it, with Write Single otherwise.
+* @brief	A tag with extended commands and without protocol extension is written with the extended commands.
+* @param  pBuffer			:  	write buffer
+* @retval ISO15693_SUCCESSCODE : the function is successful
+* @retval ISO15693_ERRORCODE_DEFAULT : a write failed (the blocks not written stay in the buffer)
+* @retval ISO15693_ERRORCODE_PARAMETERLENGTH : a block above 255 cannot be addressed (no protocol extension
+* @retval 		and no extended commands), nothing is sent for it
+*/
+int8_t ISO15693_WriteBufferCommit ( ISO15693_WRITEBUFFER *pBuffer)
+{
+uint8_t		RequestFlags = ISO15693_WriteBufferRequestFlags (pBuffer),
+					NbBlockPerWrite = 1,
+					NbBlockThisWrite,
+					i;
+uint16_t	NthBlock = 0;
+uint8_t		status;
+
+	if ((pBuffer->SupportedCmd & ISO15693_SUPPORT_WRITEMULTIPLE) != 0x00)
+		NbBlockPerWrite = ISO15693_WRITEBUFFER_NBBLOCKPERWRITE;
+
+	while (NthBlock < pBuffer->NbBlock)
+	{
+		if ((pBuffer->BlockState[NthBlock] & ISO15693_WRITEBUFFER_BLOCKDIRTY) == 0x00)
+		{
+			NthBlock++;
+			continue;
+		}
+
+		/* length of the run of consecutive dirty blocks */
+		NbBlockThisWrite = 1;
+		while (NbBlockThisWrite < NbBlockPerWrite && NthBlock+NbBlockThisWrite < pBuffer->NbBlock &&
+					(pBuffer->BlockState[NthBlock+NbBlockThisWrite] & ISO15693_WRITEBUFFER_BLOCKDIRTY) != 0x00)
+			NbBlockThisWrite++;
+
+		/* above block 255 : extended commands or protocol extension, the 1 byte block number would wrap */
+		if (ISO15693_WriteBufferIsExtended (pBuffer) == true && NbBlockThisWrite > 1)
+			status = ISO15693_ExtendedWriteMultipleBlock (RequestFlags, pBuffer->UID, pBuffer->FirstBlock+NthBlock, NbBlockThisWrite-1,
+																	&pBuffer->Data[NthBlock*ISO15693_NBBYTE_BLOCKLENGTH], u95HFBuffer);
+		else if (ISO15693_WriteBufferIsExtended (pBuffer) == true)
+			status = ISO15693_ExtendedWriteSingleBlock (RequestFlags, pBuffer->UID, pBuffer->FirstBlock+NthBlock,
+																	&pBuffer->Data[NthBlock*ISO15693_NBBYTE_BLOCKLENGTH], u95HFBuffer);
+		else if (NbBlockThisWrite > 1)
+			status = ISO15693_WriteMultipleBlock (RequestFlags, pBuffer->UID, pBuffer->FirstBlock+NthBlock, NbBlockThisWrite-1,
+																	&pBuffer->Data[NthBlock*ISO15693_NBBYTE_BLOCKLENGTH], u95HFBuffer);
+		else
+			status = ISO15693_WriteSingleBlock (RequestFlags, pBuffer->UID, pBuffer->FirstBlock+NthBlock,
+																	&pBuffer->Data[NthBlock*ISO15693_NBBYTE_BLOCKLENGTH], u95HFBuffer);
+		if (status == ISO15693_ERRORCODE_PARAMETERLENGTH)
+			return ISO15693_ERRORCODE_PARAMETERLENGTH;
+		errchk(ISO15693_CheckTagReply (u95HFBuffer));
+
+		for (i=0; i<NbBlockThisWrite; i++)
+			pBuffer->BlockState[NthBlock+i] = ISO15693_WRITEBUFFER_BLOCKVALID;
+		pBuffer->NbBlockWritten += NbBlockThisWrite;
+		NthBlock += NbBlockThisWrite;
+	}
+
+	return ISO15693_SUCCESSCODE;
+Error:
+	/* the tag may have changed, its information will be read again */
+	ISO15693_InvalidateSystemInfo (pBuffer->UID);
+	return ISO15693_ERRORCODE_DEFAULT;
+}
+
+/**  
+* @brief  this function commits a write buffer and releases it. It shall be called before the tag
+* @brief	leaves the field (i.e. at the end of the application transaction)
+* @param  pBuffer			:  	write buffer
+* @retval ISO15693_SUCCESSCODE : the function is successful
+* @retval ISO15693_ERRORCODE_DEFAULT : a write failed
+*/
+int8_t ISO15693_WriteBufferClose ( ISO15693_WRITEBUFFER *pBuffer)
+{
+int8_t	status;
+
+	status = ISO15693_WriteBufferCommit (pBuffer);
+	memset(pBuffer->BlockState, 0x00, sizeof(pBuffer->BlockState));
+	pBuffer->NbBlock = 0;
+
+	return status;
+}
+
 /**  
 * @brief  this function splits inventory response. If the residue of tag response	is incorrect the function returns ERRORCODE_GENERIC, otherwise ISO15693_SUCCESSCODE
 * @param  ReaderResponse	:  	pointer on PCD  response
@@ -1111,8 +2233,8 @@ int8_t ISO15693_RunAntiCollision (uc8 Flags , uc8 AFI,uint8_t *NbTag,uint8_t *pU
 	int8_t		status;
 	uint8_t		MaskValue[ISO15693_NBBYTE_UID],
 			MaskLength = 0,
-			MaskStack [0x80*ISO15693_NBBYTE_UID];	//	can save 16 mask. the size of a mask is ISO15693_NBBYTE_UID.
-												// the first byte is mask length (bit size). the orthers bytre are mask value
+			MaskStack [ISO15693_MASKSTACK_NBENTRY*ISO15693_MASKSTACK_ENTRYSIZE];	// the first byte of an entry is mask length (bit size).
+																								// the others bytes are mask value
 	uint8_t		RequestFlags = Flags,
 			offset=0,
 			ReplyFlag,
@@ -1125,7 +2247,7 @@ int8_t ISO15693_RunAntiCollision (uc8 Flags , uc8 AFI,uint8_t *NbTag,uint8_t *pU
 			UIDoutOffet = PCD_DATA_OFFSET + 2 ;
 	uint16_t	SlotOccupancy= 0x0000	;
 
-	memset(MaskStack,0x00,16*ISO15693_NBBYTE_UID);
+	memset(MaskStack,0x00,ISO15693_MASKSTACK_ENTRYSIZE);
 	*NbTag = 0;
 
 	
@@ -1172,10 +2294,10 @@ int8_t ISO15693_RunAntiCollision (uc8 Flags , uc8 AFI,uint8_t *NbTag,uint8_t *pU
 	// the UIDs can be represnt as a binary tree
 	do{
 
-		memset(MaskValue,0x00,ISO15693_NBBYTE_UID);
-		// unstack mask value
+		// unstack mask length and mask value
 		NthStackValue -- ;
-	   	memcpy(MaskValue,(MaskStack+NthStackValue*ISO15693_NBBYTE_UID+1),ISO15693_NBBYTE_UID);	
+		MaskLength = MaskStack[NthStackValue*ISO15693_MASKSTACK_ENTRYSIZE];
+	   	memcpy(MaskValue,(MaskStack+NthStackValue*ISO15693_MASKSTACK_ENTRYSIZE+1),ISO15693_NBBYTE_UID);	
 
 
 		// at this point : at least two tags are in the field
@@ -1219,10 +2341,8 @@ int8_t ISO15693_RunAntiCollision (uc8 Flags , uc8 AFI,uint8_t *NbTag,uint8_t *pU
 		} // for (i=0;i<NbTagInventoried;i++)
 	
 	   		
-		// add 4 bits to the mask
-		MaskLength +=4;
 	 	// create and stack the masks for the next inventory commands
-		for (i=0;i<16;i++)
+		for (i=0;i<16 && MaskLength+4 <= ISO15693_NBBITS_MASKPARAMETER && NthStackValue < ISO15693_MASKSTACK_NBENTRY;i++)
 		{
 			/*
 			A collision was detected in the inventory 16 slots
@@ -1231,11 +2351,10 @@ int8_t ISO15693_RunAntiCollision (uc8 Flags , uc8 AFI,uint8_t *NbTag,uint8_t *pU
 		
 			if ((SlotOccupancy & (0x01 <<i)) != 0)
 			{
-				// create the mask which include the slot whare the collision occured
-				MaskValue[(MaskLength-4)/8] |= (i << ((MaskLength-4)%8)) ;  
-				// copy masklength and maskvalue into mask stack
-				MaskStack[NthStackValue*ISO15693_NBBYTE_UID]= MaskLength;
-				memcpy((MaskStack+(NthStackValue*ISO15693_NBBYTE_UID)+1),MaskValue,ISO15693_NBBYTE_UID);
+				// the new mask is the mask of the inventory followed by the slot where the collision occured
+				MaskStack[NthStackValue*ISO15693_MASKSTACK_ENTRYSIZE]= MaskLength + 4;
+				memcpy((MaskStack+(NthStackValue*ISO15693_MASKSTACK_ENTRYSIZE)+1),MaskValue,ISO15693_NBBYTE_UID);
+				MaskStack[NthStackValue*ISO15693_MASKSTACK_ENTRYSIZE+1+MaskLength/8] |= (i << (MaskLength%8)) ;  
 				NthStackValue++;
 			}
 		}
@@ -1243,12 +2362,140 @@ int8_t ISO15693_RunAntiCollision (uc8 Flags , uc8 AFI,uint8_t *NbTag,uint8_t *pU
 		 			
 		Nbloop ++;
 
-	} while (NthStackValue >0 && Nbloop < 0x20);
+	// NbTag is on one byte : the next inventory 16 slots could add 16 tags
+	} while (NthStackValue >0 && Nbloop < 0x20 && *NbTag <= 0xFF-16);
 	
 	 return ISO15693_SUCCESSCODE;
 
 }
 
+/**  
+* @brief  	this function stores the tags found by ISO15693_RunAntiCollision in an inventory table.
+* @brief	The tags already in the table are updated (last seen timestamp and hit count).
+* @param  	pTable		: 	inventory table
+* @param  	pInventory	: 	tag records (DSFID + UID) as returned by ISO15693_RunAntiCollision
+* @param  	NbTag		: 	number of tag records
+* @param  	Timestamp	: 	time of the inventory (unit chosen by the application)
+* @retval 	ISO15693_SUCCESSCODE	: 	all the tags have been stored
+* @retval 	ISO15693_ERRORCODE_DEFAULT	: 	the inventory table is full
+*/
+int8_t ISO15693_AddToInventory ( INVENTORY_TABLE *pTable, uc8 *pInventory, uc8 NbTag, uc32 Timestamp)
+{
+	uint8_t		NthTag;
+	int8_t		status = ISO15693_SUCCESSCODE;
+
+	for (NthTag=0; NthTag<NbTag; NthTag++)
+	{
+		if (INVENTORY_Add (	pTable,
+												INVENTORY_TECHNO_ISO15693,
+												&pInventory[NthTag*ISO15693_NBBYTE_INVENTORYRECORD+ISO15693_NBBYTE_DSFID],
+												ISO15693_NBBYTE_UID,
+												pInventory[NthTag*ISO15693_NBBYTE_INVENTORYRECORD],
+												INVENTORY_RSSI_UNKNOWN,
+												Timestamp) != INVENTORY_SUCCESSCODE)
+			status = ISO15693_ERRORCODE_DEFAULT;
+	}
+
+	return status;
+}
+
+/**  
+* @brief  	this function runs an inventory which returns the UID and the first blocks of each tag.
+* @brief	The ST tags answer to the ST Inventory Read with UID and data in one RF frame, several ST tags
+* @brief	are separated by the 16 slots anticollision. The other vendors are then found by the standard
+* @brief	anticollision and their blocks are read with addressed commands (memory layout of the system
+* @brief	information cache). The protocol select command has to be send first.
+* @param  	Flags		: 	request flags (inventory flag set)
+* @param  	AFI			: 	AFI parameter (optional)
+* @param  	Mode		: 	ISO15693_INVENTORYREAD_STONLY if only ST tags can be in the field, 0 otherwise
+* @param  	FirstBlock	: 	first block to read
+* @param  	NbBlock		: 	number of blocks to read (1 to ISO15693_INVENTORYREAD_MAXNBBLOCK)
+* @param  	NbTag		: 	Number of tag seen
+* @param	pOut		: 	tag records of ISO15693_NBBYTE_INVENTORYREADRECORD(NbBlock) bytes (DSFID, UID, status, data)
+* @retval 	ISO15693_SUCCESSCODE	: 	function succesful executed  
+* @retval 	ISO15693_ERRORCODE_DEFAULT	: 	the blocks of at least one tag cannot be read (see the status of the records)
+* @retval 	ISO15693_ERRORCODE_PARAMETERLENGTH	: 	NbBlock is erroneous
+*/
+int8_t ISO15693_RunInventoryRead ( uc8 Flags , uc8 AFI, uc8 Mode, uc8 FirstBlock, uc8 NbBlock, uint8_t *NbTag, uint8_t *pOut)
+{
+	ISO15693_SYSTEMINFO 			Layout;
+	ISO15693_BULKREADRESULT		Result;
+	uint16_t	RecordLength = ISO15693_NBBYTE_INVENTORYREADRECORD(NbBlock);
+	uint8_t		StayQuietFlags = (Flags & ~ISO15693_MASK_INVENTORYFLAG) | ISO15693_MASK_ADDRORNBSLOTSFLAG,
+						NbTagFound = 0,
+						NbTagAntiCol = 0,
+						ReplyStatus,
+						*pRecord;
+	int16_t		NthTag;
+	int8_t		status = ISO15693_SUCCESSCODE;
+
+	*NbTag = 0;
+
+	if (NbBlock == 0 || NbBlock > ISO15693_INVENTORYREAD_MAXNBBLOCK || FirstBlock + NbBlock > 0x100)
+		return ISO15693_ERRORCODE_PARAMETERLENGTH;
+
+	/* one ST tag => UID and data in one RF frame */
+	ISO15693_STInventoryRead (Flags | ISO15693_MASK_ADDRORNBSLOTSFLAG, AFI, 0, 0x00, FirstBlock, NbBlock, u95HFBuffer);
+	ReplyStatus = ISO15693_STInventoryReadRecord (u95HFBuffer, 0, 0x00, NbBlock, pOut);
+	if (ReplyStatus == ISO15693_SUCCESSCODE)
+	{
+		NbTagFound = 1;
+		if ((Mode & ISO15693_INVENTORYREAD_STONLY) == 0x00)
+			ISO15693_StayQuiet (StayQuietFlags, &pOut[ISO15693_NBBYTE_DSFID]);
+	}
+	/* several ST tags => 16 slots anticollision, each tag returns UID and data in its slot */
+	else if (ReplyStatus == ISO15693_ERRORCODE_CRCRESIDUE)
+		ISO15693_STInventoryReadAntiCollision (Flags, AFI, FirstBlock, NbBlock, &NbTagFound, pOut);
+
+	if ((Mode & ISO15693_INVENTORYREAD_STONLY) != 0x00)
+	{
+		*NbTag = NbTagFound;
+		return ISO15693_SUCCESSCODE;
+	}
+
+	/* the ST tags are quiet, the other vendors did not answer to the custom command => look for them */
+	pRecord = &pOut[NbTagFound*RecordLength];
+	ISO15693_RunAntiCollision (Flags, AFI, &NbTagAntiCol, pRecord);
+	/* NbTag is on one byte */
+	if (NbTagAntiCol > 0xFF - NbTagFound)
+		NbTagAntiCol = 0xFF - NbTagFound;
+
+	/* spread the DSFID + UID records (from the last one) to make room for the status and the data */
+	for (NthTag = NbTagAntiCol-1; NthTag >= 0; NthTag--)
+		memmove(&pRecord[NthTag*RecordLength], &pRecord[NthTag*ISO15693_NBBYTE_INVENTORYRECORD], ISO15693_NBBYTE_INVENTORYRECORD);
+
+	/* the tags are quiet => addressed reads with the density and the block size of the tag */
+	for (NthTag = 0; NthTag < NbTagAntiCol; NthTag++, pRecord += RecordLength)
+	{
+		memset(&Result, 0x00, sizeof(ISO15693_BULKREADRESULT));
+		pRecord[ISO15693_INVENTORYREADOFFSET_STATUS] = ISO15693_BulkReadTag (&pRecord[ISO15693_NBBYTE_DSFID], FirstBlock, NbBlock, 0x00,
+																																				&pRecord[ISO15693_INVENTORYREADOFFSET_DATA], &Result);
+		/* no system information => low density tag, it may not support read multiple (i.e. LRiS2K) */
+		if (pRecord[ISO15693_INVENTORYREADOFFSET_STATUS] == ISO15693_ERRORCODE_NOTAGFOUND)
+		{
+			memset(&Layout, 0x00, sizeof(ISO15693_SYSTEMINFO));
+			Layout.Density = ISO15693_LOW_DENSITY;
+			Layout.BlockSize = ISO15693_NBBYTE_BLOCKLENGTH;
+			Layout.SupportedCmd = ISO15693_SUPPORT_READMULTIPLE;
+			memset(&Result, 0x00, sizeof(ISO15693_BULKREADRESULT));
+			pRecord[ISO15693_INVENTORYREADOFFSET_STATUS] = ISO15693_BulkReadTag (&pRecord[ISO15693_NBBYTE_DSFID], FirstBlock, NbBlock, &Layout,
+																																					&pRecord[ISO15693_INVENTORYREADOFFSET_DATA], &Result);
+			if (pRecord[ISO15693_INVENTORYREADOFFSET_STATUS] != ISO15693_SUCCESSCODE && NbBlock > 1)
+			{
+				memset(&Result, 0x00, sizeof(ISO15693_BULKREADRESULT));
+				Layout.SupportedCmd = 0x00;
+				pRecord[ISO15693_INVENTORYREADOFFSET_STATUS] = ISO15693_BulkReadTag (&pRecord[ISO15693_NBBYTE_DSFID], FirstBlock, NbBlock, &Layout,
+																																						&pRecord[ISO15693_INVENTORYREADOFFSET_DATA], &Result);
+			}
+		}
+		if (pRecord[ISO15693_INVENTORYREADOFFSET_STATUS] != ISO15693_SUCCESSCODE)
+			status = ISO15693_ERRORCODE_DEFAULT;
+	}
+
+	*NbTag = NbTagFound + NbTagAntiCol;
+	return status;
+}
+
 
 /**  
 * @brief  	this function runs an anticollision sequence and returns the number of tag seen and their UID.
@@ -1336,52 +2583,25 @@ int8_t ISO15693_RunInventory16slots (uc8 Flags , uc8 AFI,uint8_t *NbTag,uint8_t
 */
 int8_t ISO15693_GetTagIdentification (uint16_t *Length_Memory_TAG, uint8_t *Tag_Density, uint8_t *IC_Ref_TAG)
 {
-	uint8_t RepBuffer[32],
-				RequestFlags = 0x0A;
-
+	ISO15693_SYSTEMINFO SysInfo;
 	uint8_t IC_Ref;
 		
 		/*Use ISO15693 Protocol*/
 		ISO15693_Init();
 		
+		/*Get_System_Info is only sent if the tag is not already in the cache*/
+		if (ISO15693_GetCachedSystemInfo (0x00, &SysInfo) != ISO15693_SUCCESSCODE)
+			return ISO15693_ERRORCODE_NOTAGFOUND;
 		
-		/*Send Get_System_Info with Protocol Extention Flag Set*/
-		if ( ISO15693_GetSystemInfo ( RequestFlags, 0x00, RepBuffer) == ISO15693_SUCCESSCODE)
-			IC_Ref = RepBuffer[17];
-		else
-		{
-				RequestFlags = 0x02;
-				if ( ISO15693_GetSystemInfo ( RequestFlags, 0x00, RepBuffer) == ISO15693_SUCCESSCODE)
-					IC_Ref = RepBuffer[16];
-				else 
-					return ISO15693_ERRORCODE_NOTAGFOUND; 	
-		}
+		IC_Ref = SysInfo.ICRef;
 		
 		switch (IC_Ref)
 		{
 			case ISO15693_M24LR64R :
-				*Length_Memory_TAG = ((((RepBuffer[15] <<8)& 0xFF00) | RepBuffer[14])+1);
-			  *Tag_Density = ISO15693_HIGH_DENSITY;
-				break;
-				
 			case ISO15693_M24LR64ER :
-				*Length_Memory_TAG = ((((RepBuffer[15] <<8)& 0xFF00) | RepBuffer[14])+1);
-				*Tag_Density = ISO15693_HIGH_DENSITY;
-				break;
-				
 			case ISO15693_M24LR16ER :
-				*Length_Memory_TAG = ((((RepBuffer[15] <<8)& 0xFF00) | RepBuffer[14])+1);
-				*Tag_Density = ISO15693_HIGH_DENSITY;
-				break;
-				
 			case ISO15693_M24LR04ER :
-				*Length_Memory_TAG = (RepBuffer[14]+1);
-				*Tag_Density = ISO15693_LOW_DENSITY;
-				break;
-				
 			case ISO15693_LRiS64K :
-				*Length_Memory_TAG = ((((RepBuffer[15] <<8)& 0xFF00) | RepBuffer[14])+1);
-				*Tag_Density = ISO15693_HIGH_DENSITY;
 				break;
 
 			default :
@@ -1391,18 +2611,8 @@ int8_t ISO15693_GetTagIdentification (uint16_t *Length_Memory_TAG, uint8_t *Tag_
 				switch (IC_Ref)
 				{		
 					case ISO15693_LRiS2K :
-						*Length_Memory_TAG = (RepBuffer[14]+1);
-						*Tag_Density = ISO15693_LOW_DENSITY;
-					break;
-				
 					case ISO15693_LRi2K :
-						*Length_Memory_TAG = (RepBuffer[14]+1);
-						*Tag_Density = ISO15693_LOW_DENSITY;
-					break;
-				
 					case ISO15693_LRi1K :
-						*Length_Memory_TAG = (RepBuffer[14]+1);
-						*Tag_Density = ISO15693_LOW_DENSITY;
 					break;
 			
 					default :
@@ -1410,6 +2620,8 @@ int8_t ISO15693_GetTagIdentification (uint16_t *Length_Memory_TAG, uint8_t *Tag_
 				}
 		}
 		
+		*Length_Memory_TAG = SysInfo.NbBlock;
+		*Tag_Density = SysInfo.Density;
 		*IC_Ref_TAG = IC_Ref;
 		return ISO15693_SUCCESSCODE;
 }
@@ -18,17 +18,24 @@
   * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
   */ 
 #include "lib_iso18092pcd.h"
+
+extern uint8_t													u95HFBuffer [RFTRANS_95HF_MAX_BUFFER_SIZE+3];
  
  /* Variables for the different modes */
 extern ST95Mode st95mode;
 extern ST95TagType st95tagtype;
 
 FELICA_CARD 	FELICA_Card;
+/* highest bit rate selected for the cards (lowered when a bit rate fails) */
+static uint8_t	FELICA_MaxBitRate = FELICA_BITRATE_424K;
 
 static uc8 REQC[] = {SEND_RECEIVE ,0x05,0x00,0x12,0xFC,0x01,0x03};
 
-static int8_t FELICA_Init( uint8_t *pDataRead );
-static int8_t FELICA_REQC( uint8_t *pDataRead );
+static int8_t FELICA_Init( uc8 BitRate, uint8_t *pDataRead );
+static uint8_t FELICA_CheckPollingResponse( int8_t SendStatus, uc8 *pDataRead );
+static int8_t FELICA_CheckStatusFlag( uc8 ResponseCode, uc8 *pIDm, uc8 *pDataRead );
+static uint8_t FELICA_BlockListCommand( uc8 Command, uc8 *pIDm, uc16 ServiceCode, uc16 FirstBlock, uc8 NbBlock, uint8_t *pCommand );
+static int8_t FELICA_RequestResponse( uc8 *pIDm );
 
 /** @addtogroup _95HF_Libraries
  * 	@{
@@ -56,15 +63,18 @@ static int8_t FELICA_REQC( uint8_t *pDataRead );
 
 /**
  * @brief  Initializes the xx95HF for the FELICA protocol
- * @param  void
+ * @param  BitRate : FELICA_BITRATE_212K or FELICA_BITRATE_424K
  * @return TRUE (if well configured) / FALSE (Communication issue)
  */
-static int8_t FELICA_Init( uint8_t *pDataRead )
+static int8_t FELICA_Init( uc8 BitRate, uint8_t *pDataRead )
 {
 	int8_t  status;
 	u8     ProtocolSelectParameters []  = {0x51, 0x13, 0x01,0x0D};
 	u8     WriteAmpliGain []  = {0x01, 0x51};
 	u8     AutoFDet []  = {0x02,0xA1};
+
+	if (BitRate == FELICA_BITRATE_424K)
+		ProtocolSelectParameters[0] = PCD_FELICA_TRANSMISSION_SPEED_424K | PCD_FELICA_RECEPTION_SPEED_424K | PCD_FELICA_APPEND_CRC;
 	
 	/* sends a protocol Select command to the pcd to configure it */
 	errchk(PCD_ProtocolSelect(0x05,PCD_PROTOCOL_FELICA,ProtocolSelectParameters,pDataRead));
@@ -83,15 +93,114 @@ Error:
 }
 
 /**
- * @brief  Handles the REQC command
+ * @brief  Checks the answer to a polling command
+ * @param  SendStatus	: status returned by PCD_SendRecv
  * @param  *pDataRead	: Pointer on the response
- * @return TRUE (if CR95HF answered ATQB) / FALSE (No ISO14443B in Field)
+ * @return ISO18092_SUCCESSCODE : one card answered
+ * @return ISO18092_ERRORCODE_DEFAULT : no card answered
+ * @return ISO18092_ERRORCODE_COLLISION : several cards answered in the same slot
  */
-static int8_t FELICA_REQC( uint8_t *pDataRead )
+static uint8_t FELICA_CheckPollingResponse( int8_t SendStatus, uc8 *pDataRead )
 {
-	if(PCD_CheckSendReceive(REQC, pDataRead)!= ISO18092_SUCCESSCODE)
+	uint8_t NbByte = pDataRead[PCD_LENGTH_OFFSET];
+
+	if (SendStatus != PCD_SUCCESSCODE && pDataRead[PCD_COMMAND_OFFSET] == SENDRECV_ERRORCODE_FRAMEWAIT)
 		return ISO18092_ERRORCODE_DEFAULT;
-		
+
+	/* framing or CRC error, collision flag or truncated response */
+	if (SendStatus != PCD_SUCCESSCODE ||
+			NbByte < FELICA_NBBYTE_POLLINGRESPONSE + CONTROL_FELICA_NBBYTE ||
+			pDataRead[PCD_DATA_OFFSET] != FELICA_RESPONSE_POLLING ||
+			(pDataRead[PCD_DATA_OFFSET + NbByte - CONTROL_FELICA_NBBYTE] & (CONTROL_FELICA_CRCMASK | CONTROL_FELICA_COLISIONMASK)) != 0)
+		return ISO18092_ERRORCODE_COLLISION;
+
+	return ISO18092_SUCCESSCODE;
+}
+
+/**
+ * @brief  Checks the answer to a command addressed to a card (response code, IDm and status flags)
+ * @param  ResponseCode : response code expected
+ * @param  *pIDm : IDm of the card
+ * @param  *pDataRead : Pointer on the response
+ * @return ISO18092_SUCCESSCODE : the card executed the command
+ * @return ISO18092_ERRORCODE_DEFAULT : an error occured
+ */
+static int8_t FELICA_CheckStatusFlag( uc8 ResponseCode, uc8 *pIDm, uc8 *pDataRead )
+{
+	if (pDataRead[PCD_LENGTH_OFFSET] < FELICA_OFFSET_NBBLOCK + CONTROL_FELICA_NBBYTE ||
+			PCD_IsCRCOk(PCD_PROTOCOL_FELICA, pDataRead) != PCD_SUCCESSCODE ||
+			pDataRead[PCD_DATA_OFFSET] != ResponseCode ||
+			memcmp(&pDataRead[PCD_DATA_OFFSET + 1], pIDm, FELICA_NBBYTE_IDM) != 0 ||
+			pDataRead[PCD_DATA_OFFSET + FELICA_OFFSET_STATUSFLAG1] != 0x00 ||
+			pDataRead[PCD_DATA_OFFSET + FELICA_OFFSET_STATUSFLAG2] != 0x00)
+		return ISO18092_ERRORCODE_DEFAULT;
+
+	return ISO18092_SUCCESSCODE;
+}
+
+/**
+ * @brief  Builds a Check or Update command up to its block list (one service)
+ * @param  Command : FELICA_COMMAND_CHECK or FELICA_COMMAND_UPDATE
+ * @param  *pIDm : IDm of the card
+ * @param  ServiceCode : service code of the blocks
+ * @param  FirstBlock : first block of the command
+ * @param  NbBlock : number of blocks of the command
+ * @param  *pCommand : command built
+ * @return number of bytes of the command
+ */
+static uint8_t FELICA_BlockListCommand( uc8 Command, uc8 *pIDm, uc16 ServiceCode, uc16 FirstBlock, uc8 NbBlock, uint8_t *pCommand )
+{
+	uint8_t 	Length = 0,
+						i;
+	uint16_t 	Block;
+
+	pCommand[Length++] = Command;
+	memcpy(&pCommand[Length], pIDm, FELICA_NBBYTE_IDM);
+	Length += FELICA_NBBYTE_IDM;
+	/* one service, code lsb first */
+	pCommand[Length++] = 0x01;
+	pCommand[Length++] = ServiceCode & 0xFF;
+	pCommand[Length++] = (ServiceCode >> 8) & 0xFF;
+	pCommand[Length++] = NbBlock;
+
+	for (i=0; i<NbBlock; i++)
+	{
+		Block = FirstBlock + i;
+		if (Block <= 0xFF)
+		{
+			pCommand[Length++] = FELICA_BLOCKLIST_2BYTES;
+			pCommand[Length++] = Block;
+		}
+		else
+		{
+			pCommand[Length++] = FELICA_BLOCKLIST_3BYTES;
+			pCommand[Length++] = Block & 0xFF;
+			pCommand[Length++] = (Block >> 8) & 0xFF;
+		}
+	}
+
+	return Length;
+}
+
+/**
+ * @brief  Sends a Request Response command to check that the card answers
+ * @param  *pIDm : IDm of the card
+ * @return ISO18092_SUCCESSCODE : the card answered
+ * @return ISO18092_ERRORCODE_DEFAULT : no answer
+ */
+static int8_t FELICA_RequestResponse( uc8 *pIDm )
+{
+	uint8_t RequestResponse[1+FELICA_NBBYTE_IDM] = {FELICA_COMMAND_REQUESTRESPONSE},
+					*pDataRead = u95HFBuffer;
+
+	memcpy(&RequestResponse[1], pIDm, FELICA_NBBYTE_IDM);
+
+	if (PCD_SendRecv(sizeof(RequestResponse), RequestResponse, pDataRead) != PCD_SUCCESSCODE ||
+			PCD_IsCRCOk(PCD_PROTOCOL_FELICA, pDataRead) != PCD_SUCCESSCODE ||
+			pDataRead[PCD_DATA_OFFSET] != FELICA_RESPONSE_REQUESTRESPONSE ||
+			memcmp(&pDataRead[PCD_DATA_OFFSET + 1], pIDm, FELICA_NBBYTE_IDM) != 0)
+		return ISO18092_ERRORCODE_DEFAULT;
+
 	return ISO18092_SUCCESSCODE;
 }
 
@@ -105,13 +214,203 @@ static int8_t FELICA_REQC( uint8_t *pDataRead )
  *  @{
  */
 
+/**
+ * @brief  Initializes the PCD device for FeliCa and waits for the whole guard time of the field
+ */
 void FELICA_Initialization( void )
+{
+	FELICA_InitializationGuardTime(0);
+}
+
+/**
+ * @brief  Initializes the PCD device for FeliCa and waits for the end of the guard time of the field
+ * @param  FieldOnTime : time (ms) already spent since the RF field was switched on
+ */
+void FELICA_InitializationGuardTime( uc8 FieldOnTime )
 {
 	uint8_t DataRead[MAX_BUFFER_SIZE];
 	
 	/* Init the FeliCa communication */
-	FELICA_Init(DataRead);
-	delay_ms(20);
+	FELICA_Init(FELICA_BITRATE_212K, DataRead);
+	FELICA_Card.BitRate = FELICA_BITRATE_212K;
+
+	/* the card is powered by the field for the guard time before the first polling */
+	if (FieldOnTime < FELICA_GUARDTIME_MS)
+		delay_ms(FELICA_GUARDTIME_MS - FieldOnTime);
+}
+
+/**
+ * @brief  Sends polling commands and returns the cards which answered.
+ * @brief  The PCD device only receives the first answer of a polling, so the polling is sent again 
+ * @brief  (each card chooses a new slot) until FELICA_POLLING_NBREPEAT pollings bring no new card.
+ * @param  SystemCode : system code of the cards (FELICA_SYSTEMCODE_WILDCARD for all the cards)
+ * @param  RequestCode : FELICA_REQUESTCODE_xxx
+ * @param  TimeSlot : FELICA_TIMESLOT_xxx (with FELICA_TIMESLOT_1 a single polling is sent)
+ * @param  *pRecord : card records (IDm, PMm, request data)
+ * @param  MaxNbTag : number of records of pRecord (the polling stops when pRecord is full)
+ * @param  *pNbTag : Number of tag detected
+ * @return ISO18092_SUCCESSCODE : at least one card answered
+ * @return ISO18092_ERRORCODE_DEFAULT : no card (or only collisions)
+ */
+int8_t FELICA_Polling( uc16 SystemCode, uc8 RequestCode, uc8 TimeSlot, FELICA_TAGRECORD *pRecord, uc8 MaxNbTag, uint8_t *pNbTag )
+{
+	uint8_t Polling[] = {ISO18092_COMMAND_REQC, (SystemCode >> 8) & 0xFF, SystemCode & 0xFF, RequestCode, TimeSlot};
+	uint8_t *pDataRead = u95HFBuffer,
+					NbPolling,
+					NbRepeat = 0,
+					status,
+					i;
+
+	*pNbTag = 0;
+
+	for (NbPolling = 0; NbPolling < FELICA_POLLING_MAXNBPOLLING && NbRepeat < FELICA_POLLING_NBREPEAT && *pNbTag < MaxNbTag; NbPolling++)
+	{
+		status = FELICA_CheckPollingResponse(PCD_SendRecv(sizeof(Polling), Polling, pDataRead), pDataRead);
+		/* every card answers to each polling : no more card in the field */
+		if (status == ISO18092_ERRORCODE_DEFAULT)
+			break;
+
+		/* a collision hides cards which may be new */
+		if (status == ISO18092_SUCCESSCODE)
+		{
+			NbRepeat++;
+			for (i=0; i<*pNbTag && memcmp(pRecord[i].IDm, &pDataRead[PCD_DATA_OFFSET + 1], FELICA_NBBYTE_IDM) != 0; i++);
+			if (i == *pNbTag)
+			{
+				memcpy(pRecord[i].IDm, &pDataRead[PCD_DATA_OFFSET + 1], FELICA_NBBYTE_IDM);
+				memcpy(pRecord[i].PMm, &pDataRead[PCD_DATA_OFFSET + 1 + FELICA_NBBYTE_IDM], FELICA_NBBYTE_PMM);
+				memset(pRecord[i].RequestData, 0x00, FELICA_NBBYTE_REQUESTDATA);
+				if (RequestCode != FELICA_REQUESTCODE_NONE && 
+						pDataRead[PCD_LENGTH_OFFSET] >= FELICA_NBBYTE_POLLINGRESPONSE + FELICA_NBBYTE_REQUESTDATA + CONTROL_FELICA_NBBYTE)
+					memcpy(pRecord[i].RequestData, &pDataRead[PCD_DATA_OFFSET + FELICA_NBBYTE_POLLINGRESPONSE], FELICA_NBBYTE_REQUESTDATA);
+				(*pNbTag)++;
+				NbRepeat = 0;
+			}
+		}
+
+		/* all the cards answer in the same slot */
+		if (TimeSlot == FELICA_TIMESLOT_1)
+			break;
+	}
+
+	if (*pNbTag == 0)
+		return ISO18092_ERRORCODE_DEFAULT;
+
+	return ISO18092_SUCCESSCODE;
+}
+
+/**
+ * @brief  Reads blocks of a card with as many Check commands as needed
+ * @param  *pIDm : IDm of the card
+ * @param  ServiceCode : service code of the blocks
+ * @param  FirstBlock : first block to read
+ * @param  NbBlock : number of blocks to read
+ * @param  MaxNbBlock : blocks read by a Check command for the card (Nbr of the NFC Forum attribute information)
+ * @param  *pDataRead : blocks read (NbBlock * FELICA_NBBYTE_BLOCK bytes)
+ * @return ISO18092_SUCCESSCODE : the blocks are read
+ * @return ISO18092_ERRORCODE_DEFAULT : an error occured
+ */
+int8_t FELICA_Check( uc8 *pIDm, uc16 ServiceCode, uc16 FirstBlock, uc16 NbBlock, uc8 MaxNbBlock, uint8_t *pDataRead )
+{
+	uint8_t 	Command[FELICA_NBBYTE_BLOCKCOMMANDHEADER + FELICA_MAX_NBBLOCK_CHECK*FELICA_NBBYTE_MAXBLOCKLISTELEMENT],
+						*pResponse = u95HFBuffer,
+						NbBlockFrame,
+						Length;
+	uint16_t 	NthBlock;
+
+	for (NthBlock = 0; NthBlock < NbBlock; NthBlock += NbBlockFrame)
+	{
+		NbBlockFrame = MIN(NbBlock - NthBlock, MIN(MAX(MaxNbBlock, 1), FELICA_MAX_NBBLOCK_CHECK));
+		Length = FELICA_BlockListCommand(FELICA_COMMAND_CHECK, pIDm, ServiceCode, FirstBlock + NthBlock, NbBlockFrame, Command);
+
+		if (PCD_SendRecv(Length, Command, pResponse) != PCD_SUCCESSCODE ||
+				FELICA_CheckStatusFlag(FELICA_RESPONSE_CHECK, pIDm, pResponse) != ISO18092_SUCCESSCODE ||
+				pResponse[PCD_LENGTH_OFFSET] < FELICA_OFFSET_BLOCKDATA + NbBlockFrame*FELICA_NBBYTE_BLOCK + CONTROL_FELICA_NBBYTE ||
+				pResponse[PCD_DATA_OFFSET + FELICA_OFFSET_NBBLOCK] != NbBlockFrame)
+			return ISO18092_ERRORCODE_DEFAULT;
+
+		/* the blocks go straight to their place in the buffer */
+		memcpy(&pDataRead[NthBlock*FELICA_NBBYTE_BLOCK], &pResponse[PCD_DATA_OFFSET + FELICA_OFFSET_BLOCKDATA], NbBlockFrame*FELICA_NBBYTE_BLOCK);
+	}
+
+	return ISO18092_SUCCESSCODE;
+}
+
+/**
+ * @brief  Writes blocks of a card with as many Update commands as needed
+ * @param  *pIDm : IDm of the card
+ * @param  ServiceCode : service code of the blocks
+ * @param  FirstBlock : first block to write
+ * @param  NbBlock : number of blocks to write
+ * @param  MaxNbBlock : blocks written by an Update command for the card (Nbw of the NFC Forum attribute information)
+ * @param  *pDataToWrite : blocks to write (NbBlock * FELICA_NBBYTE_BLOCK bytes)
+ * @return ISO18092_SUCCESSCODE : the blocks are written
+ * @return ISO18092_ERRORCODE_DEFAULT : an error occured
+ */
+int8_t FELICA_Update( uc8 *pIDm, uc16 ServiceCode, uc16 FirstBlock, uc16 NbBlock, uc8 MaxNbBlock, uc8 *pDataToWrite )
+{
+	uint8_t 	Command[RFTRANS_95HF_MAX_BUFFER_SIZE],
+						*pResponse = u95HFBuffer,
+						NbBlockFrame,
+						Length;
+	uint16_t 	NthBlock;
+
+	for (NthBlock = 0; NthBlock < NbBlock; NthBlock += NbBlockFrame)
+	{
+		NbBlockFrame = MIN(NbBlock - NthBlock, MIN(MAX(MaxNbBlock, 1), FELICA_MAX_NBBLOCK_UPDATE));
+		Length = FELICA_BlockListCommand(FELICA_COMMAND_UPDATE, pIDm, ServiceCode, FirstBlock + NthBlock, NbBlockFrame, Command);
+		memcpy(&Command[Length], &pDataToWrite[NthBlock*FELICA_NBBYTE_BLOCK], NbBlockFrame*FELICA_NBBYTE_BLOCK);
+		Length += NbBlockFrame*FELICA_NBBYTE_BLOCK;
+
+		if (PCD_SendRecv(Length, Command, pResponse) != PCD_SUCCESSCODE ||
+				FELICA_CheckStatusFlag(FELICA_RESPONSE_UPDATE, pIDm, pResponse) != ISO18092_SUCCESSCODE)
+			return ISO18092_ERRORCODE_DEFAULT;
+	}
+
+	return ISO18092_SUCCESSCODE;
+}
+
+/**
+ * @brief  Switches the PCD device to 424 kbps when the card supports it (communication performance of the polling).
+ * @brief  The card answers at the bit rate of the command, it is checked with a Request Response command.
+ * @return ISO18092_SUCCESSCODE : the PCD device uses the highest bit rate of the card
+ * @return ISO18092_ERRORCODE_DEFAULT : the card did not answer at 424 kbps, the PCD device is back to 212 kbps
+ */
+int8_t FELICA_SelectMaxBitRate( void )
+{
+	FELICA_TAGRECORD Record;
+	uint8_t NbTag,
+					DataRead[MAX_BUFFER_SIZE];
+
+	if (FELICA_Card.BitRate >= FELICA_MaxBitRate)
+		return ISO18092_SUCCESSCODE;
+
+	if (FELICA_Polling(FELICA_SYSTEMCODE_WILDCARD, FELICA_REQUESTCODE_COMMUNICATIONPERFORMANCE, FELICA_TIMESLOT_1, &Record, 1, &NbTag) != ISO18092_SUCCESSCODE ||
+			memcmp(Record.IDm, FELICA_Card.UID, FELICA_NBBYTE_IDM) != 0 ||
+			(Record.RequestData[1] & FELICA_COMMUNICATIONPERFORMANCE_424K) == 0x00)
+		return ISO18092_SUCCESSCODE;
+
+	if (FELICA_Init(FELICA_BITRATE_424K, DataRead) != ISO18092_SUCCESSCODE ||
+			FELICA_RequestResponse(FELICA_Card.UID) != ISO18092_SUCCESSCODE)
+	{
+		/* fallback : 424 kbps is not selected any more */
+		FELICA_MaxBitRate = FELICA_BITRATE_212K;
+		FELICA_Init(FELICA_BITRATE_212K, DataRead);
+		return ISO18092_ERRORCODE_DEFAULT;
+	}
+	FELICA_Card.BitRate = FELICA_BITRATE_424K;
+
+	return ISO18092_SUCCESSCODE;
+}
+
+/**
+ * @brief  Sets the highest bit rate selected by FELICA_SelectMaxBitRate (the fallback after a failure lowers it)
+ * @param  BitRate: FELICA_BITRATE_212K or FELICA_BITRATE_424K
+ * @retval None
+ */
+void FELICA_SetMaxBitRate( uc8 BitRate )
+{
+	FELICA_MaxBitRate = MIN(BitRate, FELICA_BITRATE_424K);
 }
 
 /**
@@ -121,18 +420,20 @@ void FELICA_Initialization( void )
  */
 int8_t FELICA_IsPresent( void )
 {
-	uint8_t DataRead[MAX_BUFFER_SIZE];
-
-	/* Initializing buffer */
-	memset(DataRead,0,MAX_BUFFER_SIZE);
+	FELICA_TAGRECORD Record;
+	uint8_t NbTag;
 
-	/* REQC attempt */
-	if(FELICA_REQC(DataRead) != ISO18092_SUCCESSCODE  )
+	/* Polling attempt, the first card answering is kept */
+	if(FELICA_Polling(FELICA_SYSTEMCODE_NDEF, FELICA_REQUESTCODE_SYSTEMCODE, FELICA_TIMESLOT_4, &Record, 1, &NbTag) != ISO18092_SUCCESSCODE  )
 		return ISO18092_ERRORCODE_DEFAULT;
 
 	/* Filling of the data structure */
 	FELICA_Card.IsDetected = true;
-	memcpy(FELICA_Card.ATQC, &DataRead[PCD_DATA_OFFSET],  ATQC_SIZE);
+	memset(FELICA_Card.ATQC, 0x00, ATQC_SIZE);
+	FELICA_Card.ATQC[0] = FELICA_RESPONSE_POLLING;
+	memcpy(&FELICA_Card.ATQC[1], Record.IDm, FELICA_NBBYTE_IDM);
+	memcpy(&FELICA_Card.ATQC[1+FELICA_NBBYTE_IDM], Record.PMm, FELICA_NBBYTE_PMM);
+	memcpy(&FELICA_Card.ATQC[FELICA_NBBYTE_POLLINGRESPONSE], Record.RequestData, FELICA_NBBYTE_REQUESTDATA);
 	memcpy(FELICA_Card.UID , &FELICA_Card.ATQC[1]  , UID_SIZE_FELICA);
 	
 	st95mode = PCD;
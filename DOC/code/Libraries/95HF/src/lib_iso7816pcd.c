@@ -19,17 +19,39 @@
   */ 
 
 #include "lib_iso7816pcd.h"
+#include "lib_iso14443Apcd.h"
+#include "lib_iso14443Bpcd.h"
 
 extern ST95TagType st95tagtype;
+extern uint16_t FSC;
+extern ISO14443B_CARD ISO14443B_Card;
 
-uint8_t bufferSend[MAX_BUFFER_SIZE+3],
-				bufferReceive[MAX_BUFFER_SIZE+3];
+uint8_t bufferSend[ISO7816_MAX_COMMAND_SIZE],
+				bufferReceive[ISO7816_MAX_RESPONSE_SIZE];
 
 static APDU_Commands APDUcommand ; 
 static APDU_Responce APDUresponse;
-static uint8_t BlockNumber = 0x02;
+/* current block number of the PCD device (ISO14443-4 rules A and B) */
+static uint8_t BlockNumber = 0x00;
+/* block sent to the PCD device and its reply */
+static uint8_t ISO7816_Block [RFTRANS_95HF_MAX_BUFFER_SIZE];
+/* command being sent : the INF field of its I-block is gathered again in ISO7816_Block for each
+   retransmission (the R-blocks and S-blocks sent in between overwrite it) */
+static uc8 *ISO7816_pHeader,
+					 *ISO7816_pData;
+static uint16_t ISO7816_HeaderLength;
+static uint32_t ISO7816_NbByteSent;
+static uint8_t ISO7816_Frame [RFTRANS_95HF_MAX_BUFFER_SIZE+3];
 
 static int8_t ISO7816_SendReceiveAPDU ( uint8_t *pDataReceived );
+static uint16_t ISO7816_MaxInfSize ( void );
+static void ISO7816_PlaceInf ( uint8_t *pInf, uc8 InfLength );
+static int8_t ISO7816_ExtendFrameWaitingTime ( uc8 WTXM );
+static int8_t ISO7816_SendFrame ( uc8 PCB, uc8 *pInf, uc8 InfLength, uint8_t *pBlockLength );
+static int8_t ISO7816_ExchangeBlock ( uc8 PCB, uc8 *pInf, uc8 InfLength, uint8_t *pBlockLength );
+static int8_t ISO7816_SendBlock ( uc8 PCB, uc8 *pInf, uc8 InfLength, uc8 RecoveryPCB, uint8_t *pBlockLength );
+static int8_t ISO7816_TransceiveData ( uc8 *pHeader, uc16 HeaderLength, uc8 *pData, uc16 DataLength,
+																			uint8_t *pResponse, uint16_t *pResponseLength, uc16 MaxResponseLength );
 
 /** @addtogroup _95HF_Libraries
  * 	@{
@@ -57,21 +79,272 @@ static int8_t ISO7816_SendReceiveAPDU ( uint8_t *pDataReceived );
 
 
 
+/**
+ * @brief  this function returns the largest INF field of a block sent to the card
+ * @return FSC without PCB and CRC, limited by the buffer of the PCD device
+ */
+static uint16_t ISO7816_MaxInfSize ( void )
+{
+	uint16_t FrameSize = FSC;
+
+	if( st95tagtype != TT4A )
+		FrameSize = PCD_ISO14443FrameSize(ISO14443B_Card.ProtocolInfo[1] >> ISO14443B_PROTOCOLINFO_FSCISHIFT);
+
+	/* the control byte is also sent to the PCD device for the type A */
+	return MIN(FrameSize - ISO7816_NBBYTE_PCB - ISO7816_NBBYTE_CRC, RFTRANS_95HF_MAX_BUFFER_SIZE - ISO7816_NBBYTE_PCB - 1);
+}
+
+/**
+ * @brief  this function gathers the INF field of the I-block being sent from the end of the header
+ * @brief  and the data of the command (ISO7816_NbByteSent bytes of the command are already sent)
+ * @param  pInf : INF field
+ * @param  InfLength : number of bytes of the INF field
+ * @return None
+ */
+static void ISO7816_PlaceInf ( uint8_t *pInf, uc8 InfLength )
+{
+	uint8_t 	NbByteHeader = 0;
+
+	if (ISO7816_NbByteSent < ISO7816_HeaderLength)
+	{
+		NbByteHeader = MIN((uint32_t)(ISO7816_HeaderLength - ISO7816_NbByteSent), (uint32_t)InfLength);
+		memcpy(pInf,&ISO7816_pHeader[ISO7816_NbByteSent],NbByteHeader);
+	}
+	if (InfLength > NbByteHeader)
+		memcpy(&pInf[NbByteHeader],&ISO7816_pData[ISO7816_NbByteSent + NbByteHeader - ISO7816_HeaderLength],InfLength - NbByteHeader);
+}
+
+/**
+ * @brief  this function multiplies the time out of the PCD device by the WTXM of a S(WTX) block
+ * @param  WTXM : waiting time extension multiplier (1 goes back to the frame waiting time of the card)
+ * @return ISO7816_SUCCESSCODE : the function is succesful
+ * @return ISO7816_ERRORCODE_DEFAULT : the PCD device cannot be configured
+ */
+static int8_t ISO7816_ExtendFrameWaitingTime ( uc8 WTXM )
+{
+	int8_t 		status;
+
+	if( st95tagtype == TT4A )
+		status = ISO14443A_ExtendFrameWaitingTime(WTXM);
+	else
+		status = ISO14443B_ExtendFrameWaitingTime(WTXM);
+
+	if (status != RESULTOK)
+		return ISO7816_ERRORCODE_DEFAULT;
+	return ISO7816_SUCCESSCODE;
+}
+
+/**
+ * @brief  this function sends a block to the RF transceiver and checks the block returned by the card
+ * @param  PCB : protocol control byte
+ * @param  pInf : INF field (0x00 => INF field of the command being sent, see ISO7816_PlaceInf)
+ * @param  InfLength : number of bytes of the INF field
+ * @param  pBlockLength : number of bytes of the block returned (PCB and INF field in ISO7816_Frame)
+ * @return ISO7816_SUCCESSCODE : a valid block is received
+ * @return ISO7816_ERRORCODE_DEFAULT : time out, CRC error or empty frame
+ */
+static int8_t ISO7816_SendFrame ( uc8 PCB, uc8 *pInf, uc8 InfLength, uint8_t *pBlockLength )
+{
+	uint8_t 	NthByte = 0,
+						Protocol = PCD_PROTOCOL_ISO14443B,
+						NbByteTrailer = ISO7816_NBBYTE_CRC + CONTROL_14443B_NBBYTE;
+	int8_t 		status;
+
+	ISO7816_Block[NthByte++] = PCB;
+	if (InfLength > 0 && pInf == 0x00)
+		ISO7816_PlaceInf(&ISO7816_Block[NthByte],InfLength);
+	else if (InfLength > 0)
+		memcpy(&ISO7816_Block[NthByte],pInf,InfLength);
+	NthByte += InfLength;
+
+	// control byte append CRC + 8 bits
+	if( st95tagtype == TT4A )
+	{
+		ISO7816_Block[NthByte++] = SEND_MASK_APPENDCRC | SEND_MASK_8BITSINFIRSTBYTE;
+		Protocol = PCD_PROTOCOL_ISO14443A;
+		NbByteTrailer = ISO7816_NBBYTE_CRC + ISO14443A_NBBYTE;
+	}
+
+	// send the block to the RF transceiver
+	errchk(PCD_SendRecv(NthByte,ISO7816_Block,ISO7816_Frame));
+	errchk(PCD_IsCRCOk (Protocol,ISO7816_Frame));
+
+	/* the block contains at least the PCB */
+	if (ISO7816_Frame[PCD_LENGTH_OFFSET] <= NbByteTrailer)
+		goto Error;
+	*pBlockLength = ISO7816_Frame[PCD_LENGTH_OFFSET] - NbByteTrailer;
+
+	return ISO7816_SUCCESSCODE;
+Error:
+	return ISO7816_ERRORCODE_DEFAULT;
+}
+
+/**
+ * @brief  this function sends a block and answers the S(WTX) of the card until it returns another block.
+ * @brief  The time out of the PCD device is multiplied by WTXM for the block following each S(WTX).
+ * @param  PCB : protocol control byte
+ * @param  pInf : INF field (0x00 => INF field of the command being sent)
+ * @param  InfLength : number of bytes of the INF field
+ * @param  pBlockLength : number of bytes of the block returned (PCB and INF field in ISO7816_Frame)
+ * @return ISO7816_SUCCESSCODE : a valid block is received
+ * @return ISO7816_ERRORCODE_DEFAULT : the exchange failed
+ */
+static int8_t ISO7816_ExchangeBlock ( uc8 PCB, uc8 *pInf, uc8 InfLength, uint8_t *pBlockLength )
+{
+	uint8_t 	NbWTX = 0,
+						WTXM;
+	int8_t 		status;
+
+	status = ISO7816_SendFrame(PCB, pInf, InfLength, pBlockLength);
+
+	/* the card asks for a waiting time extension */
+	while (status == ISO7816_SUCCESSCODE && ISO7816_Frame[PCD_DATA_OFFSET] == ISO7816_PCB_SWTX &&
+				*pBlockLength == ISO7816_NBBYTE_PCB + 1)
+	{
+		WTXM = ISO7816_Frame[PCD_DATA_OFFSET + ISO7816_NBBYTE_PCB] & ISO7816_WTXM_MASK;
+		if (WTXM == 0 || NbWTX++ >= ISO7816_MAX_NBWTX || ISO7816_ExtendFrameWaitingTime(WTXM) != ISO7816_SUCCESSCODE)
+		{
+			status = ISO7816_ERRORCODE_DEFAULT;
+			break;
+		}
+		/* the S(WTX) is sent back with the same WTXM */
+		status = ISO7816_SendFrame(ISO7816_PCB_SWTX, &WTXM, 1, pBlockLength);
+	}
+
+	/* the extension is only valid for the block following the S(WTX) */
+	if (NbWTX > 0)
+		ISO7816_ExtendFrameWaitingTime(1);
+
+	return status;
+}
+
+/**
+ * @brief  this function sends a block and recovers the transmission errors (ISO14443-4 rules 4 and 6) :
+ * @brief  a R-block asks the card to send its last block again, the last I-block is sent again when
+ * @brief  the card did not receive it.
+ * @param  PCB : protocol control byte
+ * @param  pInf : INF field (0x00 => INF field of the command being sent)
+ * @param  InfLength : number of bytes of the INF field
+ * @param  RecoveryPCB : R-block sent after an error (R(NAK), or R(ACK) when the card chains its answer)
+ * @param  pBlockLength : number of bytes of the block returned (PCB and INF field in ISO7816_Frame)
+ * @return ISO7816_SUCCESSCODE : a valid block is received
+ * @return ISO7816_ERRORCODE_DEFAULT : the exchange still fails after ISO7816_NBRETRY R-blocks
+ */
+static int8_t ISO7816_SendBlock ( uc8 PCB, uc8 *pInf, uc8 InfLength, uc8 RecoveryPCB, uint8_t *pBlockLength )
+{
+	uint8_t 	NbRetry = 0,
+						NbResend = 0;
+	int8_t 		status;
+
+	status = ISO7816_ExchangeBlock(PCB, pInf, InfLength, pBlockLength);
+
+	while (1)
+	{
+		/* time out or invalid block */
+		if (status != ISO7816_SUCCESSCODE && NbRetry++ < ISO7816_NBRETRY)
+			status = ISO7816_ExchangeBlock(RecoveryPCB | BlockNumber, 0, 0, pBlockLength);
+		/* the R(ACK) does not acknowledge the last I-block */
+		else if (status == ISO7816_SUCCESSCODE && (PCB & ISO7816_PCB_TYPEMASK) == ISO7816_PCB_TYPE_I &&
+						(ISO7816_Frame[PCD_DATA_OFFSET] & ~ISO7816_PCB_BLOCKNUMBERMASK) == ISO7816_PCB_RACK &&
+						(ISO7816_Frame[PCD_DATA_OFFSET] & ISO7816_PCB_BLOCKNUMBERMASK) != BlockNumber &&
+						NbResend++ < ISO7816_NBRETRY)
+			status = ISO7816_ExchangeBlock(PCB, pInf, InfLength, pBlockLength);
+		else
+			break;
+	}
+
+	return status;
+}
+
+/**
+ * @brief  this function exchanges a command made of a header and data with the card (ISO14443-4 block
+ * @brief  protocol). The command is chained in blocks of FSC bytes taken directly from both buffers,
+ * @brief  the response chained by the card is written in the response buffer as it is received.
+ * @param  pHeader	: first bytes of the command
+ * @param  HeaderLength	: number of bytes of the header
+ * @param  pData	: following bytes of the command
+ * @param  DataLength	: number of bytes of the data
+ * @param  pResponse	: response of the card
+ * @param  pResponseLength	: number of bytes of the response
+ * @param  MaxResponseLength	: size of the response buffer
+ * @return ISO7816_SUCCESSCODE : the function is successful
+ * @return ISO7816_ERRORCODE_DEFAULT : the function is not successful 
+ */
+static int8_t ISO7816_TransceiveData ( uc8 *pHeader, uc16 HeaderLength, uc8 *pData, uc16 DataLength,
+																			uint8_t *pResponse, uint16_t *pResponseLength, uc16 MaxResponseLength )
+{
+	uint32_t 	CommandLength = (uint32_t)HeaderLength + DataLength;
+	uint16_t 	MaxInfSize = ISO7816_MaxInfSize( );
+	uint8_t 	InfLength,
+						PCB,
+						BlockLength;
+	int8_t 		status;
+
+	*pResponseLength = 0;
+	APDUresponse.SW1 = GETMSB(ISO7816_SW_NONE);
+	APDUresponse.SW2 = GETLSB(ISO7816_SW_NONE);
+	ISO7816_pHeader = pHeader;
+	ISO7816_HeaderLength = HeaderLength;
+	ISO7816_pData = pData;
+	ISO7816_NbByteSent = 0;
+
+	/* PCD chaining : each chained I-block is acknowledged with a R(ACK) */
+	do
+	{
+		InfLength = MIN(CommandLength - ISO7816_NbByteSent, MaxInfSize);
+		PCB = ISO7816_PCB_IBLOCK | BlockNumber;
+		if (ISO7816_NbByteSent + InfLength < CommandLength)
+			PCB |= ISO7816_PCB_CHAININGMASK;
+
+		/* the INF field is gathered from the end of the header and the data at each transmission */
+		errchk(ISO7816_SendBlock(PCB, 0x00, InfLength, ISO7816_PCB_RNAK, &BlockLength));
+		ISO7816_NbByteSent += InfLength;
+
+		if ((PCB & ISO7816_PCB_CHAININGMASK) != 0x00)
+		{
+			if (ISO7816_Frame[PCD_DATA_OFFSET] != (ISO7816_PCB_RACK | BlockNumber))
+				goto Error;
+			BlockNumber ^= ISO7816_PCB_BLOCKNUMBERMASK;
+		}
+	} while (ISO7816_NbByteSent < CommandLength);
+
+	/* card chaining : each chained I-block is acknowledged with a R(ACK) */
+	while (1)
+	{
+		PCB = ISO7816_Frame[PCD_DATA_OFFSET];
+		if ((PCB & ISO7816_PCB_TYPEMASK) != ISO7816_PCB_TYPE_I || (PCB & ISO7816_PCB_BLOCKNUMBERMASK) != BlockNumber)
+			goto Error;
+		BlockNumber ^= ISO7816_PCB_BLOCKNUMBERMASK;
+
+		InfLength = BlockLength - ISO7816_NBBYTE_PCB;
+		if ((uint32_t)*pResponseLength + InfLength > MaxResponseLength)
+			goto Error;
+		memcpy(&pResponse[*pResponseLength],&ISO7816_Frame[PCD_DATA_OFFSET + ISO7816_NBBYTE_PCB],InfLength);
+		*pResponseLength += InfLength;
+
+		if ((PCB & ISO7816_PCB_CHAININGMASK) == 0x00)
+			break;
+		errchk(ISO7816_SendBlock(ISO7816_PCB_RACK | BlockNumber, 0, 0, ISO7816_PCB_RACK, &BlockLength));
+	}
+
+	return ISO7816_SUCCESSCODE;
+Error:
+	return ISO7816_ERRORCODE_DEFAULT;
+}
+
 /**
  * @brief  this function sends the APDU command to the RF transceiver and returns its response
+ * @param  pDataReceived : status and length of the PCD device, PCB, response of the card (SW1 SW2 included)
  * @return ISO7816_SUCCESSCODE : the function is succesful
  * @return ISO7816_ERRORCODE_RESPONSE : the function is not  succesful. The tag returns an error code
  * @return ISO7816_ERRORCODE_DEFAULT : the function is not  succesful. 
  */
 static int8_t ISO7816_SendReceiveAPDU ( uint8_t *pDataReceived )
 {
-	uint8_t 	NthByte=0;
+	uint16_t 	NthByte=0,
+						ResponseLength;
 	int8_t 		status;
-	uint8_t 	bufferFWI[3];
 	
-	bufferSend[NthByte++] = BlockNumber; 
-	BlockNumber ^= 0x01;
-
 	// add the class byte
 	bufferSend[NthByte++] = APDUcommand.Header.CLA; 
 	// add the command code
@@ -90,39 +363,19 @@ static int8_t ISO7816_SendReceiveAPDU ( uint8_t *pDataReceived )
 	if (APDUcommand.Body.LE || (APDUcommand.Header.P1 == 0x04 && APDUcommand.Header.P2 == 0x00))
 		bufferSend[NthByte++] = APDUcommand.Body.LE;
 	
-	// control byte append CRC + 8 bits
-	if( st95tagtype == TT4A )
-		bufferSend[NthByte++] = SEND_MASK_APPENDCRC | SEND_MASK_8BITSINFIRSTBYTE;	 
-		
-	// send the command to the RF transceiver
-	errchk(PCD_SendRecv(NthByte,bufferSend,pDataReceived))
-	
-	/* Test if a time extension is required */
-	if (pDataReceived[2] == 0xF2)
-	{
-		/* Send the same buffer in order to accept the time extension */
-		memcpy(bufferFWI,&pDataReceived[2],2);
-		if( st95tagtype == TT4A )
-		{
-			bufferFWI[2] = SEND_MASK_APPENDCRC | SEND_MASK_8BITSINFIRSTBYTE;
-			PCD_SendRecv(3,bufferFWI, pDataReceived);
-		}
-		else
-			PCD_SendRecv(2,bufferFWI, pDataReceived);
-		/* Sleep for the asked time (9.6ms*bufferFWI[1])*/
-		//delay_ms(10*bufferFWI[1]);
-	}
+	// send the command, chained when it is longer than FSC
+	errchk(ISO7816_Transceive(bufferSend, NthByte, &pDataReceived[ISO7816_RESPONSEOFFSET_DATA], &ResponseLength,
+														ISO7816_MAX_RESPONSE_SIZE - ISO7816_RESPONSEOFFSET_DATA));
+	if (ResponseLength < ISO7816_NBBYTE_SW)
+		goto Error;
+
+	/* same layout as the reply of the PCD device (the length is saturated for the long responses) */
+	pDataReceived[PCD_COMMAND_OFFSET] = SENDRECV_RESULTSCODE_OK;
+	pDataReceived[PCD_LENGTH_OFFSET] = MIN(ResponseLength + ISO7816_NBBYTE_PCB, 0xFF);
+	pDataReceived[PCD_DATA_OFFSET] = ISO7816_PCB_IBLOCK;
 	
-	if( st95tagtype == TT4A )
-	{
-		APDUresponse.SW1 = pDataReceived[pDataReceived[PCD_LENGTH_OFFSET]-5];
-		APDUresponse.SW2 = pDataReceived[pDataReceived[PCD_LENGTH_OFFSET]-4];
-	}
-	else
-	{
-		APDUresponse.SW1 = pDataReceived[pDataReceived[PCD_LENGTH_OFFSET]-3];
-		APDUresponse.SW2 = pDataReceived[pDataReceived[PCD_LENGTH_OFFSET]-2];
-	}
+	APDUresponse.SW1 = pDataReceived[ISO7816_RESPONSEOFFSET_DATA + ResponseLength - 2];
+	APDUresponse.SW2 = pDataReceived[ISO7816_RESPONSEOFFSET_DATA + ResponseLength - 1];
 		
 	if (APDUresponse.SW1 == 0x90 && APDUresponse.SW2 == 0x00)
 		return ISO7816_SUCCESSCODE;	
@@ -167,9 +420,9 @@ int8_t ISO7816_SelectFile ( uc8 P1byte , uc8 P2byte , uc8 LCbyte ,uint8_t *pData
 		APDUcommand.Body.LE = 0x00;
 	
 		// Special case for the selectApplication
-		// The block number HAS TO be 0x02
+		// The block number HAS TO be 0 (first exchange after the activation)
 		if (APDUcommand.Header.P1 == 0x04 && APDUcommand.Header.P2 == 0x00)
-			BlockNumber = 0x02;
+			ISO7816_ResetBlockNumber( );
 	
 		return ISO7816_SendReceiveAPDU ( bufferReceive );
 }
@@ -232,6 +485,191 @@ int8_t ISO7816_UpdateBinary( uc8 P1byte , uc8 P2byte , uc8 LCbyte , uint8_t *pDa
 
 }
 
+/**
+ * @brief  this function exchanges an INF field with the card (ISO14443-4 block protocol).
+ * @brief  The command is chained in blocks of FSC bytes, the response chained by the card is
+ * @brief  concatenated, the S(WTX) are answered and the transmission errors are recovered.
+ * @param  pCommand	: command to send
+ * @param  CommandLength	: number of bytes of the command
+ * @param  pResponse	: response of the card
+ * @param  pResponseLength	: number of bytes of the response
+ * @param  MaxResponseLength	: size of the response buffer
+ * @return ISO7816_SUCCESSCODE : the function is successful
+ * @return ISO7816_ERRORCODE_DEFAULT : the function is not successful 
+ */
+int8_t ISO7816_Transceive ( uc8 *pCommand , uc16 CommandLength , uint8_t *pResponse , uint16_t *pResponseLength , uc16 MaxResponseLength )
+{
+	return ISO7816_TransceiveData(pCommand, CommandLength, 0, 0, pResponse, pResponseLength, MaxResponseLength);
+}
+
+/**
+ * @brief  this function sets the block number back to 0, it has to be called after each activation of a card
+ * @return None
+ */
+void ISO7816_ResetBlockNumber ( void )
+{
+	BlockNumber = 0x00;
+}
+
+/**
+ * @brief  this function sends a ReadBinary command with an extended LE field, the data are
+ * @brief  written in the buffer of the caller as the blocks are received.
+ * @param  P1byte	: P1 value
+ * @param  P2byte	: P2 value
+ * @param  LE	: number of bytes to read (1 to ISO7816_MAX_EXTENDEDLE)
+ * @param  *pDataRead	: data read from the tag, LE + ISO7816_NBBYTE_SW bytes (SW1 SW2 follow the data)
+ * @param  *pNbByteRead	: number of bytes read (SW1 SW2 excluded)
+ * @return ISO7816_SUCCESSCODE : the function is successful and the tag returns a success code
+ * @return ISO7816_ERRORCODE_RESPONSE : the tag returns an error code
+ * @return ISO7816_ERRORCODE_DEFAULT : the function is not successful 
+ */
+int8_t ISO7816_ReadBinaryExtended( uc8 P1byte , uc8 P2byte , uc16 LE , uint8_t *pDataRead , uint16_t *pNbByteRead )
+{
+	uint8_t 	Header[ISO7816_NBBYTE_HEADER + ISO7816_NBBYTE_EXTENDEDLENGTH];
+	uint16_t 	ResponseLength;
+	int8_t 		status;
+
+	*pNbByteRead = 0;
+	if (LE == 0 || LE > ISO7816_MAX_EXTENDEDLE)
+		return ISO7816_ERRORCODE_DEFAULT;
+
+	Header[0] = ISO7816_CLASS_0X00;
+	Header[1] = ISO7816_READ_BINARY;
+	Header[2] = P1byte;
+	Header[3] = P2byte;
+	// the LC field is empty, LE on 3 bytes
+	Header[4] = ISO7816_EXTENDEDLENGTH;
+	Header[5] = GETMSB(LE);
+	Header[6] = GETLSB(LE);
+
+	errchk(ISO7816_TransceiveData(Header, sizeof(Header), 0, 0, pDataRead, &ResponseLength, LE + ISO7816_NBBYTE_SW));
+	if (ResponseLength < ISO7816_NBBYTE_SW)
+		goto Error;
+
+	*pNbByteRead = ResponseLength - ISO7816_NBBYTE_SW;
+	APDUresponse.SW1 = pDataRead[*pNbByteRead];
+	APDUresponse.SW2 = pDataRead[*pNbByteRead + 1];
+
+	if (APDUresponse.SW1 == 0x90 && APDUresponse.SW2 == 0x00)
+		return ISO7816_SUCCESSCODE;	
+	else 
+		return ISO7816_ERRORCODE_RESPONSE;	
+
+Error:
+	return ISO7816_ERRORCODE_DEFAULT;
+}
+
+/**
+ * @brief  this function sends an UpdateBinary command with an extended LC field, the data are
+ * @brief  sent directly from the buffer of the caller.
+ * @param  P1byte	: P1 value
+ * @param  P2byte	: P2 value
+ * @param  LC	: number of bytes to write
+ * @param  *pData	: Pointer to the data to write
+ * @return ISO7816_SUCCESSCODE : the function is successful and the tag returns a success code
+ * @return ISO7816_ERRORCODE_RESPONSE : the tag returns an error code
+ * @return ISO7816_ERRORCODE_DEFAULT : the function is not successful 
+ */
+int8_t ISO7816_UpdateBinaryExtended( uc8 P1byte , uc8 P2byte , uc16 LC , uc8 *pData )
+{
+	uint8_t 	Header[ISO7816_NBBYTE_HEADER + ISO7816_NBBYTE_EXTENDEDLENGTH],
+						Response[ISO7816_NBBYTE_SW];
+	uint16_t 	ResponseLength;
+	int8_t 		status;
+
+	Header[0] = ISO7816_CLASS_0X00;
+	Header[1] = ISO7816_UPDATE_BINARY;
+	Header[2] = P1byte;
+	Header[3] = P2byte;
+	// LC on 3 bytes, the LE field is empty
+	Header[4] = ISO7816_EXTENDEDLENGTH;
+	Header[5] = GETMSB(LC);
+	Header[6] = GETLSB(LC);
+
+	errchk(ISO7816_TransceiveData(Header, sizeof(Header), pData, LC, Response, &ResponseLength, sizeof(Response)));
+	if (ResponseLength < ISO7816_NBBYTE_SW)
+		goto Error;
+
+	APDUresponse.SW1 = Response[0];
+	APDUresponse.SW2 = Response[1];
+
+	if (APDUresponse.SW1 == 0x90 && APDUresponse.SW2 == 0x00)
+		return ISO7816_SUCCESSCODE;	
+	else 
+		return ISO7816_ERRORCODE_RESPONSE;	
+
+Error:
+	return ISO7816_ERRORCODE_DEFAULT;
+}
+
+/**
+ * @brief  this function checks the card capabilities of the historical bytes (ATS of a type A card)
+ * @return true : the card supports the extended LC and LE fields
+ * @return false : the card does not support them or does not tell it
+ */
+bool ISO7816_IsExtendedLengthSupported( void )
+{
+	uc8 			*pHistoricalBytes;
+	uint8_t 	NbByte,
+						NthByte = 1,
+						Tag,
+						Length;
+
+	if( st95tagtype != TT4A )
+		return false;
+
+	NbByte = ISO14443A_GetHistoricalBytes(&pHistoricalBytes);
+	if (NbByte == 0)
+		return false;
+
+	// category indicator : compact-TLV objects, followed by the status indicator for 0x00
+	if (pHistoricalBytes[0] == ISO7816_CATEGORY_COMPACTTLVSTATUS && NbByte > ISO7816_NBBYTE_STATUSINDICATOR)
+		NbByte -= ISO7816_NBBYTE_STATUSINDICATOR;
+	else if (pHistoricalBytes[0] != ISO7816_CATEGORY_COMPACTTLV)
+		return false;
+
+	while (NthByte < NbByte)
+	{
+		Tag = pHistoricalBytes[NthByte] >> 4;
+		Length = pHistoricalBytes[NthByte] & 0x0F;
+		if (Tag == ISO7816_TAG_CARDCAPABILITIES && Length >= ISO7816_NBBYTE_CARDCAPABILITIES &&
+				NthByte + ISO7816_NBBYTE_CARDCAPABILITIES < NbByte)
+			return ((pHistoricalBytes[NthByte + ISO7816_NBBYTE_CARDCAPABILITIES] & ISO7816_EXTENDEDLENGTH_MASK) != 0x00);
+		NthByte += 1 + Length;
+	}
+
+	return false;
+}
+
+/**
+ * @brief  this function returns the status word of the last response of the card
+ * @return SW1 SW2 (ISO7816_SW_NONE when the card has not answered)
+ */
+uint16_t ISO7816_GetStatusWord( void )
+{
+	return (APDUresponse.SW1 << 8) | APDUresponse.SW2;
+}
+
+/**
+ * @brief  this function sends a S(DESELECT) block, the card goes back to the halt state
+ * @return ISO7816_SUCCESSCODE : the card acknowledges the S(DESELECT)
+ * @return ISO7816_ERRORCODE_DEFAULT : the card does not answer
+ */
+int8_t ISO7816_Deselect( void )
+{
+	uint8_t 	BlockLength;
+	int8_t 		status;
+
+	BlockNumber = 0x00;
+	errchk(ISO7816_SendFrame(ISO7816_PCB_SDESELECT, 0, 0, &BlockLength));
+	if (ISO7816_Frame[PCD_DATA_OFFSET] != ISO7816_PCB_SDESELECT)
+		goto Error;
+
+	return ISO7816_SUCCESSCODE;
+Error:
+	return ISO7816_ERRORCODE_DEFAULT;
+}
+
 
 /**
   * @}
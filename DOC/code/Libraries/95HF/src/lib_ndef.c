@@ -0,0 +1,608 @@
+/**
+  ******************************************************************************
+  * @file    lib_ndef.c
+  * @author  MMY Application Team
+  * @version V4.0.0
+  * @date    02/06/2014
+  * @brief   NDEF message parser (records are returned as views on the tag buffer)
+  ******************************************************************************
+  * @copyright
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
+  */
+#include "lib_ndef.h"
+
+/* states of the stream parser */
+#define NDEF_STATE_FIRSTHEADER									0x00
+#define NDEF_STATE_HEADER												0x01
+#define NDEF_STATE_TYPELENGTH										0x02
+#define NDEF_STATE_PAYLOADLENGTH								0x03
+#define NDEF_STATE_IDLENGTH											0x04
+#define NDEF_STATE_TYPEID												0x05
+#define NDEF_STATE_PAYLOAD											0x06
+#define NDEF_STATE_END													0x07
+
+/* URI identifier codes of the URI record type definition (0x24..0xFF are RFU, no prefix) */
+static const char * const NDEF_URIPrefix[] = {
+	"",						"http://www.",	"https://www.",	"http://",			"https://",		"tel:",				"mailto:",		"ftp://anonymous:anonymous@",
+	"ftp://ftp.",	"ftps://",			"sftp://",			"smb://",				"nfs://",			"ftp://",			"dav://",			"news:",
+	"telnet://",	"imap:",				"rtsp://",			"urn:",					"pop:",				"sip:",				"sips:",			"tftp:",
+	"btspp://",		"btl2cap://",		"btgoep://",		"tcpobex://",		"irdaobex://","file://",		"urn:epc:id:","urn:epc:tag:",
+	"urn:epc:pat:","urn:epc:raw:","urn:epc:",			"urn:nfc:"
+};
+#define NDEF_NBURIPREFIX												(sizeof(NDEF_URIPrefix)/sizeof(NDEF_URIPrefix[0]))
+
+uint32_t (*NDEF_GetTick_ms)(void) = 0x00;
+
+static int8_t NDEF_CheckHeader 					( uc8 Header, bool First, bool InChunk);
+static int8_t NDEF_StreamHeaderDone			( NDEF_STREAM *pStream, NDEF_STREAMEVENT *pEvent);
+static void NDEF_StreamRecord						( NDEF_STREAM *pStream, NDEF_RECORD *pRecord);
+
+/** @addtogroup _95HF_Libraries
+ * 	@{
+ *	@brief  <b>This is the library used by the whole 95HF family (RX95HF, CR95HF, ST95HF) <br />
+ *				  You will find ISO libraries ( 14443A, 14443B, 15693, ...) for PICC and PCD <br />
+ *				  The libraries selected in the project will depend of the application targetted <br />
+ *				  and the product chosen (RX95HF emulate PICC, CR95HF emulate PCD, ST95HF can do both)</b>
+ */
+
+/** @addtogroup PCD
+ * 	@{
+ *	@brief  This part of the library enables PCD capabilities of CR95HF & ST95HF.
+ */
+
+
+/** @addtogroup NDEF_pcd
+ * 	@{
+ *	@brief  This file parses the NDEF messages read by the NFC type libraries. The records are
+ *					returned as pointers on the buffer of the tag (no copy), the stream parser handles a
+ *					message received in several parts.
+*/
+
+
+/** @addtogroup lib_ndef_Private_Functions
+ *  @{
+ */
+
+/**
+ * @brief  Check the flags of a record header against its position in the message
+ * @param  Header : 1st byte of the record
+ * @param  First : true for the first record of the message
+ * @param  InChunk : true when the record is a following chunk of a chunked record
+ * @retval NDEF_SUCCESSCODE : the header is valid
+ * @retval NDEF_ERRORCODE_FORMAT : MB, CF, IL or TNF is not allowed here
+ */
+static int8_t NDEF_CheckHeader ( uc8 Header, bool First, bool InChunk)
+{
+	uint8_t TNF = Header & NDEF_HEADER_TNF_MASK;
+
+	if (((Header & NDEF_HEADER_MB) != 0x00) != First)
+		return NDEF_ERRORCODE_FORMAT;
+	/* the following chunks have no type and no ID */
+	if (InChunk == true)
+	{
+		if (TNF != NDEF_TNF_UNCHANGED || (Header & NDEF_HEADER_IL) != 0x00)
+			return NDEF_ERRORCODE_FORMAT;
+	}
+	else if (TNF >= NDEF_TNF_UNCHANGED)
+		return NDEF_ERRORCODE_FORMAT;
+	/* the last record cannot be a middle chunk */
+	if ((Header & (NDEF_HEADER_CF | NDEF_HEADER_ME)) == (NDEF_HEADER_CF | NDEF_HEADER_ME))
+		return NDEF_ERRORCODE_FORMAT;
+
+	return NDEF_SUCCESSCODE;
+}
+
+/**
+ * @brief  Fill the record view with the header received by the stream
+ * @param  *pStream : stream
+ * @param  *pRecord : record view
+ * @retval None
+ */
+static void NDEF_StreamRecord ( NDEF_STREAM *pStream, NDEF_RECORD *pRecord)
+{
+	pRecord->Header = pStream->Header;
+	pRecord->TNF = pStream->ChunkTNF;
+	pRecord->TypeLength = pStream->ChunkTypeLength;
+	pRecord->pType = pStream->TypeID;
+	pRecord->IDLength = pStream->IDLength;
+	pRecord->pID = &pStream->TypeID[pStream->TypeLength];
+	pRecord->PayloadLength = pStream->PayloadLength;
+	pRecord->pPayload = 0x00;
+}
+
+/**
+ * @brief  Validate the header of a record received by the stream and return the record event
+ * @param  *pStream : stream
+ * @param  *pEvent : NDEF_EVENT_RECORD event
+ * @retval NDEF_SUCCESSCODE : the event is returned
+ * @retval NDEF_ERRORCODE_FORMAT : the header is not valid
+ */
+static int8_t NDEF_StreamHeaderDone ( NDEF_STREAM *pStream, NDEF_STREAMEVENT *pEvent)
+{
+	if (pStream->InChunk == true)
+	{
+		if (pStream->TypeLength != 0)
+			return NDEF_ERRORCODE_FORMAT;
+	}
+	else
+	{
+		pStream->ChunkTNF = pStream->Header & NDEF_HEADER_TNF_MASK;
+		pStream->ChunkTypeLength = pStream->TypeLength;
+	}
+	pStream->InChunk = ((pStream->Header & NDEF_HEADER_CF) != 0x00);
+	pStream->PayloadLeft = pStream->PayloadLength;
+	pStream->State = NDEF_STATE_PAYLOAD;
+
+	pEvent->Event = NDEF_EVENT_RECORD;
+	NDEF_StreamRecord (pStream, &pEvent->Record);
+	pEvent->pData = 0x00;
+	pEvent->DataLength = 0;
+	pEvent->LastData = false;
+
+	return NDEF_SUCCESSCODE;
+}
+
+/**
+  * @}
+  */
+
+/** @addtogroup lib_ndef_Public_Functions
+ *  @{
+ */
+
+/**
+ * @brief  Find the NDEF message TLV in the memory of a Type 1, 2 or 5 tag (NULL, lock and memory control TLVs are skipped)
+ * @param  *pTLV : first TLV (after the capability container)
+ * @param  Length : number of bytes of the buffer
+ * @param  **ppMessage : first byte of the NDEF message
+ * @param  *pMessageLength : number of bytes of the NDEF message
+ * @retval NDEF_SUCCESSCODE : the message is found
+ * @retval NDEF_ERRORCODE_FORMAT : no NDEF message TLV before the terminator TLV
+ */
+int8_t NDEF_FindMessageTLV ( uc8 *pTLV, uc32 Length, uc8 **ppMessage, uint32_t *pMessageLength)
+{
+	uint32_t	Offset = 0,
+						TLVLength;
+	uint8_t		Tag;
+
+	while (Offset < Length)
+	{
+		Tag = pTLV[Offset++];
+		if (Tag == NDEF_TLV_NULL)
+			continue;
+		if (Tag == NDEF_TLV_TERMINATOR || Offset >= Length)
+			break;
+		/* 1 byte or 3 bytes length */
+		TLVLength = pTLV[Offset++];
+		if (TLVLength == 0xFF)
+		{
+			if (Offset + 2 > Length)
+				break;
+			TLVLength = (pTLV[Offset]<<8) | pTLV[Offset+1];
+			Offset += 2;
+		}
+		if (TLVLength > Length - Offset)
+			break;
+		if (Tag == NDEF_TLV_MESSAGE)
+		{
+			*ppMessage = &pTLV[Offset];
+			*pMessageLength = TLVLength;
+			return NDEF_SUCCESSCODE;
+		}
+		Offset += TLVLength;
+	}
+
+	return NDEF_ERRORCODE_FORMAT;
+}
+
+/**
+ * @brief  Initialize an iterator on the records of a message
+ * @param  *pIterator : iterator
+ * @param  *pMessage : first byte of the NDEF message (stays in use by the record views)
+ * @param  Length : number of bytes of the message
+ * @retval None
+ */
+void NDEF_IteratorInit ( NDEF_ITERATOR *pIterator, uc8 *pMessage, uc32 Length)
+{
+	memset(pIterator, 0x00, sizeof(NDEF_ITERATOR));
+	pIterator->pMessage = pMessage;
+	pIterator->Length = Length;
+}
+
+/**
+ * @brief  Return the next record of the message. The following chunks of a chunked record are
+ * @brief	 returned one by one with the TNF and type of the first chunk.
+ * @param  *pIterator : iterator
+ * @param  *pRecord : record view (pointers on the message)
+ * @retval NDEF_SUCCESSCODE : a record is returned
+ * @retval NDEF_ERRORCODE_END : the last record has been returned
+ * @retval NDEF_ERRORCODE_FORMAT : the message is not valid
+ */
+int8_t NDEF_NextRecord ( NDEF_ITERATOR *pIterator, NDEF_RECORD *pRecord)
+{
+	uc8				*pData = &pIterator->pMessage[pIterator->Offset];
+	uint32_t	Left = pIterator->Length - pIterator->Offset,
+						Offset;
+	uint8_t		Header;
+	int8_t		status;
+
+	if (Left == 0)
+		return NDEF_ERRORCODE_END;
+
+	/* header, type length, 1 byte payload length at least */
+	if (Left < 3)
+		return NDEF_ERRORCODE_FORMAT;
+	Header = pData[0];
+	errchk(NDEF_CheckHeader (Header, pIterator->Offset == 0, pIterator->InChunk));
+
+	pRecord->Header = Header;
+	pRecord->TypeLength = pData[1];
+	Offset = 2;
+	if ((Header & NDEF_HEADER_SR) != 0x00)
+		pRecord->PayloadLength = pData[Offset++];
+	else
+	{
+		if (Left < 6)
+			return NDEF_ERRORCODE_FORMAT;
+		pRecord->PayloadLength = ((uint32_t)pData[2]<<24) | ((uint32_t)pData[3]<<16) | (pData[4]<<8) | pData[5];
+		Offset = 6;
+	}
+	pRecord->IDLength = 0;
+	if ((Header & NDEF_HEADER_IL) != 0x00)
+	{
+		if (Offset >= Left)
+			return NDEF_ERRORCODE_FORMAT;
+		pRecord->IDLength = pData[Offset++];
+	}
+	pRecord->pType = &pData[Offset];
+	Offset += pRecord->TypeLength;
+	pRecord->pID = &pData[Offset];
+	Offset += pRecord->IDLength;
+	pRecord->pPayload = &pData[Offset];
+	if (Offset > Left || pRecord->PayloadLength > Left - Offset)
+		return NDEF_ERRORCODE_FORMAT;
+	Offset += pRecord->PayloadLength;
+
+	/* chunked record : the following chunks take the type of the first one */
+	if (pIterator->InChunk == true)
+	{
+		if (pRecord->TypeLength != 0)
+			return NDEF_ERRORCODE_FORMAT;
+		pRecord->pType = pIterator->pChunkType;
+		pRecord->TypeLength = pIterator->ChunkTypeLength;
+	}
+	else
+	{
+		pIterator->ChunkTNF = Header & NDEF_HEADER_TNF_MASK;
+		pIterator->pChunkType = pRecord->pType;
+		pIterator->ChunkTypeLength = pRecord->TypeLength;
+	}
+	pRecord->TNF = pIterator->ChunkTNF;
+	pIterator->InChunk = ((Header & NDEF_HEADER_CF) != 0x00);
+
+	/* bytes after the last record are ignored */
+	if ((Header & NDEF_HEADER_ME) != 0x00)
+		pIterator->Offset = pIterator->Length;
+	else
+		pIterator->Offset += Offset;
+
+	return NDEF_SUCCESSCODE;
+Error:
+	return status;
+}
+
+/**
+ * @brief  Initialize a stream parser (the message is given in several parts with NDEF_StreamFeed)
+ * @param  *pStream : stream
+ * @retval None
+ */
+void NDEF_StreamInit ( NDEF_STREAM *pStream)
+{
+	memset(pStream, 0x00, sizeof(NDEF_STREAM));
+	pStream->State = NDEF_STATE_FIRSTHEADER;
+}
+
+/**
+ * @brief  Give the next part of the message to a stream. The bytes shall stay valid until
+ * @brief	 NDEF_StreamNext returns NDEF_ERRORCODE_NEEDDATA (the payload events point on them).
+ * @param  *pStream : stream
+ * @param  *pData : bytes of the message
+ * @param  Length : number of bytes
+ * @retval None
+ */
+void NDEF_StreamFeed ( NDEF_STREAM *pStream, uc8 *pData, uc16 Length)
+{
+	pStream->pData = pData;
+	pStream->DataLength = Length;
+}
+
+/**
+ * @brief  Parse the bytes fed to the stream up to the next event. A record header is returned
+ * @brief	 as soon as it is received, its payload is returned in parts pointing on the fed bytes.
+ * @param  *pStream : stream
+ * @param  *pEvent : event
+ * @retval NDEF_SUCCESSCODE : an event is returned
+ * @retval NDEF_ERRORCODE_NEEDDATA : all the fed bytes are parsed
+ * @retval NDEF_ERRORCODE_END : the message is complete
+ * @retval NDEF_ERRORCODE_FORMAT : the message is not valid
+ * @retval NDEF_ERRORCODE_OVERFLOW : the type and ID of a record are longer than NDEF_STREAM_MAX_TYPEID
+ */
+int8_t NDEF_StreamNext ( NDEF_STREAM *pStream, NDEF_STREAMEVENT *pEvent)
+{
+	uint8_t		Byte;
+	uint16_t	NbByte;
+	int8_t		status;
+
+	for (;;)
+	{
+		if (pStream->State == NDEF_STATE_END)
+			return NDEF_ERRORCODE_END;
+
+		if (pStream->State == NDEF_STATE_PAYLOAD)
+		{
+			/* end of the record */
+			if (pStream->PayloadLeft == 0)
+			{
+				if ((pStream->Header & NDEF_HEADER_ME) != 0x00)
+				{
+					pStream->State = NDEF_STATE_END;
+					pEvent->Event = NDEF_EVENT_END;
+					return NDEF_SUCCESSCODE;
+				}
+				pStream->State = NDEF_STATE_HEADER;
+				continue;
+			}
+			if (pStream->DataLength == 0)
+				return NDEF_ERRORCODE_NEEDDATA;
+			NbByte = (pStream->PayloadLeft < pStream->DataLength) ? (uint16_t)pStream->PayloadLeft : pStream->DataLength;
+			pEvent->Event = NDEF_EVENT_PAYLOAD;
+			NDEF_StreamRecord (pStream, &pEvent->Record);
+			pEvent->pData = pStream->pData;
+			pEvent->DataLength = NbByte;
+			pStream->pData += NbByte;
+			pStream->DataLength -= NbByte;
+			pStream->PayloadLeft -= NbByte;
+			pEvent->LastData = (pStream->PayloadLeft == 0);
+			return NDEF_SUCCESSCODE;
+		}
+
+		if (pStream->DataLength == 0)
+			return NDEF_ERRORCODE_NEEDDATA;
+		Byte = *pStream->pData++;
+		pStream->DataLength--;
+
+		switch (pStream->State)
+		{
+			case NDEF_STATE_FIRSTHEADER :
+			case NDEF_STATE_HEADER :
+				errchk(NDEF_CheckHeader (Byte, pStream->State == NDEF_STATE_FIRSTHEADER, pStream->InChunk));
+				pStream->Header = Byte;
+				pStream->IDLength = 0;
+				pStream->State = NDEF_STATE_TYPELENGTH;
+				break;
+
+			case NDEF_STATE_TYPELENGTH :
+				pStream->TypeLength = Byte;
+				pStream->NbByte = 0;
+				pStream->State = NDEF_STATE_PAYLOADLENGTH;
+				break;
+
+			case NDEF_STATE_PAYLOADLENGTH :
+				pStream->PayloadLengthField[pStream->NbByte++] = Byte;
+				if ((pStream->Header & NDEF_HEADER_SR) != 0x00)
+					pStream->PayloadLength = Byte;
+				else if (pStream->NbByte == 4)
+					pStream->PayloadLength = ((uint32_t)pStream->PayloadLengthField[0]<<24) | ((uint32_t)pStream->PayloadLengthField[1]<<16) |
+																	 (pStream->PayloadLengthField[2]<<8) | pStream->PayloadLengthField[3];
+				else
+					break;
+				pStream->NbByte = 0;
+				pStream->State = ((pStream->Header & NDEF_HEADER_IL) != 0x00) ? NDEF_STATE_IDLENGTH : NDEF_STATE_TYPEID;
+				break;
+
+			case NDEF_STATE_IDLENGTH :
+				pStream->IDLength = Byte;
+				pStream->State = NDEF_STATE_TYPEID;
+				break;
+
+			case NDEF_STATE_TYPEID :
+				pStream->TypeID[pStream->NbByte++] = Byte;
+				break;
+
+			default :
+				return NDEF_ERRORCODE_DEFAULT;
+		}
+
+		/* type and ID are copied in the stream, the record is returned once they are received */
+		if (pStream->State == NDEF_STATE_TYPEID)
+		{
+			if (pStream->TypeLength + pStream->IDLength > NDEF_STREAM_MAX_TYPEID)
+				return NDEF_ERRORCODE_OVERFLOW;
+			if (pStream->NbByte == pStream->TypeLength + pStream->IDLength)
+				return NDEF_StreamHeaderDone (pStream, pEvent);
+		}
+	}
+Error:
+	return status;
+}
+
+/**
+ * @brief  Check the type of a well-known record
+ * @param  *pRecord : record
+ * @param  *pType : record type name (NDEF_RTD_xxx)
+ * @retval true : the record is of this well-known type
+ */
+bool NDEF_IsWellKnown ( const NDEF_RECORD *pRecord, const char *pType)
+{
+	uint8_t TypeLength = strlen(pType);
+
+	return (pRecord->TNF == NDEF_TNF_WELLKNOWN &&
+					pRecord->TypeLength == TypeLength &&
+					memcmp(pRecord->pType, pType, TypeLength) == 0);
+}
+
+/**
+ * @brief  Return the URI of a well-known URI record (the prefix comes from the URI identifier code)
+ * @param  *pRecord : record
+ * @param  *pURI : prefix and rest of the URI
+ * @retval NDEF_SUCCESSCODE : the URI is returned
+ * @retval NDEF_ERRORCODE_TYPE : the record is not a URI record
+ * @retval NDEF_ERRORCODE_FORMAT : the payload is empty
+ */
+int8_t NDEF_GetURI ( const NDEF_RECORD *pRecord, NDEF_URI *pURI)
+{
+	uint8_t Code;
+
+	/* fast path : 1 byte type compared first */
+	if (pRecord->TNF != NDEF_TNF_WELLKNOWN || pRecord->TypeLength != 1 || pRecord->pType[0] != NDEF_RTD_URI[0])
+		return NDEF_ERRORCODE_TYPE;
+	if (pRecord->PayloadLength == 0)
+		return NDEF_ERRORCODE_FORMAT;
+
+	Code = pRecord->pPayload[0];
+	pURI->pPrefix = (Code < NDEF_NBURIPREFIX) ? NDEF_URIPrefix[Code] : NDEF_URIPrefix[0];
+	pURI->PrefixLength = strlen(pURI->pPrefix);
+	pURI->pURI = &pRecord->pPayload[1];
+	pURI->URILength = pRecord->PayloadLength - 1;
+
+	return NDEF_SUCCESSCODE;
+}
+
+/**
+ * @brief  Return the language and the text of a well-known Text record
+ * @param  *pRecord : record
+ * @param  *pText : language code and text
+ * @retval NDEF_SUCCESSCODE : the text is returned
+ * @retval NDEF_ERRORCODE_TYPE : the record is not a Text record
+ * @retval NDEF_ERRORCODE_FORMAT : the language code is longer than the payload
+ */
+int8_t NDEF_GetText ( const NDEF_RECORD *pRecord, NDEF_TEXT *pText)
+{
+	uint8_t Status;
+
+	if (pRecord->TNF != NDEF_TNF_WELLKNOWN || pRecord->TypeLength != 1 || pRecord->pType[0] != NDEF_RTD_TEXT[0])
+		return NDEF_ERRORCODE_TYPE;
+	if (pRecord->PayloadLength == 0)
+		return NDEF_ERRORCODE_FORMAT;
+
+	Status = pRecord->pPayload[0];
+	pText->UTF16 = ((Status & NDEF_TEXT_UTF16) != 0x00);
+	pText->LanguageLength = Status & NDEF_TEXT_LANGUAGE_MASK;
+	if (pText->LanguageLength >= pRecord->PayloadLength)
+		return NDEF_ERRORCODE_FORMAT;
+	pText->pLanguage = &pRecord->pPayload[1];
+	pText->pText = &pRecord->pPayload[1+pText->LanguageLength];
+	pText->TextLength = pRecord->PayloadLength - 1 - pText->LanguageLength;
+
+	return NDEF_SUCCESSCODE;
+}
+
+/**
+ * @brief  Return the URI and the first title of a well-known Smart Poster record
+ * @param  *pRecord : record
+ * @param  *pURI : URI of the poster
+ * @param  *pTitle : first Text record of the poster, TextLength = 0 if none (0x00 if not needed)
+ * @retval NDEF_SUCCESSCODE : the URI is returned
+ * @retval NDEF_ERRORCODE_TYPE : the record is not a Smart Poster record
+ * @retval NDEF_ERRORCODE_FORMAT : the poster has no URI record or is not a valid message
+ */
+int8_t NDEF_GetSmartPoster ( const NDEF_RECORD *pRecord, NDEF_URI *pURI, NDEF_TEXT *pTitle)
+{
+	NDEF_ITERATOR	Iterator;
+	NDEF_RECORD		Record;
+	bool					URIFound = false,
+								TitleFound = false;
+	int8_t				status;
+
+	if (NDEF_IsWellKnown (pRecord, NDEF_RTD_SMARTPOSTER) == false)
+		return NDEF_ERRORCODE_TYPE;
+
+	if (pTitle != 0x00)
+		memset(pTitle, 0x00, sizeof(NDEF_TEXT));
+
+	/* the payload is an NDEF message */
+	NDEF_IteratorInit (&Iterator, pRecord->pPayload, pRecord->PayloadLength);
+	while ((status = NDEF_NextRecord (&Iterator, &Record)) == NDEF_SUCCESSCODE)
+	{
+		if (URIFound == false && NDEF_GetURI (&Record, pURI) == NDEF_SUCCESSCODE)
+			URIFound = true;
+		else if (pTitle != 0x00 && TitleFound == false && NDEF_GetText (&Record, pTitle) == NDEF_SUCCESSCODE)
+			TitleFound = true;
+	}
+	if (status != NDEF_ERRORCODE_END || URIFound == false)
+		return NDEF_ERRORCODE_FORMAT;
+
+	return NDEF_SUCCESSCODE;
+}
+
+/**
+ * @brief  Measure the throughput of the parser : the records of the message are parsed NbLoop
+ * @brief	 times, with the URI and Text fast path. The duration needs NDEF_GetTick_ms.
+ * @param  *pMessage : NDEF message
+ * @param  Length : number of bytes of the message
+ * @param  NbLoop : number of times the message is parsed
+ * @param  *pStat : result
+ * @retval NDEF_SUCCESSCODE : the message has been parsed
+ * @retval NDEF_ERRORCODE_FORMAT : the message is not valid
+ */
+int8_t NDEF_Benchmark ( uc8 *pMessage, uc32 Length, uc16 NbLoop, NDEF_BENCHSTAT *pStat)
+{
+	NDEF_ITERATOR	Iterator;
+	NDEF_RECORD		Record;
+	NDEF_URI			URI;
+	NDEF_TEXT			Text;
+	uint16_t			Loop;
+	uint32_t			StartTime = 0;
+	int8_t				status;
+
+	memset(pStat, 0x00, sizeof(NDEF_BENCHSTAT));
+	if (NDEF_GetTick_ms != 0x00)
+		StartTime = NDEF_GetTick_ms();
+
+	for (Loop=0; Loop<NbLoop; Loop++)
+	{
+		NDEF_IteratorInit (&Iterator, pMessage, Length);
+		while ((status = NDEF_NextRecord (&Iterator, &Record)) == NDEF_SUCCESSCODE)
+		{
+			if (NDEF_GetURI (&Record, &URI) != NDEF_SUCCESSCODE)
+				NDEF_GetText (&Record, &Text);
+			pStat->NbRecord++;
+		}
+		if (status != NDEF_ERRORCODE_END)
+			return status;
+		pStat->NbByte += Length;
+	}
+
+	if (NDEF_GetTick_ms != 0x00)
+		pStat->Duration = NDEF_GetTick_ms() - StartTime;
+	if (pStat->Duration != 0)
+		pStat->BytesPerSecond = (pStat->NbByte/pStat->Duration)*1000 + ((pStat->NbByte%pStat->Duration)*1000)/pStat->Duration;
+
+	return NDEF_SUCCESSCODE;
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/******************* (C) COPYRIGHT 2014 STMicroelectronics *****END OF FILE****/
@@ -22,8 +22,19 @@
 extern uint8_t TT1Tag[];
 extern uint8_t TagUID[];
 
+/* memory map of the tag being read or written */
+static uint16_t 			PCDNFCT1_MemorySize;
+static PCDNFCT1_AREA 	PCDNFCT1_Area[PCDNFCT1_MAX_NBAREA];
+static uint8_t 				PCDNFCT1_NbArea;
+
 static uint8_t PCDNFCT1_ReadAll(uint8_t *pBufferRead);
+static uint8_t PCDNFCT1_ReadSegment(uint8_t segment, uint8_t *pBufferRead);
 static uint8_t PCDNFCT1_WriteErase(uint8_t address, uint8_t byte);
+static uint8_t PCDNFCT1_WriteErase8(uint8_t block, uc8 *pData);
+static uint8_t PCDNFCT1_ReadMemory(uint8_t *pMemory, bool *pIsDynamic);
+static bool PCDNFCT1_IsDataByte(uc16 address);
+static uint16_t PCDNFCT1_NextDataByte(uint16_t address);
+static uint8_t PCDNFCT1_FindNDEF(uc8 *pMemory, uint16_t *pNDEFaddress);
 
 /** @addtogroup _95HF_Libraries
  * 	@{
@@ -68,6 +79,26 @@ static uint8_t PCDNFCT1_ReadAll(uint8_t *pBufferRead)
 		return PCDNFCT1_ERROR; 
 }
 
+/**
+ * @brief  This function generates the RSEG command (128 bytes of a segment of the dynamic memory)
+ * @param  segment : The segment to read
+ * @param  pBufferRead : Pointer on the buffer which will contain the data read (ADDS then the segment)
+ * @retval PCDNFCT1_OK : Command success
+ * @retval PCDNFCT1_ERROR : Transmission error
+ */
+static uint8_t PCDNFCT1_ReadSegment(uint8_t segment, uint8_t *pBufferRead)
+{
+	uint8_t buffer[] = {PCDNFCT1_RSEG,0,0,0,0,0,0,0,0,0,0,0,0,0,PCDNFCT1_TOPAZ_MODE};
+
+	buffer[1] = segment << 4;
+	memcpy(&buffer[10], &TagUID[4],4);
+
+	if (PCD_SendRecv(15,buffer, pBufferRead) == PCD_SUCCESSCODE && pBufferRead[2] == buffer[1])
+		return PCDNFCT1_OK;
+	else
+		return PCDNFCT1_ERROR; 
+}
+
 /**
  * @brief  This function generates the WriteErase command
  * @param  address : The address of the byte to write
@@ -80,8 +111,8 @@ static uint8_t PCDNFCT1_WriteErase(uint8_t address, uint8_t byte)
 	uint8_t buffer[] = {PCDNFCT1_WRITE_E,0,0,0,0,0,0,PCDNFCT1_TOPAZ_MODE};
 	uint8_t bufferRead[16];
 
-	/* Cannot write protected sector */
-	if (address < 13 || address > 102)
+	/* Cannot write protected sector (only the NMN of the CC and the data bytes of the static area) */
+	if (address != PCDNFCT1_NMN_ADDRESS && (address < PCDNFCT1_DATA_ADDRESS || address >= PCDNFCT1_RESERVED_ADDRESS))
 		return PCDNFCT1_ERROR;
 
 	buffer[1] = address;
@@ -94,6 +125,195 @@ static uint8_t PCDNFCT1_WriteErase(uint8_t address, uint8_t byte)
 		return PCDNFCT1_ERROR; 
 }
 
+/**
+ * @brief  This function generates the WriteErase8 command (dynamic memory)
+ * @param  block : The block to write
+ * @param  pData : The 8 bytes to write
+ * @retval PCDNFCT1_OK : Command success
+ * @retval PCDNFCT1_ERROR : Transmission error
+ */
+static uint8_t PCDNFCT1_WriteErase8(uint8_t block, uc8 *pData)
+{
+	uint8_t buffer[] = {PCDNFCT1_WRITE_E8,0,0,0,0,0,0,0,0,0,0,0,0,0,PCDNFCT1_TOPAZ_MODE};
+	uint8_t bufferRead[24];
+
+	/* Cannot write the UID and CC block */
+	if (block < PCDNFCT1_DATA_ADDRESS/PCDNFCT1_NBBYTE_BLOCK)
+		return PCDNFCT1_ERROR;
+
+	buffer[1] = block;
+	memcpy(&buffer[2], pData, PCDNFCT1_NBBYTE_BLOCK);
+	memcpy(&buffer[10], &TagUID[4],4);
+
+	/* the tag answers with the block written */
+	if (PCD_SendRecv(15,buffer, bufferRead) == PCD_SUCCESSCODE && bufferRead[2] == block &&
+			memcmp(&bufferRead[3], pData, PCDNFCT1_NBBYTE_BLOCK) == 0)
+		return PCDNFCT1_OK;
+	else
+		return PCDNFCT1_ERROR; 
+}
+
+/**
+ * @brief  This function reads the whole memory of the tag : RALL for the static memory, 
+ * @brief  RALL then RSEG of the next segments for the dynamic memory
+ * @param  pMemory : Pointer on the buffer which will contain the memory (PCDNFCT1_MAX_MEMORYSIZE bytes)
+ * @param  pIsDynamic : true for a tag with dynamic memory (RSEG and WRITE-E8 commands)
+ * @retval PCDNFCT1_OK : Command success
+ * @retval PCDNFCT1_ERROR : Transmission error
+ * @retval PCDNFCT1_ERROR_NOT_FORMATED : The tag is not NDEF formated
+ * @retval PCDNFCT1_ERROR_MEMORY_INTERNAL : The memory of the tag is bigger than PCDNFCT1_MAX_MEMORYSIZE
+ */
+static uint8_t PCDNFCT1_ReadMemory(uint8_t *pMemory, bool *pIsDynamic)
+{
+	uint8_t bufferRead[RFTRANS_95HF_MAX_BUFFER_SIZE+3];
+	uint8_t segment;
+
+	if (PCDNFCT1_ReadAll(bufferRead) != PCDNFCT1_OK)
+		return PCDNFCT1_ERROR;
+	
+	if ((bufferRead[2] & PCDNFCT1_NDEF_CAPABLE_MSK) != 0x10) /* NDEF capable TT1 if H0 = 0x1X */
+		return PCDNFCT1_ERROR_NOT_FORMATED;
+	/* HR0, HR1 then the static area */
+	memcpy(pMemory, &bufferRead[4], PCDNFCT1_NBBYTE_STATICMEMORY);
+	if (pMemory[PCDNFCT1_NMN_ADDRESS] != PCDNFCT1_NDEF_MNB) /* CC file with NDEF info */
+		return PCDNFCT1_ERROR_NOT_FORMATED;
+
+	PCDNFCT1_MemorySize = PCDNFCT1_MEMORYSIZE(pMemory[PCDNFCT1_TMS_ADDRESS]);
+	PCDNFCT1_NbArea = 0;
+	*pIsDynamic = (bufferRead[2] != PCDNFCT1_HR0_STATIC);
+
+	if (*pIsDynamic == false)
+	{
+		PCDNFCT1_MemorySize = MIN(PCDNFCT1_MemorySize, PCDNFCT1_NBBYTE_STATICMEMORY);
+		return PCDNFCT1_OK;
+	}
+
+	if (PCDNFCT1_MemorySize > PCDNFCT1_MAX_MEMORYSIZE)
+		return PCDNFCT1_ERROR_MEMORY_INTERNAL;
+
+	/* block 0x0F (reserved) is not read by RALL */
+	memset(&pMemory[PCDNFCT1_NBBYTE_STATICMEMORY], 0x00, PCDNFCT1_NBBYTE_SEGMENT - PCDNFCT1_NBBYTE_STATICMEMORY);
+	for (segment = 1; segment*PCDNFCT1_NBBYTE_SEGMENT < PCDNFCT1_MemorySize; segment++)
+	{
+		if (PCDNFCT1_ReadSegment(segment, bufferRead) != PCDNFCT1_OK)
+			return PCDNFCT1_ERROR;
+		memcpy(&pMemory[segment*PCDNFCT1_NBBYTE_SEGMENT], &bufferRead[3], MIN(PCDNFCT1_NBBYTE_SEGMENT, PCDNFCT1_MemorySize - segment*PCDNFCT1_NBBYTE_SEGMENT));
+	}
+
+	return PCDNFCT1_OK;
+}
+
+/**
+ * @brief  This function checks if a byte belongs to the data area (not UID, CC, reserved or lock bytes)
+ * @param  address : The address of the byte
+ * @retval true : data byte
+ * @retval false : other byte
+ */
+static bool PCDNFCT1_IsDataByte(uc16 address)
+{
+	uint8_t i;
+
+	if (address < PCDNFCT1_DATA_ADDRESS || address >= PCDNFCT1_MemorySize)
+		return false;
+	if (address >= PCDNFCT1_RESERVED_ADDRESS && address < PCDNFCT1_NBBYTE_SEGMENT)
+		return false;
+
+	for (i=0; i<PCDNFCT1_NbArea; i++)
+	{
+		if (address >= PCDNFCT1_Area[i].Address && address < PCDNFCT1_Area[i].Address + PCDNFCT1_Area[i].Size)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief  This function returns the data byte following a byte
+ * @param  address : The address of the byte
+ * @retval address of the next data byte (PCDNFCT1_MemorySize or more at the end of the memory)
+ */
+static uint16_t PCDNFCT1_NextDataByte(uint16_t address)
+{
+	do
+	{
+		address++;
+	}while (address < PCDNFCT1_MemorySize && PCDNFCT1_IsDataByte(address) == false);
+
+	return address;
+}
+
+/**
+ * @brief  This function searches the first NDEF TLV. The Lock and Memory control TLVs found on the way
+ * @brief  are added to the areas skipped in the data area.
+ * @param  pMemory : Pointer on the memory of the tag
+ * @param  pNDEFaddress : address of the T byte of the NDEF TLV
+ * @retval PCDNFCT1_OK : NDEF TLV found
+ * @retval PCDNFCT1_ERROR : no NDEF TLV
+ */
+static uint8_t PCDNFCT1_FindNDEF(uc8 *pMemory, uint16_t *pNDEFaddress)
+{
+	uint16_t address = PCDNFCT1_DATA_ADDRESS, 
+					 length,
+					 i;
+	uint8_t  tag,
+					 value[PCDNFCT1_TLV_CONTROL_LENGTH];
+
+	while (address < PCDNFCT1_MemorySize)
+	{
+		tag = pMemory[address];
+
+		if (tag == PCDNFCT1_TLV_NDEF)
+		{
+			*pNDEFaddress = address;
+			return PCDNFCT1_OK;
+		}
+		if (tag == PCDNFCT1_TLV_TERMINATOR)
+			return PCDNFCT1_ERROR; // EOF and no NDEF TLV found
+		if (tag == PCDNFCT1_TLV_EMPTY) // Empty TLV
+		{
+			address = PCDNFCT1_NextDataByte(address);
+			continue;
+		}
+		if (tag != PCDNFCT1_TLV_LOCK && tag != PCDNFCT1_TLV_MEM && tag != PCDNFCT1_TLV_PROPRIETARY)
+			return PCDNFCT1_ERROR;
+
+		/* Length on 1 or 3 bytes */
+		address = PCDNFCT1_NextDataByte(address);
+		length = pMemory[address];
+		if (length == PCDNFCT1_TLV_LONGLENGTH)
+		{
+			address = PCDNFCT1_NextDataByte(address);
+			length = pMemory[address] << 8;
+			address = PCDNFCT1_NextDataByte(address);
+			length |= pMemory[address];
+		}
+
+		/* Value, the control TLVs give the position of the lock and reserved bytes */
+		for (i=0; i<length; i++)
+		{
+			address = PCDNFCT1_NextDataByte(address);
+			if (address >= PCDNFCT1_MemorySize)
+				return PCDNFCT1_ERROR;
+			if (i < PCDNFCT1_TLV_CONTROL_LENGTH)
+				value[i] = pMemory[address];
+		}
+		if (tag != PCDNFCT1_TLV_PROPRIETARY && length == PCDNFCT1_TLV_CONTROL_LENGTH && PCDNFCT1_NbArea < PCDNFCT1_MAX_NBAREA)
+		{
+			PCDNFCT1_Area[PCDNFCT1_NbArea].Address = PCDNFCT1_PAGEADDRESS(value[0])*PCDNFCT1_BYTESPERPAGE(value[2]) + PCDNFCT1_BYTEOFFSET(value[0]);
+			/* number of lock bits or number of reserved bytes */
+			if (tag == PCDNFCT1_TLV_LOCK)
+				PCDNFCT1_Area[PCDNFCT1_NbArea].Size = (PCDNFCT1_CONTROLSIZE(value[1]) + 7) / 8;
+			else
+				PCDNFCT1_Area[PCDNFCT1_NbArea].Size = PCDNFCT1_CONTROLSIZE(value[1]);
+			PCDNFCT1_NbArea++;
+		}
+
+		address = PCDNFCT1_NextDataByte(address);
+	}
+
+	return PCDNFCT1_ERROR;
+}
+
 /**
   * @}
   */
@@ -110,41 +330,33 @@ static uint8_t PCDNFCT1_WriteErase(uint8_t address, uint8_t byte)
 uint8_t PCDNFCT1_ReadNDEF( void )
 {
 	uint8_t status;
-	uint8_t buffer[NFCT1_MAX_TAGMEMORY+2];
-	uint16_t NDEFposition = 16, size;
-	
-	errchk(PCDNFCT1_ReadAll(buffer));
+	uint8_t memory[PCDNFCT1_MAX_MEMORYSIZE];
+	bool isDynamic;
+	uint16_t NDEFaddress, size, i;
 	
-	if ((buffer[2] & PCDNFCT1_NDEF_CAPABLE_MSK) != 0x10) /* NDEF capable TT1 if H0 = 0x1X */
-		return PCDNFCT1_ERROR_NOT_FORMATED;
-	if (buffer[12] != PCDNFCT1_NDEF_MNB) /* CC file with NDEF info */
-		return PCDNFCT1_ERROR_NOT_FORMATED;
-	if (buffer[14] != 0x0E) /* Check the size (only static memory supported yet)*/
-		return PCDNFCT1_ERROR_MEMORY_INTERNAL;
+	status = PCDNFCT1_ReadMemory(memory, &isDynamic);
+	if (status != PCDNFCT1_OK)
+		return status;
 	
 	// Searching for the first NDEF TLV
-	while (buffer[NDEFposition] != PCDNFCT1_TLV_NDEF)
-	{
-		if (buffer[NDEFposition] == PCDNFCT1_TLV_EMPTY) // Empty TLV
-			NDEFposition++;
-		else if (buffer[NDEFposition] == PCDNFCT1_TLV_LOCK || buffer[NDEFposition] == PCDNFCT1_TLV_MEM)  // Lock CTRL TLV or Mem CTRL TLV
-			NDEFposition+=5;
-		else
-			return PCDNFCT1_ERROR; // Other TLV not supported yet (proprietary)
-		if (NDEFposition > NFCT1_MAX_TAGMEMORY)
-			return PCDNFCT1_ERROR; // EOF and no NDEF TLV found
-	}
+	errchk(PCDNFCT1_FindNDEF(memory, &NDEFaddress));
 	
-	// Get the length of the message and copy it
-	if (buffer[NDEFposition+1] == 0xFF) // Long message (cannot happen with static memory...)
+	// Get the length of the message (T, L, V and the next byte)
+	i = PCDNFCT1_NextDataByte(NDEFaddress);
+	if (memory[i] == PCDNFCT1_TLV_LONGLENGTH) // Long message
 	{
-		size = buffer[NDEFposition+2]<<8|buffer[NDEFposition+3];
-		memcpy(&TT1Tag[16],&buffer[NDEFposition],size+5);
+		size = memory[PCDNFCT1_NextDataByte(i)]<<8|memory[PCDNFCT1_NextDataByte(PCDNFCT1_NextDataByte(i))];
+		size += 5;
 	}
 	else // Short message
-	{
-		memcpy(&TT1Tag[16],&buffer[NDEFposition],buffer[NDEFposition+1]+3);
-	}
+		size = memory[i]+3;
+
+	if (16 + size > NFCT1_MAX_TAGMEMORY)
+		return PCDNFCT1_ERROR_MEMORY_INTERNAL;
+
+	// Copy the message, the lock and reserved bytes are skipped
+	for (i=0; i<size && NDEFaddress < PCDNFCT1_MemorySize; i++, NDEFaddress = PCDNFCT1_NextDataByte(NDEFaddress))
+		TT1Tag[16+i] = memory[NDEFaddress];
 	
 	return PCDNFCT1_OK;
 Error:
@@ -153,6 +365,8 @@ Error:
 
 /**
  * @brief  This function writes the NDEF message to a tag type 1 from the TT1Tag buffer
+ * @brief  (only the bytes which change are written : by block with WRITE-E8 on the dynamic memory, 
+ * @brief  by byte with WRITE-E otherwise)
  * @retval PCDNFCT1_OK : Command success
  * @retval PCDNFCT1_ERROR : Transmission error
  * @retval PCDNFCT1_ERROR_MEMORY : Not enough memory available on the tag
@@ -160,50 +374,88 @@ Error:
 uint8_t PCDNFCT1_WriteNDEF( void )
 {
 	uint8_t status;
-	uint8_t buffer[NFCT1_MAX_TAGMEMORY+2];
-	uint16_t NDEFposition = 16, size, i;
+	uint8_t memory[PCDNFCT1_MAX_MEMORYSIZE];
+	uint8_t changed[PCDNFCT1_MAX_MEMORYSIZE/8];
+	bool isDynamic, 
+			 blockOfData;
+	uint16_t NDEFaddress, size, i, block, address;
 	
-	errchk(PCDNFCT1_ReadAll(buffer));
+	PCDNFC_WriteStat.NbWritten = 0;
+	PCDNFC_WriteStat.NbSaved = 0;
 	
-	if ((buffer[2] & PCDNFCT1_NDEF_CAPABLE_MSK) != 0x10) /* NDEF capable TT1 if H0 = 0x1X */
-		return PCDNFCT1_ERROR_NOT_FORMATED;
-	if (buffer[12] != PCDNFCT1_NDEF_MNB) /* CC file with NDEF info */
-		return PCDNFCT1_ERROR_NOT_FORMATED;
-	if (buffer[14] != 0x0E) /* Check the size (only static memory supported yet)*/
-		return PCDNFCT1_ERROR;
+	status = PCDNFCT1_ReadMemory(memory, &isDynamic);
+	if (status != PCDNFCT1_OK)
+		return status;
 	
 	// Searching for the first NDEF TLV
-	while (buffer[NDEFposition] != PCDNFCT1_TLV_NDEF)
-	{
-		if (buffer[NDEFposition] == PCDNFCT1_TLV_EMPTY) // Empty TLV
-			NDEFposition++;
-		else if (buffer[NDEFposition] == PCDNFCT1_TLV_LOCK || buffer[NDEFposition] == PCDNFCT1_TLV_MEM)  // Lock CTRL TLV or Mem CTRL TLV
-			NDEFposition+=5;
-		else
-			return PCDNFCT1_ERROR; // Other TLV not supported yet (proprietary)
-		if (NDEFposition > NFCT1_MAX_TAGMEMORY)
-			return PCDNFCT1_ERROR; // EOF and no NDEF TLV found
-	}
+	errchk(PCDNFCT1_FindNDEF(memory, &NDEFaddress));
 	
-	if (TT1Tag[15] == 0xFF)
-		size = TT1Tag[16]<<8|TT1Tag[17]+4;
+	if (TT1Tag[15] == PCDNFCT1_TLV_LONGLENGTH)
+		size = (TT1Tag[16]<<8|TT1Tag[17])+4;
 	else
 		size = TT1Tag[15]+2;
 	
-	if (size > NFCT1_MAX_TAGMEMORY-32)
-		return PCDNFCT1_ERROR_MEMORY_TAG;
+	// Place the message (from the L byte) in the data area and mark the bytes which change
+	memset(changed, 0x00, sizeof(changed));
+	address = PCDNFCT1_NextDataByte(NDEFaddress);
+	for(i=15;i<15+size;i++,address = PCDNFCT1_NextDataByte(address))
+	{
+		if (address >= PCDNFCT1_MemorySize)
+			return PCDNFCT1_ERROR_MEMORY_TAG;
+		if (memory[address] != TT1Tag[i])
+		{
+			memory[address] = TT1Tag[i];
+			changed[address/8] |= 1 << (address%8);
+		}
+	}
+	
+	// A whole write is the bytes of the message and the NMN twice
+	PCDNFC_WriteStat.NbSaved = size+2;
+	for (block = 0; block < PCDNFCT1_MemorySize/PCDNFCT1_NBBYTE_BLOCK && changed[block] == 0x00; block++);
+	if (block == PCDNFCT1_MemorySize/PCDNFCT1_NBBYTE_BLOCK)
+		return PCDNFCT1_OK;
 	
 	// Invalidate the NDEF message
-	PCDNFCT1_WriteErase(8,PCDNFCT1_NDEF_DISABLE);
+	PCDNFCT1_WriteErase(PCDNFCT1_NMN_ADDRESS,PCDNFCT1_NDEF_DISABLE);
+	PCDNFC_WriteStat.NbWritten++;
 
-	NDEFposition-=3;
-	for(i=15;i<15+size;i++,NDEFposition++)
+	for (block = 0; block < PCDNFCT1_MemorySize/PCDNFCT1_NBBYTE_BLOCK; block++)
 	{
-		errchk(PCDNFCT1_WriteErase(NDEFposition,TT1Tag[i]));
+		/* one byte of the changed array by block */
+		if (changed[block] == 0x00)
+			continue;
+
+		blockOfData = true;
+		for (address = block*PCDNFCT1_NBBYTE_BLOCK; address < (block+1)*PCDNFCT1_NBBYTE_BLOCK; address++)
+			blockOfData &= PCDNFCT1_IsDataByte(address);
+
+		/* a block with lock or reserved bytes of the first segment is written byte by byte */
+		if (isDynamic == true && (blockOfData == true || block*PCDNFCT1_NBBYTE_BLOCK > PCDNFCT1_MAX_WRITEE_ADDRESS))
+		{
+			errchk(PCDNFCT1_WriteErase8(block, &memory[block*PCDNFCT1_NBBYTE_BLOCK]));
+			PCDNFC_WriteStat.NbWritten++;
+		}
+		else
+		{
+			for (address = block*PCDNFCT1_NBBYTE_BLOCK; address < (block+1)*PCDNFCT1_NBBYTE_BLOCK; address++)
+			{
+				if ((changed[block] & (1 << (address%8))) != 0x00)
+				{
+					errchk(PCDNFCT1_WriteErase(address,memory[address]));
+					PCDNFC_WriteStat.NbWritten++;
+				}
+			}
+		}
 	}
 	
 	// Validate the NDEF message
-	PCDNFCT1_WriteErase(8,PCDNFCT1_NDEF_MNB);
+	PCDNFCT1_WriteErase(PCDNFCT1_NMN_ADDRESS,PCDNFCT1_NDEF_MNB);
+	PCDNFC_WriteStat.NbWritten++;
+	
+	if (PCDNFC_WriteStat.NbSaved > PCDNFC_WriteStat.NbWritten)
+		PCDNFC_WriteStat.NbSaved -= PCDNFC_WriteStat.NbWritten;
+	else
+		PCDNFC_WriteStat.NbSaved = 0;
 	
 	return PCDNFCT1_OK;
 Error:
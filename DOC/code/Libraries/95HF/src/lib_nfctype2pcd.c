@@ -19,11 +19,42 @@
   */
 #include "lib_nfctype2pcd.h"
 
+extern ISO14443A_CARD 	ISO14443A_Card;
 extern uint8_t TT2Tag[];
 
 static uint8_t PCDNFCT2_Read(uint8_t blocNbr, uint8_t *pBufferRead);
 static uint8_t PCDNFCT2_Write(uint8_t blocNbr, uint8_t *pBufferWrite);
+static bool PCDNFCT2_IsAck(uc8 *pBufferRead);
+static uint8_t PCDNFCT2_CompatibilityWrite(uint8_t blocNbr, uint8_t *pBufferWrite);
 static uint8_t PCDNFCT2_SectorSelect(uint8_t sector);
+static uint8_t PCDNFCT2_FastRead(uint8_t firstBloc, uint8_t lastBloc, uint8_t *pBufferRead);
+static void PCDNFCT2_DetectFastRead(void);
+static uint8_t PCDNFCT2_ReadByte(uc16 address, uint8_t *pByte);
+static uint16_t PCDNFCT2_NextDataByte(uint16_t address);
+static uint8_t PCDNFCT2_ReadLength(uint16_t *pAddress, uint16_t *pLength);
+static void PCDNFCT2_AddArea(uc8 tag, uc8 *pValue);
+static uint8_t PCDNFCT2_ReadTLV(void);
+static uint8_t PCDNFCT2_ReadCachedTLV(const PCDNFC_CCINFO *pInfo);
+static uint8_t PCDNFCT2_ReadMessage(uint16_t address);
+static uint16_t PCDNFCT2_FindNDEF(uc8 *pBuffer, uc16 endBuffer);
+
+/* last READ or FAST_READ answer (from CacheAddress) and sector selected */
+static uint8_t 				PCDNFCT2_Cache[PCDNFCT2_FASTREAD_MAX_SIZE];
+static uint16_t 			PCDNFCT2_CacheAddress;
+static uint16_t 			PCDNFCT2_CacheSize;
+static uint8_t 				PCDNFCT2_Sector;
+/* FAST_READ supported by the tag (GET_VERSION), last byte needed by the reading */
+static bool 					PCDNFCT2_FastReadSupported = false;
+static uint16_t 			PCDNFCT2_ReadEnd;
+/* delay before the COMPATIBILITY_WRITE fallback (can be set for a product) */
+static uint8_t 				PCDNFCT2_WriteDelay = PCDNFCT2_WRITE_DELAY_MS;
+/* size of the memory (header and data area) and lock/reserved areas of the data area */
+static uint16_t 			PCDNFCT2_MemorySize;
+static PCDNFCT2_AREA 	PCDNFCT2_Area[PCDNFCT2_MAX_NBAREA];
+static uint8_t 				PCDNFCT2_NbArea;
+/* address of the NDEF TLV and access byte of the CC found by the last reading */
+static uint16_t 			PCDNFCT2_NDEFAddress;
+static uint8_t 				PCDNFCT2_Access;
 
 /** @addtogroup _95HF_Libraries
  * 	@{
@@ -70,10 +101,23 @@ static uint8_t PCDNFCT2_Read(uint8_t blocNbr, uint8_t *pBufferRead)
 }
 
 /**
- * @brief  This function generates the Write command
+ * @brief  This function checks if the answer of the tag is an ACK
+ * @param  pBufferRead : answer of the PCD device
+ * @retval true : ACK received
+ * @retval false : NAK or no answer
+ */
+static bool PCDNFCT2_IsAck(uc8 *pBufferRead)
+{
+	return (pBufferRead[0] == PCDNFCT2_RESULTSCODE_4BITS && (pBufferRead[2]&PCDNFCT2_ACKNAK_MSK) == PCDNFCT2_ACK);
+}
+
+/**
+ * @brief  This function generates the Write command. The tag answers when the bloc is programmed, 
+ * @brief  so the next command can be sent as soon as the ACK is received.
  * @param  blocNbr : First bloc number
  * @param  pBufferWrite : Pointer on the buffer which contains the data to write
  * @retval PCDNFCT2_OK : Command success
+ * @retval PCDNFCT2_ERROR : NAK received or the COMPATIBILITY_WRITE failed
  */
 static uint8_t PCDNFCT2_Write(uint8_t blocNbr, uint8_t *pBufferWrite)
 {
@@ -84,6 +128,42 @@ static uint8_t PCDNFCT2_Write(uint8_t blocNbr, uint8_t *pBufferWrite)
 	memcpy(&buffer[2], pBufferWrite,4);
 
 	PCD_SendRecv(7,buffer, pBufferRead);
+	if (PCDNFCT2_IsAck(pBufferRead) == true)
+		return PCDNFCT2_OK;
+	/* NAK : the bloc cannot be written */
+	if (pBufferRead[0] == PCDNFCT2_RESULTSCODE_4BITS)
+		return PCDNFCT2_ERROR;
+	
+	/* no ACK received : waits for the programming time and tries the COMPATIBILITY_WRITE */
+	delay_ms(PCDNFCT2_WriteDelay);
+	return PCDNFCT2_CompatibilityWrite(blocNbr, pBufferWrite);
+}
+
+/**
+ * @brief  This function generates the Compatibility Write command (16 bytes frame, 4 bytes written)
+ * @param  blocNbr : First bloc number
+ * @param  pBufferWrite : Pointer on the buffer which contains the data to write
+ * @retval PCDNFCT2_OK : Command success
+ * @retval PCDNFCT2_ERROR : Transmission error
+ */
+static uint8_t PCDNFCT2_CompatibilityWrite(uint8_t blocNbr, uint8_t *pBufferWrite)
+{
+	uint8_t pBufferRead[32];
+	uint8_t buffer[] = {PCDNFCT2_COMPATIBILITY_WRITE,0,SEND_MASK_APPENDCRC|SEND_MASK_8BITSINFIRSTBYTE};
+	uint8_t buffer2[PCDNFCT2_READ_SIZE+1];
+	
+	buffer[1] = blocNbr;
+	memset(buffer2, 0x00, PCDNFCT2_READ_SIZE);
+	memcpy(buffer2, pBufferWrite,4);
+	buffer2[PCDNFCT2_READ_SIZE] = SEND_MASK_APPENDCRC|SEND_MASK_8BITSINFIRSTBYTE;
+
+	PCD_SendRecv(3,buffer, pBufferRead);
+	if (PCDNFCT2_IsAck(pBufferRead) == false)
+		return PCDNFCT2_ERROR;
+	PCD_SendRecv(PCDNFCT2_READ_SIZE+1,buffer2, pBufferRead);
+	if (PCDNFCT2_IsAck(pBufferRead) == false)
+		return PCDNFCT2_ERROR;
+	
 	return PCDNFCT2_OK;
 }
 
@@ -115,90 +195,451 @@ static uint8_t PCDNFCT2_SectorSelect(uint8_t sector)
 }
 
 /**
-  * @}
-  */
+ * @brief  This function generates the FAST_READ command
+ * @param  firstBloc : First bloc number
+ * @param  lastBloc : Last bloc number (PCDNFCT2_FASTREAD_MAX_NBPAGE blocs at most)
+ * @param  pBufferRead : Pointer on the buffer which will contain the data read
+ * @retval PCDNFCT2_OK : Command success
+ * @retval PCDNFCT2_ERROR : Transmission error
+ */
+static uint8_t PCDNFCT2_FastRead(uint8_t firstBloc, uint8_t lastBloc, uint8_t *pBufferRead)
+{
+	uint8_t buffer[] = {PCDNFCT2_FAST_READ,0,0,SEND_MASK_APPENDCRC|SEND_MASK_8BITSINFIRSTBYTE};
+	
+	buffer[1] = firstBloc;
+	buffer[2] = lastBloc;
 
-/** @addtogroup lib_nfctype2pcd_Public_Functions
- *  @{
+	if (PCD_SendRecv(4,buffer, pBufferRead) == PCD_SUCCESSCODE && 
+			pBufferRead[1] >= (lastBloc-firstBloc+1)*PCDNFCT2_BLOCK_SIZE)
+		return PCDNFCT2_OK;
+	else
+		return PCDNFCT2_ERROR; 
+}
+
+/**
+ * @brief  This function enables the FAST_READ command for the NXP NTAG and Ultralight EV1 tags.
+ * @brief  The tag which does not know GET_VERSION goes back to idle state, it is activated again.
  */
+static void PCDNFCT2_DetectFastRead(void)
+{
+	uint8_t version[PCDNFCT2_VERSION_SIZE];
+	
+	PCDNFCT2_FastReadSupported = false;
+	if (PCDNFCT2_GetVersion(version) == PCDNFCT2_OK)
+	{
+		if (version[PCDNFCT2_VERSION_VENDOR] == PCDNFCT2_VENDOR_NXP && 
+				(version[PCDNFCT2_VERSION_TYPE] == PCDNFCT2_TYPE_ULTRALIGHT || version[PCDNFCT2_VERSION_TYPE] == PCDNFCT2_TYPE_NTAG))
+			PCDNFCT2_FastReadSupported = true;
+	}
+	else
+	{
+		if (ISO14443A_IsPresent() == ISO14443A_SUCCESSCODE)
+			ISO14443A_Anticollision();
+	}
+}
 
 /**
- * @brief  This function reads the NDEF message from a tag type 2 and store result in the TT2Tag buffer
+ * @brief  This function returns a byte of the tag, a READ command (16 bytes) or a FAST_READ command 
+ * @brief  (up to PCDNFCT2_ReadEnd) is only sent when the byte is not in the last answer. 
+ * @brief  The sector is selected if needed.
+ * @param  address : Address of the byte in the memory of the tag
+ * @param  pByte : Pointer on the byte read
  * @retval PCDNFCT2_OK : Command success
  * @retval PCDNFCT2_ERROR : Transmission error
+ */
+static uint8_t PCDNFCT2_ReadByte(uc16 address, uint8_t *pByte)
+{
+	uint8_t status;
+	uint8_t bufferRead[RFTRANS_95HF_MAX_BUFFER_SIZE+3];
+	uint8_t sector = address / PCDNFCT2_SECTOR_SIZE;
+	uint16_t firstBloc, lastBloc;
+	
+	if (address < PCDNFCT2_CacheAddress || address >= PCDNFCT2_CacheAddress + PCDNFCT2_CacheSize)
+	{
+		if (sector != PCDNFCT2_Sector)
+		{
+			errchk(PCDNFCT2_SectorSelect(sector));
+			PCDNFCT2_Sector = sector;
+		}
+		firstBloc = (address % PCDNFCT2_SECTOR_SIZE) / PCDNFCT2_BLOCK_SIZE;
+		
+		if (PCDNFCT2_FastReadSupported == true && address < PCDNFCT2_ReadEnd)
+		{
+			/* up to the last byte needed, in the sector and in the buffer of the PCD device */
+			lastBloc = (PCDNFCT2_ReadEnd - 1 - sector*PCDNFCT2_SECTOR_SIZE) / PCDNFCT2_BLOCK_SIZE;
+			if (lastBloc >= PCDNFCT2_SECTOR_SIZE/PCDNFCT2_BLOCK_SIZE)
+				lastBloc = PCDNFCT2_SECTOR_SIZE/PCDNFCT2_BLOCK_SIZE - 1;
+			if (lastBloc >= firstBloc + PCDNFCT2_FASTREAD_MAX_NBPAGE)
+				lastBloc = firstBloc + PCDNFCT2_FASTREAD_MAX_NBPAGE - 1;
+			errchk(PCDNFCT2_FastRead(firstBloc, lastBloc, bufferRead));
+			PCDNFCT2_CacheSize = (lastBloc - firstBloc + 1) * PCDNFCT2_BLOCK_SIZE;
+			memcpy(PCDNFCT2_Cache, &bufferRead[2], PCDNFCT2_CacheSize);
+			PCDNFCT2_CacheAddress = address - address % PCDNFCT2_BLOCK_SIZE;
+			*pByte = PCDNFCT2_Cache[address - PCDNFCT2_CacheAddress];
+			return PCDNFCT2_OK;
+		}
+		
+		errchk(PCDNFCT2_Read(firstBloc, bufferRead));
+		/* a NACK is a 4-bit answer */
+		if (bufferRead[1] < PCDNFCT2_READ_SIZE)
+			return PCDNFCT2_ERROR;
+		memcpy(PCDNFCT2_Cache, &bufferRead[2], PCDNFCT2_READ_SIZE);
+		PCDNFCT2_CacheAddress = address - address % PCDNFCT2_BLOCK_SIZE;
+		/* the READ command rolls over at the end of the sector */
+		PCDNFCT2_CacheSize = PCDNFCT2_READ_SIZE;
+		if (PCDNFCT2_SECTOR_SIZE - PCDNFCT2_CacheAddress % PCDNFCT2_SECTOR_SIZE < PCDNFCT2_READ_SIZE)
+			PCDNFCT2_CacheSize = PCDNFCT2_SECTOR_SIZE - PCDNFCT2_CacheAddress % PCDNFCT2_SECTOR_SIZE;
+	}
+	
+	*pByte = PCDNFCT2_Cache[address - PCDNFCT2_CacheAddress];
+	
+	return PCDNFCT2_OK;
+Error:
+	return PCDNFCT2_ERROR;
+}
+
+/**
+ * @brief  This function returns the byte of the data area following a byte (lock and reserved 
+ * @brief  areas declared by the control TLVs are skipped)
+ * @param  address : The address of the byte
+ * @retval address of the next data byte (PCDNFCT2_MemorySize or more at the end of the data area)
+ */
+static uint16_t PCDNFCT2_NextDataByte(uint16_t address)
+{
+	uint8_t i = 0;
+	
+	address++;
+	while (i<PCDNFCT2_NbArea && address < PCDNFCT2_MemorySize)
+	{
+		if (address >= PCDNFCT2_Area[i].Address && address < PCDNFCT2_Area[i].Address + PCDNFCT2_Area[i].Size)
+		{
+			address = PCDNFCT2_Area[i].Address + PCDNFCT2_Area[i].Size;
+			i = 0;
+		}
+		else
+			i++;
+	}
+	
+	return address;
+}
+
+/**
+ * @brief  This function reads the length (1 or 3 bytes) of a TLV
+ * @param  pAddress : address of the T byte, updated with the address of the last L byte
+ * @param  pLength : length of the V field
+ * @retval PCDNFCT2_OK : Command success
+ * @retval PCDNFCT2_ERROR : Transmission error or end of the data area
+ */
+static uint8_t PCDNFCT2_ReadLength(uint16_t *pAddress, uint16_t *pLength)
+{
+	uint8_t status;
+	uint8_t byte;
+	
+	*pAddress = PCDNFCT2_NextDataByte(*pAddress);
+	errchk(PCDNFCT2_ReadByte(*pAddress, &byte));
+	*pLength = byte;
+	if (byte == PCDNFCT2_TLV_LONGLENGTH)
+	{
+		*pAddress = PCDNFCT2_NextDataByte(*pAddress);
+		errchk(PCDNFCT2_ReadByte(*pAddress, &byte));
+		*pLength = byte << 8;
+		*pAddress = PCDNFCT2_NextDataByte(*pAddress);
+		errchk(PCDNFCT2_ReadByte(*pAddress, &byte));
+		*pLength |= byte;
+	}
+	if (*pAddress >= PCDNFCT2_MemorySize)
+		return PCDNFCT2_ERROR;
+	
+	return PCDNFCT2_OK;
+Error:
+	return PCDNFCT2_ERROR;
+}
+
+/**
+ * @brief  This function adds the lock or reserved area declared by a control TLV to the areas 
+ * @brief  skipped in the data area
+ * @param  tag : PCDNFCT2_TLV_LOCK or PCDNFCT2_TLV_MEM
+ * @param  pValue : value of the control TLV (PCDNFCT2_TLV_CONTROL_LENGTH bytes)
+ * @retval None
+ */
+static void PCDNFCT2_AddArea(uc8 tag, uc8 *pValue)
+{
+	if (PCDNFCT2_NbArea >= PCDNFCT2_MAX_NBAREA)
+		return;
+	
+	PCDNFCT2_Area[PCDNFCT2_NbArea].Address = PCDNFCT2_PAGEADDRESS(pValue[0])*PCDNFCT2_BYTESPERPAGE(pValue[2]) + PCDNFCT2_BYTEOFFSET(pValue[0]);
+	if (tag == PCDNFCT2_TLV_LOCK)
+		PCDNFCT2_Area[PCDNFCT2_NbArea].Size = (PCDNFCT2_CONTROLSIZE(pValue[1]) + 7) / 8;
+	else
+		PCDNFCT2_Area[PCDNFCT2_NbArea].Size = PCDNFCT2_CONTROLSIZE(pValue[1]);
+	PCDNFCT2_NbArea++;
+}
+
+/**
+ * @brief  This function parses the TLVs while they are read and only reads the blocks covering 
+ * @brief  the NDEF TLV. The NDEF TLV (and the next byte) is stored in the TT2Tag buffer.
+ * @retval PCDNFCT2_OK : Command success
+ * @retval PCDNFCT2_ERROR : Transmission error or no NDEF TLV
  * @retval PCDNFCT2_ERROR_LOCKED : The tag cannot be read (CC lock)
+ * @retval PCDNFCT2_ERROR_NOT_FORMATED : No CC
+ * @retval PCDNFCT2_ERROR_MEMORY_INTERNAL : The NDEF message is bigger than the TT2Tag buffer
  */
-uint8_t PCDNFCT2_ReadNDEF( void )
+static uint8_t PCDNFCT2_ReadTLV(void)
 {
 	uint8_t status;
-	uint8_t bufferRead[PCDNFCT2_READ_SIZE_BUFFER];
-	uint8_t buffer[NFCT2_MAX_TAGMEMORY];
-	uint16_t size, totalSize, i;
-	uint16_t NDEFposition = 16;
+	uint8_t tag, 
+					value[PCDNFCT2_TLV_CONTROL_LENGTH];
+	uint16_t address = PCDNFCT2_DATA_ADDRESS, 
+					 length, 
+					 i;
 	
-	// Check if CC is present with NDEF capability
-	errchk(PCDNFCT2_Read(0,buffer));
-	if (buffer[14] != PCDNFCT2_NDEF_MNB)
+	// Check if CC is present with NDEF capability (first READ, kept for the first data bytes)
+	PCDNFCT2_CacheSize = 0;
+	PCDNFCT2_NbArea = 0;
+	PCDNFCT2_ReadEnd = 0;
+	errchk(PCDNFCT2_ReadByte(0, &tag));
+	if (PCDNFCT2_Cache[12] != PCDNFCT2_NDEF_MNB)
 		return PCDNFCT2_ERROR_NOT_FORMATED;
 	// Check if the tag is not protected
-	if ((buffer[17]&PCDNFCT2_READ_MSK) != 0x00)
+	if ((PCDNFCT2_Cache[15]&PCDNFCT2_READ_MSK) != 0x00)
 		return PCDNFCT2_ERROR_LOCKED;
+	PCDNFCT2_Access = PCDNFCT2_Cache[15];
 	// Read the size from CC
-	totalSize = buffer[16]*8;
+	PCDNFCT2_MemorySize = PCDNFCT2_DATA_ADDRESS + PCDNFCT2_Cache[14]*8;
+	PCDNFCT2_ReadEnd = PCDNFCT2_MemorySize;
 	
-	// Check if there is enough memory available to read the tag
-	if (totalSize > NFCT2_MAX_TAGMEMORY)
-		return PCDNFCT2_ERROR_MEMORY_INTERNAL;
-	
-	if (totalSize > PCDNFCT2_SECTOR_SIZE)
-		size = PCDNFCT2_SECTOR_SIZE;
-	else
-		size = totalSize;
-	// Read the whole memory
-	for (i=0;i<size/4;i+=4)
+	// Searching for the first NDEF TLV
+	while (address < PCDNFCT2_MemorySize)
 	{
-		errchk(PCDNFCT2_Read(i,bufferRead));
-		memcpy(&buffer[i*4],&bufferRead[2],PCDNFCT2_READ_SIZE);
+		errchk(PCDNFCT2_ReadByte(address, &tag));
+		if (tag == PCDNFCT2_TLV_NDEF)
+			break;
+		if (tag == PCDNFCT2_TLV_EMPTY) // Empty TLV
+		{
+			address = PCDNFCT2_NextDataByte(address);
+			continue;
+		}
+		if (tag != PCDNFCT2_TLV_LOCK && tag != PCDNFCT2_TLV_MEM && tag != PCDNFCT2_TLV_PROPRIETARY)
+			return PCDNFCT2_ERROR; // EOF and no NDEF TLV found
+		
+		errchk(PCDNFCT2_ReadLength(&address, &length));
+		if (tag != PCDNFCT2_TLV_PROPRIETARY && length == PCDNFCT2_TLV_CONTROL_LENGTH)
+		{
+			// Lock CTRL TLV or Mem CTRL TLV : the area is skipped in the data area
+			for (i=0; i<PCDNFCT2_TLV_CONTROL_LENGTH; i++)
+			{
+				address = PCDNFCT2_NextDataByte(address);
+				errchk(PCDNFCT2_ReadByte(address, &value[i]));
+			}
+			PCDNFCT2_AddArea(tag, value);
+		}
+		else
+		{
+			// Proprietary TLV : the value is not read
+			for (i=0; i<length; i++)
+				address = PCDNFCT2_NextDataByte(address);
+		}
+		address = PCDNFCT2_NextDataByte(address);
 	}
-	// Second sector (if needed)
-	if (totalSize > PCDNFCT2_SECTOR_SIZE)
+	if (address >= PCDNFCT2_MemorySize)
+		return PCDNFCT2_ERROR;
+	
+	return PCDNFCT2_ReadMessage(address);
+Error:
+	return PCDNFCT2_ERROR;
+}
+
+/**
+ * @brief  This function reads the NDEF TLV at the address found by a previous reading of the tag 
+ * @brief  (capability cache), the CC and the TLVs before the NDEF TLV are not read.
+ * @param  pInfo : Capability information of the tag
+ * @retval PCDNFCT2_OK : Command success
+ * @retval PCDNFCT2_ERROR : Transmission error or no NDEF TLV at this address
+ * @retval PCDNFCT2_ERROR_MEMORY_INTERNAL : The NDEF message is bigger than the TT2Tag buffer
+ */
+static uint8_t PCDNFCT2_ReadCachedTLV(const PCDNFC_CCINFO *pInfo)
+{
+	uint8_t status;
+	uint8_t tag;
+	
+	PCDNFCT2_CacheSize = 0;
+	PCDNFCT2_NbArea = 0;
+	PCDNFCT2_MemorySize = pInfo->MemorySize;
+	PCDNFCT2_ReadEnd = PCDNFCT2_MemorySize;
+	PCDNFCT2_Access = pInfo->Access;
+	
+	errchk(PCDNFCT2_ReadByte(pInfo->NDEFOffset, &tag));
+	if (tag != PCDNFCT2_TLV_NDEF)
+		return PCDNFCT2_ERROR;
+	
+	return PCDNFCT2_ReadMessage(pInfo->NDEFOffset);
+Error:
+	return PCDNFCT2_ERROR;
+}
+
+/**
+ * @brief  This function copies the NDEF TLV (and the next byte) in the TT2Tag buffer
+ * @param  address : Address of the T byte of the NDEF TLV
+ * @retval PCDNFCT2_OK : Command success
+ * @retval PCDNFCT2_ERROR : Transmission error or end of the data area
+ * @retval PCDNFCT2_ERROR_MEMORY_INTERNAL : The NDEF message is bigger than the TT2Tag buffer
+ */
+static uint8_t PCDNFCT2_ReadMessage(uint16_t address)
+{
+	uint8_t status;
+	uint8_t tag;
+	uint16_t length, 
+					 size,
+					 i;
+	
+	PCDNFCT2_NDEFAddress = address;
+	
+	// Get the length of the message (T, L, V and the next byte)
+	i = address;
+	errchk(PCDNFCT2_ReadLength(&i, &length));
+	errchk(PCDNFCT2_ReadByte(PCDNFCT2_NextDataByte(address), &tag));
+	if (tag == PCDNFCT2_TLV_LONGLENGTH)
+		size = length + 5;
+	else
+		size = length + 3;
+	if (PCDNFCT2_DATA_ADDRESS + size > NFCT2_MAX_TAGMEMORY)
+		return PCDNFCT2_ERROR_MEMORY_INTERNAL;
+	// The FAST_READ commands stop at the end of the message (without the areas skipped)
+	if (address + size < PCDNFCT2_MemorySize)
+		PCDNFCT2_ReadEnd = address + size;
+	
+	// Copy the message, only the blocks covering the message are read
+	for (i=0; i<size; i++, address = PCDNFCT2_NextDataByte(address))
 	{
-		errchk(PCDNFCT2_SectorSelect(1));
-		size = totalSize-PCDNFCT2_SECTOR_SIZE;
-		for (i=4;i<size/4;i+=4)
+		if (address < PCDNFCT2_MemorySize)
 		{
-			errchk(PCDNFCT2_Read(i,bufferRead));
-			memcpy(&buffer[PCDNFCT2_SECTOR_SIZE+i*4],&bufferRead[2],PCDNFCT2_READ_SIZE);
+			errchk(PCDNFCT2_ReadByte(address, &TT2Tag[PCDNFCT2_DATA_ADDRESS+i]));
 		}
+		else if (i == size-1) // the message ends the data area
+			TT2Tag[PCDNFCT2_DATA_ADDRESS+i] = PCDNFCT2_TLV_TERMINATOR;
+		else
+			return PCDNFCT2_ERROR;
 	}
 	
-	// Searching for the first NDEF TLV
-	while (buffer[NDEFposition] != PCDNFCT2_TLV_NDEF)
+	return PCDNFCT2_OK;
+Error:
+	return PCDNFCT2_ERROR;
+}
+
+/**
+ * @brief  This function finds the NDEF TLV in a buffer holding the memory of the tag from its first 
+ * @brief  byte, the areas declared by the control TLVs are added to the areas skipped (as in the read)
+ * @param  pBuffer : memory of the tag
+ * @param  endBuffer : number of bytes of the memory in pBuffer
+ * @retval address of the T byte of the NDEF TLV, endBuffer when no NDEF TLV is found
+ */
+static uint16_t PCDNFCT2_FindNDEF(uc8 *pBuffer, uc16 endBuffer)
+{
+	uint8_t tag, 
+					value[PCDNFCT2_TLV_CONTROL_LENGTH];
+	uint16_t address = PCDNFCT2_DATA_ADDRESS, 
+					 length, 
+					 i;
+	
+	PCDNFCT2_NbArea = 0;
+	while (address < endBuffer && pBuffer[address] != PCDNFCT2_TLV_NDEF)
 	{
-		if (buffer[NDEFposition] == PCDNFCT2_TLV_EMPTY) // Empty TLV
-			NDEFposition++;
-		else if (buffer[NDEFposition] == PCDNFCT2_TLV_LOCK || buffer[NDEFposition] == PCDNFCT2_TLV_MEM)  // Lock CTRL TLV or Mem CTRL TLV
-			NDEFposition+=5;
+		tag = pBuffer[address];
+		address = PCDNFCT2_NextDataByte(address);
+		if (tag == PCDNFCT2_TLV_EMPTY) // Empty TLV
+			continue;
+		if ((tag != PCDNFCT2_TLV_LOCK && tag != PCDNFCT2_TLV_MEM && tag != PCDNFCT2_TLV_PROPRIETARY) || address >= endBuffer)
+			return endBuffer; // EOF and no NDEF TLV found
+		
+		length = pBuffer[address];
+		if (length == PCDNFCT2_TLV_LONGLENGTH)
+		{
+			address = PCDNFCT2_NextDataByte(address);
+			i = PCDNFCT2_NextDataByte(address);
+			if (i >= endBuffer)
+				return endBuffer;
+			length = (pBuffer[address]<<8) | pBuffer[i];
+			address = i;
+		}
+		if (tag != PCDNFCT2_TLV_PROPRIETARY && length == PCDNFCT2_TLV_CONTROL_LENGTH)
+		{
+			// Lock CTRL TLV or Mem CTRL TLV : the area is skipped in the data area
+			for (i=0; i<PCDNFCT2_TLV_CONTROL_LENGTH; i++)
+			{
+				address = PCDNFCT2_NextDataByte(address);
+				if (address >= endBuffer)
+					return endBuffer;
+				value[i] = pBuffer[address];
+			}
+			PCDNFCT2_AddArea(tag, value);
+		}
 		else
-			return PCDNFCT2_ERROR; // Other TLV not supported yet (proprietary)
-		if (NDEFposition > totalSize)
-			return PCDNFCT2_ERROR; // EOF and no NDEF TLV found
+		{
+			// Proprietary TLV : the value is skipped
+			for (i=0; i<length; i++)
+				address = PCDNFCT2_NextDataByte(address);
+		}
+		address = PCDNFCT2_NextDataByte(address);
 	}
 	
-	// Get the length of the message and copy it
-	if (buffer[NDEFposition+1] == 0xFF) // Long message
+	return MIN(address, endBuffer);
+}
+
+/**
+  * @}
+  */
+
+/** @addtogroup lib_nfctype2pcd_Public_Functions
+ *  @{
+ */
+
+/**
+ * @brief  This function reads the NDEF message from a tag type 2 and store result in the TT2Tag buffer
+ * @brief  (the memory is read up to the end of the NDEF TLV only)
+ * @retval PCDNFCT2_OK : Command success
+ * @retval PCDNFCT2_ERROR : Transmission error
+ * @retval PCDNFCT2_ERROR_LOCKED : The tag cannot be read (CC lock)
+ */
+uint8_t PCDNFCT2_ReadNDEF( void )
+{
+	uint8_t status = PCDNFCT2_ERROR;
+	PCDNFC_CCINFO CCInfo;
+	
+	PCDNFCT2_Sector = 0;
+	// Tag already read : no GET_VERSION and no CC, the NDEF TLV is read at the same address
+	if (PCDNFC_GetCachedCC(TT2, ISO14443A_Card.UID, ISO14443A_Card.UIDsize, &CCInfo) == PCDNFC_OK)
 	{
-		size = buffer[NDEFposition+2]<<8|buffer[NDEFposition+3];
-		memcpy(&TT2Tag[16],&buffer[NDEFposition],size+5);
+		PCDNFCT2_FastReadSupported = ((CCInfo.Flags & PCDNFC_CC_FASTREAD) != 0);
+		status = PCDNFCT2_ReadCachedTLV(&CCInfo);
+		if (status != PCDNFCT2_OK)
+			PCDNFC_InvalidateCC(TT2, ISO14443A_Card.UID, ISO14443A_Card.UIDsize);
 	}
-	else // Short message
+	
+	if (status != PCDNFCT2_OK)
 	{
-		memcpy(&TT2Tag[16],&buffer[NDEFposition],buffer[NDEFposition+1]+3);
+		PCDNFCT2_DetectFastRead();
+		status = PCDNFCT2_ReadTLV();
+		// The tags with lock or reserved areas are not cached (the areas are not kept)
+		if (status == PCDNFCT2_OK && PCDNFCT2_NbArea == 0)
+		{
+			memset(&CCInfo, 0x00, sizeof(CCInfo));
+			CCInfo.TagType = TT2;
+			CCInfo.UIDsize = ISO14443A_Card.UIDsize;
+			memcpy(CCInfo.UID, ISO14443A_Card.UID, ISO14443A_Card.UIDsize);
+			CCInfo.MemorySize = PCDNFCT2_MemorySize;
+			CCInfo.NDEFOffset = PCDNFCT2_NDEFAddress;
+			CCInfo.Access = PCDNFCT2_Access;
+			if (PCDNFCT2_FastReadSupported == true)
+				CCInfo.Flags = PCDNFC_CC_FASTREAD;
+			PCDNFC_StoreCC(&CCInfo);
+		}
 	}
 	
-	return PCDNFCT2_OK;
-Error:
-	return PCDNFCT2_ERROR;
+	// The tag is left in the first sector
+	if (PCDNFCT2_Sector != 0)
+		PCDNFCT2_SectorSelect(0);
+	
+	return status;
 }
 
 /**
@@ -211,19 +652,29 @@ Error:
 uint8_t PCDNFCT2_WriteNDEF( void )
 {
 	uint8_t status;
-	uint8_t bufferRead[PCDNFCT2_READ_SIZE_BUFFER];
+	uint8_t bufferRead[RFTRANS_95HF_MAX_BUFFER_SIZE+3];
 	uint8_t buffer[NFCT2_MAX_TAGMEMORY];
+	uint8_t changed[NFCT2_MAX_TAGMEMORY/PCDNFCT2_BLOCK_SIZE/8+1];
 	uint8_t byteSize;
-	uint16_t size, totalSize, i, firstBloc;
-	uint16_t NDEFposition = 16;
+	uint16_t size, totalSize, i, firstBloc, lastBloc, sizeBloc, nbChanged = 0;
+	uint16_t NDEFposition, sizeAddress, address, endRead;
+	
+	PCDNFC_WriteStat.NbWritten = 0;
+	PCDNFC_WriteStat.NbSaved = 0;
 	
 	// Check if CC is present with NDEF capability
 	errchk(PCDNFCT2_Read(0,buffer));
 	if (buffer[14] != PCDNFCT2_NDEF_MNB)
+	{
+		PCDNFC_InvalidateCC(TT2, ISO14443A_Card.UID, ISO14443A_Card.UIDsize);
 		return PCDNFCT2_ERROR_NOT_FORMATED;
+	}
 	// Check if the tag is not protected for read and write
 	if ((buffer[17]&(PCDNFCT2_READ_MSK|PCDNFCT2_WRITE_MSK)) != 0x00)
+	{
+		PCDNFC_InvalidateCC(TT2, ISO14443A_Card.UID, ISO14443A_Card.UIDsize);
 		return PCDNFCT2_ERROR_LOCKED; 
+	}
 	// Read the size from CC
 	totalSize = buffer[16]*8;
 	// Read the size of message
@@ -234,77 +685,183 @@ uint8_t PCDNFCT2_WriteNDEF( void )
 	if (size > totalSize)
 		return PCDNFCT2_ERROR_MEMORY_TAG;
 	
-	if (totalSize > PCDNFCT2_SECTOR_SIZE)
-		size = PCDNFCT2_SECTOR_SIZE;
-	else
-		size = totalSize;
-	// Read the whole memory
-	for (i=0;i<size/4;i+=4)
+	// Read the header and the whole data area (bytes 16 to 16+totalSize-1) which fits in buffer
+	endRead = MIN((PCDNFCT2_DATA_ADDRESS+totalSize), NFCT2_MAX_TAGMEMORY);
+	memset(buffer, 0x00, sizeof(buffer));
+	for (i=0; i*4<endRead && i*4<PCDNFCT2_SECTOR_SIZE; i+=4)
 	{
 		errchk(PCDNFCT2_Read(i,bufferRead));
-		memcpy(&buffer[i*4],&bufferRead[2],PCDNFCT2_READ_SIZE);
+		if (bufferRead[1] < PCDNFCT2_READ_SIZE)
+			goto Error;
+		memcpy(&buffer[i*4],&bufferRead[2],MIN(PCDNFCT2_READ_SIZE, endRead-i*4));
 	}
 	// Second sector (if needed)
-	if (totalSize > PCDNFCT2_SECTOR_SIZE)
+	if (endRead > PCDNFCT2_SECTOR_SIZE)
 	{
-		PCDNFCT2_SectorSelect(1);
-		size = totalSize-PCDNFCT2_SECTOR_SIZE;
-		for (i=4;i<size/4;i+=4)
+		errchk(PCDNFCT2_SectorSelect(1));
+		for (i=0; PCDNFCT2_SECTOR_SIZE+i*4<endRead; i+=4)
 		{
 			errchk(PCDNFCT2_Read(i,bufferRead));
-			memcpy(&buffer[PCDNFCT2_SECTOR_SIZE+i*4],&bufferRead[2],PCDNFCT2_READ_SIZE);
+			if (bufferRead[1] < PCDNFCT2_READ_SIZE)
+				goto Error;
+			memcpy(&buffer[PCDNFCT2_SECTOR_SIZE+i*4],&bufferRead[2],MIN(PCDNFCT2_READ_SIZE, endRead-PCDNFCT2_SECTOR_SIZE-i*4));
 		}
 	}
 	
-	// Searching for the first NDEF TLV
-	while (buffer[NDEFposition] != PCDNFCT2_TLV_NDEF)
-	{
-		if (buffer[NDEFposition] == PCDNFCT2_TLV_EMPTY) // Empty TLV
-			NDEFposition++;
-		else if (buffer[NDEFposition] == PCDNFCT2_TLV_LOCK || buffer[NDEFposition] == PCDNFCT2_TLV_MEM)  // Lock CTRL TLV or Mem CTRL TLV
-			NDEFposition+=5;
-		else
-			return PCDNFCT2_ERROR; // Other TLV not supported yet (proprietary)
-		if (NDEFposition > totalSize)
-			return PCDNFCT2_ERROR; // EOF and no NDEF TLV found
-	}
+	// Searching for the first NDEF TLV, the lock and reserved areas are skipped as in the read
+	PCDNFCT2_MemorySize = PCDNFCT2_DATA_ADDRESS + totalSize;
+	NDEFposition = PCDNFCT2_FindNDEF(buffer, endRead);
+	if (NDEFposition >= endRead)
+		return PCDNFCT2_ERROR; // EOF and no NDEF TLV found
 	
-	// Write the message
+	// Size of the TLV (T, L, V and the next byte)
 	if (TT2Tag[17] == 0xFF)
-		size = TT2Tag[18]<<8|TT2Tag[19]+5;
+		size = (TT2Tag[18]<<8|TT2Tag[19])+5;
 	else
 		size = TT2Tag[17]+3;
 
-	memcpy(&buffer[NDEFposition],&TT2Tag[16],size);
-	
-	// The size has to be 0 for the first write
-	byteSize = TT2Tag[17];
-	buffer[NDEFposition+1] = 0;
-	
+	// Each byte of the TLV goes to the next data byte of the tag, only the blocks which content changes are written
 	firstBloc = NDEFposition>>2;
+	lastBloc = firstBloc;
+	sizeAddress = PCDNFCT2_NextDataByte(NDEFposition);
+	sizeBloc = sizeAddress>>2;
+	memset(changed, 0x00, sizeof(changed));
+	for (i=0, address=NDEFposition; i<size; i++, address=PCDNFCT2_NextDataByte(address))
+	{
+		// the message ends the data area : no terminator
+		if (address >= PCDNFCT2_MemorySize && i == size-1)
+			break;
+		if (address >= endRead)
+			return PCDNFCT2_ERROR_MEMORY_TAG;
+		lastBloc = address>>2;
+		if (buffer[address] != TT2Tag[16+i])
+		{
+			buffer[address] = TT2Tag[16+i];
+			changed[address>>5] |= 1 << ((address>>2)&0x07);
+		}
+	}
+	for (i=firstBloc; i<=lastBloc; i++)
+	{
+		if ((changed[i>>3] & (1 << (i&0x07))) != 0x00)
+			nbChanged++;
+	}
 	
 	// To be sure to write the first sector
-	if (totalSize > PCDNFCT2_SECTOR_SIZE)
+	if (nbChanged != 0 && totalSize > PCDNFCT2_SECTOR_SIZE)
 	{
 		errchk(PCDNFCT2_SectorSelect(0));
 	}
-	// Write all the blocks
-	for (i=firstBloc;i<=(size>>2)+firstBloc;i++)
+	
+	// A single block is written at once, otherwise the size is 0 during the write and written last
+	if (nbChanged > 1)
+	{
+		byteSize = buffer[sizeAddress];
+		buffer[sizeAddress] = 0;
+		errchk(PCDNFCT2_Write(sizeBloc, &buffer[sizeBloc*4]));
+		PCDNFC_WriteStat.NbWritten++;
+		buffer[sizeAddress] = byteSize;
+		changed[sizeBloc>>3] |= 1 << (sizeBloc&0x07);
+	}
+	for (i=firstBloc; i<=lastBloc; i++)
+	{
+		if (i != sizeBloc && (changed[i>>3] & (1 << (i&0x07))) != 0x00)
+		{
+			errchk(PCDNFCT2_Write(i, &buffer[i*4]));
+			PCDNFC_WriteStat.NbWritten++;
+		}
+	}
+	if ((changed[sizeBloc>>3] & (1 << (sizeBloc&0x07))) != 0x00)
 	{
-		errchk(PCDNFCT2_Write(i, &buffer[i*4]));
-		// Tag from NXP needs this delay...
-		delay_ms(5);
+		errchk(PCDNFCT2_Write(sizeBloc, &buffer[sizeBloc*4]));
+		PCDNFC_WriteStat.NbWritten++;
 	}
 	
-	// Write the size (numBloc = (NDEFposition+1)>>2)
-	buffer[NDEFposition+1] = byteSize;
-	errchk(PCDNFCT2_Write(((NDEFposition+1)>>2), &buffer[((NDEFposition+1)>>2)*4]));
+	// A whole write is the blocks of the TLV and the size
+	if (lastBloc-firstBloc+2 > PCDNFC_WriteStat.NbWritten)
+		PCDNFC_WriteStat.NbSaved = lastBloc-firstBloc+2 - PCDNFC_WriteStat.NbWritten;
 	
 	return PCDNFCT2_OK;
 Error:
+	PCDNFC_InvalidateCC(TT2, ISO14443A_Card.UID, ISO14443A_Card.UIDsize);
 	return PCDNFCT2_ERROR;
 }
 
+/**
+ * @brief  This function sets the NDEF message of a tag type 2 read-only (write access of the CC)
+ * @brief  The lock bits are not set, a tag which supports it can still be reformated
+ * @retval PCDNFCT2_OK : Command success
+ * @retval PCDNFCT2_ERROR : Transmission error
+ * @retval PCDNFCT2_ERROR_NOT_FORMATED : The tag is not NDEF formated
+ */
+uint8_t PCDNFCT2_LockNDEF( void )
+{
+	uint8_t status;
+	uint8_t buffer[PCDNFCT2_READ_SIZE_BUFFER];
+	
+	// The CC is the 4th bloc
+	errchk(PCDNFCT2_Read(0,buffer));
+	if (buffer[14] != PCDNFCT2_NDEF_MNB)
+		return PCDNFCT2_ERROR_NOT_FORMATED;
+	if ((buffer[17]&PCDNFCT2_WRITE_MSK) == PCDNFCT2_WRITE_MSK)
+		return PCDNFCT2_OK;
+	
+	// No write access
+	buffer[17] |= PCDNFCT2_WRITE_MSK;
+	errchk(PCDNFCT2_Write(3, &buffer[14]));
+	PCDNFC_InvalidateCC(TT2, ISO14443A_Card.UID, ISO14443A_Card.UIDsize);
+	
+	return PCDNFCT2_OK;
+Error:
+	PCDNFC_InvalidateCC(TT2, ISO14443A_Card.UID, ISO14443A_Card.UIDsize);
+	return PCDNFCT2_ERROR;
+}
+
+/**
+ * @brief  This function generates the GET_VERSION command (NXP NTAG and Ultralight EV1)
+ * @param  pVersion : Pointer on the buffer which will contain the version (8 bytes)
+ * @retval PCDNFCT2_OK : Command success
+ * @retval PCDNFCT2_ERROR : Transmission error or command not supported
+ */
+uint8_t PCDNFCT2_GetVersion( uint8_t *pVersion )
+{
+	uint8_t bufferRead[RFTRANS_95HF_MAX_BUFFER_SIZE+3];
+	uint8_t buffer[] = {PCDNFCT2_GET_VERSION,SEND_MASK_APPENDCRC|SEND_MASK_8BITSINFIRSTBYTE};
+
+	if (PCD_SendRecv(2,buffer, bufferRead) != PCD_SUCCESSCODE || bufferRead[1] < PCDNFCT2_VERSION_SIZE)
+		return PCDNFCT2_ERROR;
+	
+	memcpy(pVersion, &bufferRead[2], PCDNFCT2_VERSION_SIZE);
+	return PCDNFCT2_OK;
+}
+
+/**
+ * @brief  This function generates the READ_SIG command (NXP originality signature)
+ * @param  pSignature : Pointer on the buffer which will contain the signature (32 bytes)
+ * @retval PCDNFCT2_OK : Command success
+ * @retval PCDNFCT2_ERROR : Transmission error or command not supported
+ */
+uint8_t PCDNFCT2_ReadSignature( uint8_t *pSignature )
+{
+	uint8_t bufferRead[RFTRANS_95HF_MAX_BUFFER_SIZE+3];
+	uint8_t buffer[] = {PCDNFCT2_READ_SIG,0x00,SEND_MASK_APPENDCRC|SEND_MASK_8BITSINFIRSTBYTE};
+
+	if (PCD_SendRecv(3,buffer, bufferRead) != PCD_SUCCESSCODE || bufferRead[1] < PCDNFCT2_SIGNATURE_SIZE)
+		return PCDNFCT2_ERROR;
+	
+	memcpy(pSignature, &bufferRead[2], PCDNFCT2_SIGNATURE_SIZE);
+	return PCDNFCT2_OK;
+}
+
+/**
+ * @brief  This function sets the delay waited before the COMPATIBILITY_WRITE when a WRITE is not 
+ * @brief  acknowledged (programming time of the product)
+ * @param  Delay_ms : delay in ms
+ */
+void PCDNFCT2_SetWriteDelay( uc8 Delay_ms )
+{
+	PCDNFCT2_WriteDelay = Delay_ms;
+}
+
 /**
   * @}
   */ 
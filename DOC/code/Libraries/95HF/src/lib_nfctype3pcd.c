@@ -25,8 +25,10 @@ extern uint8_t *TT3AttribInfo, *TT3NDEFfile;
 
 static uint8_t PCDNFCT3_ReadAttribInfo(uint8_t *pBufferRead);
 static uint8_t PCDNFCT3_WriteAttribInfo(uint8_t *pBufferWrite);
-static uint8_t PCDNFCT3_ReadMessage(uc32 NbByteToRead, uint8_t *pBufferRead);
-static uint8_t PCDNFCT3_WriteMessage(uc32 NbByteToWrite, uint8_t *pBufferWrite, uint8_t maxBlocWrite);
+static uint8_t PCDNFCT3_ReadMessage(uc16 FirstBloc, uc32 NbByteToRead, uint8_t *pBufferRead);
+static bool PCDNFCT3_IsCheckSumOk(uc8 *bufferAttrib);
+static uint8_t PCDNFCT3_CompareMessage(uc16 NbBloc, uc8 maxBlocRead, uint8_t *pChanged, uint16_t *pNbChanged);
+static uint8_t PCDNFCT3_WriteChangedBloc(uc16 NbBloc, uc8 maxBlocWrite, uc8 *pChanged);
 static void PCDNFCT3_UpdateCheckSum(uint8_t *bufferAttrib);
 
 /** @addtogroup _95HF_Libraries
@@ -56,18 +58,13 @@ static void PCDNFCT3_UpdateCheckSum(uint8_t *bufferAttrib);
 
 /**
  * @brief  This function generates the Check command in order to read the AttribInfo field
- * @param  pBufferRead : Pointer on the buffer which will contain the data read
+ * @param  pBufferRead : Pointer on the buffer which will contain the AttribInfo field
  * @retval PCDNFCT3_OK : Command success
  * @retval PCDNFCT3_ERROR : Transmission error
  */
 static uint8_t PCDNFCT3_ReadAttribInfo(uint8_t *pBufferRead)
 {
-	uint8_t buffer[] = {PCDNFCT3_CHECK,0,0,0,0,0,0,0,0,0x01,PCDNFCT3_CODE_READ_LSB,PCDNFCT3_CODE_READ_MSB,0x01,PCDNFCT3_FIRST_BLOC_MSB,PCDNFCT3_FIRST_BLOC_LSB};
-	
-	/* Write UID */
-	memcpy(&buffer[1],FELICA_Card.UID,8);
-
-	if (PCD_SendRecv(15,buffer, pBufferRead) == PCD_SUCCESSCODE)
+	if (FELICA_Check(FELICA_Card.UID, PCDNFCT3_SERVICECODE_READ, PCDNFCT3_ATTR_BLOC, 1, 1, pBufferRead) == ISO18092_SUCCESSCODE)
 		return PCDNFCT3_OK;
 	else
 		return PCDNFCT3_ERROR; 
@@ -81,131 +78,94 @@ static uint8_t PCDNFCT3_ReadAttribInfo(uint8_t *pBufferRead)
  */
 static uint8_t PCDNFCT3_WriteAttribInfo(uint8_t *pBufferWrite)
 {
-	uint8_t buffer[31] = {PCDNFCT3_UPDATE,0,0,0,0,0,0,0,0,0x01,PCDNFCT3_CODE_WRITE_LSB,PCDNFCT3_CODE_WRITE_MSB,0x01,PCDNFCT3_FIRST_BLOC_MSB,PCDNFCT3_FIRST_BLOC_LSB};
-	uint8_t bufferRead[PCDNFCT3_ATTR_SIZE];
-
-	/* Write UID */
-	memcpy(&buffer[1],FELICA_Card.UID,8);
-	/* Write AttribInfo */
-	memcpy(&buffer[15],pBufferWrite,PCDNFCT3_ATTR_SIZE);
-
-	if (PCD_SendRecv(31,buffer, bufferRead) == PCD_SUCCESSCODE)
-	{
-		if (bufferRead[11] == 0 && bufferRead[12] == 0)
-			return PCDNFCT3_OK;
-		else
-			return PCDNFCT3_ERROR; /* Error code in reception frame */
-	}
+	if (FELICA_Update(FELICA_Card.UID, PCDNFCT3_SERVICECODE_WRITE, PCDNFCT3_ATTR_BLOC, 1, 1, pBufferWrite) == ISO18092_SUCCESSCODE)
+		return PCDNFCT3_OK;
 	else
-		return PCDNFCT3_ERROR; /* Transmission error */
+		return PCDNFCT3_ERROR; /* Transmission error or error code in reception frame */
 }
 
 /**
  * @brief  This function generates check commands in order to read all the NDEF message
- * @param  NbByteToRead : Size of the NDEF message to read
+ * @brief  (Nbr blocks by command, the blocks are stored straight in pBufferRead)
+ * @param  FirstBloc : First block of the message to read (0 for the beginning of the message)
+ * @param  NbByteToRead : Size of the NDEF message to read (from FirstBloc)
  * @param  pBufferRead : Pointer on the buffer which will contain the data read
  * @retval PCDNFCT3_OK : Command success
  * @retval PCDNFCT3_ERROR : Transmission error
  */
-static uint8_t PCDNFCT3_ReadMessage(uc32 NbByteToRead, uint8_t *pBufferRead)
+static uint8_t PCDNFCT3_ReadMessage(uc16 FirstBloc, uc32 NbByteToRead, uint8_t *pBufferRead)
 {
-	uint8_t nbBloc,i,j=0,maxBlocRead;
-	uint8_t buffer[48] = {PCDNFCT3_CHECK,0,0,0,0,0,0,0,0,0x01,PCDNFCT3_CODE_READ_LSB,PCDNFCT3_CODE_READ_MSB};
-	uint8_t bufferRead[280];
-
-	memcpy(&buffer[1],FELICA_Card.UID,8);
-
-	/* Check the maximum number of bloc that can be read with one command */
-	maxBlocRead = TT3AttribInfo[1];
-
-	/* Check the total number of bloc to read */
-	nbBloc = (NbByteToRead>>4)+1;
+	uint16_t nbBloc = PCDNFCT3_NBBLOC(NbByteToRead);
+	
+	if (nbBloc == 0)
+		return PCDNFCT3_OK;
+	
+	if (FELICA_Check(FELICA_Card.UID, PCDNFCT3_SERVICECODE_READ, PCDNFCT3_FIRST_NDEF_BLOC+FirstBloc, nbBloc, TT3AttribInfo[1], pBufferRead) == ISO18092_SUCCESSCODE)
+		return PCDNFCT3_OK;
+	else
+		return PCDNFCT3_ERROR; 
+}
 
-	/* Send as many commands as needed */
-	while (nbBloc > maxBlocRead)
-	{
-		nbBloc-=maxBlocRead;
-		buffer[12] = maxBlocRead;
-		for(i=0;i<maxBlocRead;i++) // 8001,8002,8003...
-		{
-			buffer[13+i*2] = PCDNFCT3_FIRST_BLOC_MSB;
-			buffer[14+i*2] = PCDNFCT3_FIRST_BLOC_LSB+i+1+j*maxBlocRead;
-		}
-		if (PCD_SendRecv(13+maxBlocRead*2,buffer, bufferRead) != PCD_SUCCESSCODE)
-			return PCDNFCT3_ERROR; 
-		/* Append the result to the pBufferRead buffer */
-		memcpy(&pBufferRead[j*maxBlocRead*16],&bufferRead[14],maxBlocRead*16);
-		j++;
-	}
-	if (nbBloc != 0) /* If there are blocks remaining */
+/**
+ * @brief  This function reads the blocks of the tag covering the message to write and marks the blocks 
+ * @brief  which content is different from the TT3NDEFfile buffer
+ * @param  NbBloc : Number of blocks of the message to write
+ * @param  maxBlocRead : Maximum number of blocs that can be read in a single command
+ * @param  pChanged : bitmap of the blocks to write (bit n of byte n/8 for the nth block of the message)
+ * @param  pNbChanged : number of blocks to write
+ * @retval PCDNFCT3_OK : Command success
+ * @retval PCDNFCT3_ERROR : Transmission error
+ */
+static uint8_t PCDNFCT3_CompareMessage(uc16 NbBloc, uc8 maxBlocRead, uint8_t *pChanged, uint16_t *pNbChanged)
+{
+	uint8_t bufferRead[FELICA_MAX_NBBLOCK_CHECK*FELICA_NBBYTE_BLOCK];
+	uint16_t bloc = 0, nbBlocRead, i;
+	
+	memset(pChanged, 0x00, NbBloc/8+1);
+	*pNbChanged = 0;
+	while (bloc < NbBloc)
 	{
-		buffer[12] = nbBloc;
-		for(i=0;i<nbBloc;i++) // 8001,8002,8003...
+		nbBlocRead = MIN(NbBloc-bloc, FELICA_MAX_NBBLOCK_CHECK);
+		if (FELICA_Check(FELICA_Card.UID, PCDNFCT3_SERVICECODE_READ, PCDNFCT3_FIRST_NDEF_BLOC+bloc, nbBlocRead, maxBlocRead, bufferRead) != ISO18092_SUCCESSCODE)
+			return PCDNFCT3_ERROR;
+		for (i=0; i<nbBlocRead; i++, bloc++)
 		{
-			buffer[13+i*2] = PCDNFCT3_FIRST_BLOC_MSB;
-			buffer[14+i*2] = PCDNFCT3_FIRST_BLOC_LSB+i+1+j*maxBlocRead;
+			if (memcmp(&bufferRead[i*FELICA_NBBYTE_BLOCK], &TT3NDEFfile[bloc*FELICA_NBBYTE_BLOCK], FELICA_NBBYTE_BLOCK) != 0)
+			{
+				pChanged[bloc>>3] |= 1 << (bloc&0x07);
+				(*pNbChanged)++;
+			}
 		}
-		if (PCD_SendRecv(13+nbBloc*2,buffer, bufferRead) != PCD_SUCCESSCODE)
-			return PCDNFCT3_ERROR; 
-		/* Append the result to the pBufferRead buffer */
-		memcpy(&pBufferRead[j*maxBlocRead*16],&bufferRead[14],nbBloc*16);
 	}
-		
+	
 	return PCDNFCT3_OK;
 }
 
 /**
- * @brief  This function generates Update commands in order to write all the NDEF message
- * @param  NbByteToWrite : Size of the NDEF message to write
- * @param  pBufferWrite : Pointer on the buffer which contains the data to write
+ * @brief  This function generates Update commands for the runs of blocks marked in the bitmap
+ * @param  NbBloc : Number of blocks of the message to write
  * @param  maxBlocWrite : Maximum number of blocs that can be write in a single command
+ * @param  pChanged : bitmap of the blocks to write
  * @retval PCDNFCT3_OK : Command success
  * @retval PCDNFCT3_ERROR : Transmission error
  */
-static uint8_t PCDNFCT3_WriteMessage(uc32 NbByteToWrite, uint8_t *pBufferWrite, uint8_t maxBlocWrite)
+static uint8_t PCDNFCT3_WriteChangedBloc(uc16 NbBloc, uc8 maxBlocWrite, uc8 *pChanged)
 {
-	uint8_t nbBloc,i,j=0;
-	uint8_t buffer[280] = {PCDNFCT3_UPDATE,0,0,0,0,0,0,0,0,0x01,PCDNFCT3_CODE_WRITE_LSB,PCDNFCT3_CODE_WRITE_MSB};
-	uint8_t bufferRead[16];
-
-	/* Write UID */
-	memcpy(&buffer[1],FELICA_Card.UID,8);
-
-	/* Check the total number of bloc to write */
-	nbBloc = (NbByteToWrite>>4)+1;
-
-	/* Send as many commands as needed */
-	while (nbBloc > maxBlocWrite)
-	{
-		nbBloc-=maxBlocWrite;
-		buffer[12] = maxBlocWrite;
-		for(i=0;i<maxBlocWrite;i++) // 8001,8002,8003...
-		{
-			buffer[13+i*2] = PCDNFCT3_FIRST_BLOC_MSB;
-			buffer[14+i*2] = PCDNFCT3_FIRST_BLOC_LSB+i+1+j*maxBlocWrite;
-		}
-		memcpy(&buffer[13+maxBlocWrite*2],&pBufferWrite[j*maxBlocWrite*16],maxBlocWrite*16);
-		if (PCD_SendRecv(13+maxBlocWrite*2+16*maxBlocWrite,buffer, bufferRead) != PCD_SUCCESSCODE)
-			return PCDNFCT3_ERROR; 
-		if (bufferRead[11] != 0 || bufferRead[12] != 0)
-			return PCDNFCT3_ERROR; /* Error code in reception frame */
-		j++;
-	}
-	if (nbBloc != 0) /* If there are blocks remaining */
+	uint16_t bloc = 0, nbBlocWrite;
+	
+	while (bloc < NbBloc)
 	{
-		buffer[12] = nbBloc;
-		for(i=0;i<nbBloc;i++) // 8001,8002,8003...
+		if ((pChanged[bloc>>3] & (1 << (bloc&0x07))) == 0x00)
 		{
-			buffer[13+i*2] = PCDNFCT3_FIRST_BLOC_MSB;
-			buffer[14+i*2] = PCDNFCT3_FIRST_BLOC_LSB+i+1+j*maxBlocWrite;
+			bloc++;
+			continue;
 		}
-		memcpy(&buffer[13+nbBloc*2],&pBufferWrite[j*maxBlocWrite*16],nbBloc*16);
-		if (PCD_SendRecv(13+nbBloc*2+16*nbBloc,buffer, bufferRead) != PCD_SUCCESSCODE)
-			return PCDNFCT3_ERROR; 
-		if (bufferRead[11] != 0 || bufferRead[12] != 0)
-			return PCDNFCT3_ERROR; /* Error code in reception frame */
+		for (nbBlocWrite = 1; bloc+nbBlocWrite < NbBloc && (pChanged[(bloc+nbBlocWrite)>>3] & (1 << ((bloc+nbBlocWrite)&0x07))) != 0x00; nbBlocWrite++);
+		if (FELICA_Update(FELICA_Card.UID, PCDNFCT3_SERVICECODE_WRITE, PCDNFCT3_FIRST_NDEF_BLOC+bloc, nbBlocWrite, maxBlocWrite, &TT3NDEFfile[bloc*FELICA_NBBYTE_BLOCK]) != ISO18092_SUCCESSCODE)
+			return PCDNFCT3_ERROR;
+		bloc += nbBlocWrite;
 	}
-		
+	
 	return PCDNFCT3_OK;
 }
 
@@ -223,6 +183,26 @@ static void PCDNFCT3_UpdateCheckSum(uint8_t *bufferAttrib)
 	bufferAttrib[15] = checkSum&0x00FF;
 }
 
+/**
+ * @brief  This function checks the checksum of the AttribInfo field
+ * @param  bufferAttrib : Pointer to the memory containing the AttribInfo field
+ * @retval true : the checksum is right
+ * @retval false : the checksum is wrong
+ */
+static bool PCDNFCT3_IsCheckSumOk(uc8 *bufferAttrib)
+{
+	uint8_t i;
+	uint16_t checkSum = 0;
+	
+	for(i=0;i<14;i++)
+		checkSum+=bufferAttrib[i];
+	
+	if (bufferAttrib[14] == (checkSum>>8) && bufferAttrib[15] == (checkSum&0x00FF))
+		return true;
+	else
+		return false;
+}
+
 /**
   * @}
   */
@@ -239,13 +219,36 @@ static void PCDNFCT3_UpdateCheckSum(uint8_t *bufferAttrib)
  */
 uint8_t PCDNFCT3_ReadNDEF( void )
 {
-	uint8_t buffer[32];
 	uint8_t status;
+	uint8_t bufferRead[FELICA_MAX_NBBLOCK_CHECK*FELICA_NBBYTE_BLOCK];
+	uint16_t nbBloc = 0;
 	uint32_t size;
+	PCDNFC_CCINFO CCInfo;
 		
-	/* Read AttribInfo field */
-	errchk(PCDNFCT3_ReadAttribInfo(buffer));
-	memcpy(TT3AttribInfo,&buffer[14],PCDNFCT3_ATTR_SIZE);
+	/* 424 kbps when the tag supports it */
+	FELICA_SelectMaxBitRate();
+	
+	/* Tag already read : the AttribInfo and the first blocks of the message are read by a single Check command */
+	if (PCDNFC_GetCachedCC(TT3, FELICA_Card.UID, FELICA_NBBYTE_IDM, &CCInfo) == PCDNFC_OK)
+	{
+		nbBloc = MIN(CCInfo.MaxRead, FELICA_MAX_NBBLOCK_CHECK);
+		nbBloc = MIN(nbBloc, PCDNFCT3_NBBLOC(CCInfo.MemorySize)+1);
+		if (FELICA_Check(FELICA_Card.UID, PCDNFCT3_SERVICECODE_READ, PCDNFCT3_ATTR_BLOC, nbBloc, CCInfo.MaxRead, bufferRead) != ISO18092_SUCCESSCODE ||
+				PCDNFCT3_IsCheckSumOk(bufferRead) == false || bufferRead[1] != CCInfo.MaxRead)
+		{
+			PCDNFC_InvalidateCC(TT3, FELICA_Card.UID, FELICA_NBBYTE_IDM);
+			nbBloc = 0;
+		}
+		else
+			memcpy(TT3AttribInfo, bufferRead, PCDNFCT3_ATTR_SIZE);
+	}
+	
+	if (nbBloc == 0)
+	{
+		/* Read AttribInfo field */
+		errchk(PCDNFCT3_ReadAttribInfo(TT3AttribInfo));
+		nbBloc = 1;
+	}
 	/* Calculate the size */
 	size = TT3AttribInfo[11]<<16|TT3AttribInfo[12]<<8|TT3AttribInfo[13];
 	
@@ -253,11 +256,29 @@ uint8_t PCDNFCT3_ReadNDEF( void )
 	if (size > NFCT3_MAX_TAGMEMORY)
 		return PCDNFCT3_ERROR_MEMORY_INTERNAL;
 	
-	/* Read the NDEF message */
-	errchk(PCDNFCT3_ReadMessage(size,TT3NDEFfile));
+	/* Blocks of the message already read with the AttribInfo */
+	nbBloc = MIN((uint32_t)(nbBloc-1), PCDNFCT3_NBBLOC(size));
+	memcpy(TT3NDEFfile, &bufferRead[FELICA_NBBYTE_BLOCK], nbBloc*FELICA_NBBYTE_BLOCK);
+	
+	/* Read the rest of the NDEF message */
+	if (size > nbBloc*FELICA_NBBYTE_BLOCK)
+	{
+		errchk(PCDNFCT3_ReadMessage(nbBloc, size-nbBloc*FELICA_NBBYTE_BLOCK, &TT3NDEFfile[nbBloc*FELICA_NBBYTE_BLOCK]));
+	}
+	
+	memset(&CCInfo, 0x00, sizeof(CCInfo));
+	CCInfo.TagType = TT3;
+	CCInfo.UIDsize = FELICA_NBBYTE_IDM;
+	memcpy(CCInfo.UID, FELICA_Card.UID, FELICA_NBBYTE_IDM);
+	CCInfo.MemorySize = (TT3AttribInfo[3]<<8|TT3AttribInfo[4])*FELICA_NBBYTE_BLOCK;
+	CCInfo.MaxRead = TT3AttribInfo[1];
+	CCInfo.MaxWrite = TT3AttribInfo[2];
+	CCInfo.Access = TT3AttribInfo[10];
+	PCDNFC_StoreCC(&CCInfo);
 	
 	return PCDNFCT3_OK;
 Error:
+	PCDNFC_InvalidateCC(TT3, FELICA_Card.UID, FELICA_NBBYTE_IDM);
 	return PCDNFCT3_ERROR; 
 }
 
@@ -270,14 +291,20 @@ Error:
  */
 uint8_t PCDNFCT3_WriteNDEF( void )
 {
-	uint8_t buffer[32];
-	uint8_t bufferAttrib[16];
+	uint8_t bufferAttrib[PCDNFCT3_ATTR_SIZE];
+	uint8_t changed[PCDNFCT3_NBBLOC(NFCT3_MAX_TAGMEMORY)/8+1];
 	uint8_t status;
 	uint32_t size, memoryAvailable;
+	uint16_t nbBloc, nbChanged;
+	
+	PCDNFC_WriteStat.NbWritten = 0;
+	PCDNFC_WriteStat.NbSaved = 0;
 		
+	/* 424 kbps when the tag supports it */
+	FELICA_SelectMaxBitRate();
+
 	/* Read AttribInfo field */
-	errchk(PCDNFCT3_ReadAttribInfo(buffer));
-	memcpy(bufferAttrib,&buffer[14],PCDNFCT3_ATTR_SIZE);
+	errchk(PCDNFCT3_ReadAttribInfo(bufferAttrib));
 	/* Check if write is available */
 	if(bufferAttrib[10] != 0x01)
 		return PCDNFCT3_ERROR_LOCKED; 
@@ -287,6 +314,16 @@ uint8_t PCDNFCT3_WriteNDEF( void )
 	if ((size>>4) > memoryAvailable)
 		return PCDNFCT3_ERROR_MEMORY_TAG; 
 	
+	/* Only the blocks which content changes are written */
+	nbBloc = PCDNFCT3_NBBLOC(size);
+	errchk(PCDNFCT3_CompareMessage(nbBloc, bufferAttrib[1], changed, &nbChanged));
+	/* A whole write is the blocks of the message and the AttribInfo twice */
+	PCDNFC_WriteStat.NbSaved = nbBloc - nbChanged + 2;
+	if (nbChanged == 0 && bufferAttrib[9] == PCDNFCT3_WRITE_OFF && memcmp(&bufferAttrib[11],&TT3AttribInfo[11],3) == 0)
+		return PCDNFCT3_OK;
+	PCDNFC_WriteStat.NbWritten = nbChanged + 2;
+	PCDNFC_WriteStat.NbSaved -= 2;
+	
 	/* Writing flag set to ON */
 	bufferAttrib[9] = PCDNFCT3_WRITE_ON;
 	/* Update CheckSum */
@@ -295,7 +332,7 @@ uint8_t PCDNFCT3_WriteNDEF( void )
 	errchk(PCDNFCT3_WriteAttribInfo(bufferAttrib));
 	
 	/* Write the message */
-	errchk(PCDNFCT3_WriteMessage(size, TT3NDEFfile,bufferAttrib[2]));
+	errchk(PCDNFCT3_WriteChangedBloc(nbBloc, bufferAttrib[2], changed));
 	
 	/* Length */
 	memcpy(&bufferAttrib[11],&TT3AttribInfo[11],3);
@@ -308,6 +345,32 @@ uint8_t PCDNFCT3_WriteNDEF( void )
 	
 	return PCDNFCT3_OK;
 Error:
+	PCDNFC_InvalidateCC(TT3, FELICA_Card.UID, FELICA_NBBYTE_IDM);
+	return PCDNFCT3_ERROR; 
+}
+
+/**
+ * @brief  This function sets the NDEF message of a tag type 3 read-only (RWFlag of the AttribInfo)
+ * @retval PCDNFCT3_OK : Command success
+ * @retval PCDNFCT3_ERROR : Transmission error
+ */
+uint8_t PCDNFCT3_LockNDEF( void )
+{
+	uint8_t bufferAttrib[PCDNFCT3_ATTR_SIZE];
+	uint8_t status;
+	
+	errchk(PCDNFCT3_ReadAttribInfo(bufferAttrib));
+	if (bufferAttrib[10] == PCDNFCT3_RWFLAG_READONLY)
+		return PCDNFCT3_OK;
+	
+	bufferAttrib[10] = PCDNFCT3_RWFLAG_READONLY;
+	PCDNFCT3_UpdateCheckSum(bufferAttrib);
+	errchk(PCDNFCT3_WriteAttribInfo(bufferAttrib));
+	PCDNFC_InvalidateCC(TT3, FELICA_Card.UID, FELICA_NBBYTE_IDM);
+	
+	return PCDNFCT3_OK;
+Error:
+	PCDNFC_InvalidateCC(TT3, FELICA_Card.UID, FELICA_NBBYTE_IDM);
 	return PCDNFCT3_ERROR; 
 }
 
@@ -18,7 +18,11 @@
   * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
   */
 #include "lib_nfctype4pcd.h"
+#include "lib_iso14443Apcd.h"
+#include "lib_iso14443Bpcd.h"
 
+extern ISO14443A_CARD ISO14443A_Card;
+extern ISO14443B_CARD ISO14443B_Card;
 extern uint8_t CardNDEFfileT4A[];
 extern uint8_t CardNDEFfileT4B[];
 extern uint16_t FSC;
@@ -30,8 +34,23 @@ extern ST95TagType st95tagtype;
 static int8_t PCDNFCT4_SelectApplication ( void );
 static int8_t PCDNFCT4_SelectCCfile ( void );
 static int8_t PCDNFCT4_SelectNDEFfile ( uc8 NDEF_ID_MSB, uc8 NDEF_ID_LSB );
+static uint8_t PCDNFCT4_GetUID ( uc8 **ppUID );
+static void PCDNFCT4_InvalidateCC ( void );
+static uint8_t PCDNFCT4_SelectNDEF ( PCDNFC_CCINFO *pInfo );
 static uint8_t PCDNFCT4_ReadBinary ( uc16 Offset ,uc8 NbByteToRead , uint8_t *pBufferRead );
 static uint8_t PCDNFCT4_UpdateBinary ( uc16 Offset ,uc8 NbByteToWrite , uint8_t *pBufferWrite );
+static uint8_t PCDNFCT4_ReadBinaryExtended ( uc16 Offset ,uc16 NbByteToRead , uint8_t *pBufferRead );
+static uint8_t PCDNFCT4_UpdateBinaryExtended ( uc16 Offset ,uc16 NbByteToWrite , uint8_t *pBufferWrite );
+static uint8_t PCDNFCT4_WriteRange ( uc16 Offset ,uc16 NbByteToWrite , uint8_t *pBufferWrite, uc16 MLc, bool ExtendedLength );
+static uint8_t PCDNFCT4_SessionSelect ( uc16 FileID );
+static uint8_t PCDNFCT4_SessionRecover ( void );
+static bool PCDNFCT4_SessionIsCurrentTag ( void );
+static uint8_t PCDNFCT4_Begin ( PCDNFC_CCINFO *pInfo );
+static uint8_t PCDNFCT4_ReadNDEFfile ( void );
+static uint8_t PCDNFCT4_WriteNDEFfile ( void );
+
+/* current session (PCDNFCT4_OpenSession) */
+static PCDNFCT4_SESSION Session = {0};
 
 /** @addtogroup _95HF_Libraries
  * 	@{
@@ -118,6 +137,90 @@ static int8_t PCDNFCT4_SelectNDEFfile ( uc8 NDEF_ID_MSB, uc8 NDEF_ID_LSB )
 		return PCDNFCT4_ERROR;
 }
 
+/**
+  * @brief  This function returns the UID of the tag (UID of a type 4A tag, PUPI of a type 4B tag)
+  * @param  ppUID : Pointer on the UID
+	* @retval number of bytes of the UID
+  */
+static uint8_t PCDNFCT4_GetUID ( uc8 **ppUID )
+{
+	if (st95tagtype == TT4A)
+	{
+		*ppUID = ISO14443A_Card.UID;
+		return ISO14443A_Card.UIDsize;
+	}
+	
+	*ppUID = ISO14443B_Card.PUPI;
+	return ISO14443B_MAX_PUPI_SIZE;
+}
+
+/**
+  * @brief  This function removes the tag from the capability cache (after an error)
+  */
+static void PCDNFCT4_InvalidateCC ( void )
+{
+	uint8_t UIDsize;
+	uc8 *pUID;
+	
+	UIDsize = PCDNFCT4_GetUID(&pUID);
+	PCDNFC_InvalidateCC(st95tagtype, pUID, UIDsize);
+}
+
+/**
+  * @brief  This function selects the NDEF application and the NDEF file. The CC file is only read 
+  * @brief  when the tag is not in the capability cache or when its NDEF file cannot be selected.
+  * @brief  The NDEF file is not selected when the read access is not allowed.
+  * @param  pInfo : Capability information of the tag (from the CC file)
+	* @retval PCDNFCT4_OK : Command success
+	* @retval PCDNFCT4_ERROR : Transmission error
+  */
+static uint8_t PCDNFCT4_SelectNDEF ( PCDNFC_CCINFO *pInfo )
+{
+	uint8_t status, UIDsize;
+	uint8_t buffer[PCDNFCT4_BUFFER_READ];
+	uc8 *pUID;
+	
+	UIDsize = PCDNFCT4_GetUID(&pUID);
+	
+	// SelectAppli
+	errchk(PCDNFCT4_SelectApplication());
+	
+	// Tag already read : the CC file is not read again
+	if (PCDNFC_GetCachedCC(st95tagtype, pUID, UIDsize, pInfo) == PCDNFC_OK)
+	{
+		if (pInfo->Access == PCDNFCT4_ACCESS_ALLOWED && 
+				PCDNFCT4_SelectNDEFfile(pInfo->FileID>>8, pInfo->FileID&0xFF) == PCDNFCT4_OK)
+			return PCDNFCT4_OK;
+		PCDNFCT4_InvalidateCC();
+	}
+	
+	// SelectCC
+	errchk(PCDNFCT4_SelectCCfile());
+	errchk(PCDNFCT4_ReadBinary(0x00, 0x0F, buffer));
+	memset(pInfo, 0x00, sizeof(PCDNFC_CCINFO));
+	pInfo->TagType = st95tagtype;
+	pInfo->UIDsize = UIDsize;
+	memcpy(pInfo->UID, pUID, UIDsize);
+	pInfo->MaxRead = buffer[6]<<8|buffer[7];
+	pInfo->MaxWrite = buffer[8]<<8|buffer[9];
+	pInfo->FileID = buffer[12]<<8|buffer[13];
+	pInfo->MemorySize = buffer[14]<<8|buffer[15];
+	pInfo->Access = buffer[16];
+	pInfo->WriteAccess = buffer[17];
+	PCDNFC_StoreCC(pInfo);
+	
+	// SelectNDEF
+	if (pInfo->Access == PCDNFCT4_ACCESS_ALLOWED)
+	{
+		errchk(PCDNFCT4_SelectNDEFfile(pInfo->FileID>>8, pInfo->FileID&0xFF));
+	}
+	
+	return PCDNFCT4_OK;
+Error:
+	PCDNFCT4_InvalidateCC();
+	return PCDNFCT4_ERROR;
+}
+
 /**
   * @brief  This function sends a read binary command
 	* @param	Offset : first byte to read
@@ -160,12 +263,150 @@ static uint8_t PCDNFCT4_UpdateBinary ( uc16 Offset ,uc8 NbByteToWrite , uint8_t
 }
 
 /**
-  * @}
+  * @brief  This function sends a read binary command with an extended LE field
+	* @param	Offset : first byte to read
+	* @param	NbByteToRead : number of byte to read
+	* @param	pBufferRead : pointer of the buffer read from the tag (NbByteToRead + 2 bytes, SW1 SW2 follow the data)
+	* @retval PCDNFCT4_OK : Command success
+	* @retval PCDNFCT4_ERROR : Transmission error
   */
+static uint8_t PCDNFCT4_ReadBinaryExtended ( uc16 Offset ,uc16 NbByteToRead , uint8_t *pBufferRead )
+{
+	uint16_t NbByteRead;
 
-/** @addtogroup lib_nfctype4pcd_Public_Functions
- *  @{
- */
+	if (ISO7816_ReadBinaryExtended ( GETMSB(Offset) , GETLSB(Offset) , NbByteToRead , pBufferRead , &NbByteRead ) == ISO7816_SUCCESSCODE &&
+			NbByteRead == NbByteToRead)
+		return PCDNFCT4_OK;
+	else
+		return PCDNFCT4_ERROR;		
+}
+
+/**
+  * @brief  This function sends a update binary command with an extended LC field
+	* @param	Offset : first byte to write
+	* @param	NbByteToWrite : number of byte to write
+	* @param	pBufferWrite : pointer of the buffer which contains data to write
+	* @retval PCDNFCT4_OK : Command success
+	* @retval PCDNFCT4_ERROR : Transmission error
+  */
+static uint8_t PCDNFCT4_UpdateBinaryExtended ( uc16 Offset ,uc16 NbByteToWrite , uint8_t *pBufferWrite )
+{
+	if (ISO7816_UpdateBinaryExtended ( GETMSB(Offset) , GETLSB(Offset) , NbByteToWrite , pBufferWrite ) == ISO7816_SUCCESSCODE)
+		return PCDNFCT4_OK;
+	else
+		return PCDNFCT4_ERROR;		
+}
+
+/**
+  * @brief  This function writes a range of the NDEF file with update binary commands of MLc bytes
+	* @param	Offset : first byte to write
+	* @param	NbByteToWrite : number of byte to write
+	* @param	pBufferWrite : pointer of the buffer which contains data to write
+	* @param	MLc : maximum number of bytes of an update binary command
+	* @param	ExtendedLength : true when the extended LC field is used
+	* @retval PCDNFCT4_OK : Command success
+	* @retval PCDNFCT4_ERROR : Transmission error
+  */
+static uint8_t PCDNFCT4_WriteRange ( uc16 Offset ,uc16 NbByteToWrite , uint8_t *pBufferWrite, uc16 MLc, bool ExtendedLength )
+{
+	uint8_t status;
+	uint16_t i = 0, nbByte;
+	
+	while (i < NbByteToWrite)
+	{
+		nbByte = MIN(NbByteToWrite-i, MLc);
+		if (ExtendedLength == true)
+			status = PCDNFCT4_UpdateBinaryExtended(Offset+i, nbByte, &pBufferWrite[i]);
+		else
+			status = PCDNFCT4_UpdateBinary(Offset+i, nbByte, &pBufferWrite[i]);
+		if (status != PCDNFCT4_OK)
+			return PCDNFCT4_ERROR;
+		PCDNFC_WriteStat.NbWritten += nbByte;
+		i += nbByte;
+	}
+	
+	return PCDNFCT4_OK;
+}
+
+/**
+  * @brief  This function selects a file in the session (the select command is only sent when 
+  * @brief  another file is selected)
+	* @param	FileID : file identifier
+	* @retval PCDNFCT4_OK : Command success
+	* @retval PCDNFCT4_ERROR : Transmission error
+  */
+static uint8_t PCDNFCT4_SessionSelect ( uc16 FileID )
+{
+	if (Session.SelectedFile == FileID)
+		return PCDNFCT4_OK;
+	
+	Session.SelectedFile = PCDNFCT4_NOFILE;
+	if (PCDNFCT4_SelectNDEFfile(GETMSB(FileID), GETLSB(FileID)) != PCDNFCT4_OK)
+		return PCDNFCT4_ERROR;
+	Session.SelectedFile = FileID;
+	
+	return PCDNFCT4_OK;
+}
+
+/**
+  * @brief  This function selects the NDEF application again after an error of the session which tells
+  * @brief  that the tag has lost the selection (file not found or no current EF)
+	* @retval PCDNFCT4_OK : The application is selected, the command can be sent again
+	* @retval PCDNFCT4_ERROR : Other error or transmission error
+  */
+static uint8_t PCDNFCT4_SessionRecover ( void )
+{
+	uint16_t SW = ISO7816_GetStatusWord();
+	
+	Session.SelectedFile = PCDNFCT4_NOFILE;
+	if (Session.IsOpen == false || (SW != ISO7816_SW_FILENOTFOUND && SW != ISO7816_SW_NOCURRENTEF))
+		return PCDNFCT4_ERROR;
+	
+	return (uint8_t)PCDNFCT4_SelectApplication();
+}
+
+/**
+  * @brief  This function tells if the tag in the field is the tag of the session (UID of a type 4A tag, 
+  * @brief  PUPI of a type 4B tag)
+	* @retval true : same tag
+	* @retval false : other tag, the session cannot be used
+  */
+static bool PCDNFCT4_SessionIsCurrentTag ( void )
+{
+	uint8_t UIDsize;
+	uc8 *pUID;
+	
+	UIDsize = PCDNFCT4_GetUID(&pUID);
+	return (Session.CC.TagType == st95tagtype && Session.CC.UIDsize == UIDsize && 
+					memcmp(Session.CC.UID, pUID, UIDsize) == 0);
+}
+
+/**
+  * @brief  This function selects the NDEF file before a read or a write of the NDEF message, with the CC 
+  * @brief  of the session when a session is open (no application select, no select when already selected)
+  * @brief  The session is opened again when another tag is in the field.
+  * @param  pInfo : Capability information of the tag (from the CC file)
+	* @retval PCDNFCT4_OK : Command success
+	* @retval PCDNFCT4_ERROR : Transmission error
+  */
+static uint8_t PCDNFCT4_Begin ( PCDNFC_CCINFO *pInfo )
+{
+	if (Session.IsOpen == false)
+		return PCDNFCT4_SelectNDEF(pInfo);
+	
+	if (PCDNFCT4_SessionIsCurrentTag() == false)
+	{
+		PCDNFCT4_CloseSession();
+		if (PCDNFCT4_OpenSession() != PCDNFCT4_OK)
+			return PCDNFCT4_ERROR;
+	}
+	
+	memcpy(pInfo, &Session.CC, sizeof(PCDNFC_CCINFO));
+	if (pInfo->Access != PCDNFCT4_ACCESS_ALLOWED)
+		return PCDNFCT4_OK;
+	
+	return PCDNFCT4_SessionSelect(pInfo->FileID);
+}
 
 /**
  * @brief  This function reads the NDEF message from a tag type 4 and store result in the CardNDEFfile buffer
@@ -173,12 +414,14 @@ static uint8_t PCDNFCT4_UpdateBinary ( uc16 Offset ,uc8 NbByteToWrite , uint8_t
  * @retval PCDNFCT4_ERROR : Transmission error
  * @retval PCDNFCT4_ERROR_LOCKED : The tag cannot be read (CCfile lock)
  */
-uint8_t PCDNFCT4_ReadNDEF( void )
+static uint8_t PCDNFCT4_ReadNDEFfile( void )
 {
-	uint8_t status, NDEF_ID_MSB, NDEF_ID_LSB;
+	uint8_t status;
 	uint16_t size, i = 0, MLe;
 	uint8_t buffer[PCDNFCT4_BUFFER_READ];
+	bool ExtendedLength;
 	uint8_t *CardNDEFfile;
+	PCDNFC_CCINFO CCInfo;
 	
 	// Choose the correct buffer
 	if (st95tagtype == TT4A)
@@ -186,29 +429,40 @@ uint8_t PCDNFCT4_ReadNDEF( void )
 	else
 		CardNDEFfile = CardNDEFfileT4B;
 
-	// SelectAppli
-	errchk(PCDNFCT4_SelectApplication());
-
-	// SelectCC
-	errchk(PCDNFCT4_SelectCCfile());
-	errchk(PCDNFCT4_ReadBinary(0x00, 0x0F, buffer));
-	NDEF_ID_MSB = buffer[12];
-	NDEF_ID_LSB = buffer[13];
-	MLe = MIN((buffer[6]<<8|buffer[7]),0xF6);
+	// SelectAppli, CC (from the session or the capability cache) and SelectNDEF
+	errchk(PCDNFCT4_Begin(&CCInfo));
+	MLe = MIN(CCInfo.MaxRead,ISO7816_MAX_EXTENDEDLE);
+	// The extended LE is used when the CC or the historical bytes tell it is supported
+	ExtendedLength = (MLe > PCDNFCT4_MAX_MLE || ISO7816_IsExtendedLengthSupported() == true);
 	// Check if read access is allowed
-	if (buffer[16] != PCDNFCT4_ACCESS_ALLOWED)
+	if (CCInfo.Access != PCDNFCT4_ACCESS_ALLOWED)
 		return PCDNFCT4_ERROR_LOCKED;
-	// SelectNDEF
-	errchk(PCDNFCT4_SelectNDEFfile(NDEF_ID_MSB,NDEF_ID_LSB));
 	// Read length
 	errchk(PCDNFCT4_ReadBinary(0x00, 0x02, buffer));
-	size = (buffer[3]<<8)|(buffer[4]) + 2;
+	size = ((buffer[3]<<8)|buffer[4]) + 2;
 	
 	// Check if there is enough memory available to read the tag
 	if (size > NFCT4_MAX_NDEFMEMORY)
 		return PCDNFCT4_ERROR_MEMORY_INTERNAL;
 	
+	// Read data directly in the NDEF buffer (SW1 SW2 are written after the data)
+	if (ExtendedLength == true && size <= NFCT4_MAX_NDEFMEMORY - ISO7816_NBBYTE_SW)
+	{
+		while (size>MLe)
+		{
+			errchk(PCDNFCT4_ReadBinaryExtended(i*MLe, MLe, &CardNDEFfile[i*MLe]));
+			size -= MLe;
+			i++;
+		}
+		if (size > 0)
+		{
+			errchk(PCDNFCT4_ReadBinaryExtended(i*MLe, size, &CardNDEFfile[i*MLe]));
+		}
+		return PCDNFCT4_OK;
+	}
+
 	// Read data
+	MLe = MIN(MLe,PCDNFCT4_MAX_MLE);
 	while (size>MLe)
 	{
 		errchk(PCDNFCT4_ReadBinary(i*MLe, MLe, buffer));
@@ -224,22 +478,29 @@ uint8_t PCDNFCT4_ReadNDEF( void )
 		
 	return PCDNFCT4_OK;
 Error:
+	PCDNFCT4_InvalidateCC();
 	return PCDNFCT4_ERROR;
 }
 
 /**
  * @brief  This function writes the NDEF message to a tag type 4 from the CardNDEFfile buffer
+ * @brief  Only the bytes which differ from the content of the tag are written
  * @retval PCDNFCT4_OK : Command success
  * @retval PCDNFCT4_ERROR : Transmission error
  * @retval PCDNFCT4_ERROR_LOCKED : The tag cannot be write (CCfile lock)
  * @retval PCDNFCT4_ERROR_MEMORY : Not enough memory available on the tag
  */
-uint8_t PCDNFCT4_WriteNDEF( void )
+static uint8_t PCDNFCT4_WriteNDEFfile( void )
 {
-	uint8_t status, NDEF_ID_MSB, NDEF_ID_LSB;
-	uint16_t size, i = 0, MLc, memoryAvailable;
-	uint8_t buffer[32], bufferSize[2];
+	uint8_t status, nbByteRead;
+	uint16_t size, offset, runStart = 0, runEnd = 0, MLc, MLe, i;
+	uint8_t buffer[PCDNFCT4_BUFFER_READ], bufferSize[2] = {0x00, 0x00};
+	bool ExtendedLength, run = false, sizeCleared = false;
 	uint8_t *CardNDEFfile;
+	PCDNFC_CCINFO CCInfo;
+	
+	PCDNFC_WriteStat.NbWritten = 0;
+	PCDNFC_WriteStat.NbSaved = 0;
 	
 	// Choose the correct buffer
 	if (st95tagtype == TT4A)
@@ -247,63 +508,243 @@ uint8_t PCDNFCT4_WriteNDEF( void )
 	else
 		CardNDEFfile = CardNDEFfileT4B;
 
-	// SelectAppli
-	errchk(PCDNFCT4_SelectApplication());
-	// SelectCC
-	errchk(PCDNFCT4_SelectCCfile());
-	errchk(PCDNFCT4_ReadBinary(0x00, 0x0F, buffer));
-	NDEF_ID_MSB = buffer[12];
-	NDEF_ID_LSB = buffer[13];
+	// SelectAppli, CC (from the session or the capability cache) and SelectNDEF
+	errchk(PCDNFCT4_Begin(&CCInfo));
 	// Check if there is enough memory available on the tag 
-	memoryAvailable = buffer[14]<<8|buffer[15];
-	size = CardNDEFfile[0]<<8|CardNDEFfile[1]+2;
-	if (size > memoryAvailable)
+	size = (CardNDEFfile[0]<<8|CardNDEFfile[1])+2;
+	if (size > CCInfo.MemorySize)
 		return PCDNFCT4_ERROR_MEMORY_TAG;
-	// Check if write access is allowed
-	if (buffer[17] != PCDNFCT4_ACCESS_ALLOWED)
+	// Check if write access is allowed (the NDEF file is read to be compared)
+	if (CCInfo.Access != PCDNFCT4_ACCESS_ALLOWED || CCInfo.WriteAccess != PCDNFCT4_ACCESS_ALLOWED)
 		return PCDNFCT4_ERROR_LOCKED;
-	// Chaining not supported yet... and the maximum for ST95HF is 0xF6
-	MLc = MIN((buffer[8]<<8|buffer[9]),0xF6);
-	// SelectNDEF
-	errchk(PCDNFCT4_SelectNDEFfile(NDEF_ID_MSB,NDEF_ID_LSB));
-	// Write NDEF
-	// The size must be 0
-	bufferSize[0] = CardNDEFfile[0]; bufferSize[1] = CardNDEFfile[1];
-	CardNDEFfile[0] = CardNDEFfile[1] = 0;
+	MLe = MIN(CCInfo.MaxRead,PCDNFCT4_MAX_MLE);
+	// The command is chained by the ISO-DEP layer when it is longer than FSC
+	// The extended LC is used when the CC or the historical bytes tell it is supported
+	MLc = CCInfo.MaxWrite;
+	ExtendedLength = (MLc > PCDNFCT4_MAX_MLC || ISO7816_IsExtendedLengthSupported() == true);
+	if (ExtendedLength == false)
+		MLc = MIN(MLc,PCDNFCT4_MAX_MLC);
 	
-	while (size>MLc)
+	// A whole write is the NDEF file and the size a second time
+	PCDNFC_WriteStat.NbSaved = size + 2;
+	
+	// Compare the file with the content of the tag, a run of different bytes is written when
+	// PCDNFCT4_DIFF_GAP identical bytes follow it (a new update binary costs more than these bytes)
+	// The size is cleared before the first run so that a partial write leaves an empty message
+	for (offset = 2; offset < size; offset += nbByteRead)
 	{
-		status = PCDNFCT4_UpdateBinary(i*MLc, MLc, &CardNDEFfile[i*MLc]);
-		// If an error occur we have to write back the size to the NDEF buffer
-		if (status == PCDNFCT4_ERROR)
+		nbByteRead = MIN(size-offset, MLe);
+		errchk(PCDNFCT4_ReadBinary(offset, nbByteRead, buffer));
+		for (i=0; i<nbByteRead; i++)
 		{
-			CardNDEFfile[0]=bufferSize[0]; 
-			CardNDEFfile[1]=bufferSize[1];
-			return PCDNFCT4_ERROR;
+			if (buffer[PCD_DATA_OFFSET+1+i] != CardNDEFfile[offset+i])
+			{
+				if (run == false)
+					runStart = offset+i;
+				run = true;
+				runEnd = offset+i+1;
+			}
+			else if (run == true && offset+i >= runEnd+PCDNFCT4_DIFF_GAP)
+			{
+				if (sizeCleared == false)
+				{
+					errchk(PCDNFCT4_WriteRange(0, 2, bufferSize, MLc, ExtendedLength));
+					sizeCleared = true;
+				}
+				errchk(PCDNFCT4_WriteRange(runStart, runEnd-runStart, &CardNDEFfile[runStart], MLc, ExtendedLength));
+				run = false;
+			}
 		}
-		size -= MLc;
-		i++;
 	}
-	if (size > 0)
+	if (run == true)
 	{
-		status = PCDNFCT4_UpdateBinary(i*MLc, size, &CardNDEFfile[i*MLc]);
-		// If an error occur we have to write back the size to the NDEF buffer
-		if (status == PCDNFCT4_ERROR)
+		if (sizeCleared == false)
 		{
-			CardNDEFfile[0]=bufferSize[0]; 
-			CardNDEFfile[1]=bufferSize[1];
-			return PCDNFCT4_ERROR;
+			errchk(PCDNFCT4_WriteRange(0, 2, bufferSize, MLc, ExtendedLength));
+			sizeCleared = true;
 		}
+		errchk(PCDNFCT4_WriteRange(runStart, runEnd-runStart, &CardNDEFfile[runStart], MLc, ExtendedLength));
 	}
 	
-	// Write the size
-	errchk(PCDNFCT4_UpdateBinary(0,2,bufferSize));
-		
+	// Write the size when it has been cleared or when it changes
+	if (sizeCleared == false)
+	{
+		errchk(PCDNFCT4_ReadBinary(0x00, 0x02, buffer));
+		sizeCleared = (buffer[PCD_DATA_OFFSET+1] != CardNDEFfile[0] || buffer[PCD_DATA_OFFSET+2] != CardNDEFfile[1]);
+	}
+	if (sizeCleared == true)
+	{
+		errchk(PCDNFCT4_WriteRange(0, 2, CardNDEFfile, MLc, ExtendedLength));
+	}
+	
+	PCDNFC_WriteStat.NbSaved -= MIN(PCDNFC_WriteStat.NbWritten, PCDNFC_WriteStat.NbSaved);
+	return PCDNFCT4_OK;
+Error:
+	PCDNFCT4_InvalidateCC();
+	return PCDNFCT4_ERROR;
+}
+
+/**
+  * @}
+  */
+
+/** @addtogroup lib_nfctype4pcd_Public_Functions
+ *  @{
+ */
+
+/**
+ * @brief  This function reads the NDEF message from a tag type 4 and store result in the CardNDEFfile buffer
+ * @brief  (in a session, the message is read again once when the tag has lost the selection)
+ * @retval PCDNFCT4_OK : Command success
+ * @retval PCDNFCT4_ERROR : Transmission error
+ * @retval PCDNFCT4_ERROR_LOCKED : The tag cannot be read (CCfile lock)
+ */
+uint8_t PCDNFCT4_ReadNDEF( void )
+{
+	uint8_t status = PCDNFCT4_ReadNDEFfile();
+	
+	if (status == PCDNFCT4_ERROR && PCDNFCT4_SessionRecover() == PCDNFCT4_OK)
+		status = PCDNFCT4_ReadNDEFfile();
+	
+	return status;
+}
+
+/**
+ * @brief  This function writes the NDEF message to a tag type 4 from the CardNDEFfile buffer
+ * @brief  (in a session, the message is written again once when the tag has lost the selection)
+ * @retval PCDNFCT4_OK : Command success
+ * @retval PCDNFCT4_ERROR : Transmission error
+ * @retval PCDNFCT4_ERROR_LOCKED : The tag cannot be write (CCfile lock)
+ * @retval PCDNFCT4_ERROR_MEMORY : Not enough memory available on the tag
+ */
+uint8_t PCDNFCT4_WriteNDEF( void )
+{
+	uint8_t status = PCDNFCT4_WriteNDEFfile();
+	
+	if (status == PCDNFCT4_ERROR && PCDNFCT4_SessionRecover() == PCDNFCT4_OK)
+		status = PCDNFCT4_WriteNDEFfile();
+	
+	return status;
+}
+
+/**
+ * @brief  This function opens a session with the tag : the NDEF application is selected, the CC is read 
+ * @brief  and the NDEF file is selected once. The following reads and writes (NDEF message or other 
+ * @brief  files) only select a file when it is not already selected, until PCDNFCT4_CloseSession.
+ * @retval PCDNFCT4_OK : Command success
+ * @retval PCDNFCT4_ERROR : Transmission error
+ */
+uint8_t PCDNFCT4_OpenSession( void )
+{
+	uint8_t status;
+	
+	Session.IsOpen = false;
+	Session.SelectedFile = PCDNFCT4_NOFILE;
+	
+	errchk(PCDNFCT4_SelectNDEF(&Session.CC));
+	if (Session.CC.Access == PCDNFCT4_ACCESS_ALLOWED)
+		Session.SelectedFile = Session.CC.FileID;
+	
+	Session.MLe = MIN(Session.CC.MaxRead, PCDNFCT4_MAX_MLE);
+	Session.MLc = Session.CC.MaxWrite;
+	Session.ExtendedLength = (Session.MLc > PCDNFCT4_MAX_MLC || ISO7816_IsExtendedLengthSupported() == true);
+	if (Session.ExtendedLength == false)
+		Session.MLc = MIN(Session.MLc, PCDNFCT4_MAX_MLC);
+	Session.IsOpen = true;
+	
 	return PCDNFCT4_OK;
 Error:
 	return PCDNFCT4_ERROR;
 }
 
+/**
+ * @brief  This function closes the session (the next read or write selects the application again)
+ */
+void PCDNFCT4_CloseSession( void )
+{
+	Session.IsOpen = false;
+	Session.SelectedFile = PCDNFCT4_NOFILE;
+}
+
+/**
+ * @brief  This function reads a file of the tag in the session (the file is selected if needed)
+ * @param  FileID : file identifier (the NDEF file ID is in the CC of the session)
+ * @param  Offset : first byte to read
+ * @param  NbByteToRead : number of bytes to read
+ * @param  pBufferRead : data read (NbByteToRead bytes)
+ * @retval PCDNFCT4_OK : Command success
+ * @retval PCDNFCT4_ERROR : Transmission error, no session or session of another tag
+ */
+uint8_t PCDNFCT4_SessionReadBinary( uc16 FileID, uc16 Offset, uc16 NbByteToRead, uint8_t *pBufferRead )
+{
+	uint8_t buffer[PCDNFCT4_BUFFER_READ];
+	uint16_t i = 0, nbByte;
+	bool recovered = false;
+	
+	if (Session.IsOpen == false)
+		return PCDNFCT4_ERROR;
+	/* the files of another tag are not read with the session */
+	if (PCDNFCT4_SessionIsCurrentTag() == false)
+	{
+		PCDNFCT4_CloseSession();
+		return PCDNFCT4_ERROR;
+	}
+	
+	while (i < NbByteToRead)
+	{
+		nbByte = MIN(NbByteToRead-i, Session.MLe);
+		if (PCDNFCT4_SessionSelect(FileID) == PCDNFCT4_OK && PCDNFCT4_ReadBinary(Offset+i, nbByte, buffer) == PCDNFCT4_OK)
+		{
+			memcpy(&pBufferRead[i], &buffer[PCD_DATA_OFFSET+1], nbByte);
+			i += nbByte;
+		}
+		else if (recovered == false && PCDNFCT4_SessionRecover() == PCDNFCT4_OK)
+			recovered = true;
+		else
+			return PCDNFCT4_ERROR;
+	}
+	
+	return PCDNFCT4_OK;
+}
+
+/**
+ * @brief  This function writes a file of the tag in the session (the file is selected if needed)
+ * @param  FileID : file identifier (the NDEF file ID is in the CC of the session)
+ * @param  Offset : first byte to write
+ * @param  NbByteToWrite : number of bytes to write
+ * @param  pBufferWrite : data to write
+ * @retval PCDNFCT4_OK : Command success
+ * @retval PCDNFCT4_ERROR : Transmission error, no session or session of another tag
+ */
+uint8_t PCDNFCT4_SessionUpdateBinary( uc16 FileID, uc16 Offset, uc16 NbByteToWrite, uint8_t *pBufferWrite )
+{
+	uint16_t i = 0, nbByte;
+	bool recovered = false;
+	
+	if (Session.IsOpen == false)
+		return PCDNFCT4_ERROR;
+	/* the files of another tag are not written with the session */
+	if (PCDNFCT4_SessionIsCurrentTag() == false)
+	{
+		PCDNFCT4_CloseSession();
+		return PCDNFCT4_ERROR;
+	}
+	
+	while (i < NbByteToWrite)
+	{
+		nbByte = MIN(NbByteToWrite-i, Session.MLc);
+		if (PCDNFCT4_SessionSelect(FileID) == PCDNFCT4_OK && 
+				PCDNFCT4_WriteRange(Offset+i, nbByte, &pBufferWrite[i], Session.MLc, Session.ExtendedLength) == PCDNFCT4_OK)
+			i += nbByte;
+		else if (recovered == false && PCDNFCT4_SessionRecover() == PCDNFCT4_OK)
+			recovered = true;
+		else
+			return PCDNFCT4_ERROR;
+	}
+	
+	return PCDNFCT4_OK;
+}
+
 /**
   * @}
   */ 
@@ -21,6 +21,18 @@
 
 extern uint8_t TT5Tag[];
 
+/* write buffer used to program the changed blocks of the message */
+static ISO15693_WRITEBUFFER WriteBuffer;
+
+static uint8_t PCDNFCT5_OpenWriteBuffer(uc16 FirstBlock, const ISO15693_SYSTEMINFO *pLayout);
+static uint8_t PCDNFCT5_WriteBlock(uc16 Block, uc8 *pData, const ISO15693_SYSTEMINFO *pLayout);
+static uint8_t PCDNFCT5_WriteChangedBlock(uc16 NbBlock, uc16 LengthBlock, uc8 *pChanged, const ISO15693_SYSTEMINFO *pLayout);
+static uint8_t PCDNFCT5_ParseCC(uc8 *pCC, PCDNFCT5_CC *pInfo);
+static void PCDNFCT5_SetLayout(ISO15693_SYSTEMINFO *pLayout, uc8 Density, uc8 Flags);
+static uint8_t PCDNFCT5_ReadFirstSector(uint8_t *pBuffer, ISO15693_SYSTEMINFO *pLayout);
+static uint8_t PCDNFCT5_PlaceMessage(uc8 *pCC, uc8 BufferCCSize);
+static void PCDNFCT5_InvalidateCC(void);
+
 /** @addtogroup _95HF_Libraries
  * 	@{
  *	@brief  <b>This is the library used by the whole 95HF family (RX95HF, CR95HF, ST95HF) <br />
@@ -45,6 +57,237 @@ extern uint8_t TT5Tag[];
  *  @{
  */
 
+/**
+ * @brief  This function opens the write buffer with the addressing of the reads (density and extended
+ * @brief  commands of the CC), so that the blocks above 255 are not written with a 1 byte block number
+ * @param  FirstBlock : first block covered by the buffer
+ * @param  pLayout : memory layout of the tag
+ * @retval PCDNFCT5_OK : Command success
+ * @retval PCDNFCT5_ERROR : Transmission error
+ */
+static uint8_t PCDNFCT5_OpenWriteBuffer(uc16 FirstBlock, const ISO15693_SYSTEMINFO *pLayout)
+{
+	if (ISO15693_WriteBufferOpen(&WriteBuffer, 0x00, FirstBlock) != ISO15693_SUCCESSCODE)
+		return PCDNFCT5_ERROR;
+	WriteBuffer.Density = pLayout->Density;
+	WriteBuffer.SupportedCmd |= pLayout->SupportedCmd & ISO15693_SUPPORT_EXTENDEDCMD;
+	
+	return PCDNFCT5_OK;
+}
+
+/**
+ * @brief  This function writes one block of the tag
+ * @param  Block : number of the block to write
+ * @param  pData : content of the block (4 bytes)
+ * @param  pLayout : memory layout of the tag
+ * @retval PCDNFCT5_OK : Command success
+ * @retval PCDNFCT5_ERROR : Transmission error
+ */
+static uint8_t PCDNFCT5_WriteBlock(uc16 Block, uc8 *pData, const ISO15693_SYSTEMINFO *pLayout)
+{
+	if (PCDNFCT5_OpenWriteBuffer(Block, pLayout) != PCDNFCT5_OK)
+		return PCDNFCT5_ERROR;
+	if (ISO15693_WriteBufferWrite(&WriteBuffer, pData, ISO15693_NBBYTE_BLOCKLENGTH, Block*ISO15693_NBBYTE_BLOCKLENGTH) != ISO15693_SUCCESSCODE ||
+			ISO15693_WriteBufferClose(&WriteBuffer) != ISO15693_SUCCESSCODE)
+		return PCDNFCT5_ERROR;
+	PCDNFC_WriteStat.NbWritten += WriteBuffer.NbBlockWritten;
+	
+	return PCDNFCT5_OK;
+}
+
+/**
+ * @brief  This function writes the blocks of the TT5Tag buffer marked in the bitmap, except the length block
+ * @brief  Consecutive blocks are written with Write Multiple by the write buffer
+ * @param  NbBlock : number of blocks of the message to write
+ * @param  LengthBlock : block of the NDEF TLV header (written by the caller)
+ * @param  pChanged : bitmap of the blocks to write (bit n of byte n/8 for the block n)
+ * @param  pLayout : memory layout of the tag
+ * @retval PCDNFCT5_OK : Command success
+ * @retval PCDNFCT5_ERROR : Transmission error
+ */
+static uint8_t PCDNFCT5_WriteChangedBlock(uc16 NbBlock, uc16 LengthBlock, uc8 *pChanged, const ISO15693_SYSTEMINFO *pLayout)
+{
+	uint16_t firstBlock, block, lastBlock;
+	bool open;
+	
+	for (firstBlock = 0; firstBlock < NbBlock; firstBlock += ISO15693_WRITEBUFFER_NBBLOCK)
+	{
+		lastBlock = MIN(NbBlock, firstBlock+ISO15693_WRITEBUFFER_NBBLOCK);
+		open = false;
+		for (block = firstBlock; block < lastBlock; block++)
+		{
+			if (block == LengthBlock || (pChanged[block>>3] & (1 << (block&0x07))) == 0x00)
+				continue;
+			if (open == false)
+			{
+				if (PCDNFCT5_OpenWriteBuffer(firstBlock, pLayout) != PCDNFCT5_OK)
+					return PCDNFCT5_ERROR;
+				open = true;
+			}
+			if (ISO15693_WriteBufferWrite(&WriteBuffer, &TT5Tag[block*ISO15693_NBBYTE_BLOCKLENGTH], ISO15693_NBBYTE_BLOCKLENGTH, block*ISO15693_NBBYTE_BLOCKLENGTH) != ISO15693_SUCCESSCODE)
+				return PCDNFCT5_ERROR;
+		}
+		if (open == true)
+		{
+			if (ISO15693_WriteBufferClose(&WriteBuffer) != ISO15693_SUCCESSCODE)
+				return PCDNFCT5_ERROR;
+			PCDNFC_WriteStat.NbWritten += WriteBuffer.NbBlockWritten;
+		}
+	}
+	
+	return PCDNFCT5_OK;
+}
+
+/**
+ * @brief  This function decodes a 4 or 8 bytes capability container
+ * @brief  A 4 bytes CC with CC3 bit2 set (memory above 2 KB) takes the size from Get System Info
+ * @param  pCC : capability container
+ * @param  pInfo : decoded CC
+ * @retval PCDNFCT5_OK : Command success
+ * @retval PCDNFCT5_ERROR : Transmission error
+ * @retval PCDNFCT5_ERROR_NOT_FORMATED : The tag is not NDEF formated
+ */
+static uint8_t PCDNFCT5_ParseCC(uc8 *pCC, PCDNFCT5_CC *pInfo)
+{
+	ISO15693_SYSTEMINFO SysInfo;
+	
+	if (pCC[0] != PCDNFCT5_CC_MAGIC && pCC[0] != PCDNFCT5_CC_MAGIC_EXTENDED)
+		return PCDNFCT5_ERROR_NOT_FORMATED;
+	
+	pInfo->NbByteCC = PCDNFCT5_CCSIZE(pCC);
+	pInfo->Access = pCC[1];
+	pInfo->Flags = 0x00;
+	if (pCC[0] == PCDNFCT5_CC_MAGIC_EXTENDED)
+		pInfo->Flags |= PCDNFC_CC_EXTENDEDCMD;
+	
+	if (pInfo->NbByteCC == PCDNFCT5_NBBYTE_EXTENDEDCC)
+		pInfo->MemorySize = ((pCC[6]<<8)|pCC[7])*8;
+	else if ((pCC[3] & PCDNFCT5_CC_LARGEMEMORY) != 0x00)
+	{
+		// Get_System_Info is only sent if the tag is not already in the cache
+		if (ISO15693_GetCachedSystemInfo (0x00, &SysInfo) != ISO15693_SUCCESSCODE)
+			return PCDNFCT5_ERROR;
+		pInfo->MemorySize = SysInfo.NbBlock*SysInfo.BlockSize;
+	}
+	else
+		pInfo->MemorySize = pCC[2]*8;
+	
+	return PCDNFCT5_OK;
+}
+
+/**
+ * @brief  This function sets the memory layout used to read the tag (the first sector is always read
+ * @brief  with Read Multiple, so the next reads use it too)
+ * @param  pLayout : memory layout
+ * @param  Density : ISO15693_HIGH_DENSITY (protocol extension) or ISO15693_LOW_DENSITY
+ * @param  Flags : PCDNFC_CC_EXTENDEDCMD
+ */
+static void PCDNFCT5_SetLayout(ISO15693_SYSTEMINFO *pLayout, uc8 Density, uc8 Flags)
+{
+	memset(pLayout, 0x00, sizeof(ISO15693_SYSTEMINFO));
+	pLayout->BlockSize = ISO15693_NBBYTE_BLOCKLENGTH;
+	pLayout->Density = Density;
+	pLayout->SupportedCmd = ISO15693_SUPPORT_READMULTIPLE;
+	if ((Flags & PCDNFC_CC_EXTENDEDCMD) != 0x00)
+		pLayout->SupportedCmd |= ISO15693_SUPPORT_EXTENDEDCMD;
+}
+
+/**
+ * @brief  This function reads the first sector (128 bytes) of the tag. The density of a tag found in the
+ * @brief  capability cache is known, otherwise the high density then the low density are tried.
+ * @param  pBuffer : Pointer on the buffer which will contain the data read
+ * @param  pLayout : memory layout to use for the next reads of the tag (density and supported commands)
+ * @retval PCDNFCT5_OK : Command success
+ * @retval PCDNFCT5_ERROR : Transmission error
+ */
+static uint8_t PCDNFCT5_ReadFirstSector(uint8_t *pBuffer, ISO15693_SYSTEMINFO *pLayout)
+{
+	uint8_t UID[ISO15693_NBBYTE_UID];
+	PCDNFC_CCINFO CCInfo;
+	PCDNFCT5_CC CC;
+	
+	// Tag already read : the first sector is read with its density, the CC must not have changed
+	if (ISO15693_GetCurrentUID(UID) == ISO15693_SUCCESSCODE &&
+			PCDNFC_GetCachedCC(TT5, UID, ISO15693_NBBYTE_UID, &CCInfo) == PCDNFC_OK)
+	{
+		PCDNFCT5_SetLayout(pLayout, CCInfo.Density, CCInfo.Flags);
+		if (ISO15693_ReadBlocks(0x00, 0, PCDNFCT5_NBBLOCK_SECTOR, pLayout, pBuffer) == ISO15693_SUCCESSCODE &&
+				PCDNFCT5_ParseCC(pBuffer, &CC) == PCDNFCT5_OK &&
+				CC.NbByteCC == CCInfo.NDEFOffset && CC.MemorySize == CCInfo.MemorySize && CC.Flags == CCInfo.Flags)
+			return PCDNFCT5_OK;
+		PCDNFC_InvalidateCC(TT5, UID, ISO15693_NBBYTE_UID);
+	}
+	
+	// Try to determine the density by reading the first sector (128 bytes)
+	PCDNFCT5_SetLayout(pLayout, ISO15693_HIGH_DENSITY, 0x00);
+	if (ISO15693_ReadBlocks(0x00, 0, PCDNFCT5_NBBLOCK_SECTOR, pLayout, pBuffer) != ISO15693_SUCCESSCODE)
+	{
+		PCDNFCT5_SetLayout(pLayout, ISO15693_LOW_DENSITY, 0x00);
+		if (ISO15693_ReadBlocks(0x00, 0, PCDNFCT5_NBBLOCK_SECTOR, pLayout, pBuffer) != ISO15693_SUCCESSCODE)
+			return PCDNFCT5_ERROR;
+	}
+	
+	// Only the NDEF formatted tags are cached, the next reads use the addressing given by the CC
+	if (PCDNFCT5_ParseCC(pBuffer, &CC) == PCDNFCT5_OK)
+	{
+		PCDNFCT5_SetLayout(pLayout, pLayout->Density, CC.Flags);
+		if (ISO15693_GetCurrentUID(UID) == ISO15693_SUCCESSCODE)
+		{
+			memset(&CCInfo, 0x00, sizeof(CCInfo));
+			CCInfo.TagType = TT5;
+			CCInfo.UIDsize = ISO15693_NBBYTE_UID;
+			memcpy(CCInfo.UID, UID, ISO15693_NBBYTE_UID);
+			CCInfo.MemorySize = CC.MemorySize;
+			CCInfo.NDEFOffset = CC.NbByteCC;
+			CCInfo.Access = CC.Access;
+			CCInfo.Density = pLayout->Density;
+			CCInfo.Flags = CC.Flags;
+			PCDNFC_StoreCC(&CCInfo);
+		}
+	}
+	
+	return PCDNFCT5_OK;
+}
+
+/**
+ * @brief  This function puts the CC of the tag at the beginning of the TT5Tag buffer. A NDEF TLV
+ * @brief  prepared behind a CC of another size is moved behind the CC of the tag.
+ * @param  pCC : CC of the tag (4 or 8 bytes)
+ * @param  BufferCCSize : size of the CC in front of the NDEF TLV prepared in TT5Tag
+ * @retval PCDNFCT5_OK : Command success
+ * @retval PCDNFCT5_ERROR_MEMORY_INTERNAL : The TT5Tag buffer is too small
+ */
+static uint8_t PCDNFCT5_PlaceMessage(uc8 *pCC, uc8 BufferCCSize)
+{
+	uint8_t ccSize = PCDNFCT5_CCSIZE(pCC);
+	uint32_t nbByte;
+	
+	// TLV header, message and terminator TLV
+	if (TT5Tag[BufferCCSize+1] == 0xFF)
+		nbByte = 4 + ((TT5Tag[BufferCCSize+2]<<8)|TT5Tag[BufferCCSize+3]) + 1;
+	else
+		nbByte = 2 + TT5Tag[BufferCCSize+1] + 1;
+	if (MAX(ccSize, BufferCCSize) + nbByte > NFCT5_MAX_TAGMEMORY)
+		return PCDNFCT5_ERROR_MEMORY_INTERNAL;
+	
+	if (ccSize != BufferCCSize)
+		memmove(&TT5Tag[ccSize], &TT5Tag[BufferCCSize], nbByte);
+	memcpy(TT5Tag, pCC, ccSize);
+	
+	return PCDNFCT5_OK;
+}
+
+/**
+ * @brief  This function removes the tag from the capability cache (after an error)
+ */
+static void PCDNFCT5_InvalidateCC(void)
+{
+	uint8_t UID[ISO15693_NBBYTE_UID];
+	
+	if (ISO15693_GetCurrentUID(UID) == ISO15693_SUCCESSCODE)
+		PCDNFC_InvalidateCC(TT5, UID, ISO15693_NBBYTE_UID);
+}
+
 /**
   * @}
   */
@@ -55,55 +298,67 @@ extern uint8_t TT5Tag[];
 
 /**
  * @brief  This function reads the NDEF message from a tag type V and store result in the TT5Tag buffer
+ * @brief  The CC is followed by the NDEF TLV, only the blocks of the TLV are read after the first sector
  * @retval PCDNFCT5_OK : Command success
  * @retval PCDNFCT5_ERROR : Transmission error
  * @retval PCDNFCT5_ERROR_LOCKED : The tag cannot be read (CC lock)
+ * @retval PCDNFCT5_ERROR_NOT_FORMATED : The tag is not NDEF formated
+ * @retval PCDNFCT5_ERROR_MEMORY_INTERNAL : The message does not fit in the TT5Tag buffer
  */
 uint8_t PCDNFCT5_ReadNDEF( void )
 {
-	uint16_t size;
-	uint8_t tagDensity = ISO15693_HIGH_DENSITY;
-	// Try to determine the density by reading the first sector (128 bytes)
-	if (ISO15693_ReadBytesTagData(ISO15693_HIGH_DENSITY, ISO15693_LRiS64K, TT5Tag, 127, 0) != ISO15693_SUCCESSCODE)
-	{
-		if (ISO15693_ReadBytesTagData(ISO15693_LOW_DENSITY, ISO15693_LRiS64K, TT5Tag, 127, 0) != ISO15693_SUCCESSCODE)
-			return PCDNFCT5_ERROR;
-		tagDensity = ISO15693_LOW_DENSITY;
-	}
+	ISO15693_SYSTEMINFO layout;
+	PCDNFCT5_CC CC;
+	uint32_t nbByte;
+	uint16_t nbBlock;
+	uint8_t status;
+	
+	// Read the first sector (the density is found when the tag is not in the capability cache)
+	if (PCDNFCT5_ReadFirstSector(TT5Tag, &layout) != PCDNFCT5_OK)
+		return PCDNFCT5_ERROR;
 	
 	// NDEF capable ?
-	if (TT5Tag[0] != 0xE1)
-		return PCDNFCT5_ERROR_NOT_FORMATED;
+	status = PCDNFCT5_ParseCC(TT5Tag, &CC);
+	if (status != PCDNFCT5_OK)
+		return status;
 	
 	// Check read access
-	if ((TT5Tag[1]&0x0C) != 0)
+	if ((CC.Access&PCDNFCT5_CC_READACCESS_MASK) != 0)
 		return PCDNFCT5_ERROR_LOCKED;
 	
-	// Get the size of the message
-	if (TT5Tag[5] == 0xFF)
-		size = (TT5Tag[6]<<8)|TT5Tag[7];
+	// Get the size of the message (TLV header, message)
+	if (TT5Tag[CC.NbByteCC+1] == 0xFF)
+		nbByte = 4 + ((TT5Tag[CC.NbByteCC+2]<<8)|TT5Tag[CC.NbByteCC+3]);
 	else
-		size = 0x00FF&TT5Tag[5];
+		nbByte = 2 + TT5Tag[CC.NbByteCC+1];
 	
-	// Check if there is enough memory to read the tag
-	// If CC3 bit3 = 1 the size is higher than 2KB but we don't know the size...
-	if (size+7 > NFCT5_MAX_TAGMEMORY)
+	// The message cannot be larger than the memory of the tag
+	if (nbByte > CC.MemorySize)
+		return PCDNFCT5_ERROR;
+	// Check if there is enough memory to read the tag (with the terminator TLV if the message does not fill the tag)
+	nbByte = CC.NbByteCC + MIN(nbByte+1, CC.MemorySize);
+	if (nbByte > NFCT5_MAX_TAGMEMORY)
 		return PCDNFCT5_ERROR_MEMORY_INTERNAL;
 	
-	// Read the rest of the tag if needed
-	if (size > 124)
+	// Read the rest of the message if needed, the read stops at the end of the TLV
+	nbBlock = (nbByte+ISO15693_NBBYTE_BLOCKLENGTH-1)/ISO15693_NBBYTE_BLOCKLENGTH;
+	if (nbBlock > PCDNFCT5_NBBLOCK_SECTOR)
 	{
-		if (ISO15693_ReadBytesTagData(tagDensity, ISO15693_LRiS64K, &TT5Tag[128], size-128, 128) != ISO15693_SUCCESSCODE)
+		if (ISO15693_ReadBlocks(0x00, PCDNFCT5_NBBLOCK_SECTOR, nbBlock-PCDNFCT5_NBBLOCK_SECTOR, &layout, &TT5Tag[PCDNFCT5_NBBYTE_SECTOR]) != ISO15693_SUCCESSCODE)
 		{
+			PCDNFCT5_InvalidateCC();
 			return PCDNFCT5_ERROR;
 		}
 	}
 	
-	return PCDNFCT5_OK;	
+	return PCDNFCT5_OK;
 }
 
 /**
  * @brief  This function writes the NDEF message to a tag type V from the TT5Tag buffer
+ * @brief  The NDEF TLV follows the CC of the buffer (4 bytes if the buffer does not start with a CC),
+ * @brief  it is moved behind the CC of the tag. Tags above 2 KB are formated with a 8 bytes CC.
+ * @brief  Only the blocks which differ from the content of the tag are written
  * @retval PCDNFCT5_OK : Command success
  * @retval PCDNFCT5_ERROR : Transmission error
  * @retval PCDNFCT5_ERROR_LOCKED : The tag cannot be write or read (CC lock)
@@ -111,91 +366,161 @@ uint8_t PCDNFCT5_ReadNDEF( void )
  */
 uint8_t PCDNFCT5_WriteNDEF( void )
 {
-	uint8_t RepBuffer[30];
-	uint8_t firstSector[140], status;
-	uint16_t size, tagSize;
-	uint8_t tagDensity = ISO15693_HIGH_DENSITY;
-	// Try to determine the density by ready the first sector (128 bytes)
-	if (ISO15693_ReadBytesTagData(ISO15693_HIGH_DENSITY, ISO15693_LRiS64K, firstSector, 127, 0) != ISO15693_SUCCESSCODE)
-	{
-		if (ISO15693_ReadBytesTagData(ISO15693_LOW_DENSITY, ISO15693_LRiS64K, firstSector, 127, 0) != ISO15693_SUCCESSCODE)
-			return PCDNFCT5_ERROR;
-		tagDensity = ISO15693_LOW_DENSITY;
-	}
+	ISO15693_SYSTEMINFO SysInfo, layout;
+	PCDNFCT5_CC CC;
+	uint8_t firstSector[PCDNFCT5_NBBYTE_SECTOR], newCC[PCDNFCT5_NBBYTE_EXTENDEDCC], status;
+	uint8_t changed[NFCT5_MAX_TAGMEMORY/(ISO15693_NBBYTE_BLOCKLENGTH*8)+1], header[ISO15693_NBBYTE_BLOCKLENGTH];
+	uint16_t block, nbBlock, lengthBlock, nbChanged = 0;
+	uint32_t size, tagSize, nbByte;
+	uint8_t bufferCCSize;
+	
+	PCDNFC_WriteStat.NbWritten = 0;
+	PCDNFC_WriteStat.NbSaved = 0;
+	// Read the first sector (the density is found when the tag is not in the capability cache)
+	if (PCDNFCT5_ReadFirstSector(firstSector, &layout) != PCDNFCT5_OK)
+		return PCDNFCT5_ERROR;
+	// Size of the CC in front of the message prepared by the application
+	bufferCCSize = PCDNFCT5_NBBYTE_CC;
+	if (TT5Tag[0] == PCDNFCT5_CC_MAGIC || TT5Tag[0] == PCDNFCT5_CC_MAGIC_EXTENDED)
+		bufferCCSize = PCDNFCT5_CCSIZE(TT5Tag);
+	
 	// NDEF capable ?
-	if (firstSector[0] != 0xE1)
+	status = PCDNFCT5_ParseCC(firstSector, &CC);
+	if (status == PCDNFCT5_ERROR)
+		return PCDNFCT5_ERROR;
+	if (status != PCDNFCT5_OK)
 	{
 		/* Create the CC file */
-		// We need the size
-		if (tagDensity == ISO15693_HIGH_DENSITY)
-			ISO15693_GetSystemInfo (0x0A , 0x00, RepBuffer);
-		else
-			ISO15693_GetSystemInfo (0x02 , 0x00, RepBuffer);
-		if (RepBuffer[14] == 0xFF)
-			tagSize = (((RepBuffer[15]<<8)|RepBuffer[14])+1)*(RepBuffer[16]+1);
-		else
-			tagSize = (RepBuffer[14]+1)*(RepBuffer[15]+1);
-		// NDEF capable
-		TT5Tag[0] = 0xE1;
+		// We need the size (Get_System_Info is only sent if the tag is not already in the cache)
+		if (ISO15693_GetCachedSystemInfo (0x00, &SysInfo) != ISO15693_SUCCESSCODE)
+			return PCDNFCT5_ERROR;
+		tagSize = SysInfo.NbBlock*SysInfo.BlockSize;
+		memset(newCC, 0x00, sizeof(newCC));
+		// NDEF capable (2 bytes address when the blocks above 255 cannot be reached with the protocol extension)
+		newCC[0] = (SysInfo.NbBlock > 256 && SysInfo.Density != ISO15693_HIGH_DENSITY)? PCDNFCT5_CC_MAGIC_EXTENDED : PCDNFCT5_CC_MAGIC;
 		// Version + Read/Write allowed
-		TT5Tag[1] = 0x40;
+		newCC[1] = 0x40;
 		// Size
-		if (tagSize > 2040)
+		if (tagSize > PCDNFCT5_CC_MAX_MEMORYSIZE)
 		{
-			// If the size is above 2040 (0xFF) then we have to set the bit3 of CC4
-			TT5Tag[2] = 0xFF;
-			TT5Tag[3] = 0x05;
+			// Above 2040 bytes the size of the data area is given by CC6-CC7 of a 8 bytes CC
+			newCC[2] = 0x00;
+			newCC[6] = GETMSB((tagSize-PCDNFCT5_NBBYTE_EXTENDEDCC)/8);
+			newCC[7] = GETLSB((tagSize-PCDNFCT5_NBBYTE_EXTENDEDCC)/8);
 		}
 		else
-		{
-			TT5Tag[2] = tagSize/8;
-			TT5Tag[3] = 0x01;
-		}
+			newCC[2] = tagSize/8;
+		if ((SysInfo.SupportedCmd & ISO15693_SUPPORT_READMULTIPLE) != 0x00)
+			newCC[3] = PCDNFCT5_CC_MBREAD;
+		if (PCDNFCT5_ParseCC(newCC, &CC) != PCDNFCT5_OK)
+			return PCDNFCT5_ERROR;
+		PCDNFCT5_SetLayout(&layout, layout.Density, CC.Flags);
+		status = PCDNFCT5_PlaceMessage(newCC, bufferCCSize);
 	}
 	else
 	{
-		// Copy the CC
-		memcpy(TT5Tag,firstSector,4);
-		
 		// Check read and write access
-		if ((TT5Tag[1]&0x0F) != 0)
+		if ((CC.Access&PCDNFCT5_CC_ACCESS_MASK) != 0)
 			return PCDNFCT5_ERROR_LOCKED;
+	
+		// Copy the CC
+		status = PCDNFCT5_PlaceMessage(firstSector, bufferCCSize);
 	}
-		
-	// Get the size of the message to write
-	if (TT5Tag[5] == 0xFF)
-		size = (TT5Tag[6]<<8)|TT5Tag[7];
+	if (status != PCDNFCT5_OK)
+		return status;
+	
+	// Get the size of the message to write (TLV header, message)
+	if (TT5Tag[CC.NbByteCC+1] == 0xFF)
+		size = 4 + ((TT5Tag[CC.NbByteCC+2]<<8)|TT5Tag[CC.NbByteCC+3]);
 	else
-		size = 0x00FF&TT5Tag[5];
+		size = 2 + TT5Tag[CC.NbByteCC+1];
 	
 	// Check if the memory available on the tag is enough
-	// If CC3 bit3 = 1 the size is higher than 2KB but we don't know the size...
-	if (TT5Tag[2]*8 < size+7 && (TT5Tag[3]&0x04) == 0)
+	if (size > CC.MemorySize)
 		return PCDNFCT5_ERROR_MEMORY_TAG;
-	if ((TT5Tag[3]&0x04) != 0) // So we use get system info command
+	
+	// CC, TLV header, message and terminator TLV (the terminator is left out when the message fills the tag)
+	nbByte = CC.NbByteCC + MIN(size+1, CC.MemorySize);
+	if (nbByte > NFCT5_MAX_TAGMEMORY)
+		return PCDNFCT5_ERROR_MEMORY_INTERNAL;
+	nbBlock = (nbByte+ISO15693_NBBYTE_BLOCKLENGTH-1)/ISO15693_NBBYTE_BLOCKLENGTH;
+	lengthBlock = CC.NbByteCC/ISO15693_NBBYTE_BLOCKLENGTH;
+	// A whole write is one block more than the message
+	PCDNFC_WriteStat.NbSaved = nbByte/ISO15693_NBBYTE_BLOCKLENGTH+1;
+	
+	// Compare the message with the content of the tag, sector by sector (the first one is already read)
+	memset(changed, 0x00, nbBlock/8+1);
+	for (block = 0; block < nbBlock; block++)
 	{
-		if (tagDensity == ISO15693_HIGH_DENSITY)
-			ISO15693_GetSystemInfo (0x0A , 0x00, RepBuffer);
-		else
-			ISO15693_GetSystemInfo (0x02 , 0x00, RepBuffer);
-		
-		if (RepBuffer[14] == 0xFF)
-			tagSize = (((RepBuffer[15]<<8)|RepBuffer[14])+1)*(RepBuffer[16]+1);
-		else
-			tagSize = (RepBuffer[14]+1)*(RepBuffer[15]+1);
-		
-		if (tagSize < size+7)
-			return PCDNFCT5_ERROR_MEMORY_TAG;
+		if (block%PCDNFCT5_NBBLOCK_SECTOR == 0 && block != 0)
+		{
+			errchk(ISO15693_ReadBlocks(0x00, block, MIN(PCDNFCT5_NBBLOCK_SECTOR, nbBlock-block), &layout, firstSector));
+		}
+		if (memcmp(&firstSector[(block%PCDNFCT5_NBBLOCK_SECTOR)*ISO15693_NBBYTE_BLOCKLENGTH], &TT5Tag[block*ISO15693_NBBYTE_BLOCKLENGTH], ISO15693_NBBYTE_BLOCKLENGTH) != 0)
+		{
+			changed[block>>3] |= 1 << (block&0x07);
+			nbChanged++;
+		}
 	}
+	if (nbChanged == 0)
+		return PCDNFCT5_OK;
 	
-	// Write the tag
-	errchk(ISO15693_WriteBytes_TagData(tagDensity, TT5Tag, size+7, 0));
+	// When several blocks change the length is cleared first and written last,
+	// a tag removed during the write keeps an empty message
+	if (nbChanged > 1)
+	{
+		memcpy(header, &TT5Tag[lengthBlock*ISO15693_NBBYTE_BLOCKLENGTH], ISO15693_NBBYTE_BLOCKLENGTH);
+		if (header[1] == 0xFF)
+			header[2] = header[3] = 0x00;
+		else
+			header[1] = 0x00;
+		errchk(PCDNFCT5_WriteBlock(lengthBlock, header, &layout));
+		changed[lengthBlock>>3] |= 1 << (lengthBlock&0x07);
+	}
+	errchk(PCDNFCT5_WriteChangedBlock(nbBlock, lengthBlock, changed, &layout));
+	if ((changed[lengthBlock>>3] & (1 << (lengthBlock&0x07))) != 0x00)
+	{
+		errchk(PCDNFCT5_WriteBlock(lengthBlock, &TT5Tag[lengthBlock*ISO15693_NBBYTE_BLOCKLENGTH], &layout));
+	}
 	
-	return PCDNFCT5_OK;	
+	PCDNFC_WriteStat.NbSaved -= MIN(PCDNFC_WriteStat.NbWritten, PCDNFC_WriteStat.NbSaved);
+	return PCDNFCT5_OK;
 Error:
+	// The tag may have been removed or replaced, do not trust its cached information anymore
+	PCDNFCT5_InvalidateCC();
+	ISO15693_InvalidateSystemInfo (0x00);
 	return PCDNFCT5_ERROR;
 }
 
+/**
+ * @brief  This function sets the NDEF message of a tag type V read-only (write access of the CC)
+ * @brief  The blocks are not locked, the tag can still be reformated with its own commands
+ * @retval PCDNFCT5_OK : Command success
+ * @retval PCDNFCT5_ERROR : Transmission error
+ * @retval PCDNFCT5_ERROR_NOT_FORMATED : The tag is not NDEF formated
+ */
+uint8_t PCDNFCT5_LockNDEF( void )
+{
+	ISO15693_SYSTEMINFO layout;
+	PCDNFCT5_CC CC;
+	uint8_t firstSector[PCDNFCT5_NBBYTE_SECTOR], status;
+	
+	if (PCDNFCT5_ReadFirstSector(firstSector, &layout) != PCDNFCT5_OK)
+		return PCDNFCT5_ERROR;
+	status = PCDNFCT5_ParseCC(firstSector, &CC);
+	if (status != PCDNFCT5_OK)
+		return status;
+	if ((CC.Access&PCDNFCT5_CC_WRITEACCESS_MASK) == PCDNFCT5_CC_WRITEACCESS_NEVER)
+		return PCDNFCT5_OK;
+	
+	// No write access (CC1)
+	firstSector[1] |= PCDNFCT5_CC_WRITEACCESS_NEVER;
+	status = PCDNFCT5_WriteBlock(0, firstSector, &layout);
+	PCDNFCT5_InvalidateCC();
+	
+	return status;
+}
+
 /**
   * @}
   */ 
@@ -0,0 +1,609 @@
+/**
+  ******************************************************************************
+  * @file    vtag_main.c
+  * @author  MMY Application Team
+  * @version V4.0.0
+  * @date    02/06/2014
+  * @brief   Command line tool : generates a virtual tag population and runs the PCD libraries on it
+  ******************************************************************************
+  * @copyright
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
+  *
+  * Host build (Linux) : make in the VirtualTag directory. The lib_95HF.h of the host (types,
+  * command codes, ST95Mode, tag buffer sizes) is in VirtualTag/host.
+  *
+  * Examples :
+  *   vtag -n 500 -m M24LR64E-R=1 inv15693             500 M24LR64E-R, random UIDs
+  *   vtag -n 200 -u prefix -f 8 -m NTAG213=1 inv14443a  200 NTAG213 sharing all the UID except 8 bits
+  *   vtag -n 100 -e 1000:5000 -r 10 inv14443b           1 ppm = 1e-6 : 0.1% missed frames, 0.5% CRC errors
+  */
+
+/* Includes ------------------------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "drv_95HF_host.h"
+#include "lib_iso15693pcd.h"
+#include "lib_iso14443Apcd.h"
+#include "lib_iso14443Bpcd.h"
+
+/* variables of the application used by the libraries */
+uint8_t							u95HFBuffer [RFTRANS_95HF_MAX_BUFFER_SIZE+3];
+ST95Mode						st95mode = PCD;
+ST95TagType					st95tagtype = UNDEFINED_TAG_TYPE;
+
+#define VTAG_CLI_MAX_ROUND							64				// calls of the anticollision
+#define VTAG_CLI_MAX_IDLEROUND					3					// ISO15693 : calls without new tag before the end
+#define VTAG_CLI_MAX_RECORD							255
+/* records of ISO15693_RunAntiCollision : 16 tags per inventory 16 slots, 0x20 inventories */
+#define VTAG_CLI_MAX_INVENTORY					(16*0x20+1)
+
+#define VTAG_CLI_CMD_LIST								0
+#define VTAG_CLI_CMD_DUMP								1
+#define VTAG_CLI_CMD_INV15693						2
+#define VTAG_CLI_CMD_READ15693					3
+#define VTAG_CLI_CMD_INV14443A					4
+#define VTAG_CLI_CMD_INV14443B					5
+#define VTAG_CLI_CMD_INVREAD15693				6
+
+typedef struct {
+	uint16_t		NbFound;
+	uint16_t		NbDuplicate;
+	uint16_t		NbUnknown;					// UID of no tag (corrupted reply)
+	uint16_t		NbExpected;
+	uint16_t		NbRound;
+	uint8_t			Status;							// last status of the library
+	uint16_t		NbReadOk;						// read15693, invread15693 : tags read and checked
+	uint16_t		NbReadError;
+	uint16_t		NbReadMismatch;
+}VTAG_CLI_RESULT;
+
+static VTAG_POPULATION	Population;
+static VTAG_TAG					Tag[VTAG_MAX_NBTAG];
+static uint8_t					Memory[VTAG_MAX_NBTAG*VTAG_MAX_MEMORY_SIZE];
+static bool							Found[VTAG_MAX_NBTAG];
+static uint8_t					Inventory[VTAG_MAX_NBTAG*ISO15693_NBBYTE_INVENTORYRECORD];
+static uint8_t					RoundInventory[VTAG_CLI_MAX_INVENTORY*ISO15693_NBBYTE_INVENTORYRECORD];
+static uint8_t					ReadData[VTAG_CLI_MAX_RECORD*ISO15693_BULKREAD_NBBLOCKPERREAD*ISO15693_NBBYTE_BLOCKLENGTH*8];
+static ISO15693_BULKREADRESULT	ReadResult[VTAG_CLI_MAX_RECORD];
+static ISO14443A_TAGRECORD			RecordA[VTAG_CLI_MAX_RECORD];
+static ISO14443B_TAGRECORD			RecordB[VTAG_CLI_MAX_RECORD];
+
+static void VTAG_CLI_Usage 							( void);
+static bool VTAG_CLI_ParsePair 					( const char *pArg, uint32_t *pFirst, uint32_t *pSecond);
+static bool VTAG_CLI_ParseModel 				( const char *pArg, VTAG_CONFIG *pConfig, bool *pFirstModel);
+static void VTAG_CLI_List 							( void);
+static void VTAG_CLI_Dump 							( uc16 NthTag);
+static void VTAG_CLI_Found 							( VTAG_CLI_RESULT *pResult, uc8 Protocol, uc8 *pUID, uc8 UIDsize);
+static uint16_t VTAG_CLI_Inventory15693 ( VTAG_CLI_RESULT *pResult);
+static void VTAG_CLI_Read15693 					( VTAG_CLI_RESULT *pResult, uc16 NbTag, uc16 FirstBlock, uc16 NbBlock);
+static void VTAG_CLI_CheckRead 					( VTAG_CLI_RESULT *pResult, uc8 Status, uc8 *pUID, uc8 *pData, uc16 FirstBlock, uc16 NbBlock);
+static void VTAG_CLI_InventoryRead15693 ( VTAG_CLI_RESULT *pResult, uc8 FirstBlock, uc8 NbBlock);
+static void VTAG_CLI_Inventory14443A 		( VTAG_CLI_RESULT *pResult);
+static void VTAG_CLI_Inventory14443B 		( VTAG_CLI_RESULT *pResult);
+static void VTAG_CLI_Report 						( const VTAG_CLI_RESULT *pResult, uc8 Command, uc32 Run);
+
+/** @addtogroup _VirtualTag_Libraries
+ * 	@{
+ */
+
+/** @addtogroup vtag_main
+ * 	@{
+ *	@brief  Command line tool of the virtual tag populations : it lists the tags generated or runs the
+ *					anticollision (and the bulk read of ISO15693) of the PCD libraries on them, then reports the
+ *					tags found, missing or duplicated, the frames, the collisions and the virtual time.
+ */
+
+/**
+ * @brief  This function prints the options and the commands
+ * @param  None
+ * @retval None
+ */
+static void VTAG_CLI_Usage (void)
+{
+	uint8_t Model;
+
+	printf("usage : vtag [options] <command>\n"
+				 "options :\n"
+				 "  -s <seed>              seed of the population (1)\n"
+				 "  -n <count>             number of tags, 1 to %u (16)\n"
+				 "  -m <model>=<weight>    share of a model, the models not given are not generated (all 1)\n"
+				 "  -u random|seq|prefix   UID distribution (random)\n"
+				 "  -f <bits>              prefix : bits of the serial number which differ (8)\n"
+				 "  -a 4|7|10              ISO14443A UID size (7)\n"
+				 "  -l <min>:<max>         NDEF message length (16:64)\n"
+				 "  -d <min>:<max>         reply delay of each tag in us (0:0)\n"
+				 "  -e <noreply>:<crc>     error rates in ppm (0:0)\n"
+				 "  -w <ppm>:<factor>      share of weak tags and factor of their error rates (0:10)\n"
+				 "  -r <runs>              runs of the command, field seed changed for each run (1)\n"
+				 "  -b <first>:<count>     read15693, invread15693 : blocks read (0:8)\n"
+				 "commands :\n"
+				 "  list | dump <tag> | inv15693 | read15693 | invread15693 | inv14443a | inv14443b\n"
+				 "models :", VTAG_MAX_NBTAG);
+	for (Model = 0; Model < VTAG_NB_MODEL; Model++)
+		printf(" %s", VTAG_Model[Model].pName);
+	printf("\n");
+}
+
+/**
+ * @brief  This function parses a "<first>:<second>" option
+ * @param  pArg : option
+ * @param  pFirst : first value
+ * @param  pSecond : second value
+ * @retval true : option parsed
+ */
+static bool VTAG_CLI_ParsePair (const char *pArg, uint32_t *pFirst, uint32_t *pSecond)
+{
+	char *pEnd;
+
+	*pFirst = strtoul(pArg, &pEnd, 0);
+	if (*pEnd != ':')
+		return false;
+	*pSecond = strtoul(pEnd + 1, &pEnd, 0);
+	return (*pEnd == '\0');
+}
+
+/**
+ * @brief  This function parses a "<model>=<weight>" option
+ * @param  pArg : option
+ * @param  pConfig : configuration
+ * @param  pFirstModel : true before the first model option (the other weights are cleared)
+ * @retval true : option parsed
+ */
+static bool VTAG_CLI_ParseModel (const char *pArg, VTAG_CONFIG *pConfig, bool *pFirstModel)
+{
+	const char *pWeight = strchr(pArg, '=');
+	uint8_t Model;
+
+	if (pWeight == 0x00)
+		return false;
+	for (Model = 0; Model < VTAG_NB_MODEL; Model++)
+		if (strlen(VTAG_Model[Model].pName) == (size_t)(pWeight - pArg) &&
+				strncmp(VTAG_Model[Model].pName, pArg, pWeight - pArg) == 0)
+			break;
+	if (Model == VTAG_NB_MODEL)
+		return false;
+
+	if (*pFirstModel == true)
+	{
+		memset(pConfig->ModelWeight, 0x00, sizeof(pConfig->ModelWeight));
+		*pFirstModel = false;
+	}
+	pConfig->ModelWeight[Model] = (uint16_t)atoi(pWeight + 1);
+	return true;
+}
+
+/**
+ * @brief  This function prints the tags of the population
+ * @param  None
+ * @retval None
+ */
+static void VTAG_CLI_List (void)
+{
+	uint16_t NthTag;
+	uint8_t NthByte;
+
+	for (NthTag = 0; NthTag < Population.NbTag; NthTag++)
+	{
+		printf("%4u %-12s ", NthTag, VTAG_Model[Tag[NthTag].Model].pName);
+		/* UID as printed by the readers : MSB first for ISO15693 */
+		for (NthByte = 0; NthByte < Tag[NthTag].UIDsize; NthByte++)
+			printf("%02X", Tag[NthTag].Kind == VTAG_KIND_ISO15693 ? Tag[NthTag].UID[Tag[NthTag].UIDsize - 1 - NthByte] : Tag[NthTag].UID[NthByte]);
+		printf("%*s ndef %4u delay %4u us noreply %6u ppm crc %6u ppm\n", 2*(VTAG_MAX_UID_SIZE - Tag[NthTag].UIDsize), "",
+					 Tag[NthTag].NdefLength, Tag[NthTag].ReplyDelay_us, Tag[NthTag].NoReplyPpm, Tag[NthTag].CRCErrorPpm);
+	}
+}
+
+/**
+ * @brief  This function prints the memory of a tag
+ * @param  NthTag : index of the tag
+ * @retval None
+ */
+static void VTAG_CLI_Dump (uc16 NthTag)
+{
+	uint16_t NthByte;
+
+	for (NthByte = 0; NthByte < Tag[NthTag].MemorySize; NthByte++)
+	{
+		if (NthByte % 16 == 0)
+			printf("%s%04X:", (NthByte != 0) ? "\n" : "", NthByte);
+		printf(" %02X", Tag[NthTag].pMemory[NthByte]);
+	}
+	printf("\n");
+}
+
+/**
+ * @brief  This function checks a UID found by a library against the population
+ * @param  pResult : result of the run
+ * @param  Protocol : PCD_PROTOCOL_xxx
+ * @param  pUID : UID found
+ * @param  UIDsize : size of the UID
+ * @retval None
+ */
+static void VTAG_CLI_Found (VTAG_CLI_RESULT *pResult, uc8 Protocol, uc8 *pUID, uc8 UIDsize)
+{
+	int16_t NthTag = VTAG_FindTag(&Population, Protocol, pUID, UIDsize);
+
+	if (NthTag < 0)
+		pResult->NbUnknown++;
+	else if (Found[NthTag] == true)
+		pResult->NbDuplicate++;
+	else
+	{
+		Found[NthTag] = true;
+		pResult->NbFound++;
+	}
+}
+
+/**
+ * @brief  This function runs ISO15693_RunAntiCollision until no new tag answers (the tags found stay quiet)
+ * @param  pResult : result of the run
+ * @retval number of records of Inventory
+ */
+static uint16_t VTAG_CLI_Inventory15693 (VTAG_CLI_RESULT *pResult)
+{
+	uint16_t NbRecord = 0, NthRecord, NbIdleRound = 0;
+	uint8_t NbTag;
+
+	pResult->NbExpected = Population.NbTagKind[VTAG_KIND_ISO15693];
+	pResult->Status = ISO15693_Init();
+	if (pResult->Status != ISO15693_SUCCESSCODE)
+		return 0;
+
+	while (NbIdleRound < VTAG_CLI_MAX_IDLEROUND && pResult->NbRound < VTAG_CLI_MAX_ROUND*VTAG_CLI_MAX_IDLEROUND)
+	{
+		pResult->NbRound++;
+		pResult->Status = ISO15693_RunAntiCollision(0x26, 0x00, &NbTag, RoundInventory);
+		if (pResult->Status != ISO15693_SUCCESSCODE || NbTag == 0)
+		{
+			NbIdleRound++;
+			continue;
+		}
+		NbIdleRound = 0;
+		for (NthRecord = 0; NthRecord < NbTag; NthRecord++)
+		{
+			VTAG_CLI_Found(pResult, PCD_PROTOCOL_ISO15693, &RoundInventory[NthRecord*ISO15693_NBBYTE_INVENTORYRECORD + 1], ISO15693_NBBYTE_UID);
+			if (NbRecord < VTAG_MAX_NBTAG)
+				memcpy(&Inventory[(NbRecord++)*ISO15693_NBBYTE_INVENTORYRECORD], &RoundInventory[NthRecord*ISO15693_NBBYTE_INVENTORYRECORD],
+							 ISO15693_NBBYTE_INVENTORYRECORD);
+		}
+	}
+
+	return NbRecord;
+}
+
+/**
+ * @brief  This function reads the tags inventoried with ISO15693_BulkRead and checks the data read
+ * @param  pResult : result of the run
+ * @param  NbTag : number of records of Inventory
+ * @param  FirstBlock : first block read
+ * @param  NbBlock : number of blocks read on each tag
+ * @retval None
+ */
+static void VTAG_CLI_Read15693 (VTAG_CLI_RESULT *pResult, uc16 NbTag, uc16 FirstBlock, uc16 NbBlock)
+{
+	uint16_t NthTag = 0, NbBatch, NthRecord;
+	uint32_t Length = (uint32_t)NbBlock*ISO15693_NBBYTE_BLOCKLENGTH;
+
+	while (NthTag < NbTag)
+	{
+		NbBatch = MIN(NbTag - NthTag, VTAG_CLI_MAX_RECORD);
+		ISO15693_BulkRead(&Inventory[NthTag*ISO15693_NBBYTE_INVENTORYRECORD], (uint8_t)NbBatch, FirstBlock, NbBlock, 0x00, ReadData, ReadResult, 0x00);
+		for (NthRecord = 0; NthRecord < NbBatch; NthRecord++)
+			VTAG_CLI_CheckRead(pResult, ReadResult[NthRecord].Status, ReadResult[NthRecord].UID, &ReadData[NthRecord*Length], FirstBlock, NbBlock);
+		NthTag += NbBatch;
+	}
+}
+
+/**
+ * @brief  This function compares the blocks read in a tag with the memory of the tag
+ * @param  pResult : result of the run
+ * @param  Status : status of the read
+ * @param  pUID : UID of the tag read
+ * @param  pData : blocks read
+ * @param  FirstBlock : first block read
+ * @param  NbBlock : number of blocks read
+ * @retval None
+ */
+static void VTAG_CLI_CheckRead (VTAG_CLI_RESULT *pResult, uc8 Status, uc8 *pUID, uc8 *pData, uc16 FirstBlock, uc16 NbBlock)
+{
+	int16_t Index = VTAG_FindTag(&Population, PCD_PROTOCOL_ISO15693, pUID, ISO15693_NBBYTE_UID);
+
+	if (Status != ISO15693_SUCCESSCODE || Index < 0)
+		pResult->NbReadError++;
+	else if (memcmp(pData, &Tag[Index].pMemory[FirstBlock*ISO15693_NBBYTE_BLOCKLENGTH], NbBlock*ISO15693_NBBYTE_BLOCKLENGTH) != 0)
+		pResult->NbReadMismatch++;
+	else
+		pResult->NbReadOk++;
+}
+
+/**
+ * @brief  This function runs ISO15693_RunInventoryRead until no new tag answers and checks the data read
+ * @param  pResult : result of the run
+ * @param  FirstBlock : first block read
+ * @param  NbBlock : number of blocks read on each tag
+ * @retval None
+ */
+static void VTAG_CLI_InventoryRead15693 (VTAG_CLI_RESULT *pResult, uc8 FirstBlock, uc8 NbBlock)
+{
+	uint16_t NthRecord, NbIdleRound = 0, RecordLength = ISO15693_NBBYTE_INVENTORYREADRECORD(NbBlock);
+	uint8_t NbTag, *pRecord;
+
+	pResult->NbExpected = Population.NbTagKind[VTAG_KIND_ISO15693];
+	pResult->Status = ISO15693_Init();
+	if (pResult->Status != ISO15693_SUCCESSCODE)
+		return;
+
+	while (NbIdleRound < VTAG_CLI_MAX_IDLEROUND && pResult->NbRound < VTAG_CLI_MAX_ROUND*VTAG_CLI_MAX_IDLEROUND)
+	{
+		pResult->NbRound++;
+		pResult->Status = ISO15693_RunInventoryRead(0x26, 0x00, 0x00, FirstBlock, NbBlock, &NbTag, ReadData);
+		if (NbTag == 0)
+		{
+			NbIdleRound++;
+			continue;
+		}
+		NbIdleRound = 0;
+		for (NthRecord = 0, pRecord = ReadData; NthRecord < NbTag; NthRecord++, pRecord += RecordLength)
+		{
+			VTAG_CLI_Found(pResult, PCD_PROTOCOL_ISO15693, &pRecord[ISO15693_NBBYTE_DSFID], ISO15693_NBBYTE_UID);
+			VTAG_CLI_CheckRead(pResult, pRecord[ISO15693_INVENTORYREADOFFSET_STATUS], &pRecord[ISO15693_NBBYTE_DSFID],
+												 &pRecord[ISO15693_INVENTORYREADOFFSET_DATA], FirstBlock, NbBlock);
+		}
+	}
+}
+
+/**
+ * @brief  This function runs ISO14443A_MultiTagAnticollision while the records are full
+ * @param  pResult : result of the run
+ * @retval None
+ */
+static void VTAG_CLI_Inventory14443A (VTAG_CLI_RESULT *pResult)
+{
+	uint8_t NbTag, NthRecord;
+
+	pResult->NbExpected = Population.NbTagKind[VTAG_KIND_T2] + Population.NbTagKind[VTAG_KIND_T4A];
+	pResult->Status = ISO14443A_Init();
+	if (pResult->Status != ISO14443A_SUCCESSCODE)
+		return;
+
+	do
+	{
+		pResult->NbRound++;
+		pResult->Status = ISO14443A_MultiTagAnticollision(RecordA, VTAG_CLI_MAX_RECORD, &NbTag);
+		for (NthRecord = 0; NthRecord < NbTag; NthRecord++)
+			VTAG_CLI_Found(pResult, PCD_PROTOCOL_ISO14443A, RecordA[NthRecord].UID, RecordA[NthRecord].UIDsize);
+	}while (pResult->Status == ISO14443A_ERRORCODE_TAGOVERFLOW && pResult->NbRound < VTAG_CLI_MAX_ROUND);
+}
+
+/**
+ * @brief  This function runs ISO14443B_MultiTagAnticollision while the records are full
+ * @param  pResult : result of the run
+ * @retval None
+ */
+static void VTAG_CLI_Inventory14443B (VTAG_CLI_RESULT *pResult)
+{
+	uint8_t NbTag, NthRecord;
+
+	pResult->NbExpected = Population.NbTagKind[VTAG_KIND_T4B];
+	pResult->Status = ISO14443B_Init();
+	if (pResult->Status != ISO14443B_SUCCESSCODE)
+		return;
+
+	do
+	{
+		pResult->NbRound++;
+		pResult->Status = ISO14443B_MultiTagAnticollision(RecordB, VTAG_CLI_MAX_RECORD, &NbTag);
+		for (NthRecord = 0; NthRecord < NbTag; NthRecord++)
+			VTAG_CLI_Found(pResult, PCD_PROTOCOL_ISO14443B, RecordB[NthRecord].PUPI, ISO14443B_MAX_PUPI_SIZE);
+	}while (pResult->Status == ISO14443B_ERRORCODE_TAGOVERFLOW && pResult->NbRound < VTAG_CLI_MAX_ROUND);
+}
+
+/**
+ * @brief  This function prints the result of a run
+ * @param  pResult : result of the run
+ * @param  Command : VTAG_CLI_CMD_xxx
+ * @param  Run : index of the run
+ * @retval None
+ */
+static void VTAG_CLI_Report (const VTAG_CLI_RESULT *pResult, uc8 Command, uc32 Run)
+{
+	const VTAG_STAT *pStat = &Population.Stat;
+	double Time_ms = Population.Time_us / 1000.0;
+
+	printf("run %u : found %u/%u missing %u duplicate %u unknown %u rounds %u status 0x%02X\n", Run,
+				 pResult->NbFound, pResult->NbExpected, pResult->NbExpected - pResult->NbFound, pResult->NbDuplicate,
+				 pResult->NbUnknown, pResult->NbRound, pResult->Status);
+	if (Command == VTAG_CLI_CMD_READ15693 || Command == VTAG_CLI_CMD_INVREAD15693)
+		printf("        read ok %u error %u mismatch %u\n", pResult->NbReadOk, pResult->NbReadError, pResult->NbReadMismatch);
+	printf("        commands %u frames %u timeouts %u collisions %u injected errors %u\n",
+				 pStat->NbCommand, pStat->NbFrame, pStat->NbTimeOut, pStat->NbCollision, pStat->NbInjectedError);
+	printf("        time %.1f ms (air %.1f ms) %.1f tags/s\n", Time_ms, pStat->AirTime_us / 1000.0,
+				 (Time_ms > 0) ? pResult->NbFound * 1000.0 / Time_ms : 0.0);
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+ * @brief  Main program : parses the options, generates the population and runs the command
+ * @param  argc : number of arguments
+ * @param  argv : arguments
+ * @retval 0 : success
+ */
+int main (int argc, char *argv[])
+{
+	VTAG_CONFIG Config;
+	VTAG_CLI_RESULT Result;
+	uint32_t First, Second, Run, NbRun = 1, FirstBlock = 0, NbBlock = 8;
+	uint16_t NbRecord;
+	uint8_t Command;
+	bool FirstModel = true;
+	int NthArg;
+	int8_t Status;
+
+	VTAG_DefaultConfig(&Config);
+
+	for (NthArg = 1; NthArg < argc - 1 && argv[NthArg][0] == '-'; NthArg += 2)
+	{
+		const char *pValue = argv[NthArg + 1];
+
+		switch (argv[NthArg][1])
+		{
+			case 's': Config.Seed = strtoul(pValue, 0x00, 0); break;
+			case 'n': Config.NbTag = (uint16_t)atoi(pValue); break;
+			case 'f': Config.NbFreeBit = (uint8_t)atoi(pValue); break;
+			case 'a': Config.UIDSizeA = (uint8_t)atoi(pValue); break;
+			case 'r': NbRun = strtoul(pValue, 0x00, 0); break;
+			case 'm':
+				if (VTAG_CLI_ParseModel(pValue, &Config, &FirstModel) == false)
+					goto Usage;
+				break;
+			case 'u':
+				if (strcmp(pValue, "random") == 0)
+					Config.UIDDist = VTAG_UIDDIST_RANDOM;
+				else if (strcmp(pValue, "seq") == 0)
+					Config.UIDDist = VTAG_UIDDIST_SEQUENTIAL;
+				else if (strcmp(pValue, "prefix") == 0)
+					Config.UIDDist = VTAG_UIDDIST_SHAREDPREFIX;
+				else
+					goto Usage;
+				break;
+			case 'l':
+			case 'd':
+			case 'e':
+			case 'w':
+			case 'b':
+				if (VTAG_CLI_ParsePair(pValue, &First, &Second) == false)
+					goto Usage;
+				if (argv[NthArg][1] == 'l')
+				{
+					Config.NdefMinLength = (uint16_t)First;
+					Config.NdefMaxLength = (uint16_t)Second;
+				}
+				else if (argv[NthArg][1] == 'd')
+				{
+					Config.ReplyDelayMin_us = (uint16_t)First;
+					Config.ReplyDelayMax_us = (uint16_t)Second;
+				}
+				else if (argv[NthArg][1] == 'e')
+				{
+					Config.NoReplyPpm = First;
+					Config.CRCErrorPpm = Second;
+				}
+				else if (argv[NthArg][1] == 'w')
+				{
+					Config.WeakTagPpm = First;
+					Config.WeakFactor = (uint8_t)Second;
+				}
+				else
+				{
+					FirstBlock = First;
+					NbBlock = Second;
+				}
+				break;
+			default:
+				goto Usage;
+		}
+	}
+	if (NthArg >= argc)
+		goto Usage;
+
+	if (strcmp(argv[NthArg], "list") == 0)
+		Command = VTAG_CLI_CMD_LIST;
+	else if (strcmp(argv[NthArg], "dump") == 0 && NthArg + 1 < argc)
+		Command = VTAG_CLI_CMD_DUMP;
+	else if (strcmp(argv[NthArg], "inv15693") == 0)
+		Command = VTAG_CLI_CMD_INV15693;
+	else if (strcmp(argv[NthArg], "read15693") == 0)
+		Command = VTAG_CLI_CMD_READ15693;
+	else if (strcmp(argv[NthArg], "invread15693") == 0)
+		Command = VTAG_CLI_CMD_INVREAD15693;
+	else if (strcmp(argv[NthArg], "inv14443a") == 0)
+		Command = VTAG_CLI_CMD_INV14443A;
+	else if (strcmp(argv[NthArg], "inv14443b") == 0)
+		Command = VTAG_CLI_CMD_INV14443B;
+	else
+		goto Usage;
+	if (NbBlock == 0 || NbBlock > ISO15693_BULKREAD_NBBLOCKPERREAD*8)
+		goto Usage;
+	if (Command == VTAG_CLI_CMD_INVREAD15693 && (NbBlock > ISO15693_INVENTORYREAD_MAXNBBLOCK || FirstBlock + NbBlock > 0x100))
+		goto Usage;
+
+	Status = VTAG_Generate(&Config, Tag, Memory, sizeof(Memory), &Population);
+	if (Status != VTAG_SUCCESSCODE)
+	{
+		fprintf(stderr, "vtag : population not generated (0x%02X)\n", (uint8_t)Status);
+		return 1;
+	}
+	printf("seed %u : %u tags (ISO15693 %u, Type 2 %u, Type 4A %u, Type 4B %u)\n", Config.Seed, Population.NbTag,
+				 Population.NbTagKind[VTAG_KIND_ISO15693], Population.NbTagKind[VTAG_KIND_T2],
+				 Population.NbTagKind[VTAG_KIND_T4A], Population.NbTagKind[VTAG_KIND_T4B]);
+
+	if (Command == VTAG_CLI_CMD_LIST)
+	{
+		VTAG_CLI_List();
+		return 0;
+	}
+	if (Command == VTAG_CLI_CMD_DUMP)
+	{
+		if ((uint32_t)atoi(argv[NthArg + 1]) >= Population.NbTag)
+			goto Usage;
+		VTAG_CLI_Dump((uint16_t)atoi(argv[NthArg + 1]));
+		return 0;
+	}
+
+	drv95HF_HostAttach(&Population);
+	ISO15693_GetTick_ms = drv95HF_HostGetTick_ms;
+
+	for (Run = 0; Run < NbRun; Run++)
+	{
+		/* each run starts with the field off, the errors are drawn again */
+		VTAG_FieldOff(&Population);
+		VTAG_SetFieldSeed(&Population, Config.Seed + Run);
+		memset(&Population.Stat, 0x00, sizeof(VTAG_STAT));
+		Population.Time_us = 0;
+		memset(Found, 0x00, sizeof(Found));
+		memset(&Result, 0x00, sizeof(Result));
+
+		switch (Command)
+		{
+			case VTAG_CLI_CMD_INV15693:
+			case VTAG_CLI_CMD_READ15693:
+				NbRecord = VTAG_CLI_Inventory15693(&Result);
+				if (Command == VTAG_CLI_CMD_READ15693)
+					VTAG_CLI_Read15693(&Result, NbRecord, (uint16_t)FirstBlock, (uint16_t)NbBlock);
+				break;
+			case VTAG_CLI_CMD_INVREAD15693:
+				VTAG_CLI_InventoryRead15693(&Result, (uint8_t)FirstBlock, (uint8_t)NbBlock);
+				break;
+			case VTAG_CLI_CMD_INV14443A:
+				VTAG_CLI_Inventory14443A(&Result);
+				break;
+			default:
+				VTAG_CLI_Inventory14443B(&Result);
+				break;
+		}
+		VTAG_CLI_Report(&Result, Command, Run);
+	}
+	return 0;
+
+Usage:
+	VTAG_CLI_Usage();
+	return 1;
+}
+
+/******************* (C) COPYRIGHT 2014 STMicroelectronics *****END OF FILE****/
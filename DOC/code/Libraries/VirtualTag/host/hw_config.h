@@ -0,0 +1,34 @@
+/**
+  ******************************************************************************
+  * @file    hw_config.h
+  * @author  MMY Application Team
+  * @version V4.0.0
+  * @date    02/06/2014
+  * @brief   Host stand-in of the hardware configuration : no pin nor peripheral, the delays of the
+  * @brief   board run on the virtual time of the host driver (drv_95HF_host.c)
+  ******************************************************************************
+  * @copyright
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __HW_CONFIG_H
+#define __HW_CONFIG_H
+
+#include <stdint.h>
+
+void delay_ms														( uint16_t delay);
+void delay_us														( uint16_t delay);
+void delayHighPriority_ms								( uint16_t delay);
+
+#endif /* __HW_CONFIG_H */
+
+/******************* (C) COPYRIGHT 2014 STMicroelectronics *****END OF FILE****/
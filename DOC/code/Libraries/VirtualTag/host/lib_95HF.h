@@ -0,0 +1,86 @@
+/**
+  ******************************************************************************
+  * @file    lib_95HF.h
+  * @author  MMY Application Team
+  * @version V4.0.0
+  * @date    02/06/2014
+  * @brief   Host stand-in of the board configuration of the 95HF libraries (VirtualTag build)
+  ******************************************************************************
+  * @copyright
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LIB_95HF_H
+#define __LIB_95HF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* types of the MCU library ---------------------------------------------------*/
+typedef const uint8_t 	uc8;
+typedef const uint16_t 	uc16;
+typedef const uint32_t 	uc32;
+typedef uint8_t 				u8;
+typedef uint16_t 				u16;
+typedef uint32_t 				u32;
+
+/* peripherals of the board (not used by the host driver) */
+typedef struct { int Unused; } SPI_TypeDef;
+typedef struct { int Unused; } USART_TypeDef;
+typedef int FlagStatus;
+typedef int FunctionalState;
+
+/* command codes of the 95HF devices ------------------------------------------*/
+#define IDN																				0x01
+#define PROTOCOL_SELECT														0x02
+#define POLLFIELD																	0x03
+#define SEND_RECEIVE															0x04
+#define LISTEN																		0x05
+#define SEND																			0x06
+#define IDLE																			0x07
+#define READ_REGISTER															0x08
+#define WRITE_REGISTER														0x09
+#define BAUD_RATE																	0x0A
+#define ECHO																			0x55
+
+/* result codes --------------------------------------------------------------*/
+#define IDLE_RESULTSCODE_OK												0x00
+#define IDLE_ERRORCODE_LENGTH											0x82
+#define READREG_RESULTSCODE_OK										0x00
+#define READREG_ERRORCODE_LENGTH									0x82
+#define WRITEREG_RESULTSCODE_OK										0x00
+#define BAUDRATE_LENGTH														0x01
+
+/* tag buffers of the NFC Forum libraries (bytes) ---------------------------*/
+#ifndef NFCT2_MAX_TAGMEMORY
+#define NFCT2_MAX_TAGMEMORY												1024
+#endif
+#ifndef NFCT3_MAX_TAGMEMORY
+#define NFCT3_MAX_TAGMEMORY												1024
+#endif
+#ifndef NFCT4_MAX_NDEFMEMORY
+#define NFCT4_MAX_NDEFMEMORY											1024
+#endif
+#ifndef NFCT5_MAX_TAGMEMORY
+#define NFCT5_MAX_TAGMEMORY												8192
+#endif
+
+#include "drv_95HF.h"
+#include "miscellaneous.h"
+
+typedef enum {UNDEFINED_MODE=0,PICC,PCD}ST95Mode;
+typedef enum {UNDEFINED_TAG_TYPE=0,TT1,TT2,TT3,TT4A,TT4B,TT5}ST95TagType;
+
+#endif /* __LIB_95HF_H */
+
+/******************* (C) COPYRIGHT 2014 STMicroelectronics *****END OF FILE****/
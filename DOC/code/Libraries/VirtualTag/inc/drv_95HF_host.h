@@ -0,0 +1,34 @@
+/**
+  ******************************************************************************
+  * @file    drv_95HF_host.h
+  * @author  MMY Application Team
+  * @version V4.0.0
+  * @date    02/06/2014
+  * @brief   Host stand-in of the 95HF driver : the commands are answered by a virtual tag population
+  ******************************************************************************
+  * @copyright
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __DRV_95HF_HOST_H
+#define __DRV_95HF_HOST_H
+
+#include "lib_vtag.h"
+
+/* ---------------------------------------------------------------------------------
+ * --- Local Functions
+ * --------------------------------------------------------------------------------- */
+void drv95HF_HostAttach									( VTAG_POPULATION *pPopulation);
+uint32_t drv95HF_HostGetTick_ms					( void);
+
+#endif /* __DRV_95HF_HOST_H */
+
+/******************* (C) COPYRIGHT 2014 STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,198 @@
+/**
+  ******************************************************************************
+  * @file    lib_vtag.h
+  * @author  MMY Application Team
+  * @version V4.0.0
+  * @date    02/06/2014
+  * @brief   Virtual tag populations answering in place of the RF field (host side)
+  ******************************************************************************
+  * @copyright
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LIB_VTAG_H
+#define __LIB_VTAG_H
+
+#include "lib_PCD.h"
+
+/* success and error code --------------------------------------------------------------------- */
+#define VTAG_SUCCESSCODE												RESULTOK
+#define VTAG_ERRORCODE_DEFAULT									0xD8
+#define VTAG_ERRORCODE_PARAMETER								0xD9
+#define VTAG_ERRORCODE_MEMORY										0xDA		// the tag memory given to VTAG_Generate is too small
+#define VTAG_ERRORCODE_UIDSPACE									0xDB		// not enough distinct UIDs for the distribution
+
+#ifndef VTAG_MAX_NBTAG
+	#define VTAG_MAX_NBTAG												1000
+#endif
+#define VTAG_MAX_UID_SIZE												10
+#define VTAG_PPM																1000000UL
+
+/* tag models --------------------------------------------------------------------------------- */
+#define VTAG_MODEL_M24LR64R											0
+#define VTAG_MODEL_M24LR64ER										1
+#define VTAG_MODEL_M24LR16ER										2
+#define VTAG_MODEL_M24LR04ER										3
+#define VTAG_MODEL_LRIS64K											4
+#define VTAG_MODEL_LRIS2K												5
+#define VTAG_MODEL_LRI2K												6
+#define VTAG_MODEL_LRI1K												7
+#define VTAG_MODEL_ULTRALIGHT										8
+#define VTAG_MODEL_NTAG213											9
+#define VTAG_MODEL_NTAG215											10
+#define VTAG_MODEL_NTAG216											11
+#define VTAG_MODEL_M24SR04											12
+#define VTAG_MODEL_M24SR64											13
+#define VTAG_MODEL_T4B													14
+#define VTAG_NB_MODEL														15
+
+/* kind of tag (protocol and NFC Forum type) */
+#define VTAG_KIND_ISO15693											0
+#define VTAG_KIND_T2														1
+#define VTAG_KIND_T4A														2
+#define VTAG_KIND_T4B														3
+
+#define VTAG_MODELFLAG_HIGHDENSITY							0x01		// 2 bytes block numbers (protocol extension flag)
+#define VTAG_MODELFLAG_NOREADMULTIPLE						0x02
+#define VTAG_MODELFLAG_GETVERSION								0x04		// GET_VERSION, FAST_READ and READ_SIG
+
+/* UID distributions -------------------------------------------------------------------------- */
+#define VTAG_UIDDIST_RANDOM											0				// serial numbers drawn at random
+#define VTAG_UIDDIST_SEQUENTIAL									1				// consecutive serial numbers (reel of tags)
+#define VTAG_UIDDIST_SHAREDPREFIX								2				// same serial number except the last NbFreeBit bits sent
+
+/* states of a tag in the field --------------------------------------------------------------- */
+#define VTAG_STATE_OFF													0
+#define VTAG_STATE_IDLE													1				// ISO14443 idle, ISO15693 ready
+#define VTAG_STATE_READY												2
+#define VTAG_STATE_ACTIVE												3				// ISO14443 selected (Type 2) or ATTRIB / RATS done (Type 4)
+#define VTAG_STATE_HALT													4
+#define VTAG_STATE_QUIET												5				// ISO15693 only
+#define VTAG_STATE_SELECTED											6				// ISO15693 only
+
+/* ISO-DEP buffers of the active card */
+#ifndef VTAG_MAX_APDU_SIZE
+	#define VTAG_MAX_APDU_SIZE										1024
+#endif
+#define VTAG_MAX_BLOCK_SIZE											256
+
+/* largest memory of a model : CC file and NDEF file of a M24SR64 */
+#define VTAG_T4_CCFILE_SIZE											15
+#define VTAG_MAX_MEMORY_SIZE										(8192 + VTAG_T4_CCFILE_SIZE)
+
+typedef struct {
+	const char	*pName;
+	uint8_t			Kind;							// VTAG_KIND_xxx
+	uint8_t			ICRef;						// ISO15693 IC reference, storage size of the Type 2 GET_VERSION
+	uint16_t		NbBlock;					// ISO15693 blocks or Type 2 pages (0 for Type 4)
+	uint16_t		DataSize;					// NDEF area : whole memory (ISO15693), CC size (Type 2), NDEF file (Type 4)
+	uint8_t			Flags;						// VTAG_MODELFLAG_xxx
+	uint16_t		WriteTime_us;			// programming time of a block, a page or 16 bytes of a file
+}VTAG_MODEL;
+
+/* parameters of a population */
+typedef struct {
+	uint32_t		Seed;
+	uint16_t		NbTag;
+	uint16_t		ModelWeight[VTAG_NB_MODEL];	// share of each model (0 => none)
+	uint8_t			UIDDist;					// VTAG_UIDDIST_xxx
+	uint8_t			NbFreeBit;				// VTAG_UIDDIST_SHAREDPREFIX : bits which differ from a tag to another
+	uint8_t			UIDSizeA;					// ISO14443A UID size : 4, 7 or 10
+	uint16_t		NdefMinLength;		// length of the NDEF message of each tag (0 => empty message)
+	uint16_t		NdefMaxLength;
+	uint16_t		ReplyDelayMin_us;	// added to the response time of each reply of a tag
+	uint16_t		ReplyDelayMax_us;
+	uint32_t		NoReplyPpm;				// probability that a tag misses a command
+	uint32_t		CRCErrorPpm;			// probability that a reply is received with a CRC error
+	uint32_t		WeakTagPpm;				// share of weak tags (error probabilities multiplied by WeakFactor)
+	uint8_t			WeakFactor;
+	uint16_t		HostTime_us;			// SPI transfer and processing of one command by the 95HF
+}VTAG_CONFIG;
+
+typedef struct {
+	uint8_t			Model;						// VTAG_MODEL_xxx
+	uint8_t			Kind;
+	uint8_t			UID[VTAG_MAX_UID_SIZE];	// ISO15693 : LSB first (as sent), ISO14443B : PUPI
+	uint8_t			UIDsize;
+	uint8_t			DSFID;
+	uint8_t			AFI;
+	uint16_t		NdefLength;				// length of the NDEF message written by VTAG_Generate
+	uint16_t		MemorySize;
+	uint8_t			*pMemory;					// blocks, pages or CC file followed by the NDEF file (Type 4)
+	uint16_t		ReplyDelay_us;
+	uint32_t		NoReplyPpm;
+	uint32_t		CRCErrorPpm;
+	/* state in the field */
+	uint8_t			State;						// VTAG_STATE_xxx
+	uint8_t			Level;						// ISO14443A cascade level, ISO14443B slot
+	uint8_t			Sector;						// Type 2 sector
+	uint8_t			ReadFirstBlock;		// ISO15693 inventory reply : first block (ST Inventory Read),
+	uint8_t			ReadNbBlock;			// number of blocks (0 => Inventory)
+	uint8_t			ReadNbUIDByte;		// and UID bytes sent
+	uint16_t		File;							// Type 4 selected file
+	/* statistics */
+	uint32_t		NbRequest;				// frames received
+	uint32_t		NbReply;
+	uint32_t		NbCollision;			// replies lost in a collision
+	uint32_t		NbInjectedError;
+}VTAG_TAG;
+
+typedef struct {
+	uint32_t		NbCommand;				// commands received by the 95HF
+	uint32_t		NbFrame;					// frames sent to the tags
+	uint32_t		NbTimeOut;				// frames without reply
+	uint32_t		NbCollision;			// frames with several replies
+	uint32_t		NbInjectedError;
+	uint64_t		AirTime_us;				// frames and replies on the RF field
+}VTAG_STAT;
+
+typedef struct {
+	VTAG_CONFIG	Config;
+	VTAG_TAG		*pTag;
+	uint16_t		NbTag;
+	uint16_t		NbTagKind[4];			// tags of each VTAG_KIND_xxx
+	/* field */
+	uint8_t			Protocol;					// PCD_PROTOCOL_xxx (PCD_PROTOCOL_FIELDOFF => no field)
+	uint8_t			BitRateShift;			// ISO14443 bit rate (0 : 106 kbps) or ISO15693 high data rate (0)
+	uint32_t		Random;						// generator of the errors and ISO14443B slots
+	uint64_t		Time_us;					// virtual time
+	uint8_t			InventorySlot;		// ISO15693 slot of a 16 slots inventory (0xFF => none)
+	VTAG_STAT		Stat;
+	/* ISO-DEP of the active card */
+	VTAG_TAG		*pActive;
+	uint8_t			BlockNumber;
+	uint16_t		FSD;
+	uint8_t			Apdu[VTAG_MAX_APDU_SIZE];	// chained command then response
+	uint16_t		ApduLength;
+	uint16_t		ApduOffset;				// response bytes already sent
+	uint8_t			LastBlock[VTAG_MAX_BLOCK_SIZE];	// last block sent (answer to R(NAK))
+	uint16_t		LastBlockLength;
+}VTAG_POPULATION;
+
+extern const VTAG_MODEL VTAG_Model[VTAG_NB_MODEL];
+
+/* ---------------------------------------------------------------------------------
+ * --- Local Functions
+ * --------------------------------------------------------------------------------- */
+void VTAG_DefaultConfig									( VTAG_CONFIG *pConfig);
+int8_t VTAG_Generate										( const VTAG_CONFIG *pConfig, VTAG_TAG *pTag, uint8_t *pMemory, uc32 MemorySize, VTAG_POPULATION *pPopulation);
+int16_t VTAG_FindTag										( const VTAG_POPULATION *pPopulation, uc8 Protocol, uc8 *pUID, uc8 UIDsize);
+uint8_t VTAG_Protocol										( uc8 Kind);
+uint32_t VTAG_Random										( uint32_t *pState);
+void VTAG_SetFieldSeed									( VTAG_POPULATION *pPopulation, uc32 Seed);
+
+void VTAG_Transceive										( VTAG_POPULATION *pPopulation, uc8 *pCommand, uint8_t *pResponse);
+void VTAG_FieldOff											( VTAG_POPULATION *pPopulation);
+void VTAG_Wait													( VTAG_POPULATION *pPopulation, uc32 Delay_us);
+
+#endif /* __LIB_VTAG_H */
+
+/******************* (C) COPYRIGHT 2014 STMicroelectronics *****END OF FILE****/
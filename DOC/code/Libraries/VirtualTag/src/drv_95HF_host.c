@@ -0,0 +1,320 @@
+/**
+  ******************************************************************************
+  * @file    drv_95HF_host.c
+  * @author  MMY Application Team
+  * @version V4.0.0
+  * @date    02/06/2014
+  * @brief   Host stand-in of the 95HF driver : the commands are answered by a virtual tag population
+  * @brief   (replaces drv_95HF.c, drv_interrupt.c and the delays of the board)
+  ******************************************************************************
+  * @copyright
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
+  */
+
+/* Includes ------------------------------------------------------------------------------ */
+#include "drv_95HF_host.h"
+
+/* ConfigStructure */
+drv95HF_ConfigStruct			drv95HFConfig;
+bool											uDataReady = false;
+
+static VTAG_POPULATION		*drv95HF_pPopulation = 0x00;
+static uint8_t						drv95HF_Response[RFTRANS_95HF_MAX_BUFFER_SIZE+3];
+
+/* drv95HF_Host_Private_Functions */
+static void drv95HF_HostTransceive					( uc8 *pCommand, uint8_t *pResponse);
+
+/** @addtogroup _VirtualTag_Libraries
+ * 	@{
+ */
+
+/** @addtogroup drv_95HF_host
+ * 	@{
+ *  @brief  This file replaces the driver of the 95HF on a host : the commands sent to the 95HF are
+ *					answered by the virtual tag population attached and the delays advance its virtual clock.
+ *					Without population the 95HF does not answer (time out).
+ */
+
+
+/** @addtogroup drv_95HF_host_Private_Functions
+ * 	@{
+ */
+
+/**
+ *	@brief  This function answers a command with the population attached
+ *  @param  *pCommand  : command ( Command | Length | Data)
+ *  @param  *pResponse : response ( Result code | Length | Data)
+ *  @retval None
+ */
+static void drv95HF_HostTransceive (uc8 *pCommand, uint8_t *pResponse)
+{
+	if (drv95HF_pPopulation == 0x00)
+	{
+		pResponse[0] = RFTRANS_95HF_ERRORCODE_TIMEOUT;
+		pResponse[1] = 0x00;
+		return;
+	}
+	VTAG_Transceive(drv95HF_pPopulation, pCommand, pResponse);
+}
+
+/**
+  * @}
+  */
+
+
+/** @addtogroup drv_95HF_host_Public_Functions
+ * 	@{
+ */
+
+/**
+ *	@brief  This function attaches the population which answers the commands
+ *  @param  pPopulation : population (0x00 => no answer)
+ *  @retval None
+ */
+void drv95HF_HostAttach (VTAG_POPULATION *pPopulation)
+{
+	drv95HF_pPopulation = pPopulation;
+	drv95HF_InitConfigStructure();
+	drv95HFConfig.uState = RFTRANS_95HF_STATE_READY;
+}
+
+/**
+ *	@brief  This function returns the virtual time of the population in ms (ISO15693_GetTick_ms,
+ *  @brief  NDEF_GetTick_ms and ENCODER_GetTick_ms)
+ *  @param  None
+ *  @retval time in ms
+ */
+uint32_t drv95HF_HostGetTick_ms (void)
+{
+	if (drv95HF_pPopulation == 0x00)
+		return 0;
+	return (uint32_t)(drv95HF_pPopulation->Time_us / 1000);
+}
+
+/**
+* @brief  	Initilize the 95HF device config structure
+* @param  	None
+* @retval 	None
+*/
+void drv95HF_InitConfigStructure (void)
+{
+	drv95HFConfig.uInterface = RFTRANS_95HF_INTERFACE_SPI;
+	drv95HFConfig.uSpiMode = RFTRANS_95HF_SPI_POLLING;
+	drv95HFConfig.uState = RFTRANS_95HF_STATE_POWERUP;
+	drv95HFConfig.uCurrentProtocol = RFTRANS_95HF_PROTOCOL_UNKNOWN;
+	drv95HFConfig.uMode = RFTRANS_95HF_MODE_UNKNOWN;
+}
+
+/**
+ *	@brief  Reset of the 95HF : the field is switched off
+ *  @param  None
+ *  @retval None
+ */
+void drv95HF_ResetSPI (void)
+{
+	if (drv95HF_pPopulation != 0x00)
+		VTAG_FieldOff(drv95HF_pPopulation);
+	delayHighPriority_ms(14);
+	drv95HFConfig.uState = RFTRANS_95HF_STATE_READY;
+}
+
+/**
+ *	@brief  returns the value of interface pin (SPI)
+ *  @param  None
+ *  @retval RFTRANS_95HF_INTERFACE_SPI
+ */
+int8_t drv95HF_GetInterfacePinState (void)
+{
+	return RFTRANS_95HF_INTERFACE_SPI;
+}
+
+/**
+ *	@brief  This function returns the serial interface
+ *  @param  None
+ *  @retval RFTRANS_95HF_INTERFACE_SPI
+ */
+uint8_t drv95HF_GetSerialInterface (void)
+{
+	return drv95HFConfig.uInterface;
+}
+
+/**
+ *	@brief  This function returns the IRQout state (a response is always ready)
+ *  @param  None
+ *  @retval Pin reset : 0
+ */
+int8_t drv95HF_GetIRQOutState (void)
+{
+	return 0x00;
+}
+
+/**
+ *	@brief  This function initializes the serial interface (nothing on a host)
+ *  @param  None
+ *  @retval None
+ */
+void drv95HF_InitilizeSerialInterface (void)
+{
+	drv95HFConfig.uInterface = RFTRANS_95HF_INTERFACE_SPI;
+}
+
+/**
+ *	@brief  This function sends a command : the response is computed at once
+ *  @param  *pData : command ( Command | Length | Data)
+ *  @retval None
+ */
+void drv95HF_SendSPICommand (uc8 *pData)
+{
+	drv95HF_HostTransceive(pData, drv95HF_Response);
+}
+
+/**
+ *	@brief  This function returns the response of the last command
+ *  @param  *pData : response ( Result code | Length | Data)
+ *  @retval None
+ */
+void drv95HF_ReceiveSPIResponse (uint8_t *pData)
+{
+	memcpy(pData, drv95HF_Response, drv95HF_Response[1] + 2);
+}
+
+/**
+ *	@brief  This function sends a command and returns the response
+ *  @param  *pCommand  : command ( Command | Length | Data)
+ *  @param  *pResponse : response ( Result code | Length | Data)
+ *  @retval RFTRANS_95HF_SUCCESS_CODE
+ */
+int8_t drv95HF_SendReceive (uc8 *pCommand, uint8_t *pResponse)
+{
+	drv95HF_HostTransceive(pCommand, pResponse);
+	return RFTRANS_95HF_SUCCESS_CODE;
+}
+
+/**
+ *	@brief  This function sends a command, the response is read with drv95HF_PoolingReading
+ *  @param  *pCommand  : command ( Command | Length | Data)
+ *  @retval None
+ */
+void drv95HF_SendCmd (uc8 *pCommand)
+{
+	drv95HF_SendSPICommand(pCommand);
+}
+
+/**
+ *	@brief  This function returns the response of the last command sent with drv95HF_SendCmd
+ *  @param  *pResponse : response ( Result code | Length | Data)
+ *  @retval RFTRANS_95HF_SUCCESS_CODE
+ */
+int8_t drv95HF_PoolingReading (uint8_t *pResponse)
+{
+	drv95HF_ReceiveSPIResponse(pResponse);
+	return RFTRANS_95HF_SUCCESS_CODE;
+}
+
+/**
+ *	@brief  Idle command : the field is switched off
+ *  @param  WU_source : wake up source (not used)
+ *  @param  mode : mode (not used)
+ *  @retval None
+ */
+void drv95HF_Idle (uc8 WU_source, uc8 mode)
+{
+	(void)WU_source;
+	(void)mode;
+	if (drv95HF_pPopulation != 0x00)
+		VTAG_FieldOff(drv95HF_pPopulation);
+}
+
+/**
+ *	@brief  Send a negative pulse on IRQin pin (2 ms)
+ *  @param  none
+ *  @retval None
+ */
+void drv95HF_SendIRQINPulse (void)
+{
+	delayHighPriority_ms(2);
+}
+
+/**
+ *	@brief  Enable the interrupt of the 95HF (nothing on a host)
+ *  @param  none
+ *  @retval None
+ */
+void drv95HF_EnableInterrupt (void)
+{
+}
+
+/**
+ *	@brief  Disable the interrupt of the 95HF (nothing on a host)
+ *  @param  none
+ *  @retval None
+ */
+void drv95HF_DisableInterrupt (void)
+{
+}
+
+#ifdef USE_CR95HF_DEVICE
+/**
+ *	@brief  this functions initializes UART (the host stand-in is always on SPI)
+ *  @param  BaudRate : value of the Baudrate (not used)
+ *  @retval None
+ */
+void drv95HF_InitializeUART (uc32 BaudRate)
+{
+	(void)BaudRate;
+}
+#endif /* USE_CR95HF_DEVICE */
+
+/**
+ *	@brief  Delay in ms (virtual time)
+ *  @param  delay : delay in ms
+ *  @retval None
+ */
+void delay_ms (uint16_t delay)
+{
+	if (drv95HF_pPopulation != 0x00)
+		VTAG_Wait(drv95HF_pPopulation, (uint32_t)delay*1000);
+}
+
+/**
+ *	@brief  Delay in us (virtual time)
+ *  @param  delay : delay in us
+ *  @retval None
+ */
+void delay_us (uint16_t delay)
+{
+	if (drv95HF_pPopulation != 0x00)
+		VTAG_Wait(drv95HF_pPopulation, delay);
+}
+
+/**
+ *	@brief  Delay in ms of the driver (virtual time)
+ *  @param  delay : delay in ms
+ *  @retval None
+ */
+void delayHighPriority_ms (uint16_t delay)
+{
+	delay_ms(delay);
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/******************* (C) COPYRIGHT 2014 STMicroelectronics *****END OF FILE****/
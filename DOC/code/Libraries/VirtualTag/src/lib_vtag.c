@@ -0,0 +1,667 @@
+/**
+  ******************************************************************************
+  * @file    lib_vtag.c
+  * @author  MMY Application Team
+  * @version V4.0.0
+  * @date    02/06/2014
+  * @brief   Generation of reproducible virtual tag populations (host side)
+  ******************************************************************************
+  * @copyright
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
+  */
+#include "lib_vtag.h"
+
+#define VTAG_DEFAULT_SEED												0x2545F491
+#define VTAG_FIELD_SEED													0x9E3779B9		// the field errors do not follow the population draws
+#define VTAG_MAX_UIDTRY													1024
+
+/* fixed bytes of the UIDs */
+#define VTAG_ISO15693_UIDMSB										0xE0
+#define VTAG_ISO15693_MFG_ST										0x02
+#define VTAG_ISO14443A_MFG_NXP									0x04
+#define VTAG_ISO14443A_MFG_ST										0x02
+#define VTAG_ISO14443A_CASCADETAG								0x88
+#define VTAG_ISO14443A_NUID											0x0F		// low nibble of a non unique 4 bytes UID
+
+/* NDEF areas */
+#define VTAG_ISO15693_CCSIZE										4
+#define VTAG_ISO15693_EXTENDEDCCSIZE						8
+#define VTAG_ISO15693_MAXCCSIZE									2040			// memory size coded on one CC byte
+#define VTAG_T2_DATAPAGE												4
+#define VTAG_TLV_NDEF														0x03
+#define VTAG_TLV_TERMINATOR											0xFE
+#define VTAG_TLV_LONGLENGTH											0xFF
+#define VTAG_NDEF_MINLENGTH											7					// text record without text
+#define VTAG_NDEF_SHORTPAYLOAD									255
+
+const VTAG_MODEL VTAG_Model[VTAG_NB_MODEL] = {
+	/* name						kind								IC ref	blocks	NDEF		flags															write time */
+	{"M24LR64-R",			VTAG_KIND_ISO15693,	0x2C,		2048,		8192,		VTAG_MODELFLAG_HIGHDENSITY,				5600},
+	{"M24LR64E-R",		VTAG_KIND_ISO15693,	0x5E,		2048,		8192,		VTAG_MODELFLAG_HIGHDENSITY,				5600},
+	{"M24LR16E-R",		VTAG_KIND_ISO15693,	0x4E,		512,		2048,		VTAG_MODELFLAG_HIGHDENSITY,				5600},
+	{"M24LR04E-R",		VTAG_KIND_ISO15693,	0x5A,		128,		512,		0x00,															5600},
+	{"LRiS64K",				VTAG_KIND_ISO15693,	0x44,		2048,		8192,		VTAG_MODELFLAG_HIGHDENSITY,				5000},
+	{"LRiS2K",				VTAG_KIND_ISO15693,	0x28,		64,			256,		VTAG_MODELFLAG_NOREADMULTIPLE,		5000},
+	{"LRi2K",					VTAG_KIND_ISO15693,	0x20,		64,			256,		0x00,															5000},
+	{"LRi1K",					VTAG_KIND_ISO15693,	0x40,		32,			128,		0x00,															5000},
+	{"Ultralight",		VTAG_KIND_T2,				0x00,		16,			48,			0x00,															4100},
+	{"NTAG213",				VTAG_KIND_T2,				0x0F,		45,			144,		VTAG_MODELFLAG_GETVERSION,				4100},
+	{"NTAG215",				VTAG_KIND_T2,				0x11,		135,		496,		VTAG_MODELFLAG_GETVERSION,				4100},
+	{"NTAG216",				VTAG_KIND_T2,				0x13,		231,		872,		VTAG_MODELFLAG_GETVERSION,				4100},
+	{"M24SR04",				VTAG_KIND_T4A,			0x00,		0,			512,		0x00,															3000},
+	{"M24SR64",				VTAG_KIND_T4A,			0x00,		0,			8192,		0x00,															3000},
+	{"ISO14443B-4",		VTAG_KIND_T4B,			0x00,		0,			4096,		0x00,															3000},
+};
+
+static const char VTAG_TextHeader [] = {0x02, 'e', 'n'};
+
+static uint32_t VTAG_Draw 							( uint32_t *pState, uc32 Min, uc32 Max);
+static uint8_t VTAG_DrawModel 					( const VTAG_CONFIG *pConfig, uint32_t *pState);
+static uint16_t VTAG_MemorySize 				( uc8 Model);
+static uint8_t VTAG_SerialMask 					( uc8 Kind, uc8 UIDsize, uc8 NthByte);
+static uint8_t VTAG_NbSerialBit 				( uc8 Kind, uc8 UIDsize);
+static void VTAG_BuildUID 							( VTAG_TAG *pTag, uc8 *pSerial);
+static bool VTAG_IsUIDUnique 						( const VTAG_TAG *pTag, uc16 NbTag, const VTAG_TAG *pNewTag);
+static int8_t VTAG_DrawUID 							( const VTAG_CONFIG *pConfig, VTAG_POPULATION *pPopulation, uint32_t *pState, uint8_t *pBase, uint32_t *pCounter, VTAG_TAG *pNewTag);
+static void VTAG_BuildMessage 					( uint32_t *pState, uc16 NthTag, uc16 Length, uint8_t *pMessage);
+static uint16_t VTAG_WriteTLV 					( uint32_t *pState, uc16 NthTag, uc16 Length, uc16 AreaSize, uint8_t *pArea);
+static void VTAG_Format 								( const VTAG_CONFIG *pConfig, uint32_t *pState, uc16 NthTag, VTAG_TAG *pTag);
+
+/** @addtogroup _VirtualTag_Libraries
+ * 	@{
+ *	@brief  <b>Host side libraries which stand for the RF field of the 95HF PCD : the PCD libraries
+ *				  run unchanged on a PC against populations of virtual tags</b>
+ */
+
+/** @addtogroup lib_vtag
+ * 	@{
+ *	@brief  This file generates the virtual tags of a field (1 to VTAG_MAX_NBTAG tags) : model, UID,
+ *					memory content and timing of each tag are drawn from a seed, so a population is
+ *					rebuilt identical from its configuration.
+ */
+
+
+/** @addtogroup lib_vtag_Private_Functions
+ * 	@{
+ */
+
+/**
+ * @brief  This function draws a number between Min and Max (included)
+ * @param  pState : state of the generator
+ * @param  Min : lowest value
+ * @param  Max : highest value
+ * @retval number drawn
+ */
+static uint32_t VTAG_Draw (uint32_t *pState, uc32 Min, uc32 Max)
+{
+	if (Max <= Min)
+		return Min;
+	return Min + (VTAG_Random(pState) % (Max - Min + 1));
+}
+
+/**
+ * @brief  This function draws the model of a tag according to the weights of the configuration
+ * @param  pConfig : parameters of the population
+ * @param  pState : state of the generator
+ * @retval VTAG_MODEL_xxx
+ */
+static uint8_t VTAG_DrawModel (const VTAG_CONFIG *pConfig, uint32_t *pState)
+{
+	uint32_t Total = 0, Draw;
+	uint8_t Model;
+
+	for (Model = 0; Model < VTAG_NB_MODEL; Model++)
+		Total += pConfig->ModelWeight[Model];
+
+	Draw = VTAG_Random(pState) % Total;
+	for (Model = 0; Draw >= pConfig->ModelWeight[Model]; Model++)
+		Draw -= pConfig->ModelWeight[Model];
+
+	return Model;
+}
+
+/**
+ * @brief  This function returns the size of the memory image of a model
+ * @param  Model : VTAG_MODEL_xxx
+ * @retval number of bytes (blocks, pages or CC file and NDEF file)
+ */
+static uint16_t VTAG_MemorySize (uc8 Model)
+{
+	if (VTAG_Model[Model].NbBlock != 0)
+		return VTAG_Model[Model].NbBlock*4;
+	return VTAG_T4_CCFILE_SIZE + VTAG_Model[Model].DataSize;
+}
+
+/**
+ * @brief  This function returns the bits of a UID byte which are a serial number (the other bits are
+ * @brief  the manufacturer and the IC reference)
+ * @param  Kind : VTAG_KIND_xxx
+ * @param  UIDsize : number of bytes of the UID
+ * @param  NthByte : byte of the UID
+ * @retval mask of the serial number bits
+ */
+static uint8_t VTAG_SerialMask (uc8 Kind, uc8 UIDsize, uc8 NthByte)
+{
+	switch (Kind)
+	{
+		case VTAG_KIND_ISO15693:
+			return (NthByte < 5) ? 0xFF : 0x00;
+		case VTAG_KIND_T4B:
+			return 0xFF;
+		default:
+			if (NthByte != 0)
+				return 0xFF;
+			return (UIDsize == 4) ? 0xF0 : 0x00;
+	}
+}
+
+/**
+ * @brief  This function returns the number of serial number bits of a UID
+ * @param  Kind : VTAG_KIND_xxx
+ * @param  UIDsize : number of bytes of the UID
+ * @retval number of bits
+ */
+static uint8_t VTAG_NbSerialBit (uc8 Kind, uc8 UIDsize)
+{
+	uint8_t NthByte, NbBit = 0, Mask;
+
+	for (NthByte = 0; NthByte < UIDsize; NthByte++)
+		for (Mask = VTAG_SerialMask(Kind, UIDsize, NthByte); Mask != 0; Mask &= Mask - 1)
+			NbBit++;
+
+	return NbBit;
+}
+
+/**
+ * @brief  This function builds a UID from a serial number. The bits of the serial number are
+ * @brief  placed in the order of the anticollision (first byte sent first, LSB first), so the
+ * @brief  first bits of the serial number are the first ones compared by the reader.
+ * @param  pTag : tag (Kind and UIDsize set)
+ * @param  pSerial : serial number (bit n in pSerial[n/8] bit n%8)
+ * @retval None
+ */
+static void VTAG_BuildUID (VTAG_TAG *pTag, uc8 *pSerial)
+{
+	uint8_t NthByte, NthBit, Mask, NthSerialBit = 0;
+
+	memset(pTag->UID, 0x00, VTAG_MAX_UID_SIZE);
+	for (NthByte = 0; NthByte < pTag->UIDsize; NthByte++)
+	{
+		Mask = VTAG_SerialMask(pTag->Kind, pTag->UIDsize, NthByte);
+		for (NthBit = 0; NthBit < 8; NthBit++)
+		{
+			if ((Mask & (1 << NthBit)) == 0)
+				continue;
+			if ((pSerial[NthSerialBit/8] & (1 << (NthSerialBit%8))) != 0)
+				pTag->UID[NthByte] |= 1 << NthBit;
+			NthSerialBit++;
+		}
+	}
+
+	switch (pTag->Kind)
+	{
+		case VTAG_KIND_ISO15693:
+			pTag->UID[5] = VTAG_Model[pTag->Model].ICRef;
+			pTag->UID[6] = VTAG_ISO15693_MFG_ST;
+			pTag->UID[7] = VTAG_ISO15693_UIDMSB;
+			break;
+		case VTAG_KIND_T2:
+		case VTAG_KIND_T4A:
+			if (pTag->UIDsize == 4)
+				pTag->UID[0] |= VTAG_ISO14443A_NUID;
+			else
+				pTag->UID[0] = (pTag->Kind == VTAG_KIND_T2) ? VTAG_ISO14443A_MFG_NXP : VTAG_ISO14443A_MFG_ST;
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief  This function checks that no tag of the same protocol already has the UID of a new tag
+ * @param  pTag : tags already generated
+ * @param  NbTag : number of tags already generated
+ * @param  pNewTag : new tag
+ * @retval true : the UID is unique
+ * @retval false : the UID is already used
+ */
+static bool VTAG_IsUIDUnique (const VTAG_TAG *pTag, uc16 NbTag, const VTAG_TAG *pNewTag)
+{
+	uint16_t NthTag;
+
+	for (NthTag = 0; NthTag < NbTag; NthTag++)
+		if (VTAG_Protocol(pTag[NthTag].Kind) == VTAG_Protocol(pNewTag->Kind) &&
+				pTag[NthTag].UIDsize == pNewTag->UIDsize &&
+				memcmp(pTag[NthTag].UID, pNewTag->UID, pNewTag->UIDsize) == 0)
+			return false;
+
+	return true;
+}
+
+/**
+ * @brief  This function draws the UID of a new tag according to the UID distribution
+ * @param  pConfig : parameters of the population
+ * @param  pPopulation : tags already generated
+ * @param  pState : state of the generator
+ * @param  pBase : base serial number of the kind of the tag
+ * @param  pCounter : next sequential serial number of the kind of the tag
+ * @param  pNewTag : new tag (Kind, Model and UIDsize set)
+ * @retval VTAG_SUCCESSCODE : the UID is unique
+ * @retval VTAG_ERRORCODE_UIDSPACE : no unique UID found
+ */
+static int8_t VTAG_DrawUID (const VTAG_CONFIG *pConfig, VTAG_POPULATION *pPopulation, uint32_t *pState, uint8_t *pBase, uint32_t *pCounter, VTAG_TAG *pNewTag)
+{
+	uint8_t Serial[VTAG_MAX_UID_SIZE], NbSerialBit, NbFreeBit, NthBit, NthByte;
+	uint16_t NthTry, Sum;
+	uint32_t Counter;
+
+	NbSerialBit = VTAG_NbSerialBit(pNewTag->Kind, pNewTag->UIDsize);
+	NbFreeBit = MIN(pConfig->NbFreeBit, NbSerialBit);
+
+	for (NthTry = 0; NthTry < VTAG_MAX_UIDTRY; NthTry++)
+	{
+		switch (pConfig->UIDDist)
+		{
+			case VTAG_UIDDIST_SEQUENTIAL:
+				/* base + counter, the first bit sent is the least significant one */
+				Counter = (*pCounter)++;
+				for (NthByte = 0, Sum = 0; NthByte < VTAG_MAX_UID_SIZE; NthByte++, Counter >>= 8)
+				{
+					Sum += pBase[NthByte] + (Counter & 0xFF);
+					Serial[NthByte] = (uint8_t)Sum;
+					Sum >>= 8;
+				}
+				break;
+			case VTAG_UIDDIST_SHAREDPREFIX:
+				/* the tags only differ in the last bits sent : the anticollision runs deep in the tree */
+				memcpy(Serial, pBase, VTAG_MAX_UID_SIZE);
+				for (NthBit = NbSerialBit - NbFreeBit; NthBit < NbSerialBit; NthBit++)
+				{
+					Serial[NthBit/8] &= ~(1 << (NthBit%8));
+					Serial[NthBit/8] |= (VTAG_Random(pState) & 0x01) << (NthBit%8);
+				}
+				break;
+			default:
+				for (NthByte = 0; NthByte < VTAG_MAX_UID_SIZE; NthByte++)
+					Serial[NthByte] = (uint8_t)VTAG_Random(pState);
+				break;
+		}
+
+		VTAG_BuildUID(pNewTag, Serial);
+		if (VTAG_IsUIDUnique(pPopulation->pTag, pPopulation->NbTag, pNewTag) == true)
+			return VTAG_SUCCESSCODE;
+	}
+
+	return VTAG_ERRORCODE_UIDSPACE;
+}
+
+/**
+ * @brief  This function builds a NDEF message of one text record ("vtag <index> " and letters)
+ * @param  pState : state of the generator
+ * @param  NthTag : index of the tag
+ * @param  Length : length of the message (VTAG_NDEF_MINLENGTH at least)
+ * @param  pMessage : message
+ * @retval None
+ */
+static void VTAG_BuildMessage (uint32_t *pState, uc16 NthTag, uc16 Length, uint8_t *pMessage)
+{
+	uint8_t Prefix[16] = "vtag ", Digit[5], NbDigit = 0, PrefixLength = 5;
+	uint16_t NthByte = 0, PayloadLength, NthChar, Number = NthTag;
+
+	if (Length - 4 <= VTAG_NDEF_SHORTPAYLOAD)
+	{
+		PayloadLength = Length - 4;
+		pMessage[NthByte++] = 0xD1;		// MB ME SR, well known type
+		pMessage[NthByte++] = 0x01;
+		pMessage[NthByte++] = (uint8_t)PayloadLength;
+	}
+	else
+	{
+		PayloadLength = Length - 7;
+		pMessage[NthByte++] = 0xC1;		// MB ME, well known type
+		pMessage[NthByte++] = 0x01;
+		pMessage[NthByte++] = 0x00;
+		pMessage[NthByte++] = 0x00;
+		pMessage[NthByte++] = GETMSB(PayloadLength);
+		pMessage[NthByte++] = GETLSB(PayloadLength);
+	}
+	pMessage[NthByte++] = 'T';
+	memcpy(&pMessage[NthByte], VTAG_TextHeader, sizeof(VTAG_TextHeader));
+	NthByte += sizeof(VTAG_TextHeader);
+
+	/* "vtag <index> " then random letters */
+	do
+	{
+		Digit[NbDigit++] = '0' + Number % 10;
+		Number /= 10;
+	}while (Number != 0);
+	while (NbDigit != 0)
+		Prefix[PrefixLength++] = Digit[--NbDigit];
+	Prefix[PrefixLength++] = ' ';
+	for (NthChar = 0; NthByte < Length; NthChar++)
+		pMessage[NthByte++] = (NthChar < PrefixLength) ? Prefix[NthChar] : 'a' + VTAG_Random(pState) % 26;
+}
+
+/**
+ * @brief  This function writes a NDEF TLV (Type 2 and Type 5 tags) clamped to the area
+ * @param  pState : state of the generator
+ * @param  NthTag : index of the tag
+ * @param  Length : length of the message requested (0 => empty message)
+ * @param  AreaSize : size of the area behind the CC
+ * @param  pArea : area behind the CC
+ * @retval length of the message written
+ */
+static uint16_t VTAG_WriteTLV (uint32_t *pState, uc16 NthTag, uc16 Length, uc16 AreaSize, uint8_t *pArea)
+{
+	uint16_t MessageLength = Length, NthByte = 0;
+
+	/* TLV header, message and terminator */
+	if (MessageLength > AreaSize - 5 && MessageLength >= VTAG_TLV_LONGLENGTH)
+		MessageLength = AreaSize - 5;
+	if (MessageLength > AreaSize - 3 && MessageLength < VTAG_TLV_LONGLENGTH)
+		MessageLength = AreaSize - 3;
+	if (MessageLength < VTAG_NDEF_MINLENGTH)
+		MessageLength = 0;
+
+	pArea[NthByte++] = VTAG_TLV_NDEF;
+	if (MessageLength >= VTAG_TLV_LONGLENGTH)
+	{
+		pArea[NthByte++] = VTAG_TLV_LONGLENGTH;
+		pArea[NthByte++] = GETMSB(MessageLength);
+	}
+	pArea[NthByte++] = GETLSB(MessageLength);
+	if (MessageLength != 0)
+		VTAG_BuildMessage(pState, NthTag, MessageLength, &pArea[NthByte]);
+	pArea[NthByte + MessageLength] = VTAG_TLV_TERMINATOR;
+
+	return MessageLength;
+}
+
+/**
+ * @brief  This function writes the memory image of a tag : UID pages and CC (Type 2), CC and TLV
+ * @brief  (Type 2 and Type 5), CC file and NDEF file (Type 4)
+ * @param  pConfig : parameters of the population
+ * @param  pState : state of the generator
+ * @param  NthTag : index of the tag
+ * @param  pTag : tag (UID and pMemory set, memory cleared)
+ * @retval None
+ */
+static void VTAG_Format (const VTAG_CONFIG *pConfig, uint32_t *pState, uc16 NthTag, VTAG_TAG *pTag)
+{
+	const VTAG_MODEL *pModel = &VTAG_Model[pTag->Model];
+	uint8_t *pMemory = pTag->pMemory, CCSize;
+	uint16_t Length, Capacity;
+
+	Length = VTAG_Draw(pState, pConfig->NdefMinLength, pConfig->NdefMaxLength);
+	if (Length != 0 && Length < VTAG_NDEF_MINLENGTH)
+		Length = VTAG_NDEF_MINLENGTH;
+
+	switch (pTag->Kind)
+	{
+		case VTAG_KIND_ISO15693:
+			if (pModel->DataSize <= VTAG_ISO15693_MAXCCSIZE)
+			{
+				CCSize = VTAG_ISO15693_CCSIZE;
+				pMemory[0] = 0xE1;
+				pMemory[2] = pModel->DataSize/8;
+			}
+			else
+			{
+				CCSize = VTAG_ISO15693_EXTENDEDCCSIZE;
+				pMemory[0] = 0xE2;
+				pMemory[6] = GETMSB(pModel->DataSize/8);
+				pMemory[7] = GETLSB(pModel->DataSize/8);
+			}
+			pMemory[1] = 0x40;
+			pMemory[3] = ((pModel->Flags & VTAG_MODELFLAG_NOREADMULTIPLE) == 0) ? 0x01 : 0x00;
+			pTag->NdefLength = VTAG_WriteTLV(pState, NthTag, Length, pModel->DataSize - CCSize, &pMemory[CCSize]);
+			break;
+
+		case VTAG_KIND_T2:
+			/* page 0 : UID0-2 BCC0, page 1 : UID3-6, page 2 : BCC1 internal lock0 lock1 */
+			pMemory[0] = pTag->UID[0];
+			pMemory[1] = pTag->UID[1];
+			pMemory[2] = pTag->UID[2];
+			pMemory[3] = VTAG_ISO14443A_CASCADETAG ^ pTag->UID[0] ^ pTag->UID[1] ^ pTag->UID[2];
+			memcpy(&pMemory[4], &pTag->UID[3], 4);
+			pMemory[8] = pTag->UID[3] ^ pTag->UID[4] ^ pTag->UID[5] ^ pTag->UID[6];
+			pMemory[9] = 0x48;
+			/* page 3 : CC */
+			pMemory[12] = 0xE1;
+			pMemory[13] = 0x10;
+			pMemory[14] = pModel->DataSize/8;
+			pTag->NdefLength = VTAG_WriteTLV(pState, NthTag, Length, pModel->DataSize, &pMemory[VTAG_T2_DATAPAGE*4]);
+			break;
+
+		default:
+			/* CC file then NDEF file (NLEN and message) */
+			memcpy(pMemory, "\x00\x0F\x20\x00\xF6\x00\xF6\x04\x06\x00\x01", 11);
+			pMemory[11] = GETMSB(pModel->DataSize);
+			pMemory[12] = GETLSB(pModel->DataSize);
+			Capacity = pModel->DataSize - 2;
+			if (Length > Capacity)
+				Length = Capacity;
+			pMemory[VTAG_T4_CCFILE_SIZE] = GETMSB(Length);
+			pMemory[VTAG_T4_CCFILE_SIZE+1] = GETLSB(Length);
+			if (Length != 0)
+				VTAG_BuildMessage(pState, NthTag, Length, &pMemory[VTAG_T4_CCFILE_SIZE+2]);
+			pTag->NdefLength = Length;
+			break;
+	}
+}
+
+/**
+  * @}
+  */
+
+
+/** @addtogroup lib_vtag_Public_Functions
+ * 	@{
+ */
+
+/**
+ * @brief  This function draws the next number of a xorshift generator
+ * @param  pState : state of the generator (not 0)
+ * @retval 32 bits number
+ */
+uint32_t VTAG_Random (uint32_t *pState)
+{
+	uint32_t x = *pState;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*pState = x;
+
+	return x;
+}
+
+/**
+ * @brief  This function returns the RF protocol of a kind of tag
+ * @param  Kind : VTAG_KIND_xxx
+ * @retval PCD_PROTOCOL_ISO15693, PCD_PROTOCOL_ISO14443A or PCD_PROTOCOL_ISO14443B
+ */
+uint8_t VTAG_Protocol (uc8 Kind)
+{
+	switch (Kind)
+	{
+		case VTAG_KIND_ISO15693:
+			return PCD_PROTOCOL_ISO15693;
+		case VTAG_KIND_T4B:
+			return PCD_PROTOCOL_ISO14443B;
+		default:
+			return PCD_PROTOCOL_ISO14443A;
+	}
+}
+
+/**
+ * @brief  This function sets the default parameters : 16 tags of all the models, random 7 bytes
+ * @brief  ISO14443A UIDs, 16 to 64 bytes messages, no error
+ * @param  pConfig : parameters of the population
+ * @retval None
+ */
+void VTAG_DefaultConfig (VTAG_CONFIG *pConfig)
+{
+	uint8_t Model;
+
+	memset(pConfig, 0x00, sizeof(VTAG_CONFIG));
+	pConfig->Seed = 1;
+	pConfig->NbTag = 16;
+	for (Model = 0; Model < VTAG_NB_MODEL; Model++)
+		pConfig->ModelWeight[Model] = 1;
+	pConfig->UIDDist = VTAG_UIDDIST_RANDOM;
+	pConfig->NbFreeBit = 8;
+	pConfig->UIDSizeA = 7;
+	pConfig->NdefMinLength = 16;
+	pConfig->NdefMaxLength = 64;
+	pConfig->WeakFactor = 10;
+	pConfig->HostTime_us = 150;
+}
+
+/**
+ * @brief  This function generates a population of virtual tags. The same configuration always gives
+ * @brief  the same tags (models, UIDs, memory contents, timings) and the same field errors.
+ * @param  pConfig : parameters of the population
+ * @param  pTag : pConfig->NbTag tags
+ * @param  pMemory : memory shared by the tags (VTAG_MAX_MEMORY_SIZE bytes per tag is enough)
+ * @param  MemorySize : size of pMemory
+ * @param  pPopulation : population (field off)
+ * @retval VTAG_SUCCESSCODE : population generated
+ * @retval VTAG_ERRORCODE_PARAMETER : a parameter is erroneous
+ * @retval VTAG_ERRORCODE_MEMORY : pMemory is too small
+ * @retval VTAG_ERRORCODE_UIDSPACE : not enough distinct UIDs for the distribution
+ */
+int8_t VTAG_Generate (const VTAG_CONFIG *pConfig, VTAG_TAG *pTag, uint8_t *pMemory, uc32 MemorySize, VTAG_POPULATION *pPopulation)
+{
+	uint8_t Base[4][VTAG_MAX_UID_SIZE], NthByte, Kind;
+	uint32_t Counter[4] = {0, 0, 0, 0}, State, WeakFactor, Used = 0, Total = 0;
+	uint16_t NthTag;
+	VTAG_TAG *pNewTag;
+	int8_t status;
+
+	if (pConfig->NbTag == 0 || pConfig->NbTag > VTAG_MAX_NBTAG ||
+			pConfig->UIDDist > VTAG_UIDDIST_SHAREDPREFIX ||
+			(pConfig->UIDSizeA != 4 && pConfig->UIDSizeA != 7 && pConfig->UIDSizeA != 10) ||
+			pConfig->NdefMinLength > pConfig->NdefMaxLength ||
+			pConfig->ReplyDelayMin_us > pConfig->ReplyDelayMax_us ||
+			pConfig->NoReplyPpm > VTAG_PPM || pConfig->CRCErrorPpm > VTAG_PPM || pConfig->WeakTagPpm > VTAG_PPM)
+		return VTAG_ERRORCODE_PARAMETER;
+	for (NthByte = 0; NthByte < VTAG_NB_MODEL; NthByte++)
+		Total += pConfig->ModelWeight[NthByte];
+	if (Total == 0)
+		return VTAG_ERRORCODE_PARAMETER;
+
+	memset(pPopulation, 0x00, sizeof(VTAG_POPULATION));
+	memcpy(&pPopulation->Config, pConfig, sizeof(VTAG_CONFIG));
+	pPopulation->pTag = pTag;
+	pPopulation->Protocol = PCD_PROTOCOL_FIELDOFF;
+	pPopulation->InventorySlot = 0xFF;
+
+	State = (pConfig->Seed != 0) ? pConfig->Seed : VTAG_DEFAULT_SEED;
+	for (Kind = 0; Kind < 4; Kind++)
+		for (NthByte = 0; NthByte < VTAG_MAX_UID_SIZE; NthByte++)
+			Base[Kind][NthByte] = (uint8_t)VTAG_Random(&State);
+
+	for (NthTag = 0; NthTag < pConfig->NbTag; NthTag++)
+	{
+		pNewTag = &pTag[NthTag];
+		memset(pNewTag, 0x00, sizeof(VTAG_TAG));
+		pNewTag->Model = VTAG_DrawModel(pConfig, &State);
+		pNewTag->Kind = VTAG_Model[pNewTag->Model].Kind;
+		switch (pNewTag->Kind)
+		{
+			case VTAG_KIND_ISO15693:
+				pNewTag->UIDsize = 8;
+				break;
+			case VTAG_KIND_T4B:
+				pNewTag->UIDsize = 4;
+				break;
+			default:
+				pNewTag->UIDsize = pConfig->UIDSizeA;
+				break;
+		}
+		errchk(VTAG_DrawUID(pConfig, pPopulation, &State, Base[pNewTag->Kind], &Counter[pNewTag->Kind], pNewTag));
+
+		pNewTag->MemorySize = VTAG_MemorySize(pNewTag->Model);
+		if (Used + pNewTag->MemorySize > MemorySize)
+		{
+			status = VTAG_ERRORCODE_MEMORY;
+			goto Error;
+		}
+		pNewTag->pMemory = &pMemory[Used];
+		Used += pNewTag->MemorySize;
+		memset(pNewTag->pMemory, 0x00, pNewTag->MemorySize);
+		VTAG_Format(pConfig, &State, NthTag, pNewTag);
+
+		pNewTag->ReplyDelay_us = VTAG_Draw(&State, pConfig->ReplyDelayMin_us, pConfig->ReplyDelayMax_us);
+		WeakFactor = (VTAG_Draw(&State, 0, VTAG_PPM - 1) < pConfig->WeakTagPpm) ? pConfig->WeakFactor : 1;
+		pNewTag->NoReplyPpm = MIN(pConfig->NoReplyPpm*WeakFactor, VTAG_PPM);
+		pNewTag->CRCErrorPpm = MIN(pConfig->CRCErrorPpm*WeakFactor, VTAG_PPM);
+		pNewTag->State = VTAG_STATE_OFF;
+
+		pPopulation->NbTag++;
+		pPopulation->NbTagKind[pNewTag->Kind]++;
+	}
+
+	VTAG_SetFieldSeed(pPopulation, State ^ VTAG_FIELD_SEED);
+	return VTAG_SUCCESSCODE;
+Error:
+	return status;
+}
+
+/**
+ * @brief  This function returns the index of the tag which has a UID
+ * @param  pPopulation : population
+ * @param  Protocol : PCD_PROTOCOL_ISO15693, PCD_PROTOCOL_ISO14443A or PCD_PROTOCOL_ISO14443B
+ * @param  pUID : UID (PUPI for ISO14443B)
+ * @param  UIDsize : number of bytes of the UID
+ * @retval index of the tag, -1 if no tag has this UID
+ */
+int16_t VTAG_FindTag (const VTAG_POPULATION *pPopulation, uc8 Protocol, uc8 *pUID, uc8 UIDsize)
+{
+	uint16_t NthTag;
+	const VTAG_TAG *pTag;
+
+	for (NthTag = 0; NthTag < pPopulation->NbTag; NthTag++)
+	{
+		pTag = &pPopulation->pTag[NthTag];
+		if (VTAG_Protocol(pTag->Kind) == Protocol && pTag->UIDsize == UIDsize && memcmp(pTag->UID, pUID, UIDsize) == 0)
+			return NthTag;
+	}
+
+	return -1;
+}
+
+/**
+ * @brief  This function sets the generator of the field (errors and ISO14443B slots), so a run
+ * @brief  can be replayed with other errors on the same population
+ * @param  pPopulation : population
+ * @param  Seed : seed of the generator
+ * @retval None
+ */
+void VTAG_SetFieldSeed (VTAG_POPULATION *pPopulation, uc32 Seed)
+{
+	pPopulation->Random = (Seed != 0) ? Seed : VTAG_DEFAULT_SEED;
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/******************* (C) COPYRIGHT 2014 STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,1571 @@
+/**
+  ******************************************************************************
+  * @file    lib_vtagfield.c
+  * @author  MMY Application Team
+  * @version V4.0.0
+  * @date    02/06/2014
+  * @brief   RF field of a virtual tag population : answers the 95HF commands (host side)
+  ******************************************************************************
+  * @copyright
+  *
+  * THE PRESENT FIRMWARE WHICH IS FOR GUIDANCE ONLY AIMS AT PROVIDING CUSTOMERS
+  * WITH CODING INFORMATION REGARDING THEIR PRODUCTS IN ORDER FOR THEM TO SAVE
+  * TIME. AS A RESULT, STMICROELECTRONICS SHALL NOT BE HELD LIABLE FOR ANY
+  * DIRECT, INDIRECT OR CONSEQUENTIAL DAMAGES WITH RESPECT TO ANY CLAIMS ARISING
+  * FROM THE CONTENT OF SUCH FIRMWARE AND/OR THE USE MADE BY CUSTOMERS OF THE
+  * CODING INFORMATION CONTAINED HEREIN IN CONNECTION WITH THEIR PRODUCTS.
+  *
+  * <h2><center>&copy; COPYRIGHT 2014 STMicroelectronics</center></h2>
+  */
+#include "lib_vtag.h"
+#include "lib_iso15693pcd.h"
+#include "lib_iso14443Bpcd.h"
+#include "lib_nfctype2pcd.h"
+
+/* timing of the field : frames at the nominal bit rate, fixed response times (no modulation details) */
+#define VTAG_ISO15693_BIT_NS										37760			// 26.48 kbps (request 1 out of 4, reply one subcarrier)
+#define VTAG_ISO15693_SOFEOF_US									113
+#define VTAG_ISO15693_T1_US											320
+#define VTAG_ISO14443_ETU_NS										9440			// 106 kbps
+#define VTAG_ISO14443A_FDT_US										86
+#define VTAG_ISO14443B_SOFEOF_ETU								22
+#define VTAG_ISO14443B_TR_US										151
+#define VTAG_TIMEOUT_US													1000			// time out of the PCD device without reply
+
+/* replies of the tags */
+#define VTAG_MAX_REPLY_SIZE											(RFTRANS_95HF_MAX_BUFFER_SIZE - ISO14443A_NBBYTE)
+#define VTAG_REPLY_OVERFLOW											0xFFFF		// reply longer than the buffer of the PCD device
+#define VTAG_NOCOLLISION												0xFFFF
+#define VTAG_NOSLOT															0xFF
+#define VTAG_PPMDRAW(pState)										(VTAG_Random(pState) % VTAG_PPM)
+
+/* ISO15693 */
+#define VTAG_ISO15693_FLAG_ERROR								0x01
+#define VTAG_ISO15693_FLAG_INVENTORY						0x04
+#define VTAG_ISO15693_FLAG_PROTEXT							0x08
+#define VTAG_ISO15693_FLAG_SELECTORAFI					0x10
+#define VTAG_ISO15693_FLAG_ADDRORNBSLOT					0x20
+#define VTAG_ISO15693_FLAG_OPTION								0x40
+#define VTAG_ISO15693_ERROR_NOTSUPPORTED				0x01
+#define VTAG_ISO15693_ERROR_NOTRECOGNIZED				0x02
+#define VTAG_ISO15693_ERROR_OPTION							0x03
+#define VTAG_ISO15693_ERROR_BLOCK								0x10
+#define VTAG_ISO15693_WRITEREPLY								0xFE			// Level : reply of a write sent at the next EOF
+#define VTAG_ISO15693_BLOCKSIZE									4
+
+/* ISO14443A */
+#define VTAG_ISO14443A_REQA											0x26
+#define VTAG_ISO14443A_WUPA											0x52
+#define VTAG_ISO14443A_HLTA											0x50
+#define VTAG_ISO14443A_RATS											0xE0
+#define VTAG_ISO14443A_SELECT_NVB								0x70
+#define VTAG_ISO14443A_SAK_NOTCOMPLETE					0x04
+#define VTAG_ISO14443A_SAK_ISODEP								0x20
+#define VTAG_T2_ACK															0x0A
+#define VTAG_T2_NAK															0x00
+#define VTAG_T2_COMPATWRITE											0x8000		// File : second frame of a COMPATIBILITY_WRITE expected
+
+/* ISO14443B */
+#define VTAG_ISO14443B_APF											0x05
+#define VTAG_ISO14443B_WUPB											0x08
+#define VTAG_ISO14443B_ATTRIB										0x1D
+#define VTAG_ISO14443B_HLTB											0x50
+
+/* ISO-DEP and NDEF application of the Type 4 tags */
+#define VTAG_ISODEP_RECEIVING										0xFFFF		// ApduOffset : command being received
+#define VTAG_T4_APPLICATION											0xFFFF		// File : application selected, no file
+#define VTAG_T4_CCFILE													0xE103
+#define VTAG_T4_NDEFFILE												0x0001
+
+typedef struct {
+	uint8_t			Data[VTAG_MAX_REPLY_SIZE];
+	uint16_t		Length;						// 0 => no reply
+	uint8_t			NbBit;						// bits of the last byte (4 for the Type 2 ACK/NAK)
+	bool				HasCRC;
+	uint32_t		Delay_us;					// response time added by the tag (programming time)
+}VTAG_REPLY;
+
+typedef struct {
+	uint8_t			Data[VTAG_MAX_REPLY_SIZE];	// replies ORed
+	uint8_t			First[VTAG_MAX_REPLY_SIZE];	// first reply
+	uint16_t		Length;
+	uint16_t		FirstLength;
+	uint16_t		NbReply;
+	uint16_t		CollisionBit;			// first bit which differs between the replies
+	uint8_t			StartBit;					// bits of the first byte sent by the PCD device (ISO14443A split frame)
+	uint8_t			NbBit;
+	bool				CRCError;
+	bool				Overflow;
+	uint32_t		Delay_us;
+	VTAG_TAG		*pReplier[VTAG_MAX_NBTAG];
+}VTAG_RECEPTION;
+
+static VTAG_RECEPTION	VTAG_Rx;
+
+static uc8 VTAG_T4Application [] = {0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01};
+static uc16 VTAG_FrameSize [] = {16, 24, 32, 40, 48, 64, 96, 128, 256};
+
+static uint16_t VTAG_CRC16 							( uc16 Preload, uc8 *pData, uc16 Length);
+static void VTAG_AppendCRC 							( uc8 Protocol, VTAG_REPLY *pReply);
+static uint32_t VTAG_AirTime 						( const VTAG_POPULATION *pPopulation, uc16 NbByte);
+static void VTAG_ProtocolSelect 				( VTAG_POPULATION *pPopulation, uc8 *pCommand, uint8_t *pResponse);
+/* ISO15693 */
+static void VTAG_ISO15693Error 					( VTAG_REPLY *pReply, uc8 ErrorCode);
+static void VTAG_ISO15693InventoryReply ( const VTAG_TAG *pTag, VTAG_REPLY *pReply);
+static void VTAG_ISO15693Inventory 			( VTAG_TAG *pTag, uc8 *pFrame, uc8 Length, VTAG_REPLY *pReply);
+static void VTAG_ISO15693Tag 						( VTAG_POPULATION *pPopulation, VTAG_TAG *pTag, uc8 *pFrame, uc8 Length, VTAG_REPLY *pReply);
+/* ISO14443A */
+static void VTAG_ISO14443ACLn 					( const VTAG_TAG *pTag, uc8 Level, uint8_t *pCLn);
+static void VTAG_ISO14443AAnticollision ( VTAG_TAG *pTag, uc8 *pFrame, uc8 Length, VTAG_REPLY *pReply);
+static void VTAG_T2Command 							( VTAG_TAG *pTag, uc8 *pFrame, uc8 Length, VTAG_REPLY *pReply);
+static void VTAG_ISO14443ATag 					( VTAG_POPULATION *pPopulation, VTAG_TAG *pTag, uc8 *pFrame, uc8 Length, VTAG_REPLY *pReply);
+/* ISO14443B */
+static void VTAG_ISO14443BATQB 					( const VTAG_TAG *pTag, VTAG_REPLY *pReply);
+static void VTAG_ISO14443BTag 					( VTAG_POPULATION *pPopulation, VTAG_TAG *pTag, uc8 *pFrame, uc8 Length, VTAG_REPLY *pReply);
+/* ISO-DEP */
+static void VTAG_IsoDepActivate 				( VTAG_POPULATION *pPopulation, VTAG_TAG *pTag, uc8 FSDI);
+static void VTAG_IsoDepSend 						( VTAG_POPULATION *pPopulation, uc8 PCB, uc8 *pInf, uc16 InfLength, VTAG_REPLY *pReply);
+static void VTAG_IsoDepNextBlock 				( VTAG_POPULATION *pPopulation, VTAG_REPLY *pReply);
+static uint16_t VTAG_T4Apdu 						( VTAG_TAG *pTag, uint8_t *pApdu, uc16 Length, uint32_t *pDelay_us);
+static void VTAG_IsoDep 								( VTAG_POPULATION *pPopulation, VTAG_TAG *pTag, uc8 *pBlock, uc8 Length, VTAG_REPLY *pReply);
+/* frames */
+static void VTAG_StartReception 				( VTAG_RECEPTION *pRx);
+static void VTAG_Receive 								( VTAG_RECEPTION *pRx, VTAG_TAG *pTag, const VTAG_REPLY *pReply);
+static void VTAG_EndReception 					( VTAG_POPULATION *pPopulation, VTAG_RECEPTION *pRx, uc16 RequestLength, uint8_t *pResponse);
+static void VTAG_SendRecv 							( VTAG_POPULATION *pPopulation, uc8 *pFrame, uc8 Length, uint8_t *pResponse);
+
+/** @addtogroup _VirtualTag_Libraries
+ * 	@{
+ */
+
+/** @addtogroup lib_vtagfield
+ * 	@{
+ *	@brief  This file answers the commands of the 95HF (Echo, IDN, ProtocolSelect, SendRecv, registers)
+ *					with the replies of the virtual tags of the protocol selected. Each tag follows the state
+ *					machine of its protocol, the replies of several tags are merged with the collision flags
+ *					of the 95HF, and errors are injected with the rates of each tag. A virtual clock counts
+ *					the time of the frames, the replies and the time outs.
+ */
+
+
+/** @addtogroup lib_vtagfield_Private_Functions
+ * 	@{
+ */
+
+/**
+ * @brief  This function computes a CRC16 (ISO/IEC 13239 polynomial, LSB first)
+ * @param  Preload : initial value (0xFFFF ISO15693 and ISO14443B, 0x6363 ISO14443A)
+ * @param  pData : data
+ * @param  Length : number of bytes
+ * @retval CRC (not inverted)
+ */
+static uint16_t VTAG_CRC16 (uc16 Preload, uc8 *pData, uc16 Length)
+{
+	uint16_t CRC = Preload, NthByte;
+	uint8_t NthBit;
+
+	for (NthByte = 0; NthByte < Length; NthByte++)
+	{
+		CRC ^= pData[NthByte];
+		for (NthBit = 0; NthBit < 8; NthBit++)
+			CRC = ((CRC & 0x0001) != 0) ? (CRC >> 1) ^ 0x8408 : CRC >> 1;
+	}
+
+	return CRC;
+}
+
+/**
+ * @brief  This function appends the CRC of the protocol to a reply
+ * @param  Protocol : PCD_PROTOCOL_xxx
+ * @param  pReply : reply
+ * @retval None
+ */
+static void VTAG_AppendCRC (uc8 Protocol, VTAG_REPLY *pReply)
+{
+	uint16_t CRC;
+
+	if (Protocol == PCD_PROTOCOL_ISO14443A)
+		CRC = VTAG_CRC16(0x6363, pReply->Data, pReply->Length);
+	else
+		CRC = ~VTAG_CRC16(0xFFFF, pReply->Data, pReply->Length);
+
+	pReply->Data[pReply->Length++] = GETLSB(CRC);
+	pReply->Data[pReply->Length++] = GETMSB(CRC);
+	pReply->HasCRC = true;
+}
+
+/**
+ * @brief  This function returns the time of a frame at the bit rate of the field
+ * @param  pPopulation : population
+ * @param  NbByte : number of bytes of the frame (CRC included)
+ * @retval time in us
+ */
+static uint32_t VTAG_AirTime (const VTAG_POPULATION *pPopulation, uc16 NbByte)
+{
+	switch (pPopulation->Protocol)
+	{
+		case PCD_PROTOCOL_ISO15693:
+			return ((((uint32_t)NbByte*8*VTAG_ISO15693_BIT_NS) >> pPopulation->BitRateShift) / 1000) + VTAG_ISO15693_SOFEOF_US;
+		case PCD_PROTOCOL_ISO14443A:
+			/* 8 bits and the parity bit per byte */
+			return (((uint32_t)NbByte*9*VTAG_ISO14443_ETU_NS) >> pPopulation->BitRateShift) / 1000;
+		default:
+			/* start bit, 8 bits and stop bit per byte */
+			return ((((uint32_t)NbByte*10 + VTAG_ISO14443B_SOFEOF_ETU)*VTAG_ISO14443_ETU_NS) >> pPopulation->BitRateShift) / 1000;
+	}
+}
+
+/**
+ * @brief  This function handles the ProtocolSelect command : field on (tags powered), field off or
+ * @brief  change of protocol and bit rate
+ * @param  pPopulation : population
+ * @param  pCommand : ProtocolSelect command (command code, length, protocol, parameters)
+ * @param  pResponse : 95HF response
+ * @retval None
+ */
+static void VTAG_ProtocolSelect (VTAG_POPULATION *pPopulation, uc8 *pCommand, uint8_t *pResponse)
+{
+	uint8_t Protocol = pCommand[PCD_DATA_OFFSET],
+					Parameter = pCommand[PCD_DATA_OFFSET+1];
+	uint16_t NthTag;
+
+	pResponse[PCD_LENGTH_OFFSET] = 0x00;
+	if (pCommand[PCD_LENGTH_OFFSET] < PROTOCOLSELECT_LENGTH || Protocol > PCD_PROTOCOL_FELICA)
+	{
+		pResponse[READERREPLY_STATUSOFFSET] = PROTOCOLSELECT_ERRORCODE_INVALID;
+		return;
+	}
+	pResponse[READERREPLY_STATUSOFFSET] = PROTOCOLSELECT_RESULTSCODE_OK;
+
+	if (Protocol == PCD_PROTOCOL_FIELDOFF)
+	{
+		VTAG_FieldOff(pPopulation);
+		return;
+	}
+
+	/* the tags are powered when the field is switched on, they keep their state when the protocol changes */
+	if (pPopulation->Protocol == PCD_PROTOCOL_FIELDOFF)
+		for (NthTag = 0; NthTag < pPopulation->NbTag; NthTag++)
+			pPopulation->pTag[NthTag].State = VTAG_STATE_IDLE;
+
+	pPopulation->Protocol = Protocol;
+	pPopulation->InventorySlot = VTAG_NOSLOT;
+	/* ISO15693 : high data rate x2, ISO14443 : bit rate from the card */
+	if (Protocol == PCD_PROTOCOL_ISO15693)
+		pPopulation->BitRateShift = (((Parameter >> 4) & 0x03) == 0x01) ? 1 : 0;
+	else
+		pPopulation->BitRateShift = (Parameter >> 4) & 0x03;
+}
+
+/**
+ * @brief  This function builds an ISO15693 error reply
+ * @param  pReply : reply
+ * @param  ErrorCode : VTAG_ISO15693_ERROR_xxx
+ * @retval None
+ */
+static void VTAG_ISO15693Error (VTAG_REPLY *pReply, uc8 ErrorCode)
+{
+	pReply->Data[0] = VTAG_ISO15693_FLAG_ERROR;
+	pReply->Data[1] = ErrorCode;
+	pReply->Length = 2;
+}
+
+/**
+ * @brief  This function writes the reply of a tag to an Inventory or an ST Inventory Read request
+ * @param  pTag : tag (ReadFirstBlock, ReadNbBlock and ReadNbUIDByte set by the request)
+ * @param  pReply : reply
+ * @retval None
+ */
+static void VTAG_ISO15693InventoryReply (const VTAG_TAG *pTag, VTAG_REPLY *pReply)
+{
+	pReply->Data[pReply->Length++] = 0x00;
+	pReply->Data[pReply->Length++] = pTag->DSFID;
+	/* the UID bytes which are not covered by the mask (LSB first) */
+	memcpy(&pReply->Data[pReply->Length], &pTag->UID[ISO15693_NBBYTE_UID - pTag->ReadNbUIDByte], pTag->ReadNbUIDByte);
+	pReply->Length += pTag->ReadNbUIDByte;
+	memcpy(&pReply->Data[pReply->Length], &pTag->pMemory[pTag->ReadFirstBlock*VTAG_ISO15693_BLOCKSIZE], pTag->ReadNbBlock*VTAG_ISO15693_BLOCKSIZE);
+	pReply->Length += pTag->ReadNbBlock*VTAG_ISO15693_BLOCKSIZE;
+}
+
+/**
+ * @brief  This function handles the Inventory and ST Inventory Read requests (inventory flag set).
+ * @brief  With 16 slots the tag answers in the slot of the 4 UID bits behind the mask. Without the
+ * @brief  option flag the ST Inventory Read only returns the UID bytes not covered by the mask.
+ * @param  pTag : tag
+ * @param  pFrame : request
+ * @param  Length : number of bytes of the request
+ * @param  pReply : reply (the tag answers later when the Level of the tag is set to its slot)
+ * @retval None
+ */
+static void VTAG_ISO15693Inventory (VTAG_TAG *pTag, uc8 *pFrame, uc8 Length, VTAG_REPLY *pReply)
+{
+	uint8_t Flags = pFrame[0],
+					Command = pFrame[1],
+					Offset = 2,
+					MaskLength,
+					NthBit,
+					Slot;
+
+	if (Command == ISO15693_CMDCODE_ST_INVENTORYREAD)
+	{
+		if (Length < 3 || pFrame[Offset++] != ISO15693_ICMFGCODE_ST)
+			return;
+	}
+	else if (Command != ISO15693_CMDCODE_INVENTORY)
+		return;
+
+	if (pTag->State == VTAG_STATE_QUIET)
+		return;
+	if ((Flags & VTAG_ISO15693_FLAG_SELECTORAFI) != 0)
+	{
+		if (Offset >= Length || (pFrame[Offset] != 0x00 && pFrame[Offset] != pTag->AFI))
+			return;
+		Offset++;
+	}
+
+	/* mask : first bits of the UID, LSB first */
+	if (Offset >= Length)
+		return;
+	MaskLength = pFrame[Offset++];
+	if (MaskLength > 64 || Offset + (MaskLength+7)/8 > Length)
+		return;
+	for (NthBit = 0; NthBit < MaskLength; NthBit++)
+		if (((pFrame[Offset + NthBit/8] ^ pTag->UID[NthBit/8]) & (1 << (NthBit%8))) != 0)
+			return;
+	Offset += (MaskLength+7)/8;
+
+	pTag->ReadFirstBlock = 0;
+	pTag->ReadNbBlock = 0;
+	pTag->ReadNbUIDByte = ISO15693_NBBYTE_UID;
+	if (Command == ISO15693_CMDCODE_ST_INVENTORYREAD)
+	{
+		if (Offset + 2 > Length || pFrame[Offset] + pFrame[Offset+1] + 1 > VTAG_Model[pTag->Model].NbBlock)
+			return;
+		pTag->ReadFirstBlock = pFrame[Offset];
+		pTag->ReadNbBlock = pFrame[Offset+1] + 1;
+		if ((Flags & VTAG_ISO15693_FLAG_OPTION) == 0)
+			pTag->ReadNbUIDByte = ISO15693_NBBYTE_UID - MaskLength/8;
+		if (2 + pTag->ReadNbUIDByte + pTag->ReadNbBlock*VTAG_ISO15693_BLOCKSIZE + ISO15693_NBBYTE_CRC16 > VTAG_MAX_REPLY_SIZE)
+			return;
+	}
+
+	/* 16 slots */
+	Slot = 0;
+	if ((Flags & VTAG_ISO15693_FLAG_ADDRORNBSLOT) == 0)
+	{
+		for (NthBit = 0; NthBit < 4 && MaskLength + NthBit < 64; NthBit++)
+			if ((pTag->UID[(MaskLength + NthBit)/8] & (1 << ((MaskLength + NthBit)%8))) != 0)
+				Slot |= 1 << NthBit;
+	}
+	if (Slot != 0)
+		pTag->Level = Slot;
+	else
+		VTAG_ISO15693InventoryReply(pTag, pReply);
+}
+
+/**
+ * @brief  This function handles an ISO15693 request (or an EOF) received by a tag
+ * @param  pPopulation : population
+ * @param  pTag : tag
+ * @param  pFrame : request without CRC
+ * @param  Length : number of bytes of the request (0 => EOF)
+ * @param  pReply : reply without CRC
+ * @retval None
+ */
+static void VTAG_ISO15693Tag (VTAG_POPULATION *pPopulation, VTAG_TAG *pTag, uc8 *pFrame, uc8 Length, VTAG_REPLY *pReply)
+{
+	const VTAG_MODEL *pModel = &VTAG_Model[pTag->Model];
+	uint8_t Flags, Command, Offset = 2, *pData = pReply->Data, NthByte;
+	uint16_t Block = 0, NbBlock = 1, NthBlock;
+
+	/* EOF : next slot of an inventory or end of a write with the option flag */
+	if (Length == 0)
+	{
+		if (pTag->Level == VTAG_ISO15693_WRITEREPLY)
+		{
+			pTag->Level = VTAG_NOSLOT;
+			pData[pReply->Length++] = 0x00;
+		}
+		else if (pPopulation->InventorySlot != VTAG_NOSLOT && pTag->Level == pPopulation->InventorySlot)
+		{
+			pTag->Level = VTAG_NOSLOT;
+			VTAG_ISO15693InventoryReply(pTag, pReply);
+		}
+		return;
+	}
+	if (Length < 2)
+		return;
+
+	Flags = pFrame[0];
+	Command = pFrame[1];
+	pTag->Level = VTAG_NOSLOT;
+
+	if ((Flags & VTAG_ISO15693_FLAG_INVENTORY) != 0)
+	{
+		VTAG_ISO15693Inventory(pTag, pFrame, Length, pReply);
+		return;
+	}
+
+	/* addressed, selected or non addressed request */
+	if ((Flags & VTAG_ISO15693_FLAG_ADDRORNBSLOT) != 0)
+	{
+		if (Length < 2 + ISO15693_NBBYTE_UID || memcmp(&pFrame[2], pTag->UID, ISO15693_NBBYTE_UID) != 0)
+		{
+			/* the selected tag goes back to ready when another tag is selected */
+			if (Command == ISO15693_CMDCODE_SELECT && pTag->State == VTAG_STATE_SELECTED)
+				pTag->State = VTAG_STATE_IDLE;
+			return;
+		}
+		Offset += ISO15693_NBBYTE_UID;
+	}
+	else if ((Flags & VTAG_ISO15693_FLAG_SELECTORAFI) != 0)
+	{
+		if (pTag->State != VTAG_STATE_SELECTED)
+			return;
+	}
+	else if (pTag->State == VTAG_STATE_QUIET)
+		return;
+
+	switch (Command)
+	{
+		case ISO15693_CMDCODE_STAYQUIET:
+			if ((Flags & VTAG_ISO15693_FLAG_ADDRORNBSLOT) != 0)
+				pTag->State = VTAG_STATE_QUIET;
+			return;
+		case ISO15693_CMDCODE_SELECT:
+			pTag->State = VTAG_STATE_SELECTED;
+			pData[pReply->Length++] = 0x00;
+			return;
+		case ISO15693_CMDCODE_RESETTOREADY:
+			pTag->State = VTAG_STATE_IDLE;
+			pData[pReply->Length++] = 0x00;
+			return;
+		default:
+			break;
+	}
+
+	/* the block numbers are on 2 bytes with the protocol extension flag, the high density tags require it */
+	if ((Flags & VTAG_ISO15693_FLAG_PROTEXT) != 0 && (pModel->Flags & VTAG_MODELFLAG_HIGHDENSITY) == 0)
+	{
+		VTAG_ISO15693Error(pReply, VTAG_ISO15693_ERROR_OPTION);
+		return;
+	}
+	if ((Flags & VTAG_ISO15693_FLAG_PROTEXT) == 0 && (pModel->Flags & VTAG_MODELFLAG_HIGHDENSITY) != 0 &&
+			(Command == ISO15693_CMDCODE_READSINGLEBLOCK || Command == ISO15693_CMDCODE_WRITESINGLEBLOCK ||
+			 Command == ISO15693_CMDCODE_READMULBLOCKS || Command == ISO15693_CMDCODE_LOCKBLOCK ||
+			 Command == ISO15693_CMDCODE_GETSECURITYINFO))
+	{
+		VTAG_ISO15693Error(pReply, VTAG_ISO15693_ERROR_OPTION);
+		return;
+	}
+	if (Command == ISO15693_CMDCODE_READSINGLEBLOCK || Command == ISO15693_CMDCODE_WRITESINGLEBLOCK ||
+			Command == ISO15693_CMDCODE_READMULBLOCKS || Command == ISO15693_CMDCODE_LOCKBLOCK ||
+			Command == ISO15693_CMDCODE_GETSECURITYINFO || Command == ISO15693_CMDCODE_EXTREADMULBLOCKS)
+	{
+		if (Offset >= Length)
+		{
+			VTAG_ISO15693Error(pReply, VTAG_ISO15693_ERROR_NOTRECOGNIZED);
+			return;
+		}
+		Block = pFrame[Offset++];
+		if ((Flags & VTAG_ISO15693_FLAG_PROTEXT) != 0 || Command == ISO15693_CMDCODE_EXTREADMULBLOCKS)
+			Block |= (Offset < Length) ? pFrame[Offset++] << 8 : 0x0000;
+		if (Command == ISO15693_CMDCODE_READMULBLOCKS || Command == ISO15693_CMDCODE_GETSECURITYINFO)
+			NbBlock = (Offset < Length) ? pFrame[Offset++] + 1 : 1;
+		else if (Command == ISO15693_CMDCODE_EXTREADMULBLOCKS && Offset + 2 <= Length)
+		{
+			NbBlock = (pFrame[Offset] | (pFrame[Offset+1] << 8)) + 1;
+			Offset += 2;
+		}
+		if (Block + NbBlock > pModel->NbBlock)
+		{
+			VTAG_ISO15693Error(pReply, VTAG_ISO15693_ERROR_BLOCK);
+			return;
+		}
+	}
+
+	switch (Command)
+	{
+		case ISO15693_CMDCODE_READMULBLOCKS:
+			if ((pModel->Flags & VTAG_MODELFLAG_NOREADMULTIPLE) != 0)
+			{
+				VTAG_ISO15693Error(pReply, VTAG_ISO15693_ERROR_NOTSUPPORTED);
+				return;
+			}
+			/* no break */
+		case ISO15693_CMDCODE_READSINGLEBLOCK:
+		case ISO15693_CMDCODE_EXTREADMULBLOCKS:
+			if (Command == ISO15693_CMDCODE_EXTREADMULBLOCKS && (pModel->Flags & VTAG_MODELFLAG_HIGHDENSITY) == 0)
+			{
+				VTAG_ISO15693Error(pReply, VTAG_ISO15693_ERROR_NOTSUPPORTED);
+				return;
+			}
+			if (1 + NbBlock*(VTAG_ISO15693_BLOCKSIZE+1) + ISO15693_NBBYTE_CRC16 > VTAG_MAX_REPLY_SIZE)
+			{
+				pReply->Length = VTAG_REPLY_OVERFLOW;
+				return;
+			}
+			pData[pReply->Length++] = 0x00;
+			for (NthBlock = Block; NthBlock < Block + NbBlock; NthBlock++)
+			{
+				/* block security status */
+				if ((Flags & VTAG_ISO15693_FLAG_OPTION) != 0)
+					pData[pReply->Length++] = 0x00;
+				memcpy(&pData[pReply->Length], &pTag->pMemory[NthBlock*VTAG_ISO15693_BLOCKSIZE], VTAG_ISO15693_BLOCKSIZE);
+				pReply->Length += VTAG_ISO15693_BLOCKSIZE;
+			}
+			return;
+
+		case ISO15693_CMDCODE_WRITESINGLEBLOCK:
+			if (Offset + VTAG_ISO15693_BLOCKSIZE > Length)
+			{
+				VTAG_ISO15693Error(pReply, VTAG_ISO15693_ERROR_NOTRECOGNIZED);
+				return;
+			}
+			memcpy(&pTag->pMemory[Block*VTAG_ISO15693_BLOCKSIZE], &pFrame[Offset], VTAG_ISO15693_BLOCKSIZE);
+			/* no break */
+		case ISO15693_CMDCODE_LOCKBLOCK:
+		case ISO15693_CMDCODE_LOCKAFI:
+		case ISO15693_CMDCODE_LOCKDSFID:
+		case ISO15693_CMDCODE_WRITEAFI:
+		case ISO15693_CMDCODE_WRITEDSFID:
+			if (Command == ISO15693_CMDCODE_WRITEAFI || Command == ISO15693_CMDCODE_WRITEDSFID)
+			{
+				if (Offset >= Length)
+				{
+					VTAG_ISO15693Error(pReply, VTAG_ISO15693_ERROR_NOTRECOGNIZED);
+					return;
+				}
+				if (Command == ISO15693_CMDCODE_WRITEAFI)
+					pTag->AFI = pFrame[Offset];
+				else
+					pTag->DSFID = pFrame[Offset];
+			}
+			pReply->Delay_us = pModel->WriteTime_us;
+			/* with the option flag the tag answers to the next EOF */
+			if ((Flags & VTAG_ISO15693_FLAG_OPTION) != 0)
+				pTag->Level = VTAG_ISO15693_WRITEREPLY;
+			else
+				pData[pReply->Length++] = 0x00;
+			return;
+
+		case ISO15693_CMDCODE_GETSYSINFO:
+			pData[pReply->Length++] = 0x00;
+			pData[pReply->Length++] = 0x0F;		// DSFID, AFI, memory size and IC reference
+			memcpy(&pData[pReply->Length], pTag->UID, ISO15693_NBBYTE_UID);
+			pReply->Length += ISO15693_NBBYTE_UID;
+			pData[pReply->Length++] = pTag->DSFID;
+			pData[pReply->Length++] = pTag->AFI;
+			pData[pReply->Length++] = GETLSB((pModel->NbBlock - 1));
+			if ((Flags & VTAG_ISO15693_FLAG_PROTEXT) != 0)
+				pData[pReply->Length++] = GETMSB((pModel->NbBlock - 1));
+			pData[pReply->Length++] = VTAG_ISO15693_BLOCKSIZE - 1;
+			pData[pReply->Length++] = pModel->ICRef;
+			return;
+
+		case ISO15693_CMDCODE_GETSECURITYINFO:
+			if (1 + NbBlock + ISO15693_NBBYTE_CRC16 > VTAG_MAX_REPLY_SIZE)
+			{
+				pReply->Length = VTAG_REPLY_OVERFLOW;
+				return;
+			}
+			pData[pReply->Length++] = 0x00;
+			for (NthByte = 0; NthByte < NbBlock; NthByte++)
+				pData[pReply->Length++] = 0x00;
+			return;
+
+		default:
+			/* Write Multiple Blocks is not supported by the M24LR and LRi tags */
+			VTAG_ISO15693Error(pReply, VTAG_ISO15693_ERROR_NOTSUPPORTED);
+			return;
+	}
+}
+
+/**
+ * @brief  This function returns the UID CLn of a cascade level followed by its BCC
+ * @param  pTag : tag
+ * @param  Level : cascade level (0 to 2)
+ * @param  pCLn : UID CLn and BCC (5 bytes)
+ * @retval None
+ */
+static void VTAG_ISO14443ACLn (const VTAG_TAG *pTag, uc8 Level, uint8_t *pCLn)
+{
+	uint8_t NbLevel = (pTag->UIDsize == 4) ? 1 : (pTag->UIDsize == 7) ? 2 : 3;
+
+	if (Level < NbLevel - 1)
+	{
+		pCLn[0] = ISO14443A_CASCADETAG;
+		memcpy(&pCLn[1], &pTag->UID[Level*3], 3);
+	}
+	else
+		memcpy(pCLn, &pTag->UID[Level*3], 4);
+	pCLn[4] = pCLn[0] ^ pCLn[1] ^ pCLn[2] ^ pCLn[3];
+}
+
+/**
+ * @brief  This function handles the anticollision and SELECT commands of the cascade levels
+ * @param  pTag : tag
+ * @param  pFrame : command without the control byte
+ * @param  Length : number of bytes of the command
+ * @param  pReply : reply (from the byte of the first unknown bit, the known bits are cleared)
+ * @retval None
+ */
+static void VTAG_ISO14443AAnticollision (VTAG_TAG *pTag, uc8 *pFrame, uc8 Length, VTAG_REPLY *pReply)
+{
+	uint8_t CLn[ISO14443A_UID_SINGLE_SIZE+ISO14443A_NBBYTE_BCC],
+					Level = (pFrame[0] - SEL_CASCADE_LVL_1)/2,
+					NbKnownBit,
+					NthBit,
+					NbLevel = (pTag->UIDsize == 4) ? 1 : (pTag->UIDsize == 7) ? 2 : 3;
+
+	if (pTag->State != VTAG_STATE_READY)
+		return;
+	if (Length < 2 || pTag->Level != Level)
+	{
+		pTag->State = VTAG_STATE_IDLE;
+		return;
+	}
+	VTAG_ISO14443ACLn(pTag, Level, CLn);
+
+	/* SELECT : the other cards of the cascade level go back to idle */
+	if (pFrame[1] == VTAG_ISO14443A_SELECT_NVB)
+	{
+		if (Length < 2 + sizeof(CLn) || memcmp(&pFrame[2], CLn, sizeof(CLn)) != 0)
+		{
+			pTag->State = VTAG_STATE_IDLE;
+			return;
+		}
+		if (Level == NbLevel - 1)
+		{
+			pTag->State = VTAG_STATE_ACTIVE;
+			pReply->Data[pReply->Length++] = (pTag->Kind == VTAG_KIND_T2) ? 0x00 : VTAG_ISO14443A_SAK_ISODEP;
+		}
+		else
+		{
+			pTag->Level++;
+			pReply->Data[pReply->Length++] = VTAG_ISO14443A_SAK_NOTCOMPLETE;
+		}
+		VTAG_AppendCRC(PCD_PROTOCOL_ISO14443A, pReply);
+		return;
+	}
+
+	/* ANTICOLLISION : the card whose UID CLn starts with the known bits sends the other bits */
+	NbKnownBit = ((pFrame[1] >> 4) - 2)*8 + (pFrame[1] & 0x0F);
+	if (NbKnownBit >= ISO14443A_NBBIT_UIDCLN || Length < 2 + (NbKnownBit+7)/8)
+		return;
+	for (NthBit = 0; NthBit < NbKnownBit; NthBit++)
+		if (((pFrame[2 + NthBit/8] ^ CLn[NthBit/8]) & (1 << (NthBit%8))) != 0)
+			return;
+
+	memcpy(pReply->Data, &CLn[NbKnownBit/8], sizeof(CLn) - NbKnownBit/8);
+	pReply->Data[0] &= 0xFF << (NbKnownBit%8);
+	pReply->Length = sizeof(CLn) - NbKnownBit/8;
+}
+
+/**
+ * @brief  This function handles a Type 2 command of a selected card
+ * @param  pTag : tag
+ * @param  pFrame : command without the control byte
+ * @param  Length : number of bytes of the command
+ * @param  pReply : reply
+ * @retval None
+ */
+static void VTAG_T2Command (VTAG_TAG *pTag, uc8 *pFrame, uc8 Length, VTAG_REPLY *pReply)
+{
+	const VTAG_MODEL *pModel = &VTAG_Model[pTag->Model];
+	uint16_t NbPage = pModel->NbBlock, Page, LastPage, NthPage;
+	uint8_t NthByte;
+
+	/* second frame of a COMPATIBILITY_WRITE : 16 bytes, the first 4 ones are written */
+	if ((pTag->File & VTAG_T2_COMPATWRITE) != 0)
+	{
+		Page = pTag->File & ~VTAG_T2_COMPATWRITE;
+		pTag->File = 0x0000;
+		if (Length != 16)
+			goto Nak;
+		memcpy(&pTag->pMemory[Page*4], pFrame, 4);
+		pReply->Delay_us = pModel->WriteTime_us;
+		goto Ack;
+	}
+
+	switch (pFrame[0])
+	{
+		case PCDNFCT2_READ:
+			if (Length != 2 || pFrame[1] >= NbPage)
+				goto Nak;
+			/* 4 pages, roll over at the end of the memory */
+			for (NthPage = 0; NthPage < 4; NthPage++)
+				memcpy(&pReply->Data[NthPage*4], &pTag->pMemory[((pFrame[1] + NthPage) % NbPage)*4], 4);
+			pReply->Length = 16;
+			break;
+
+		case PCDNFCT2_FAST_READ:
+			if ((pModel->Flags & VTAG_MODELFLAG_GETVERSION) == 0 || Length != 3 || pFrame[1] > pFrame[2] || pFrame[2] >= NbPage)
+				goto Nak;
+			Page = pFrame[1];
+			LastPage = pFrame[2];
+			if ((LastPage - Page + 1)*4 + 2 > VTAG_MAX_REPLY_SIZE)
+			{
+				pReply->Length = VTAG_REPLY_OVERFLOW;
+				return;
+			}
+			memcpy(pReply->Data, &pTag->pMemory[Page*4], (LastPage - Page + 1)*4);
+			pReply->Length = (LastPage - Page + 1)*4;
+			break;
+
+		case PCDNFCT2_WRITE:
+			if (Length != 6 || pFrame[1] < 2 || pFrame[1] >= NbPage)
+				goto Nak;
+			Page = pFrame[1];
+			/* lock bytes and CC are one time programmable */
+			if (Page == 2)
+			{
+				pTag->pMemory[10] |= pFrame[4];
+				pTag->pMemory[11] |= pFrame[5];
+			}
+			else if (Page == 3)
+				for (NthByte = 0; NthByte < 4; NthByte++)
+					pTag->pMemory[12 + NthByte] |= pFrame[2 + NthByte];
+			else
+				memcpy(&pTag->pMemory[Page*4], &pFrame[2], 4);
+			pReply->Delay_us = pModel->WriteTime_us;
+			goto Ack;
+
+		case PCDNFCT2_COMPATIBILITY_WRITE:
+			if (Length != 2 || pFrame[1] < 4 || pFrame[1] >= NbPage)
+				goto Nak;
+			pTag->File = VTAG_T2_COMPATWRITE | pFrame[1];
+			goto Ack;
+
+		case PCDNFCT2_GET_VERSION:
+			/* the Ultralight does not know GET_VERSION and goes back to idle */
+			if ((pModel->Flags & VTAG_MODELFLAG_GETVERSION) == 0)
+			{
+				pTag->State = VTAG_STATE_IDLE;
+				return;
+			}
+			memcpy(pReply->Data, "\x00\x04\x04\x02\x01\x00\x00\x03", 8);
+			pReply->Data[6] = pModel->ICRef;
+			pReply->Length = 8;
+			break;
+
+		case PCDNFCT2_READ_SIG:
+			if ((pModel->Flags & VTAG_MODELFLAG_GETVERSION) == 0)
+				goto Nak;
+			memset(pReply->Data, 0x00, 32);
+			memcpy(pReply->Data, pTag->UID, pTag->UIDsize);
+			pReply->Length = 32;
+			break;
+
+		default:
+			/* SECTOR_SELECT : the emulated tags have one sector */
+			goto Nak;
+	}
+
+	VTAG_AppendCRC(PCD_PROTOCOL_ISO14443A, pReply);
+	return;
+
+Ack:
+	pReply->Data[0] = VTAG_T2_ACK;
+	pReply->Length = 1;
+	pReply->NbBit = 4;
+	return;
+
+Nak:
+	pReply->Data[0] = VTAG_T2_NAK;
+	pReply->Length = 1;
+	pReply->NbBit = 4;
+	pTag->State = VTAG_STATE_IDLE;
+}
+
+/**
+ * @brief  This function handles an ISO14443A frame received by a tag
+ * @param  pPopulation : population
+ * @param  pTag : tag
+ * @param  pFrame : frame followed by the control byte of the 95HF
+ * @param  Length : number of bytes of the frame and the control byte
+ * @param  pReply : reply
+ * @retval None
+ */
+static void VTAG_ISO14443ATag (VTAG_POPULATION *pPopulation, VTAG_TAG *pTag, uc8 *pFrame, uc8 Length, VTAG_REPLY *pReply)
+{
+	uint8_t Control = pFrame[Length-1],
+					NbByte = Length - 1;
+
+	if (NbByte == 0)
+		return;
+
+	/* REQA and WUPA (short frames) */
+	if (NbByte == 1 && (Control & 0x0F) == 0x07 && (pFrame[0] == VTAG_ISO14443A_REQA || pFrame[0] == VTAG_ISO14443A_WUPA))
+	{
+		if (pPopulation->pActive == pTag)
+			return;
+		if (pTag->State == VTAG_STATE_IDLE || (pTag->State == VTAG_STATE_HALT && pFrame[0] == VTAG_ISO14443A_WUPA))
+		{
+			pTag->State = VTAG_STATE_READY;
+			pTag->Level = 0;
+			pTag->File = 0x0000;
+			pReply->Data[0] = ((pTag->UIDsize == 4) ? 0x00 : (pTag->UIDsize == 7) ? 0x40 : 0x80) | 0x04;
+			pReply->Data[1] = 0x00;
+			pReply->Length = ISO14443A_ATQA_SIZE;
+		}
+		else if (pTag->State != VTAG_STATE_HALT)
+			pTag->State = VTAG_STATE_IDLE;
+		return;
+	}
+
+	switch (pTag->State)
+	{
+		case VTAG_STATE_READY:
+			if (pFrame[0] == SEL_CASCADE_LVL_1 || pFrame[0] == SEL_CASCADE_LVL_2 || pFrame[0] == SEL_CASCADE_LVL_3)
+				VTAG_ISO14443AAnticollision(pTag, pFrame, NbByte, pReply);
+			else
+				pTag->State = VTAG_STATE_IDLE;
+			return;
+
+		case VTAG_STATE_ACTIVE:
+			if (pPopulation->pActive == pTag)
+				VTAG_IsoDep(pPopulation, pTag, pFrame, NbByte, pReply);
+			else if (pFrame[0] == VTAG_ISO14443A_HLTA && NbByte == 2 && pFrame[1] == 0x00)
+				pTag->State = VTAG_STATE_HALT;
+			else if (pTag->Kind == VTAG_KIND_T2)
+				VTAG_T2Command(pTag, pFrame, NbByte, pReply);
+			else if (pFrame[0] == VTAG_ISO14443A_RATS && NbByte == 2)
+			{
+				VTAG_IsoDepActivate(pPopulation, pTag, pFrame[1] >> 4);
+				/* ATS : FSCI 256 bytes, 106 kbps only, FWI 8, no CID nor NAD */
+				memcpy(pReply->Data, "\x05\x78\x80\x80\x00", 5);
+				pReply->Length = 5;
+				VTAG_AppendCRC(PCD_PROTOCOL_ISO14443A, pReply);
+			}
+			else
+				pTag->State = VTAG_STATE_IDLE;
+			return;
+
+		default:
+			return;
+	}
+}
+
+/**
+ * @brief  This function builds the ATQB of a tag
+ * @param  pTag : tag
+ * @param  pReply : reply
+ * @retval None
+ */
+static void VTAG_ISO14443BATQB (const VTAG_TAG *pTag, VTAG_REPLY *pReply)
+{
+	pReply->Data[pReply->Length++] = ISO14443B_ATQB_FIRSTBYTE;
+	memcpy(&pReply->Data[pReply->Length], pTag->UID, ISO14443B_MAX_PUPI_SIZE);
+	pReply->Length += ISO14443B_MAX_PUPI_SIZE;
+	/* application data : AFI, CRC_B(AID), number of applications */
+	pReply->Data[pReply->Length++] = pTag->AFI;
+	pReply->Data[pReply->Length++] = 0x00;
+	pReply->Data[pReply->Length++] = 0x00;
+	pReply->Data[pReply->Length++] = 0x00;
+	/* protocol info : 106 kbps only, FSCI 256 bytes ISO14443-4, FWI 8 */
+	pReply->Data[pReply->Length++] = 0x00;
+	pReply->Data[pReply->Length++] = 0x81;
+	pReply->Data[pReply->Length++] = 0x80;
+	VTAG_AppendCRC(PCD_PROTOCOL_ISO14443B, pReply);
+}
+
+/**
+ * @brief  This function handles an ISO14443B frame received by a tag. A REQB/WUPB draws the slot of
+ * @brief  each card, the card answers in slot 1 or to the Slot-MARKER of its slot.
+ * @param  pPopulation : population
+ * @param  pTag : tag
+ * @param  pFrame : frame without CRC
+ * @param  Length : number of bytes of the frame
+ * @param  pReply : reply
+ * @retval None
+ */
+static void VTAG_ISO14443BTag (VTAG_POPULATION *pPopulation, VTAG_TAG *pTag, uc8 *pFrame, uc8 Length, VTAG_REPLY *pReply)
+{
+	uint8_t NbSlot;
+
+	/* REQB / WUPB */
+	if (Length == 3 && pFrame[0] == VTAG_ISO14443B_APF)
+	{
+		if (pFrame[1] != 0x00 && pFrame[1] != pTag->AFI)
+			return;
+		if (pTag->State != VTAG_STATE_IDLE && pTag->State != VTAG_STATE_READY &&
+				(pTag->State != VTAG_STATE_HALT || (pFrame[2] & VTAG_ISO14443B_WUPB) == 0))
+			return;
+		NbSlot = 1 << MIN((pFrame[2] & 0x07), 4);
+		pTag->State = VTAG_STATE_READY;
+		pTag->Level = 1 + VTAG_Random(&pPopulation->Random) % NbSlot;
+		if (pTag->Level == 1)
+			VTAG_ISO14443BATQB(pTag, pReply);
+		return;
+	}
+
+	/* Slot-MARKER */
+	if (Length == 1 && (pFrame[0] & 0x0F) == VTAG_ISO14443B_APF)
+	{
+		if (pTag->State == VTAG_STATE_READY && pTag->Level == (pFrame[0] >> 4) + 1)
+			VTAG_ISO14443BATQB(pTag, pReply);
+		return;
+	}
+
+	/* ATTRIB */
+	if (Length >= 9 && pFrame[0] == VTAG_ISO14443B_ATTRIB)
+	{
+		if (pTag->State != VTAG_STATE_READY || memcmp(&pFrame[1], pTag->UID, ISO14443B_MAX_PUPI_SIZE) != 0)
+			return;
+		pTag->State = VTAG_STATE_ACTIVE;
+		VTAG_IsoDepActivate(pPopulation, pTag, pFrame[6] & 0x0F);
+		pReply->Data[pReply->Length++] = 0x00;		// MBLI 0, CID 0
+		VTAG_AppendCRC(PCD_PROTOCOL_ISO14443B, pReply);
+		return;
+	}
+
+	/* HLTB */
+	if (Length == 5 && pFrame[0] == VTAG_ISO14443B_HLTB)
+	{
+		if ((pTag->State != VTAG_STATE_READY && pTag->State != VTAG_STATE_ACTIVE) ||
+				memcmp(&pFrame[1], pTag->UID, ISO14443B_MAX_PUPI_SIZE) != 0)
+			return;
+		pTag->State = VTAG_STATE_HALT;
+		if (pPopulation->pActive == pTag)
+			pPopulation->pActive = 0x00;
+		pReply->Data[pReply->Length++] = ISO14443B_HLTB_ANSWER;
+		VTAG_AppendCRC(PCD_PROTOCOL_ISO14443B, pReply);
+		return;
+	}
+
+	if (pTag->State == VTAG_STATE_ACTIVE && pPopulation->pActive == pTag)
+		VTAG_IsoDep(pPopulation, pTag, pFrame, Length, pReply);
+}
+
+/**
+ * @brief  This function makes a card the ISO-DEP card of the field (RATS or ATTRIB)
+ * @param  pPopulation : population
+ * @param  pTag : card
+ * @param  FSDI : frame size of the PCD device (FSDI coding)
+ * @retval None
+ */
+static void VTAG_IsoDepActivate (VTAG_POPULATION *pPopulation, VTAG_TAG *pTag, uc8 FSDI)
+{
+	pPopulation->pActive = pTag;
+	pPopulation->BlockNumber = 1;
+	pPopulation->FSD = VTAG_FrameSize[MIN(FSDI, sizeof(VTAG_FrameSize)/sizeof(VTAG_FrameSize[0]) - 1)];
+	pPopulation->ApduLength = 0;
+	pPopulation->ApduOffset = VTAG_ISODEP_RECEIVING;
+	pPopulation->LastBlockLength = 0;
+	pTag->File = 0x0000;
+}
+
+/**
+ * @brief  This function sends a block of the ISO-DEP card (kept for a retransmission)
+ * @param  pPopulation : population
+ * @param  PCB : protocol control byte
+ * @param  pInf : information field
+ * @param  InfLength : number of bytes of the information field
+ * @param  pReply : reply
+ * @retval None
+ */
+static void VTAG_IsoDepSend (VTAG_POPULATION *pPopulation, uc8 PCB, uc8 *pInf, uc16 InfLength, VTAG_REPLY *pReply)
+{
+	pPopulation->LastBlock[0] = PCB;
+	memcpy(&pPopulation->LastBlock[1], pInf, InfLength);
+	pPopulation->LastBlockLength = InfLength + 1;
+
+	memcpy(pReply->Data, pPopulation->LastBlock, pPopulation->LastBlockLength);
+	pReply->Length = pPopulation->LastBlockLength;
+	VTAG_AppendCRC(pPopulation->Protocol, pReply);
+}
+
+/**
+ * @brief  This function sends the next part of the response APDU (chained I-blocks)
+ * @param  pPopulation : population
+ * @param  pReply : reply
+ * @retval None
+ */
+static void VTAG_IsoDepNextBlock (VTAG_POPULATION *pPopulation, VTAG_REPLY *pReply)
+{
+	uint16_t MaxInf = MIN(pPopulation->FSD, VTAG_MAX_REPLY_SIZE) - 3,
+					 InfLength = pPopulation->ApduLength - pPopulation->ApduOffset;
+	uint8_t PCB = 0x02 | pPopulation->BlockNumber;
+
+	if (InfLength > MaxInf)
+	{
+		InfLength = MaxInf;
+		PCB |= 0x10;
+	}
+	VTAG_IsoDepSend(pPopulation, PCB, &pPopulation->Apdu[pPopulation->ApduOffset], InfLength, pReply);
+	pPopulation->ApduOffset += InfLength;
+}
+
+/**
+ * @brief  This function executes a command APDU of the NDEF application (select, read and update binary)
+ * @param  pTag : card
+ * @param  pApdu : command APDU (replaced by the response APDU)
+ * @param  Length : number of bytes of the command APDU
+ * @param  pDelay_us : programming time
+ * @retval number of bytes of the response APDU
+ */
+static uint16_t VTAG_T4Apdu (VTAG_TAG *pTag, uint8_t *pApdu, uc16 Length, uint32_t *pDelay_us)
+{
+	const VTAG_MODEL *pModel = &VTAG_Model[pTag->Model];
+	uint16_t SW = 0x9000, FileOffset, FileSize, Offset, Lc, NbByte = 0, DataOffset;
+	uint32_t Le;
+
+	if (Length < 4)
+		SW = 0x6700;
+	else if (pApdu[0] != 0x00)
+		SW = 0x6E00;
+	else switch (pApdu[1])
+	{
+		case 0xA4:
+			if (pApdu[2] == 0x04 && Length >= 5 + sizeof(VTAG_T4Application) && pApdu[4] == sizeof(VTAG_T4Application) &&
+					memcmp(&pApdu[5], VTAG_T4Application, sizeof(VTAG_T4Application)) == 0)
+				pTag->File = VTAG_T4_APPLICATION;
+			else if (pApdu[2] == 0x00 && Length >= 7 && pApdu[4] == 2 && pTag->File != 0x0000 &&
+							 ((pApdu[5] << 8) | pApdu[6]) == VTAG_T4_CCFILE)
+				pTag->File = VTAG_T4_CCFILE;
+			else if (pApdu[2] == 0x00 && Length >= 7 && pApdu[4] == 2 && pTag->File != 0x0000 &&
+							 ((pApdu[5] << 8) | pApdu[6]) == VTAG_T4_NDEFFILE)
+				pTag->File = VTAG_T4_NDEFFILE;
+			else
+				SW = 0x6A82;
+			break;
+
+		case 0xB0:
+		case 0xD6:
+			if (pTag->File == VTAG_T4_CCFILE)
+			{
+				FileOffset = 0;
+				FileSize = VTAG_T4_CCFILE_SIZE;
+			}
+			else if (pTag->File == VTAG_T4_NDEFFILE)
+			{
+				FileOffset = VTAG_T4_CCFILE_SIZE;
+				FileSize = pModel->DataSize;
+			}
+			else
+			{
+				SW = 0x6986;
+				break;
+			}
+			Offset = (pApdu[2] << 8) | pApdu[3];
+			if ((pApdu[2] & 0x80) != 0 || Offset > FileSize)
+			{
+				SW = 0x6B00;
+				break;
+			}
+
+			if (pApdu[1] == 0xB0)
+			{
+				/* short or extended Le */
+				if (Length == 5)
+					Le = (pApdu[4] != 0) ? pApdu[4] : 256;
+				else if (Length == 7 && pApdu[4] == 0x00)
+					Le = ((pApdu[5] << 8) | pApdu[6]) != 0 ? ((pApdu[5] << 8) | pApdu[6]) : 65536;
+				else
+				{
+					SW = 0x6700;
+					break;
+				}
+				NbByte = MIN(MIN(Le, (uint32_t)(FileSize - Offset)), (uint32_t)(VTAG_MAX_APDU_SIZE - 2));
+				memmove(pApdu, &pTag->pMemory[FileOffset + Offset], NbByte);
+				break;
+			}
+
+			/* short or extended Lc */
+			if (Length > 5 && pApdu[4] != 0x00)
+			{
+				Lc = pApdu[4];
+				DataOffset = 5;
+			}
+			else if (Length > 7 && pApdu[4] == 0x00)
+			{
+				Lc = (pApdu[5] << 8) | pApdu[6];
+				DataOffset = 7;
+			}
+			else
+			{
+				SW = 0x6700;
+				break;
+			}
+			if (DataOffset + Lc != Length)
+				SW = 0x6700;
+			else if (pTag->File == VTAG_T4_CCFILE)
+				SW = 0x6982;
+			else if (Offset + Lc > FileSize)
+				SW = 0x6A84;
+			else
+			{
+				memcpy(&pTag->pMemory[FileOffset + Offset], &pApdu[DataOffset], Lc);
+				*pDelay_us += pModel->WriteTime_us*((Lc + 15)/16);
+			}
+			break;
+
+		default:
+			SW = 0x6D00;
+			break;
+	}
+
+	pApdu[NbByte++] = GETMSB(SW);
+	pApdu[NbByte++] = GETLSB(SW);
+	return NbByte;
+}
+
+/**
+ * @brief  This function handles a block received by the ISO-DEP card (I, R and S blocks)
+ * @param  pPopulation : population
+ * @param  pTag : card
+ * @param  pBlock : block without CRC
+ * @param  Length : number of bytes of the block
+ * @param  pReply : reply
+ * @retval None
+ */
+static void VTAG_IsoDep (VTAG_POPULATION *pPopulation, VTAG_TAG *pTag, uc8 *pBlock, uc8 Length, VTAG_REPLY *pReply)
+{
+	uint8_t PCB = pBlock[0],
+					BlockNumber = PCB & 0x01,
+					Offset = 1;
+	uint16_t InfLength;
+
+	/* I-block : part of a command, the response is sent when the last part is received */
+	if ((PCB & 0xE2) == 0x02)
+	{
+		Offset += ((PCB & 0x08) != 0) + ((PCB & 0x04) != 0);		// CID and NAD
+		if (Offset > Length)
+			return;
+		pPopulation->BlockNumber = BlockNumber;
+		if (pPopulation->ApduOffset != VTAG_ISODEP_RECEIVING)
+		{
+			pPopulation->ApduLength = 0;
+			pPopulation->ApduOffset = VTAG_ISODEP_RECEIVING;
+		}
+		InfLength = MIN(Length - Offset, VTAG_MAX_APDU_SIZE - pPopulation->ApduLength);
+		memcpy(&pPopulation->Apdu[pPopulation->ApduLength], &pBlock[Offset], InfLength);
+		pPopulation->ApduLength += InfLength;
+
+		if ((PCB & 0x10) != 0)
+		{
+			VTAG_IsoDepSend(pPopulation, 0xA2 | pPopulation->BlockNumber, 0x00, 0, pReply);
+			return;
+		}
+		pPopulation->ApduLength = VTAG_T4Apdu(pTag, pPopulation->Apdu, pPopulation->ApduLength, &pReply->Delay_us);
+		pPopulation->ApduOffset = 0;
+		VTAG_IsoDepNextBlock(pPopulation, pReply);
+		return;
+	}
+
+	/* R-block */
+	if ((PCB & 0xE6) == 0xA2)
+	{
+		if (BlockNumber == pPopulation->BlockNumber)
+		{
+			/* last block lost : sent again */
+			if (pPopulation->LastBlockLength != 0)
+			{
+				memcpy(pReply->Data, pPopulation->LastBlock, pPopulation->LastBlockLength);
+				pReply->Length = pPopulation->LastBlockLength;
+				VTAG_AppendCRC(pPopulation->Protocol, pReply);
+			}
+		}
+		else if ((PCB & 0x10) != 0)
+			/* R(NAK) with the other block number (presence check) : R(ACK) */
+			VTAG_IsoDepSend(pPopulation, 0xA2 | pPopulation->BlockNumber, 0x00, 0, pReply);
+		else
+		{
+			/* R(ACK) : next part of the response */
+			pPopulation->BlockNumber = BlockNumber;
+			if (pPopulation->ApduOffset != VTAG_ISODEP_RECEIVING && pPopulation->ApduOffset < pPopulation->ApduLength)
+				VTAG_IsoDepNextBlock(pPopulation, pReply);
+		}
+		return;
+	}
+
+	/* S(DESELECT) */
+	if ((PCB & 0xF7) == 0xC2)
+	{
+		VTAG_IsoDepSend(pPopulation, PCB, 0x00, 0, pReply);
+		pTag->State = VTAG_STATE_HALT;
+		pPopulation->pActive = 0x00;
+	}
+}
+
+/**
+ * @brief  This function starts the reception of the replies of a frame
+ * @param  pRx : reception
+ * @retval None
+ */
+static void VTAG_StartReception (VTAG_RECEPTION *pRx)
+{
+	pRx->Length = 0;
+	pRx->FirstLength = 0;
+	pRx->NbReply = 0;
+	pRx->CollisionBit = VTAG_NOCOLLISION;
+	pRx->StartBit = 0;
+	pRx->NbBit = 8;
+	pRx->CRCError = false;
+	pRx->Overflow = false;
+	pRx->Delay_us = 0;
+}
+
+/**
+ * @brief  This function adds the reply of a tag to the reception : the replies are ORed and the first
+ * @brief  bit which differs from the first reply is the collision bit
+ * @param  pRx : reception
+ * @param  pTag : tag
+ * @param  pReply : reply of the tag
+ * @retval None
+ */
+static void VTAG_Receive (VTAG_RECEPTION *pRx, VTAG_TAG *pTag, const VTAG_REPLY *pReply)
+{
+	uint16_t NthBit, NbBit;
+
+	pRx->pReplier[pRx->NbReply++] = pTag;
+	pRx->Delay_us = MAX(pRx->Delay_us, pReply->Delay_us);
+	if (pReply->Length == VTAG_REPLY_OVERFLOW)
+	{
+		pRx->Overflow = true;
+		return;
+	}
+
+	if (pRx->NbReply == 1)
+	{
+		memcpy(pRx->First, pReply->Data, pReply->Length);
+		memcpy(pRx->Data, pReply->Data, pReply->Length);
+		pRx->FirstLength = pRx->Length = pReply->Length;
+		pRx->NbBit = pReply->NbBit;
+		return;
+	}
+
+	/* Manchester coding : the first bit which differs is seen as a collision */
+	NbBit = MIN(pRx->FirstLength, pReply->Length)*8;
+	for (NthBit = pRx->StartBit; NthBit < NbBit && NthBit < pRx->CollisionBit; NthBit++)
+		if (((pRx->First[NthBit/8] ^ pReply->Data[NthBit/8]) & (1 << (NthBit%8))) != 0)
+			break;
+	if (NthBit < pRx->CollisionBit && (NthBit < NbBit || pRx->FirstLength != pReply->Length))
+		pRx->CollisionBit = NthBit;
+
+	for (NthBit = 0; NthBit < pReply->Length; NthBit++)
+		pRx->Data[NthBit] = (NthBit < pRx->Length) ? pRx->Data[NthBit] | pReply->Data[NthBit] : pReply->Data[NthBit];
+	pRx->Length = MAX(pRx->Length, pReply->Length);
+}
+
+/**
+ * @brief  This function builds the 95HF response of a frame (result code, length, data and control
+ * @brief  bytes of the protocol) and advances the virtual clock
+ * @param  pPopulation : population
+ * @param  pRx : reception
+ * @param  RequestLength : number of bytes sent to the tags (CRC included)
+ * @param  pResponse : 95HF response
+ * @retval None
+ */
+static void VTAG_EndReception (VTAG_POPULATION *pPopulation, VTAG_RECEPTION *pRx, uc16 RequestLength, uint8_t *pResponse)
+{
+	uint32_t AirTime = VTAG_AirTime(pPopulation, RequestLength);
+	bool Collision = (pRx->CollisionBit != VTAG_NOCOLLISION);
+	uint16_t NthReply, CollisionBit;
+	uint8_t *pControl;
+
+	pResponse[PCD_LENGTH_OFFSET] = 0x00;
+	if (pRx->NbReply == 0)
+	{
+		pResponse[READERREPLY_STATUSOFFSET] = SENDRECV_ERRORCODE_FRAMEWAIT;
+		pPopulation->Stat.NbTimeOut++;
+		pPopulation->Stat.AirTime_us += AirTime;
+		pPopulation->Time_us += AirTime + VTAG_TIMEOUT_US;
+		return;
+	}
+
+	AirTime += VTAG_AirTime(pPopulation, pRx->Length);
+	pPopulation->Stat.AirTime_us += AirTime;
+	pPopulation->Time_us += AirTime + pRx->Delay_us;
+	switch (pPopulation->Protocol)
+	{
+		case PCD_PROTOCOL_ISO15693:
+			pPopulation->Time_us += VTAG_ISO15693_T1_US;
+			break;
+		case PCD_PROTOCOL_ISO14443A:
+			pPopulation->Time_us += VTAG_ISO14443A_FDT_US;
+			break;
+		default:
+			pPopulation->Time_us += VTAG_ISO14443B_TR_US;
+			break;
+	}
+
+	for (NthReply = 0; NthReply < pRx->NbReply; NthReply++)
+	{
+		if (Collision == true)
+			pRx->pReplier[NthReply]->NbCollision++;
+		else
+			pRx->pReplier[NthReply]->NbReply++;
+	}
+	if (Collision == true)
+		pPopulation->Stat.NbCollision++;
+
+	if (pRx->Overflow == true)
+	{
+		pResponse[READERREPLY_STATUSOFFSET] = SENDRECV_ERRORCODE_OVERFLOW;
+		return;
+	}
+
+	pResponse[READERREPLY_STATUSOFFSET] = SENDRECV_RESULTSCODE_OK;
+	memcpy(&pResponse[PCD_DATA_OFFSET], pRx->Data, pRx->Length);
+	pControl = &pResponse[PCD_DATA_OFFSET + pRx->Length];
+
+	switch (pPopulation->Protocol)
+	{
+		case PCD_PROTOCOL_ISO14443A:
+			pControl[0] = pRx->NbBit;
+			pControl[1] = 0x00;
+			pControl[2] = 0x00;
+			if (Collision == true)
+			{
+				/* collision byte from the first byte received, collision bit of the first byte from the first bit received */
+				CollisionBit = pRx->CollisionBit;
+				pControl[0] |= ISO14443A_COLISIONMASK;
+				pControl[1] = CollisionBit/8;
+				pControl[2] = CollisionBit%8 - ((CollisionBit/8 == 0) ? pRx->StartBit : 0);
+			}
+			else if (pRx->CRCError == true)
+				pControl[0] |= ISO14443A_CRCMASK;
+			if (pRx->NbBit != 8 && Collision == false)
+				pResponse[READERREPLY_STATUSOFFSET] = SENDRECV_RESULTSRESIDUAL;
+			pResponse[PCD_LENGTH_OFFSET] = pRx->Length + ISO14443A_NBBYTE;
+			break;
+
+		case PCD_PROTOCOL_ISO15693:
+			pControl[0] = (Collision == true) ? CONTROL_15693_COLISIONMASK | CONTROL_15693_CRCMASK :
+										(pRx->CRCError == true) ? CONTROL_15693_CRCMASK : 0x00;
+			pResponse[PCD_LENGTH_OFFSET] = pRx->Length + CONTROL_15693_NBBYTE;
+			break;
+
+		default:
+			pControl[0] = (Collision == true) ? CONTROL_14443B_COLISIONMASK | CONTROL_14443B_CRCMASK :
+										(pRx->CRCError == true) ? CONTROL_14443B_CRCMASK : 0x00;
+			pResponse[PCD_LENGTH_OFFSET] = pRx->Length + CONTROL_14443B_NBBYTE;
+			break;
+	}
+}
+
+/**
+ * @brief  This function sends a frame to the tags of the protocol selected and collects their replies.
+ * @brief  A tag misses the frame with its no reply rate (its state does not change) and its reply
+ * @brief  is corrupted with its CRC error rate.
+ * @param  pPopulation : population
+ * @param  pFrame : frame (ISO14443A : followed by the control byte)
+ * @param  Length : number of bytes of the frame
+ * @param  pResponse : 95HF response
+ * @retval None
+ */
+static void VTAG_SendRecv (VTAG_POPULATION *pPopulation, uc8 *pFrame, uc8 Length, uint8_t *pResponse)
+{
+	VTAG_RECEPTION *pRx = &VTAG_Rx;
+	VTAG_REPLY Reply;
+	VTAG_TAG *pTag;
+	uint16_t NthTag, RequestLength = Length, NthBit;
+
+	pPopulation->Stat.NbFrame++;
+	VTAG_StartReception(pRx);
+
+	switch (pPopulation->Protocol)
+	{
+		case PCD_PROTOCOL_ISO15693:
+			RequestLength += (Length != 0) ? ISO15693_NBBYTE_CRC16 : 0;
+			/* slot of a 16 slots inventory */
+			if (Length == 0)
+			{
+				if (pPopulation->InventorySlot != VTAG_NOSLOT && ++pPopulation->InventorySlot > 15)
+					pPopulation->InventorySlot = VTAG_NOSLOT;
+			}
+			else if (Length >= 2 && (pFrame[0] & (VTAG_ISO15693_FLAG_INVENTORY | VTAG_ISO15693_FLAG_ADDRORNBSLOT)) == VTAG_ISO15693_FLAG_INVENTORY &&
+							 (pFrame[1] == ISO15693_CMDCODE_INVENTORY || pFrame[1] == ISO15693_CMDCODE_ST_INVENTORYREAD))
+			{
+				pPopulation->InventorySlot = 0;
+				for (NthTag = 0; NthTag < pPopulation->NbTag; NthTag++)
+					if (pPopulation->pTag[NthTag].Kind == VTAG_KIND_ISO15693)
+						pPopulation->pTag[NthTag].Level = VTAG_NOSLOT;
+			}
+			else
+				pPopulation->InventorySlot = VTAG_NOSLOT;
+			break;
+		case PCD_PROTOCOL_ISO14443A:
+			if (Length == 0)
+				break;
+			RequestLength = Length - 1 + ((pFrame[Length-1] & PCD_ISO14443A_APPENDCRC) != 0 ? 2 : 0);
+			/* anticollision split frame : the first bits of the reply are known by the PCD device */
+			if (Length >= 3 && (pFrame[0] == SEL_CASCADE_LVL_1 || pFrame[0] == SEL_CASCADE_LVL_2 || pFrame[0] == SEL_CASCADE_LVL_3) &&
+					pFrame[1] != VTAG_ISO14443A_SELECT_NVB)
+				pRx->StartBit = pFrame[1] & 0x07;
+			break;
+		case PCD_PROTOCOL_ISO14443B:
+			RequestLength += ISO14443B_NBBYTE_CRC;
+			break;
+		default:
+			/* no tag of the other protocols */
+			pResponse[READERREPLY_STATUSOFFSET] = SENDRECV_ERRORCODE_FRAMEWAIT;
+			pResponse[PCD_LENGTH_OFFSET] = 0x00;
+			pPopulation->Stat.NbTimeOut++;
+			pPopulation->Time_us += VTAG_TIMEOUT_US;
+			return;
+	}
+
+	for (NthTag = 0; NthTag < pPopulation->NbTag; NthTag++)
+	{
+		pTag = &pPopulation->pTag[NthTag];
+		if (pTag->State == VTAG_STATE_OFF || VTAG_Protocol(pTag->Kind) != pPopulation->Protocol)
+			continue;
+
+		pTag->NbRequest++;
+		if (pTag->NoReplyPpm != 0 && VTAG_PPMDRAW(&pPopulation->Random) < pTag->NoReplyPpm)
+		{
+			pTag->NbInjectedError++;
+			pPopulation->Stat.NbInjectedError++;
+			continue;
+		}
+
+		Reply.Length = 0;
+		Reply.NbBit = 8;
+		Reply.HasCRC = false;
+		Reply.Delay_us = 0;
+		switch (pPopulation->Protocol)
+		{
+			case PCD_PROTOCOL_ISO15693:
+				VTAG_ISO15693Tag(pPopulation, pTag, pFrame, Length, &Reply);
+				if (Reply.Length != 0 && Reply.Length != VTAG_REPLY_OVERFLOW)
+					VTAG_AppendCRC(PCD_PROTOCOL_ISO15693, &Reply);
+				break;
+			case PCD_PROTOCOL_ISO14443A:
+				VTAG_ISO14443ATag(pPopulation, pTag, pFrame, Length, &Reply);
+				break;
+			default:
+				VTAG_ISO14443BTag(pPopulation, pTag, pFrame, Length, &Reply);
+				break;
+		}
+		if (Reply.Length == 0)
+			continue;
+
+		/* a bit of the reply is flipped, the PCD device only detects it with the CRC */
+		if (Reply.Length != VTAG_REPLY_OVERFLOW && pTag->CRCErrorPpm != 0 &&
+				VTAG_PPMDRAW(&pPopulation->Random) < pTag->CRCErrorPpm)
+		{
+			NthBit = VTAG_Random(&pPopulation->Random) % (Reply.Length*8);
+			Reply.Data[NthBit/8] ^= 1 << (NthBit%8);
+			pRx->CRCError |= Reply.HasCRC;
+			pTag->NbInjectedError++;
+			pPopulation->Stat.NbInjectedError++;
+		}
+
+		Reply.Delay_us += pTag->ReplyDelay_us;
+		VTAG_Receive(pRx, pTag, &Reply);
+	}
+
+	VTAG_EndReception(pPopulation, pRx, RequestLength, pResponse);
+}
+
+/**
+  * @}
+  */
+
+
+/** @addtogroup lib_vtagfield_Public_Functions
+ * 	@{
+ */
+
+/**
+ * @brief  This function answers a command sent to the 95HF (command code, length, data)
+ * @param  pPopulation : population in the field
+ * @param  pCommand : command
+ * @param  pResponse : response (result code, length, data)
+ * @retval None
+ */
+void VTAG_Transceive (VTAG_POPULATION *pPopulation, uc8 *pCommand, uint8_t *pResponse)
+{
+	uint8_t NthRegister;
+
+	pPopulation->Stat.NbCommand++;
+	pPopulation->Time_us += pPopulation->Config.HostTime_us;
+
+	switch (pCommand[PCD_COMMAND_OFFSET])
+	{
+		case ECHO:
+			pResponse[READERREPLY_STATUSOFFSET] = ECHORESPONSE;
+			pResponse[PCD_LENGTH_OFFSET] = 0x00;
+			break;
+
+		case IDN:
+			pResponse[READERREPLY_STATUSOFFSET] = IDN_RESULTSCODE_OK;
+			pResponse[PCD_LENGTH_OFFSET] = 0x0F;
+			memcpy(&pResponse[PCD_DATA_OFFSET], "NFC FS2JAST4\0\x2A\xCE", 0x0F);
+			break;
+
+		case PROTOCOL_SELECT:
+			VTAG_ProtocolSelect(pPopulation, pCommand, pResponse);
+			break;
+
+		case SEND_RECEIVE:
+			VTAG_SendRecv(pPopulation, &pCommand[PCD_DATA_OFFSET], pCommand[PCD_LENGTH_OFFSET], pResponse);
+			break;
+
+		case READ_REGISTER:
+			/* the analog registers are not emulated (read as 0) */
+			pResponse[READERREPLY_STATUSOFFSET] = 0x00;
+			pResponse[PCD_LENGTH_OFFSET] = MIN(pCommand[PCD_DATA_OFFSET+1], RFTRANS_95HF_MAX_BUFFER_SIZE);
+			for (NthRegister = 0; NthRegister < pResponse[PCD_LENGTH_OFFSET]; NthRegister++)
+				pResponse[PCD_DATA_OFFSET + NthRegister] = 0x00;
+			break;
+
+		case WRITE_REGISTER:
+			pResponse[READERREPLY_STATUSOFFSET] = 0x00;
+			pResponse[PCD_LENGTH_OFFSET] = 0x00;
+			break;
+
+		default:
+			pResponse[READERREPLY_STATUSOFFSET] = PROTOCOLSELECT_ERRORCODE_CMDLENGTH;
+			pResponse[PCD_LENGTH_OFFSET] = 0x00;
+			break;
+	}
+}
+
+/**
+ * @brief  This function switches the field off : the tags lose their state
+ * @param  pPopulation : population
+ * @retval None
+ */
+void VTAG_FieldOff (VTAG_POPULATION *pPopulation)
+{
+	uint16_t NthTag;
+
+	for (NthTag = 0; NthTag < pPopulation->NbTag; NthTag++)
+	{
+		pPopulation->pTag[NthTag].State = VTAG_STATE_OFF;
+		pPopulation->pTag[NthTag].Level = VTAG_NOSLOT;
+		pPopulation->pTag[NthTag].File = 0x0000;
+	}
+	pPopulation->Protocol = PCD_PROTOCOL_FIELDOFF;
+	pPopulation->InventorySlot = VTAG_NOSLOT;
+	pPopulation->pActive = 0x00;
+}
+
+/**
+ * @brief  This function advances the virtual clock (delays of the application)
+ * @param  pPopulation : population
+ * @param  Delay_us : delay
+ * @retval None
+ */
+void VTAG_Wait (VTAG_POPULATION *pPopulation, uc32 Delay_us)
+{
+	pPopulation->Time_us += Delay_us;
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/******************* (C) COPYRIGHT 2014 STMicroelectronics *****END OF FILE****/